@@ -13,9 +13,12 @@
 #include "entitytreemodel.h"
 #include "entitytreemodel_p.h"
 #include "itemcreatejob.h"
+#include "itemdeletejob.h"
 #include "monitor_p.h"
 #include "qtest_akonadi.h"
 
+#include <QElapsedTimer>
+
 using namespace Akonadi;
 
 class ModelSignalSpy : public QObject
@@ -111,6 +114,20 @@ Akonadi::Collection createCollection(const QString &name, const Akonadi::Collect
     return create->collection();
 }
 
+bool createItems(const Akonadi::Collection &collection, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        Akonadi::Item item(QStringLiteral("application/octet-stream"));
+        item.setPayloadFromData(QByteArray::number(i));
+        auto create = new ItemCreateJob(item, collection);
+        if (!create->exec()) {
+            qWarning() << create->errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * This is a test for the initial population of the ETM.
  */
@@ -127,6 +144,9 @@ private Q_SLOTS:
     void testRemoveMonitoringCollections();
     void testDisplayFilter();
     void testLoadingOfHiddenCollection();
+    void testWindowedPopulation();
+    void benchmarkPopulation_data();
+    void benchmarkPopulation();
 
 private:
     Collection res;
@@ -136,6 +156,7 @@ private:
     Collection col2;
     Collection col3;
     Collection col4;
+    Collection benchmarkCol;
 };
 
 void EtmPopulationTest::initTestCase()
@@ -332,6 +353,123 @@ void EtmPopulationTest::testLoadingOfHiddenCollection()
     AKVERIFYEXEC(deleteJob);
 }
 
+void EtmPopulationTest::testWindowedPopulation()
+{
+    const QStringList mimeTypes = {QStringLiteral("application/octet-stream")};
+    Collection col = createCollection(QStringLiteral("windowed"), monitorCol, true, mimeTypes);
+    QVERIFY(col.isValid());
+    QVERIFY(createItems(col, 25));
+
+    auto changeRecorder = new ChangeRecorder(this);
+    changeRecorder->setCollectionMonitored(col, true);
+    AkonadiTest::akWaitForSignal(changeRecorder, &Monitor::monitorReady);
+    auto model = new InspectableETM(changeRecorder, this);
+    model->setItemPopulationStrategy(EntityTreeModel::WindowedPopulation);
+    model->setItemWindowSize(10);
+    model->setCollectionFetchStrategy(EntityTreeModel::FetchCollectionsRecursive);
+
+    QTRY_VERIFY(model->isCollectionTreeFetched());
+    QTRY_VERIFY(getIndex(QStringLiteral("windowed"), model).isValid());
+    QPersistentModelIndex index = getIndex(QStringLiteral("windowed"), model);
+    QCOMPARE(model->rowCount(index), 0);
+    QVERIFY(model->canFetchMore(index));
+
+    // Every fetchMore() call appends the next window of items, newest first
+    for (int rows : {10, 20}) {
+        model->fetchMore(index);
+        QTRY_COMPARE(model->rowCount(index), rows);
+        QTRY_VERIFY(model->canFetchMore(index));
+        QVERIFY(!model->isCollectionPopulated(col.id()));
+    }
+    model->fetchMore(index);
+    QTRY_COMPARE(model->rowCount(index), 25);
+    QTRY_VERIFY(model->isCollectionPopulated(col.id()));
+    QVERIFY(!model->canFetchMore(index));
+    for (int row = 1; row < model->rowCount(index); ++row) {
+        QVERIFY(model->index(row - 1, 0, index).data(EntityTreeModel::ItemIdRole).toLongLong()
+                > model->index(row, 0, index).data(EntityTreeModel::ItemIdRole).toLongLong());
+    }
+
+    // Monitor notifications are applied to windowed collections
+    QVERIFY(createItems(col, 1));
+    QTRY_COMPARE(model->rowCount(index), 26);
+    const Item::Id newestId = model->index(25, 0, index).data(EntityTreeModel::ItemIdRole).toLongLong();
+    const Item::Id removedId = model->index(0, 0, index).data(EntityTreeModel::ItemIdRole).toLongLong();
+    auto deleteJob = new ItemDeleteJob(Item(removedId));
+    AKVERIFYEXEC(deleteJob);
+    QTRY_COMPARE(model->rowCount(index), 25);
+
+    // Evicted items can be fetched again
+    model->evictItems(index, 5);
+    QCOMPARE(model->rowCount(index), 5);
+    QCOMPARE(model->index(4, 0, index).data(EntityTreeModel::ItemIdRole).toLongLong(), newestId);
+    QVERIFY(!model->isCollectionPopulated(col.id()));
+    QVERIFY(model->canFetchMore(index));
+    model->fetchMore(index);
+    QTRY_COMPARE(model->rowCount(index), 15);
+    QTRY_VERIFY(model->canFetchMore(index));
+    model->fetchMore(index);
+    QTRY_COMPARE(model->rowCount(index), 25);
+    // The last window was full, so only an empty window tells that there are no more items
+    QTRY_VERIFY(model->canFetchMore(index));
+    model->fetchMore(index);
+    QTRY_VERIFY(model->isCollectionPopulated(col.id()));
+    QCOMPARE(model->rowCount(index), 25);
+
+    auto collectionDeleteJob = new Akonadi::CollectionDeleteJob(col);
+    AKVERIFYEXEC(collectionDeleteJob);
+}
+
+void EtmPopulationTest::benchmarkPopulation_data()
+{
+    QTest::addColumn<bool>("windowed");
+
+    QTest::newRow("immediate") << false;
+    QTest::newRow("windowed") << true;
+}
+
+/*
+ * Compares the time until a large collection is shown with immediate and windowed population.
+ * The number of items defaults to 5000 and can be changed with the AKONADI_ETMPOPULATION_BENCHMARK_COUNT
+ * environment variable.
+ */
+void EtmPopulationTest::benchmarkPopulation()
+{
+    QFETCH(bool, windowed);
+
+    const int count = qEnvironmentVariableIsSet("AKONADI_ETMPOPULATION_BENCHMARK_COUNT") ? qEnvironmentVariableIntValue("AKONADI_ETMPOPULATION_BENCHMARK_COUNT") : 5000;
+    if (!benchmarkCol.isValid()) {
+        benchmarkCol = createCollection(QStringLiteral("benchmark"), monitorCol, true, {QStringLiteral("application/octet-stream")});
+        QVERIFY(benchmarkCol.isValid());
+        QVERIFY(createItems(benchmarkCol, count));
+    }
+
+    auto changeRecorder = new ChangeRecorder(this);
+    changeRecorder->setCollectionMonitored(benchmarkCol, true);
+    AkonadiTest::akWaitForSignal(changeRecorder, &Monitor::monitorReady);
+
+    QElapsedTimer timer;
+    timer.start();
+    auto model = new InspectableETM(changeRecorder, this);
+    model->setItemPopulationStrategy(windowed ? EntityTreeModel::WindowedPopulation : EntityTreeModel::ImmediatePopulation);
+    model->setCollectionFetchStrategy(EntityTreeModel::FetchCollectionsRecursive);
+
+    QTRY_VERIFY(getIndex(QStringLiteral("benchmark"), model).isValid());
+    const QModelIndex index = getIndex(QStringLiteral("benchmark"), model);
+    if (windowed) {
+        QVERIFY(model->canFetchMore(index));
+        model->fetchMore(index);
+        QTRY_COMPARE_WITH_TIMEOUT(model->rowCount(index), model->itemWindowSize(), 60000);
+    } else {
+        QTRY_VERIFY_WITH_TIMEOUT(model->isCollectionPopulated(benchmarkCol.id()), 60000);
+        QCOMPARE(model->rowCount(index), count);
+    }
+    qDebug() << QTest::currentDataTag() << ": first" << model->rowCount(index) << "of" << count << "items shown after" << timer.elapsed() << "ms";
+
+    delete model;
+    delete changeRecorder;
+}
+
 #include "etmpopulationtest.moc"
 
 QTEST_AKONADI_CORE_MAIN(EtmPopulationTest)
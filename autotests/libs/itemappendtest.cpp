@@ -19,8 +19,12 @@
 #include "itemdeletejob.h"
 #include "itemfetchjob.h"
 #include "itemfetchscope.h"
+#include "session.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
 
 using namespace Akonadi;
 
@@ -401,4 +405,55 @@ void ItemAppendTest::testForeignPayload()
     QVERIFY(file.remove());
 }
 
+void ItemAppendTest::benchmarkCreate_data()
+{
+    QTest::addColumn<bool>("inlineParts");
+    QTest::addColumn<int>("size");
+
+    for (int size : {256, 4096, 65536}) {
+        QTest::addRow("streamed-%d", size) << false << size;
+        QTest::addRow("inline-%d", size) << true << size;
+    }
+}
+
+void ItemAppendTest::benchmarkCreate()
+{
+    QFETCH(bool, inlineParts);
+    QFETCH(int, size);
+
+    const Collection col(AkonadiTest::collectionIdFromPath(QStringLiteral("res2/space folder")));
+    QVERIFY(col.isValid());
+
+    // The inline parts are negotiated when the session connects
+    if (inlineParts) {
+        qunsetenv("AKONADI_DISABLE_INLINE_PARTS");
+    } else {
+        qputenv("AKONADI_DISABLE_INLINE_PARTS", "1");
+    }
+    Session session("benchmarkCreate");
+
+    constexpr int count = 500;
+    Item item(QStringLiteral("application/octet-stream"));
+    item.setPayload(QByteArray(size, 'X'));
+
+    Item::List created;
+    created.reserve(count);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i) {
+        auto job = new ItemCreateJob(item, col, &session);
+        connect(job, &KJob::result, this, [&created](KJob *job) {
+            QVERIFY(!job->error());
+            created.push_back(static_cast<ItemCreateJob *>(job)->item());
+        });
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(created.size(), count, 60000);
+    qDebug() << (inlineParts ? "Inline" : "Streamed") << "parts of" << size << "bytes:" << count * 1000.0 / std::max<qint64>(timer.elapsed(), 1)
+             << "creates/sec";
+    qunsetenv("AKONADI_DISABLE_INLINE_PARTS");
+
+    auto del = new ItemDeleteJob(created, this);
+    AKVERIFYEXEC(del);
+}
+
 #include "moc_itemappendtest.cpp"
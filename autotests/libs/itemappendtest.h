@@ -26,4 +26,6 @@ private Q_SLOTS:
     void testItemMerge_data();
     void testItemMerge();
     void testForeignPayload();
+    void benchmarkCreate_data();
+    void benchmarkCreate();
 };
@@ -16,6 +16,8 @@
 
 #include "qtest_akonadi.h"
 
+#include <algorithm>
+
 using namespace Akonadi;
 
 QTEST_AKONADI_CORE_MAIN(ItemFetchTest)
@@ -320,4 +322,54 @@ void ItemFetchTest::testFetchBatching()
     QCOMPARE(origItemsCount, itemCountJob->items().size());
 }
 
+void ItemFetchTest::testFetchLimitAfter_data()
+{
+    QTest::addColumn<Qt::SortOrder>("order");
+
+    QTest::newRow("descending") << Qt::DescendingOrder;
+    QTest::newRow("ascending") << Qt::AscendingOrder;
+}
+
+void ItemFetchTest::testFetchLimitAfter()
+{
+    QFETCH(Qt::SortOrder, order);
+
+    auto resolver = new CollectionPathResolver(QStringLiteral("res1/foo"), this);
+    AKVERIFYEXEC(resolver);
+    const Collection col(resolver->collection());
+
+    auto job = new ItemFetchJob(col, this);
+    AKVERIFYEXEC(job);
+    QList<Item::Id> expectedIds;
+    for (const Item &item : job->items()) {
+        expectedIds.push_back(item.id());
+    }
+    QCOMPARE(expectedIds.size(), 15);
+    std::sort(expectedIds.begin(), expectedIds.end());
+    if (order == Qt::DescendingOrder) {
+        std::reverse(expectedIds.begin(), expectedIds.end());
+    }
+
+    // Page through the collection, each page starting after the last item of the previous one
+    QList<Item::Id> ids;
+    Item::Id afterId = -1;
+    for (int page = 0; page < 4; ++page) {
+        job = new ItemFetchJob(col, this);
+        job->setLimitAfter(4, afterId, order);
+        AKVERIFYEXEC(job);
+        const Item::List items = job->items();
+        QCOMPARE(items.size(), std::min(4, 15 - page * 4));
+        for (const Item &item : items) {
+            ids.push_back(item.id());
+        }
+        afterId = items.last().id();
+    }
+    QCOMPARE(ids, expectedIds);
+
+    job = new ItemFetchJob(col, this);
+    job->setLimitAfter(4, afterId, order);
+    AKVERIFYEXEC(job);
+    QVERIFY(job->items().isEmpty());
+}
+
 #include "moc_itemfetchtest.cpp"
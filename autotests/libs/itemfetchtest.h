@@ -21,4 +21,6 @@ private Q_SLOTS:
     void testRidFetch();
     void testAncestorRetrieval();
     void testFetchBatching();
+    void testFetchLimitAfter_data();
+    void testFetchLimitAfter();
 };
@@ -426,6 +426,65 @@ void ItemStoreTest::itemModifyJobShouldOnlySendModifiedAttributes()
     }
 }
 
+void ItemStoreTest::testModifyItemsIndividually()
+{
+    static constexpr int ItemCount = 5;
+
+    Item::List items;
+    for (int i = 0; i < ItemCount; ++i) {
+        Item item;
+        item.setMimeType(QStringLiteral("application/octet-stream"));
+        item.setPayload<QByteArray>("initial");
+        auto job = new ItemCreateJob(item, res1_foo, this);
+        AKVERIFYEXEC(job);
+        items.push_back(job->item());
+    }
+
+    // Modify one of the items elsewhere, so that storing it causes a conflict
+    Item stale = items[2];
+    stale.setPayload<QByteArray>("modified elsewhere");
+    auto staleJob = new ItemModifyJob(stale, this);
+    AKVERIFYEXEC(staleJob);
+
+    for (int i = 0; i < ItemCount; ++i) {
+        items[i].setPayload<QByteArray>("body " + QByteArray::number(i));
+        items[i].attribute<TestAttribute>(Item::AddIfMissing)->data = "attr " + QByteArray::number(i);
+    }
+
+    auto modifyJob = new ItemModifyJob(items, this);
+    modifyJob->setModifyItemsIndividually(true);
+    QVERIFY(modifyJob->modifyItemsIndividually());
+    QVERIFY(!modifyJob->exec());
+    const auto conflicting = modifyJob->conflictingItems();
+    QCOMPARE(conflicting.size(), 1);
+    QCOMPARE(conflicting.first().id(), items[2].id());
+
+    const auto storedItems = modifyJob->items();
+    QCOMPARE(storedItems.size(), ItemCount);
+    for (int i = 0; i < ItemCount; ++i) {
+        if (i != 2) {
+            QCOMPARE(storedItems[i].revision(), items[i].revision() + 1);
+        }
+    }
+
+    auto fetchJob = new ItemFetchJob(items, this);
+    fetchJob->fetchScope().fetchFullPayload();
+    fetchJob->fetchScope().fetchAllAttributes();
+    AKVERIFYEXEC(fetchJob);
+    const auto fetchedItems = fetchJob->items();
+    QCOMPARE(fetchedItems.size(), ItemCount);
+    for (const Item &item : fetchedItems) {
+        const auto i = std::distance(items.cbegin(), std::find(items.cbegin(), items.cend(), item));
+        if (i == 2) {
+            QCOMPARE(item.payload<QByteArray>(), QByteArray("modified elsewhere"));
+            QVERIFY(!item.hasAttribute<TestAttribute>());
+        } else {
+            QCOMPARE(item.payload<QByteArray>(), "body " + QByteArray::number(i));
+            QCOMPARE(item.attribute<TestAttribute>()->data, "attr " + QByteArray::number(i));
+        }
+    }
+}
+
 void ItemStoreTest::testModifyLargeBatch()
 {
     static constexpr size_t ItemCount = 20'010; // batch size is 10,000, so we should need two full and one partial batch
@@ -26,5 +26,6 @@ private Q_SLOTS:
     void testRemoteIdRace();
     void itemModifyJobShouldOnlySendModifiedAttributes();
     void testParallelJobsAddingAttributes();
+    void testModifyItemsIndividually();
     void testModifyLargeBatch();
 };
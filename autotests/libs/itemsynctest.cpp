@@ -722,6 +722,45 @@ private Q_SLOTS:
         AKVERIFYEXEC(job);
     }
 
+    void testFullSyncDeletesInBatches()
+    {
+        // Given a collection with more items than are listed at once
+        const Collection col = Collection(AkonadiTest::collectionIdFromPath(QStringLiteral("res2/foo2")));
+        QVERIFY(col.isValid());
+
+        const Item::List itemsToDelete = fetchItems(col);
+        if (!itemsToDelete.isEmpty()) {
+            auto deleteJob = new ItemDeleteJob(itemsToDelete);
+            AKVERIFYEXEC(deleteJob);
+        }
+
+        const int itemCount = 1200;
+        createItems(col, itemCount);
+        const Item::List origItems = fetchItems(col);
+        QCOMPARE(origItems.size(), itemCount);
+
+        // When a full sync only lists every third item
+        Item::List remoteItems;
+        for (int i = 0; i < origItems.size(); i += 3) {
+            remoteItems.push_back(origItems.at(i));
+        }
+        auto syncer = new ItemSync(col);
+        syncer->setTransactionMode(ItemSync::SingleTransaction);
+        syncer->setFullSyncItems(remoteItems);
+        AKVERIFYEXEC(syncer);
+
+        // Then all other items are deleted
+        const Item::List resultItems = fetchItems(col);
+        QCOMPARE(resultItems.size(), remoteItems.size());
+        for (const Item &item : remoteItems) {
+            QVERIFY(resultItems.contains(item));
+        }
+
+        // Cleanup
+        auto job = new ItemDeleteJob(resultItems);
+        AKVERIFYEXEC(job);
+    }
+
     void testUserCancel()
     {
         // Given a collection with 100 items
@@ -755,6 +794,87 @@ private Q_SLOTS:
         auto job = new ItemDeleteJob(origItems);
         AKVERIFYEXEC(job);
     }
+
+    void testFullSyncManifest()
+    {
+        const Collection col = Collection(AkonadiTest::collectionIdFromPath(QStringLiteral("res2/foo2")));
+        QVERIFY(col.isValid());
+
+        const Item::List itemsToDelete = fetchItems(col);
+        if (!itemsToDelete.isEmpty()) {
+            auto deleteJob = new ItemDeleteJob(itemsToDelete);
+            AKVERIFYEXEC(deleteJob);
+        }
+
+        // Given a collection with 10 items at remote revision 1
+        for (int i = 0; i < 10; ++i) {
+            Item item(QStringLiteral("application/octet-stream"));
+            item.setRemoteId(QStringLiteral("rid") + QString::number(i));
+            item.setRemoteRevision(QStringLiteral("1"));
+            item.setPayload<QByteArray>("payload1");
+            auto job = new ItemCreateJob(item, col);
+            AKVERIFYEXEC(job);
+        }
+
+        auto monitor = createCollectionMonitor(col);
+        QSignalSpy addedSpy(monitor.get(), &Monitor::itemAdded);
+        QSignalSpy deletedSpy(monitor.get(), &Monitor::itemRemoved);
+        QSignalSpy changedSpy(monitor.get(), &Monitor::itemChanged);
+
+        // When the remote side changed rid1, added a new item and removed rid8 and rid9
+        Item::List manifest;
+        for (int i = 0; i < 8; ++i) {
+            Item item;
+            item.setRemoteId(QStringLiteral("rid") + QString::number(i));
+            item.setRemoteRevision(i == 1 ? QStringLiteral("2") : QStringLiteral("1"));
+            manifest << item;
+        }
+        Item newItem;
+        newItem.setRemoteId(QStringLiteral("ridNew"));
+        newItem.setRemoteRevision(QStringLiteral("1"));
+        manifest << newItem;
+
+        auto syncer = new ItemSync(col);
+        syncer->setTransactionMode(ItemSync::SingleTransaction);
+        QSignalSpy manifestSpy(syncer, &ItemSync::manifestProcessed);
+        syncer->setFullSyncManifest(manifest);
+        QVERIFY(manifestSpy.wait());
+        const auto changedRemoteIds = manifestSpy.first().first().toStringList();
+        QCOMPARE(changedRemoteIds, QStringList({QStringLiteral("rid1"), QStringLiteral("ridNew")}));
+
+        // Then only the changed items need to be delivered
+        Item::List remoteItems;
+        for (const QString &remoteId : changedRemoteIds) {
+            Item item(QStringLiteral("application/octet-stream"));
+            item.setRemoteId(remoteId);
+            item.setRemoteRevision(remoteId == QLatin1StringView("rid1") ? QStringLiteral("2") : QStringLiteral("1"));
+            item.setPayload<QByteArray>("payload2");
+            remoteItems << item;
+        }
+        // Unchanged items are skipped even if delivered
+        Item unchanged(QStringLiteral("application/octet-stream"));
+        unchanged.setRemoteId(QStringLiteral("rid0"));
+        unchanged.setRemoteRevision(QStringLiteral("1"));
+        unchanged.setPayload<QByteArray>("payload2");
+        remoteItems << unchanged;
+
+        syncer->setFullSyncItems(remoteItems);
+        AKVERIFYEXEC(syncer);
+
+        const Item::List resultItems = fetchItems(col);
+        QCOMPARE(resultItems.count(), 9);
+        for (const Item &item : resultItems) {
+            const bool changed = item.remoteId() == QLatin1StringView("rid1") || item.remoteId() == QLatin1StringView("ridNew");
+            QCOMPARE(item.payload<QByteArray>(), changed ? QByteArray("payload2") : QByteArray("payload1"));
+        }
+        QTRY_COMPARE(deletedSpy.count(), 2);
+        QTRY_COMPARE(addedSpy.count(), 1);
+        QTRY_COMPARE(changedSpy.count(), 1);
+
+        // Cleanup
+        auto job = new ItemDeleteJob(resultItems);
+        AKVERIFYEXEC(job);
+    }
 };
 
 QTEST_AKONADI_CORE_MAIN(ItemsyncTest)
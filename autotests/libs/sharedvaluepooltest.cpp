@@ -5,39 +5,98 @@
 */
 
 #include "../sharedvaluepool_p.h"
+#include "item.h"
+
 #include <QTest>
+#include <QThread>
 
 #include <QList>
 #include <QSet>
-#include <set>
+#include <memory>
 #include <utility>
 #include <vector>
 
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
 using namespace Akonadi;
 
 class SharedValuePoolTest : public QObject
 {
     Q_OBJECT
+
+private:
+    static qint64 heapInUse()
+    {
+#if defined(__GLIBC__)
+        return qint64(mallinfo2().uordblks);
+#else
+        return -1;
+#endif
+    }
+
+    // Builds an item listing the way ProtocolHelper does when decoding a
+    // fetch response, i.e. with a freshly allocated copy of every flag and
+    // mime type, optionally replaced by the pooled value
+    static Item::List createItems(int count, const QList<QByteArray> &flags, bool pooled)
+    {
+        Item::List items;
+        items.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            Item item(i + 1);
+            QString mimeType = QStringLiteral("message/rfc822");
+            mimeType.detach();
+            item.setMimeType(pooled ? Internal::mimeTypePool().sharedValue(mimeType) : mimeType);
+            Item::Flags itemFlags;
+            // Every item gets a different subset of the flags
+            for (int f = 0; f < flags.size(); ++f) {
+                if ((i >> f) & 1) {
+                    const QByteArray flag(flags[f].constData(), flags[f].size());
+                    itemFlags.insert(pooled ? Internal::flagPool().sharedValue(flag) : flag);
+                }
+            }
+            item.setFlags(itemFlags);
+            items.push_back(item);
+        }
+        return items;
+    }
+
+    static qsizetype distinctFlagBuffers(const Item::List &items)
+    {
+        QSet<const char *> buffers;
+        for (const Item &item : items) {
+            const auto flags = item.flags();
+            for (const QByteArray &flag : flags) {
+                buffers.insert(flag.constData());
+            }
+        }
+        return buffers.size();
+    }
+
 private Q_SLOTS:
-    void testQVector_data()
+    void testSharedValue_data()
     {
         QTest::addColumn<int>("size");
         QTest::newRow("10") << 10;
         QTest::newRow("100") << 100;
+        QTest::newRow("1000") << 1000;
     }
 
-    void testQVector()
+    void testSharedValue()
     {
         QFETCH(int, size);
         QList<QByteArray> data;
-        Internal::SharedValuePool<QByteArray, QList> pool;
+        Internal::SharedValuePool<QByteArray> pool;
 
         for (int i = 0; i < size; ++i) {
-            QByteArray b(10, static_cast<char>(i));
+            QByteArray b = "$LABEL" + QByteArray::number(i);
             data.push_back(b);
             QCOMPARE(pool.sharedValue(b), b);
-            QCOMPARE(pool.sharedValue(b), b);
+            const QByteArray copy(b.constData(), b.size());
+            QCOMPARE(pool.sharedValue(copy).constData(), b.constData());
         }
+        QCOMPARE(pool.size(), size);
 
         QBENCHMARK {
             for (const QByteArray &b : std::as_const(data)) {
@@ -46,31 +105,72 @@ private Q_SLOTS:
         }
     }
 
-    /*void testQSet_data()
+    void testMaxSize()
     {
-      QTest::addColumn<int>( "size" );
-      QTest::newRow( "10" ) << 10;
-      QTest::newRow( "100" ) << 100;
+        Internal::SharedValuePool<QByteArray> pool(2);
+        const QByteArray a("a");
+        const QByteArray b("b");
+        QCOMPARE(pool.sharedValue(a).constData(), a.constData());
+        QCOMPARE(pool.sharedValue(b).constData(), b.constData());
+
+        const QByteArray c("c");
+        QCOMPARE(pool.sharedValue(c), c);
+        QCOMPARE(pool.size(), 2);
+        QCOMPARE(pool.sharedValue(QByteArray("a")).constData(), a.constData());
+    }
+
+    void testConcurrentAccess()
+    {
+        Internal::SharedValuePool<QByteArray> pool;
+        constexpr int threadCount = 8;
+        constexpr int valueCount = 500;
+
+        std::vector<std::unique_ptr<QThread>> threads;
+        std::vector<QList<QByteArray>> results(threadCount);
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back(QThread::create([&pool, &result = results[t]]() {
+                for (int i = 0; i < valueCount; ++i) {
+                    result.push_back(pool.sharedValue("$LABEL" + QByteArray::number(i)));
+                }
+            }));
+            threads.back()->start();
+        }
+        for (const auto &thread : threads) {
+            QVERIFY(thread->wait());
+        }
+
+        QCOMPARE(pool.size(), valueCount);
+        for (int i = 0; i < valueCount; ++i) {
+            for (int t = 1; t < threadCount; ++t) {
+                QCOMPARE(results[t][i].constData(), results[0][i].constData());
+            }
+        }
     }
 
-    void testQSet()
+    void testItemListMemory()
     {
-      QFETCH( int, size );
-      QList<QByteArray> data;
-      Internal::SharedValuePool<QByteArray, QSet> pool;
-
-      for ( int i = 0; i < size; ++i ) {
-        QByteArray b( 10, (char)i );
-        data.push_back( b );
-        QCOMPARE( pool.sharedValue( b ), b );
-        QCOMPARE( pool.sharedValue( b ), b );
-      }
-
-      QBENCHMARK {
-        foreach ( const QByteArray &b, data )
-          pool.sharedValue( b );
-      }
-    }*/
+        const int count = qEnvironmentVariableIsSet("AKONADI_SHAREDVALUEPOOL_ITEM_COUNT")
+            ? qEnvironmentVariableIntValue("AKONADI_SHAREDVALUEPOOL_ITEM_COUNT")
+            : 100'000;
+        const QList<QByteArray> flags = {"\\SEEN", "\\ANSWERED", "\\FLAGGED", "$TODO", "$ATTACHMENT", "$SIGNED"};
+
+        for (const bool pooled : {false, true}) {
+            const qint64 heapBefore = heapInUse();
+            const auto items = createItems(count, flags, pooled);
+            const qint64 heapAfter = heapInUse();
+            const auto buffers = distinctFlagBuffers(items);
+
+            if (pooled) {
+                QCOMPARE(buffers, flags.size());
+            } else {
+                QVERIFY(buffers > flags.size());
+            }
+            qDebug() << (pooled ? "Pooled:" : "Unpooled:") << count << "items," << buffers << "distinct flag buffers";
+            if (heapBefore >= 0) {
+                qDebug() << "  heap used by the items:" << (heapAfter - heapBefore) / 1024 << "KiB";
+            }
+        }
+    }
 };
 
 QTEST_MAIN(SharedValuePoolTest)
@@ -38,6 +38,8 @@ private Q_SLOTS:
     void testPartCreateTrxCommit();
     void testPartUpdateTrxCommit();
     void testPartDeleteTrxCommit();
+    void testPartLink();
+    void testPartLinkTrxRollback();
 };
 
 void ExternalPartStorageTest::testResolveAbsolutePath_data()
@@ -299,6 +301,57 @@ void ExternalPartStorageTest::testPartDeleteTrxCommit()
     QVERIFY(!QFile::exists(filePath));
 }
 
+void ExternalPartStorageTest::testPartLink()
+{
+    QByteArray filename;
+    QVERIFY(ExternalPartStorage::self()->createPartFile("blabla", 20, filename));
+    const QString filePath = ExternalPartStorage::resolveAbsolutePath(filename);
+
+    QByteArray linkname;
+    QVERIFY(ExternalPartStorage::self()->createPartFileLink(filename, 21, linkname));
+    QCOMPARE(linkname, QByteArray("21_r0"));
+    const QString linkPath = ExternalPartStorage::resolveAbsolutePath(linkname);
+
+    // The content is kept as long as any of the files exists
+    QVERIFY(ExternalPartStorage::self()->removePartFile(filePath));
+    QFile f(linkPath);
+    QVERIFY(f.open(QIODevice::ReadOnly));
+    QCOMPARE(f.readAll(), QByteArray("blabla"));
+    f.close();
+
+    QVERIFY(ExternalPartStorage::self()->createPartFile("newdata", 22, filename));
+    QByteArray newlinkname;
+    QVERIFY(ExternalPartStorage::self()->updatePartFileLink(filename, linkname, newlinkname));
+    QCOMPARE(newlinkname, QByteArray("21_r1"));
+    QVERIFY(!QFile::exists(linkPath));
+    f.setFileName(ExternalPartStorage::resolveAbsolutePath(newlinkname));
+    QVERIFY(f.open(QIODevice::ReadOnly));
+    QCOMPARE(f.readAll(), QByteArray("newdata"));
+    f.close();
+    QVERIFY(f.remove());
+    QVERIFY(QFile::remove(ExternalPartStorage::resolveAbsolutePath(filename)));
+
+    // Linking to a file that doesn't exist fails
+    QVERIFY(!ExternalPartStorage::self()->createPartFileLink("23_r0", 24, linkname));
+}
+
+void ExternalPartStorageTest::testPartLinkTrxRollback()
+{
+    QByteArray filename;
+    QVERIFY(ExternalPartStorage::self()->createPartFile("blabla", 25, filename));
+    const QString filePath = ExternalPartStorage::resolveAbsolutePath(filename);
+
+    ExternalPartStorageTransaction trx;
+    QByteArray linkname;
+    QVERIFY(ExternalPartStorage::self()->createPartFileLink(filename, 26, linkname));
+    const QString linkPath = ExternalPartStorage::resolveAbsolutePath(linkname);
+    QVERIFY(QFile::exists(linkPath));
+    QVERIFY(trx.rollback());
+    QVERIFY(!QFile::exists(linkPath));
+    QVERIFY(QFile::exists(filePath));
+    QVERIFY(QFile::remove(filePath));
+}
+
 AKTEST_MAIN(ExternalPartStorageTest)
 
 #include "externalpartstoragetest.moc"
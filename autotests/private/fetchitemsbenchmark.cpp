@@ -0,0 +1,122 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "private/datastream_p_p.h"
+#include "private/protocol_p.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTest>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace Akonadi;
+using namespace Akonadi::Protocol;
+
+/**
+  Compares decoding a large item listing into fully materialized
+  FetchItemsResponses with decoding it into an Arena.
+
+  The number of items defaults to 100k and can be changed with the
+  AKONADI_FETCHITEMS_BENCHMARK_COUNT environment variable.
+*/
+class FetchItemsBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    QByteArray mWireData;
+    int mCount = 0;
+
+    static qint64 heapInUse()
+    {
+#if defined(__GLIBC__)
+        return qint64(mallinfo2().uordblks);
+#else
+        return -1;
+#endif
+    }
+
+    // Decodes all responses and accesses the properties ProtocolHelper uses
+    // for an item listing without remote identification
+    void decode(Arena *arena)
+    {
+        QBuffer buffer(&mWireData);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+        QList<CommandPtr> responses;
+        responses.reserve(mCount);
+
+        const qint64 heapBefore = heapInUse();
+        QElapsedTimer timer;
+        timer.start();
+        qint64 chars = 0;
+        for (int i = 0; i < mCount; ++i) {
+            auto cmd = Protocol::deserialize(&buffer, arena);
+            const auto &resp = cmdCast<FetchItemsResponse>(cmd);
+            chars += resp.gid().size() + resp.mimeType().size();
+            responses.push_back(std::move(cmd));
+        }
+        const auto elapsed = timer.elapsed();
+        const qint64 heapAfter = heapInUse();
+
+        QVERIFY(chars > 0);
+        qDebug() << (arena ? "Arena:" : "Eager:") << mCount << "responses in" << elapsed << "ms";
+        if (heapBefore >= 0) {
+            qDebug() << "  heap used by the responses:" << (heapAfter - heapBefore) / 1024 << "KiB";
+        }
+        if (arena) {
+            qDebug() << "  arena chunks allocated:" << arena->allocatedChunks();
+        }
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        mCount = qEnvironmentVariableIsSet("AKONADI_FETCHITEMS_BENCHMARK_COUNT") ? qEnvironmentVariableIntValue("AKONADI_FETCHITEMS_BENCHMARK_COUNT") : 100'000;
+
+        QBuffer buffer(&mWireData);
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        DataStream stream(&buffer);
+        for (int i = 0; i < mCount; ++i) {
+            auto resp = FetchItemsResponsePtr::create(i + 1);
+            resp->setRevision(1);
+            resp->setParentId(42);
+            resp->setRemoteId(QStringLiteral("%1.mbox:2,S").arg(1700000000 + i));
+            resp->setRemoteRevision(QStringLiteral("%1").arg(i));
+            resp->setGid(QStringLiteral("<%1.benchmark@localhost>").arg(i));
+            resp->setMimeType(QStringLiteral("message/rfc822"));
+            resp->setSize(4096);
+            resp->setMTime(QDateTime::currentDateTimeUtc());
+            resp->setFlags({"\\SEEN", "$TODO"});
+            Protocol::serialize(stream, resp);
+        }
+        stream.flush();
+        qDebug() << "Generated" << mCount << "responses," << mWireData.size() / 1024 << "KiB";
+    }
+
+    void benchmarkEager()
+    {
+        QBENCHMARK {
+            decode(nullptr);
+        }
+    }
+
+    void benchmarkArena()
+    {
+        QBENCHMARK {
+            Arena arena;
+            decode(&arena);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(FetchItemsBenchmark)
+
+#include "fetchitemsbenchmark.moc"
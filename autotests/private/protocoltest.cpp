@@ -44,6 +44,8 @@ void ProtocolTest::testFactory_data()
     QTest::newRow("modifyItems resp") << Command::ModifyItems << true << true;
     QTest::newRow("moveItems cmd") << Command::MoveItems << false << true;
     QTest::newRow("moveItems resp") << Command::MoveItems << true << true;
+    QTest::newRow("itemSyncManifest cmd") << Command::ItemSyncManifest << false << true;
+    QTest::newRow("itemSyncManifest resp") << Command::ItemSyncManifest << true << true;
     QTest::newRow("createCollection cmd") << Command::CreateCollection << false << true;
     QTest::newRow("createCollection resp") << Command::CreateCollection << true << true;
     QTest::newRow("copyCollection cmd") << Command::CopyCollection << false << true;
@@ -74,6 +76,8 @@ void ProtocolTest::testFactory_data()
     QTest::newRow("modifyTag resp") << Command::ModifyTag << true << true;
     QTest::newRow("selectResource cmd") << Command::SelectResource << false << true;
     QTest::newRow("selectResource resp") << Command::SelectResource << true << true;
+    QTest::newRow("preprocessItems cmd") << Command::PreprocessItems << false << true;
+    QTest::newRow("preprocessItems resp") << Command::PreprocessItems << true << true;
     QTest::newRow("streamPayload cmd") << Command::StreamPayload << false << true;
     QTest::newRow("streamPayload resp") << Command::StreamPayload << true << true;
     QTest::newRow("itemChangeNotification cmd") << Command::ItemChangeNotification << false << true;
@@ -448,6 +452,7 @@ void ProtocolTest::testLoginResponse()
     QVERIFY(in.isResponse());
     QVERIFY(in.isValid());
     QVERIFY(!in.isError());
+    in.setMaxInlinePartSize(65536);
     in.setError(42, QStringLiteral("Ooops"));
 
     const auto out = serializeAndDeserialize(LoginResponsePtr::create(in));
@@ -456,6 +461,7 @@ void ProtocolTest::testLoginResponse()
     QVERIFY(out->isError());
     QCOMPARE(out->errorCode(), 42);
     QCOMPARE(out->errorMessage(), QStringLiteral("Ooops"));
+    QCOMPARE(out->maxInlinePartSize(), 65536);
     QCOMPARE(*out, in);
     const bool notEquals = (*out != in);
     QVERIFY(!notEquals);
@@ -535,6 +541,7 @@ void ProtocolTest::testCreateItemCommand()
     Scope removedTags(QList<qint64>{5, 6});
     Attributes attrs{{"ATTR1", "MyAttr"}, {"ATTR2", "Můj chlupaťoučký kůň"}};
     QSet<QByteArray> parts{"PLD:HEAD", "PLD:ENVELOPE"};
+    QList<StreamPayloadResponse> inlineParts{StreamPayloadResponse("PLD:HEAD", PartMetaData("PLD:HEAD", 4, 1), "head")};
 
     CreateItemCommand in;
     QVERIFY(!in.isResponse());
@@ -557,6 +564,7 @@ void ProtocolTest::testCreateItemCommand()
     in.setRemovedTags(removedTags);
     in.setAttributes(attrs);
     in.setParts(parts);
+    in.setInlineParts(inlineParts);
 
     const auto out = serializeAndDeserialize(CreateItemCommandPtr::create(in));
     QVERIFY(out->isValid());
@@ -580,6 +588,7 @@ void ProtocolTest::testCreateItemCommand()
     QCOMPARE(out->removedTags(), removedTags);
     QCOMPARE(out->attributes(), attrs);
     QCOMPARE(out->parts(), parts);
+    QCOMPARE(out->inlineParts(), inlineParts);
     QCOMPARE(*out, in);
     const bool notEquals = (*out != in);
     QVERIFY(!notEquals);
@@ -643,6 +652,54 @@ void ProtocolTest::testCopyItemsResponse()
     QVERIFY(!notEquals);
 }
 
+void ProtocolTest::testFetchItemsResponseArena()
+{
+    QList<FetchItemsResponsePtr> in;
+    for (int i = 0; i < 100; ++i) {
+        auto resp = FetchItemsResponsePtr::create(i);
+        resp->setRemoteId(QStringLiteral("rid%1").arg(i));
+        resp->setRemoteRevision(i % 2 ? QString() : QStringLiteral(""));
+        resp->setGid(QString(100 + i, u'g'));
+        resp->setMimeType(QStringLiteral("message/rfc822"));
+        resp->setFlags({"\\SEEN"});
+        in.push_back(resp);
+    }
+
+    QBuffer buf;
+    buf.open(QIODevice::ReadWrite);
+    DataStream stream(&buf);
+    for (const auto &resp : std::as_const(in)) {
+        Protocol::serialize(stream, resp);
+    }
+    stream.flush();
+    buf.seek(0);
+
+    // Small chunks to force objects being moved into a new chunk
+    Arena arena(1024);
+    QList<FetchItemsResponsePtr> out;
+    for (int i = 0; i < in.size(); ++i) {
+        out.push_back(Protocol::deserialize(&buf, &arena).staticCast<FetchItemsResponse>());
+    }
+    QVERIFY(arena.allocatedChunks() > 1);
+
+    for (int i = 0; i < in.size(); ++i) {
+        QCOMPARE(out[i]->id(), in[i]->id());
+        QCOMPARE(out[i]->remoteId(), in[i]->remoteId());
+        QCOMPARE(out[i]->remoteRevision(), in[i]->remoteRevision());
+        QCOMPARE(out[i]->remoteRevision().isNull(), in[i]->remoteRevision().isNull());
+        QCOMPARE(out[i]->gid(), in[i]->gid());
+        QCOMPARE(out[i]->mimeType(), in[i]->mimeType());
+        QCOMPARE(*out[i], *in[i]);
+    }
+
+    // Copies keep the values alive, setters override the lazy value
+    FetchItemsResponse copy = *out.first();
+    out.clear();
+    QCOMPARE(copy.remoteId(), QStringLiteral("rid0"));
+    copy.setRemoteId(QStringLiteral("changed"));
+    QCOMPARE(copy.remoteId(), QStringLiteral("changed"));
+}
+
 QTEST_MAIN(ProtocolTest)
 
 #include "moc_protocoltest.cpp"
@@ -45,6 +45,7 @@ private Q_SLOTS:
     void testCreateItemResponse();
     void testCopyItemsCommand();
     void testCopyItemsResponse();
+    void testFetchItemsResponseArena();
 
 private:
     template<typename T>
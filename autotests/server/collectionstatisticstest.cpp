@@ -101,6 +101,30 @@ private Q_SLOTS:
         QCOMPARE(stats.size, size);
     }
 
+    void testDeferredPrefetch()
+    {
+        dbInitializer->cleanup();
+        dbInitializer->createResource("testresource");
+        auto col1 = dbInitializer->createCollection("col1");
+        dbInitializer->createItem("item1", col1);
+        dbInitializer->createItem("item2", col1);
+        auto col2 = dbInitializer->createCollection("col2");
+        dbInitializer->createItem("item3", col2);
+
+        IntrospectableCollectionStatistics cs(false);
+        cs.itemAdded(col2, 0, false);
+        QCOMPARE(cs.calculationsCount(), 1);
+
+        cs.prefetch();
+        auto stats = cs.statistics(col1);
+        QCOMPARE(cs.calculationsCount(), 1);
+        QCOMPARE(stats.count, 2);
+        // Already cached before the prefetch
+        stats = cs.statistics(col2);
+        QCOMPARE(cs.calculationsCount(), 1);
+        QCOMPARE(stats.count, 1);
+    }
+
     void testCalculateStats()
     {
         dbInitializer->cleanup();
@@ -177,6 +201,40 @@ private Q_SLOTS:
         QCOMPARE(stats.read, 1);
         QCOMPARE(stats.size, 8);
     }
+
+    void testItemsMoved()
+    {
+        dbInitializer->cleanup();
+        dbInitializer->createResource("testresource");
+        auto source = dbInitializer->createCollection("col1");
+        auto destination = dbInitializer->createCollection("col2");
+        dbInitializer->createItem("item1", source);
+        dbInitializer->createItem("item2", source);
+
+        IntrospectableCollectionStatistics cs(false);
+        QCOMPARE(cs.statistics(source).count, 2);
+        QCOMPARE(cs.calculationsCount(), 1);
+
+        // Until the move is committed, the statistics of the destination are not cached
+        cs.beginItemsMove(source, destination);
+        QCOMPARE(cs.statistics(destination).count, 0);
+        QCOMPARE(cs.statistics(destination).count, 0);
+        QCOMPARE(cs.calculationsCount(), 3);
+
+        cs.itemsMoved(source, destination, {1, 0, 0});
+        QCOMPARE(cs.statistics(source).count, 1);
+        QCOMPARE(cs.calculationsCount(), 3);
+        QCOMPARE(cs.statistics(destination).count, 0);
+        QCOMPARE(cs.statistics(destination).count, 0);
+        QCOMPARE(cs.calculationsCount(), 4);
+
+        // A move which is rolled back leaves the statistics untouched
+        cs.beginItemsMove(source, destination);
+        cs.itemsMoveAborted(source, destination);
+        QCOMPARE(cs.statistics(source).count, 1);
+        QCOMPARE(cs.statistics(destination).count, 0);
+        QCOMPARE(cs.calculationsCount(), 4);
+    }
 };
 
 AKTEST_MAIN(CollectionStatisticsTest)
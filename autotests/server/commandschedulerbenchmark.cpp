@@ -0,0 +1,274 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "aktest.h"
+#include "commandscheduler.h"
+#include "entities.h"
+#include "fakeakonadiserver.h"
+#include "storage/datastore.h"
+#include "storage/querybuilder.h"
+
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QTest>
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+namespace
+{
+struct RunStats {
+    qint64 commands = 0;
+    qint64 failed = 0;
+    int peakRunning = 0;
+    int peakOpenDbConnections = 0;
+    qint64 elapsed = 0;
+};
+
+void updatePeak(std::atomic_int &peak, int value)
+{
+    int current = peak.load();
+    while (value > current && !peak.compare_exchange_weak(current, value)) { }
+}
+
+// Simulates the command loop of a Connection: every command runs a query in an execution slot,
+// the database connection is kept open between commands until the scheduler evicts it
+RunStats runClients(CommandScheduler &scheduler, int clients, int commandsPerClient)
+{
+    std::atomic_int running = 0;
+    std::atomic_int openDbConnections = 0;
+    std::atomic_int peakRunning = 0;
+    std::atomic_int peakOpenDbConnections = 0;
+    std::atomic<qint64> commands = 0;
+    std::atomic<qint64> failed = 0;
+
+    std::vector<std::unique_ptr<QThread>> threads;
+    threads.reserve(clients);
+    for (int client = 0; client < clients; ++client) {
+        threads.emplace_back(QThread::create([&]() {
+            bool dbOpen = false;
+            bool idle = false;
+            // A Connection closes its evicted database connection while idle, count it as closed right away
+            std::atomic_bool evicted = false;
+            for (int i = 0; i < commandsPerClient; ++i) {
+                if (std::exchange(idle, false)) {
+                    scheduler.releaseIdleDbConnection(&evicted);
+                }
+                if (evicted.exchange(false)) {
+                    DataStore::self()->close();
+                    dbOpen = false;
+                }
+                scheduler.beginCommand();
+                updatePeak(peakRunning, ++running);
+
+                auto *store = DataStore::self();
+                if (!store->isOpened()) {
+                    store->open();
+                }
+                if (!dbOpen) {
+                    dbOpen = true;
+                    updatePeak(peakOpenDbConnections, ++openDbConnections);
+                }
+
+                QueryBuilder qb(PimItem::tableName());
+                qb.addAggregation(PimItem::idColumn(), QStringLiteral("count"));
+                if (qb.exec() && qb.query().next()) {
+                    ++commands;
+                } else {
+                    ++failed;
+                }
+                qb.query().finish();
+
+                --running;
+                scheduler.endCommand();
+
+                idle = true;
+                scheduler.keepIdleDbConnection(&evicted, [&]() {
+                    evicted = true;
+                    --openDbConnections;
+                });
+            }
+            if (idle) {
+                scheduler.releaseIdleDbConnection(&evicted);
+            }
+            if (dbOpen && !evicted) {
+                --openDbConnections;
+            }
+            DataStore::self()->close();
+        }));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (const auto &thread : threads) {
+        thread->start();
+    }
+    for (const auto &thread : threads) {
+        thread->wait();
+    }
+
+    RunStats stats;
+    stats.elapsed = timer.elapsed();
+    stats.commands = commands;
+    stats.failed = failed;
+    stats.peakRunning = peakRunning;
+    stats.peakOpenDbConnections = peakOpenDbConnections;
+    return stats;
+}
+
+} // namespace
+
+class CommandSchedulerBenchmark : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    CommandSchedulerBenchmark()
+    {
+        mAkonadi.init();
+    }
+
+private Q_SLOTS:
+    void testLimits()
+    {
+        CommandScheduler scheduler(4, 2);
+        const auto stats = runClients(scheduler, 16, 50);
+
+        QCOMPARE(stats.failed, qint64(0));
+        QCOMPARE(stats.commands, qint64(16 * 50));
+        QVERIFY(stats.peakRunning <= 4);
+        // Every running command and every idle connection hold at most one database connection
+        QVERIFY(stats.peakOpenDbConnections <= 4 + 2);
+        QCOMPARE(scheduler.runningCommands(), 0);
+        QCOMPARE(scheduler.idleDbConnections(), 0);
+    }
+
+    void testYield()
+    {
+        // A command waiting for another session must not block it with a single slot
+        CommandScheduler scheduler(1, 0);
+        QSemaphore waiting;
+        QSemaphore delivered;
+
+        std::unique_ptr<QThread> waiter(QThread::create([&]() {
+            scheduler.beginCommand();
+            {
+                CommandScheduler::Yield yield;
+                waiting.release();
+                delivered.acquire();
+            }
+            scheduler.endCommand();
+        }));
+        std::unique_ptr<QThread> deliverer(QThread::create([&]() {
+            waiting.acquire();
+            scheduler.beginCommand();
+            delivered.release();
+            scheduler.endCommand();
+        }));
+
+        waiter->start();
+        deliverer->start();
+        QVERIFY(deliverer->wait(10000));
+        QVERIFY(waiter->wait(10000));
+        QCOMPARE(scheduler.runningCommands(), 0);
+    }
+
+    void testTransaction()
+    {
+        // The session holds database locks which the commands in all slots are waiting for
+        constexpr int Slots = 4;
+        CommandScheduler scheduler(Slots, 0);
+        QSemaphore dbLock(1);
+        QSemaphore waitingForLock;
+
+        // The first command of the session begins the transaction
+        scheduler.beginCommand();
+        dbLock.acquire();
+        scheduler.endCommand();
+
+        std::vector<std::unique_ptr<QThread>> clients;
+        for (int i = 0; i < Slots; ++i) {
+            clients.emplace_back(QThread::create([&]() {
+                scheduler.beginCommand();
+                waitingForLock.release();
+                dbLock.acquire();
+                dbLock.release();
+                scheduler.endCommand();
+            }));
+            clients.back()->start();
+        }
+        QVERIFY(waitingForLock.tryAcquire(Slots, 10000));
+        QCOMPARE(scheduler.runningCommands(), Slots);
+
+        // The next command of the session commits the transaction, it must not wait for a slot
+        std::unique_ptr<QThread> session(QThread::create([&]() {
+            scheduler.beginCommand(true);
+            dbLock.release();
+            scheduler.endCommand();
+        }));
+        session->start();
+        QVERIFY(session->wait(10000));
+        for (const auto &client : clients) {
+            QVERIFY(client->wait(10000));
+        }
+        QCOMPARE(scheduler.runningCommands(), 0);
+    }
+
+    void testYieldWithoutSlot()
+    {
+        // Threads which do not execute a command, e.g. service threads, are not affected
+        CommandScheduler scheduler(1, 0);
+        {
+            CommandScheduler::Yield yield;
+        }
+        QCOMPARE(scheduler.runningCommands(), 0);
+    }
+
+    void benchmarkClients_data()
+    {
+        QTest::addColumn<int>("clients");
+        QTest::addColumn<int>("maxRunningCommands");
+
+        const int maxRunningCommands = CommandScheduler::defaultMaxRunningCommands();
+        for (int clients : {1, 8, 32, 64}) {
+            QTest::addRow("%d clients, unlimited", clients) << clients << 0;
+            QTest::addRow("%d clients, %d slots", clients, maxRunningCommands) << clients << maxRunningCommands;
+        }
+    }
+
+    void benchmarkClients()
+    {
+        QFETCH(int, clients);
+        QFETCH(int, maxRunningCommands);
+
+        CommandScheduler scheduler(maxRunningCommands, maxRunningCommands > 0 ? CommandScheduler::defaultMaxIdleDbConnections() : 0);
+        constexpr int commandsPerClient = 200;
+        RunStats stats;
+        QBENCHMARK_ONCE {
+            stats = runClients(scheduler, clients, commandsPerClient);
+        }
+        QCOMPARE(stats.failed, qint64(0));
+        QCOMPARE(stats.commands, qint64(clients) * commandsPerClient);
+
+        qDebug() << clients << "clients:" << stats.commands << "commands in" << stats.elapsed << "ms,"
+                 << (stats.elapsed > 0 ? stats.commands * 1000 / stats.elapsed : stats.commands) << "commands/s, peak" << stats.peakRunning
+                 << "running commands and" << stats.peakOpenDbConnections << "database connections";
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(CommandSchedulerBenchmark)
+
+#include "commandschedulerbenchmark.moc"
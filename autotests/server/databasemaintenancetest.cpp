@@ -0,0 +1,100 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "commandscheduler.h"
+#include "databasemaintenance.h"
+#include "fakeakonadiserver.h"
+#include "shared/aktest.h"
+#include "storage/datastore.h"
+#include "storage/dbtype.h"
+
+#include <QTest>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+using namespace std::chrono_literals;
+
+class DatabaseMaintenanceTest : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    DatabaseMaintenanceTest()
+    {
+        mAkonadi.init();
+    }
+
+private Q_SLOTS:
+    void testRunAllSteps()
+    {
+        const auto results = DatabaseMaintenance::runAllSteps(5s);
+
+        QStringList names;
+        for (const auto &result : results) {
+            QVERIFY2(result.success, qPrintable(result.name));
+            QVERIFY(result.duration >= 0ms);
+            names.push_back(result.name);
+        }
+        switch (DbType::type(DataStore::self()->database())) {
+        case DbType::Sqlite:
+            QCOMPARE(names, (QStringList{QStringLiteral("incremental vacuum"), QStringLiteral("optimize"), QStringLiteral("WAL checkpoint")}));
+            break;
+        case DbType::MySQL:
+        case DbType::PostgreSQL:
+            QCOMPARE(names, QStringList{QStringLiteral("analyze")});
+            break;
+        case DbType::Unknown:
+            QVERIFY(names.isEmpty());
+            break;
+        }
+    }
+
+    void testStepTimeLimit()
+    {
+        // Steps which have run out of time skip their remaining statements, but do not fail
+        const auto results = DatabaseMaintenance::runAllSteps(0ms);
+        for (const auto &result : results) {
+            QVERIFY2(result.success, qPrintable(result.name));
+            if (result.name == QLatin1StringView("optimize") || result.name == QLatin1StringView("analyze")) {
+                QVERIFY2(result.details.startsWith(QLatin1StringView("executed 0 of")) || result.details.startsWith(QLatin1StringView("analyzed 0 of")),
+                         qPrintable(result.details));
+            }
+        }
+    }
+
+    void testAnalyzeUnchangedTables()
+    {
+        if (DbType::type(DataStore::self()->database()) != DbType::MySQL) {
+            QSKIP("Only MySQL skips the tables which have not changed");
+        }
+
+        DatabaseMaintenance::runAllSteps(5s);
+        const auto results = DatabaseMaintenance::runAllSteps(5s);
+        QCOMPARE(results.size(), 1);
+        QVERIFY(results[0].success);
+        QCOMPARE(results[0].details, QStringLiteral("analyzed 0 of 0 changed tables"));
+    }
+
+    void testIdleTime()
+    {
+        CommandScheduler scheduler(1, 1);
+        scheduler.beginCommand();
+        QCOMPARE(scheduler.idleTime(), 0ms);
+        QTest::qWait(20);
+        QCOMPARE(scheduler.idleTime(), 0ms);
+        scheduler.endCommand();
+        QTest::qWait(20);
+        QVERIFY(scheduler.idleTime() >= 20ms);
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(DatabaseMaintenanceTest)
+
+#include "databasemaintenancetest.moc"
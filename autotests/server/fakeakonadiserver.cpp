@@ -7,6 +7,8 @@
 
 #include "fakeakonadiserver.h"
 #include "cachecleaner.h"
+#include "commandscheduler.h"
+#include "databasemaintenance.h"
 #include "debuginterface.h"
 #include "fakeclient.h"
 #include "fakeconnection.h"
@@ -15,9 +17,13 @@
 #include "fakeitemretrievalmanager.h"
 #include "fakesearchmanager.h"
 #include "inspectablenotificationcollector.h"
+#include "partfilereclaimer.h"
+#include "protocolcapturewriter.h"
 #include "resourcemanager.h"
 #include "search/searchtaskmanager.h"
 #include "storage/collectionstatistics.h"
+#include "storage/itemmergeindex.h"
+#include "storage/partstreamer.h"
 #include "storagejanitor.h"
 
 #include <QBuffer>
@@ -126,10 +132,12 @@ TestScenario::List FakeAkonadiServer::loginScenario(const QByteArray &sessionId)
     hello->setMessage(QStringLiteral("Not Really IMAP server"));
     hello->setProtocolVersion(Protocol::version());
     hello->setGeneration(schema.generation());
+    auto login = Protocol::LoginResponsePtr::create();
+    login->setMaxInlinePartSize(PartStreamer::MaxInlinePartSize);
 
     return {TestScenario::create(0, TestScenario::ServerCmd, hello),
             TestScenario::create(1, TestScenario::ClientCmd, Protocol::LoginCommandPtr::create(sessionId.isEmpty() ? instanceName().toLatin1() : sessionId)),
-            TestScenario::create(1, TestScenario::ServerCmd, Protocol::LoginResponsePtr::create())};
+            TestScenario::create(1, TestScenario::ServerCmd, login)};
 }
 
 TestScenario::List FakeAkonadiServer::selectResourceScenario(const QString &name)
@@ -203,18 +211,23 @@ void FakeAkonadiServer::initFake()
     }
 
     mTracer = std::make_unique<Tracer>();
+    mProtocolCapture = std::make_unique<ProtocolCaptureWriter>();
     mCollectionStats = std::make_unique<CollectionStatistics>();
+    mItemMergeIndex = std::make_unique<ItemMergeIndex>();
+    mCommandScheduler = std::make_unique<CommandScheduler>();
     mCacheCleaner = AkThread::create<CacheCleaner>();
     mItemRetrieval = AkThread::create<FakeItemRetrievalManager>();
     mAgentSearchManager = AkThread::create<SearchTaskManager>();
 
-    mDebugInterface = std::make_unique<DebugInterface>(*mTracer);
+    mDebugInterface = std::make_unique<DebugInterface>(*mTracer, *mProtocolCapture);
     mResourceManager = std::make_unique<ResourceManager>(*mTracer);
     mPreprocessorManager = std::make_unique<PreprocessorManager>(*mTracer);
     mPreprocessorManager->setEnabled(false);
     mIntervalCheck = AkThread::create<FakeIntervalCheck>(*mItemRetrieval);
     mSearchManager = AkThread::create<FakeSearchManager>(*mAgentSearchManager);
     mStorageJanitor = AkThread::create<StorageJanitor>(this);
+    mPartFileReclaimer = AkThread::create<PartFileReclaimer>();
+    mDatabaseMaintenance = AkThread::create<DatabaseMaintenance>(*mCommandScheduler);
 
     qDebug() << "==== Fake Akonadi Server started ====";
 }
@@ -238,6 +251,8 @@ bool FakeAkonadiServer::quit()
     mConnection.reset();
     mClient.reset();
 
+    mDatabaseMaintenance.reset();
+    mPartFileReclaimer.reset();
     mStorageJanitor.reset();
     mSearchManager.reset();
     mIntervalCheck.reset();
@@ -248,7 +263,10 @@ bool FakeAkonadiServer::quit()
     mAgentSearchManager.reset();
     mItemRetrieval.reset();
     mCacheCleaner.reset();
+    mCommandScheduler.reset();
+    mItemMergeIndex.reset();
     mCollectionStats.reset();
+    mProtocolCapture.reset();
     mTracer.reset();
 
     if (mDataStore) {
@@ -186,10 +186,10 @@ bool FakeDataStore::unhidePimItem(PimItem &pimItem)
     return DataStore::unhidePimItem(pimItem);
 }
 
-bool FakeDataStore::unhideAllPimItems()
+bool FakeDataStore::unhideAllPimItems(PimItem::Id maxItemId)
 {
-    mChanges.insert(QStringLiteral("unhideAllPimItems"), QVariantList());
-    return DataStore::unhideAllPimItems();
+    mChanges.insert(QStringLiteral("unhideAllPimItems"), QVariantList() << maxItemId);
+    return DataStore::unhideAllPimItems(maxItemId);
 }
 
 bool FakeDataStore::addCollectionAttribute(const Collection &col, const QByteArray &key, const QByteArray &value, bool silent)
@@ -93,7 +93,7 @@ public:
     bool cleanupPimItems(const PimItem::List &items, bool silent = false) override;
 
     bool unhidePimItem(PimItem &pimItem) override;
-    bool unhideAllPimItems() override;
+    bool unhideAllPimItems(PimItem::Id maxItemId = -1) override;
 
     bool addCollectionAttribute(const Collection &col, const QByteArray &key, const QByteArray &value, bool silent = false) override;
     bool removeCollectionAttribute(const Collection &col, const QByteArray &key) override;
@@ -42,7 +42,12 @@ void FakeSearchManager::updateSearchAsync(const Collection &collection)
 
 QList<Akonadi::AbstractSearchPlugin *> FakeSearchManager::searchPlugins() const
 {
-    return QList<Akonadi::AbstractSearchPlugin *>();
+    return mSearchPlugins;
+}
+
+void FakeSearchManager::setSearchPlugins(const QList<AbstractSearchPlugin *> &plugins)
+{
+    mSearchPlugins = plugins;
 }
 
 void FakeSearchManager::scheduleSearchUpdate()
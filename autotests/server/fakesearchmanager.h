@@ -31,8 +31,12 @@ public:
     void updateSearch(const Collection &collection) override;
     void updateSearchAsync(const Collection &collection) override;
     QList<AbstractSearchPlugin *> searchPlugins() const override;
+    void setSearchPlugins(const QList<AbstractSearchPlugin *> &plugins);
 
     void scheduleSearchUpdate() override;
+
+private:
+    QList<AbstractSearchPlugin *> mSearchPlugins;
 };
 
 } // namespace Server
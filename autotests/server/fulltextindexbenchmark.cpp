@@ -0,0 +1,344 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "aktest.h"
+#include "search/fulltextindex.h"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+namespace
+{
+// SearchTerm::Condition and SearchTerm::Relation
+constexpr int CondEqual = 0;
+constexpr int CondGreaterThan = 1;
+constexpr int CondContains = 5;
+constexpr int RelAnd = 0;
+constexpr int RelOr = 1;
+
+constexpr int Collections = 10;
+
+QJsonObject term(const QString &key, const QString &value, int cond = CondContains, bool negated = false)
+{
+    return QJsonObject{{QStringLiteral("key"), key}, {QStringLiteral("value"), value}, {QStringLiteral("cond"), cond}, {QStringLiteral("negated"), negated}};
+}
+
+QJsonObject group(int rel, const QJsonArray &subTerms, bool negated = false)
+{
+    return QJsonObject{{QStringLiteral("rel"), rel}, {QStringLiteral("subTerms"), subTerms}, {QStringLiteral("negated"), negated}};
+}
+
+QString query(QJsonObject root, int limit = -1)
+{
+    root.insert(QStringLiteral("limit"), limit);
+    return QString::fromUtf8(QJsonDocument(root).toJson(QJsonDocument::Compact));
+}
+
+/// Every second message is from Alice, every third is a quarterly report, every fifth mentions the budget
+QByteArray message(qint64 id)
+{
+    QByteArray msg;
+    msg += "From: " + QByteArray(id % 2 == 0 ? "Alice <alice@example.org>" : "Bob <bob@example.org>") + "\r\n";
+    msg += "To: team" + QByteArray::number(id % 7) + "@example.org\r\n";
+    msg += "Subject: " + QByteArray(id % 3 == 0 ? "Quarterly report " : "Status update ") + QByteArray::number(id) + "\r\n";
+    msg += "Content-Type: text/plain; charset=utf-8\r\n\r\n";
+    for (int line = 0; line < 20; ++line) {
+        msg += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore.\r\n";
+    }
+    if (id % 5 == 0) {
+        msg += "Please review the budget before Friday.\r\n";
+    }
+    return msg;
+}
+
+QList<FullTextIndex::Document> documents(qint64 first, qint64 count)
+{
+    QList<FullTextIndex::Document> result;
+    result.reserve(count);
+    for (qint64 id = first; id < first + count; ++id) {
+        auto document = FullTextIndex::documentFromMessage(message(id));
+        document.id = id;
+        document.collectionId = id % Collections;
+        document.mimeType = QStringLiteral("message/rfc822");
+        result.push_back(std::move(document));
+    }
+    return result;
+}
+
+} // namespace
+
+class FullTextIndexBenchmark : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir mDir;
+
+    std::unique_ptr<FullTextIndex> createIndex(const QString &name)
+    {
+        auto index = std::make_unique<FullTextIndex>(mDir.filePath(name));
+        if (!index->open()) {
+            return {};
+        }
+        return index;
+    }
+
+private Q_SLOTS:
+    void testDocumentFromMessage()
+    {
+        const QByteArray msg =
+            "From: =?UTF-8?Q?J=C3=BCrgen_M=C3=BCller?= <juergen@example.org>\r\n"
+            "To: alice@example.org,\r\n"
+            " bob@example.org\r\n"
+            "Cc: carol@example.org\r\n"
+            "Subject: =?UTF-8?B?U2Now7ZuZXM=?= =?UTF-8?Q?_Wochenende?=\r\n"
+            "MIME-Version: 1.0\r\n"
+            "Content-Type: multipart/mixed; boundary=\"outer\"\r\n"
+            "\r\n"
+            "This is a multi-part message in MIME format.\r\n"
+            "--outer\r\n"
+            "Content-Type: multipart/alternative; boundary=inner\r\n"
+            "\r\n"
+            "--inner\r\n"
+            "Content-Type: text/plain; charset=utf-8\r\n"
+            "Content-Transfer-Encoding: quoted-printable\r\n"
+            "\r\n"
+            "Gr=C3=BC=C3=9Fe aus dem Urlaub, das Wetter ist =\r\n"
+            "wunderbar.\r\n"
+            "--inner\r\n"
+            "Content-Type: text/html; charset=utf-8\r\n"
+            "\r\n"
+            "<html><style>p { color: red; }</style><p>Sonnenschein &amp; Strand</p></html>\r\n"
+            "--inner--\r\n"
+            "--outer\r\n"
+            "Content-Type: text/plain\r\n"
+            "Content-Disposition: attachment; filename=notes.txt\r\n"
+            "\r\n"
+            "secret attachment\r\n"
+            "--outer\r\n"
+            "Content-Type: image/png\r\n"
+            "Content-Transfer-Encoding: base64\r\n"
+            "\r\n"
+            "iVBORw0KGgo=\r\n"
+            "--outer--\r\n";
+
+        const auto document = FullTextIndex::documentFromMessage(msg);
+        QCOMPARE(document.sender, QStringLiteral("Jürgen Müller <juergen@example.org>"));
+        QCOMPARE(document.recipients, QStringLiteral("alice@example.org, bob@example.org\ncarol@example.org"));
+        QCOMPARE(document.subject, QStringLiteral("Schönes Wochenende"));
+        QVERIFY2(document.body.contains(QStringLiteral("Grüße aus dem Urlaub, das Wetter ist wunderbar.")), qPrintable(document.body));
+        QVERIFY2(document.body.contains(QLatin1StringView("Sonnenschein & Strand")), qPrintable(document.body));
+        QVERIFY(!document.body.contains(QLatin1StringView("color")));
+        QVERIFY(!document.body.contains(QLatin1StringView("secret attachment")));
+        QVERIFY(!document.body.contains(QLatin1StringView("iVBORw0KGgo")));
+    }
+
+    void testSearch()
+    {
+        auto index = createIndex(QStringLiteral("search.db"));
+        if (!index) {
+            QSKIP("SQLite was built without FTS5");
+        }
+        QVERIFY(index->addDocuments(documents(1, 60)));
+        QCOMPARE(index->documentCount(), qint64(60));
+
+        const auto ids = [](qint64 divisor, qint64 count = 60) {
+            QSet<qint64> result;
+            for (qint64 id = 1; id <= count; ++id) {
+                if (id % divisor == 0) {
+                    result.insert(id);
+                }
+            }
+            return result;
+        };
+
+        // Column filters
+        QCOMPARE(index->search(query(term(QStringLiteral("subject"), QStringLiteral("quarterly"))), {}, {}), ids(3));
+        QCOMPARE(index->search(query(term(QStringLiteral("body"), QStringLiteral("quarterly"))), {}, {}), QSet<qint64>{});
+        QCOMPARE(index->search(query(term(QStringLiteral("from"), QStringLiteral("alice@example.org"), CondEqual)), {}, {}), ids(2));
+        QCOMPARE(index->search(query(term(QStringLiteral("to"), QStringLiteral("alice"))), {}, {}), QSet<qint64>{});
+        QCOMPARE(index->search(query(term(QStringLiteral("message"), QStringLiteral("budg"))), {}, {}), ids(5));
+        // Phrases
+        QCOMPARE(index->search(query(term(QStringLiteral("body"), QStringLiteral("review the budget"), CondEqual)), {}, {}), ids(5));
+        QCOMPARE(index->search(query(term(QStringLiteral("body"), QStringLiteral("budget the review"), CondEqual)), {}, {}), QSet<qint64>{});
+
+        // Groups
+        QCOMPARE(index->search(query(group(RelAnd,
+                                           {term(QStringLiteral("subject"), QStringLiteral("quarterly")),
+                                            term(QStringLiteral("body"), QStringLiteral("budget"))})),
+                               {},
+                               {}),
+                 ids(15));
+        QCOMPARE(index->search(query(group(RelOr,
+                                           {term(QStringLiteral("subject"), QStringLiteral("quarterly")),
+                                            term(QStringLiteral("body"), QStringLiteral("budget"))})),
+                               {},
+                               {}),
+                 ids(3) | ids(5));
+        QCOMPARE(index->search(query(group(RelAnd,
+                                           {term(QStringLiteral("subject"), QStringLiteral("quarterly")),
+                                            term(QStringLiteral("from"), QStringLiteral("alice"), CondContains, true)})),
+                               {},
+                               {}),
+                 ids(3) - ids(2));
+
+        // Terms which cannot be answered from the index make the whole query unanswerable, the
+        // results would otherwise include items which do not match the term
+        const auto sizeTerm = term(QStringLiteral("size"), QStringLiteral("1000"), CondGreaterThan);
+        const auto dateTerm = term(QStringLiteral("date"), QStringLiteral("2026-01-01"), CondGreaterThan);
+        QCOMPARE(index->search(query(group(RelAnd, {term(QStringLiteral("subject"), QStringLiteral("quarterly")), sizeTerm})), {}, {}), QSet<qint64>{});
+        QCOMPARE(index->search(query(group(RelOr, {term(QStringLiteral("subject"), QStringLiteral("quarterly")), sizeTerm})), {}, {}), QSet<qint64>{});
+        QCOMPARE(index->search(query(group(RelAnd, {sizeTerm})), {}, {}), QSet<qint64>{});
+        QCOMPARE(index->search(query(group(RelAnd,
+                                           {term(QStringLiteral("subject"), QStringLiteral("quarterly")),
+                                            group(RelAnd, {term(QStringLiteral("body"), QStringLiteral("budget")), dateTerm})})),
+                               {},
+                               {}),
+                 QSet<qint64>{});
+        QCOMPARE(index->search(query(group(RelAnd, {term(QStringLiteral("subject"), QStringLiteral("quarterly")), dateTerm}, true)), {}, {}), QSet<qint64>{});
+
+        // Filters and limit
+        QCOMPARE(index->search(query(term(QStringLiteral("subject"), QStringLiteral("quarterly"))), {0}, {}), ids(30));
+        QCOMPARE(index->search(query(term(QStringLiteral("subject"), QStringLiteral("quarterly"))), {}, {QStringLiteral("text/directory")}), QSet<qint64>{});
+        QCOMPARE(index->search(query(term(QStringLiteral("subject"), QStringLiteral("quarterly")), 5), {}, {}).size(), 5);
+
+        // Ranked and streamed results
+        QList<AbstractSearchPlugin::SearchResult> ranked;
+        QVERIFY(index->search(query(group(RelOr,
+                                          {term(QStringLiteral("subject"), QStringLiteral("quarterly")),
+                                           term(QStringLiteral("body"), QStringLiteral("budget"))})),
+                              {},
+                              {},
+                              -1,
+                              [&](const QList<AbstractSearchPlugin::SearchResult> &results) {
+                                  ranked += results;
+                                  return true;
+                              }));
+        QCOMPARE(ranked.size(), (ids(3) | ids(5)).size());
+        for (qsizetype i = 1; i < ranked.size(); ++i) {
+            QVERIFY(ranked[i - 1].score >= ranked[i].score);
+        }
+        // Matching both terms is more relevant than matching one of them
+        QVERIFY(ids(15).contains(ranked.first().id));
+        QVERIFY(ranked.last().score > 0);
+
+        ranked.clear();
+        const auto cancel = [&](const QList<AbstractSearchPlugin::SearchResult> &results) {
+            ranked += results;
+            return false;
+        };
+        QVERIFY(!index->search(query(term(QStringLiteral("body"), QStringLiteral("lorem"))), {}, {}, 10, cancel));
+        QCOMPARE(ranked.size(), 10);
+
+        // Moved and removed documents
+        QVERIFY(index->moveDocuments({3, 6}, 42));
+        QCOMPARE(index->search(query(term(QStringLiteral("subject"), QStringLiteral("quarterly"))), {42}, {}), (QSet<qint64>{3, 6}));
+        QVERIFY(index->removeDocuments({3}));
+        QCOMPARE(index->search(query(term(QStringLiteral("subject"), QStringLiteral("quarterly"))), {42}, {}), QSet<qint64>{6});
+        QCOMPARE(index->documentCount(), qint64(59));
+    }
+
+    void benchmarkIndexing_data()
+    {
+        QTest::addColumn<int>("count");
+        for (int count : {1000, 10000, 50000}) {
+            QTest::addRow("%d items", count) << count;
+        }
+    }
+
+    void benchmarkIndexing()
+    {
+        QFETCH(int, count);
+
+        auto index = createIndex(QStringLiteral("indexing-%1.db").arg(count));
+        if (!index) {
+            QSKIP("SQLite was built without FTS5");
+        }
+
+        constexpr int batchSize = 500;
+        QElapsedTimer timer;
+        qint64 parseTime = 0;
+        QBENCHMARK_ONCE {
+            timer.start();
+            for (int first = 0; first < count; first += batchSize) {
+                QElapsedTimer parseTimer;
+                parseTimer.start();
+                const auto batch = documents(first, std::min(batchSize, count - first));
+                parseTime += parseTimer.elapsed();
+                QVERIFY(index->addDocuments(batch));
+            }
+        }
+        const qint64 elapsed = timer.elapsed();
+        QCOMPARE(index->documentCount(), qint64(count));
+
+        qDebug() << "Indexed" << count << "items in" << elapsed << "ms (" << parseTime << "ms parsing)," << (elapsed > 0 ? count * 1000LL / elapsed : count)
+                 << "items/s";
+    }
+
+    void benchmarkQueries_data()
+    {
+        QTest::addColumn<QString>("searchQuery");
+        QTest::addColumn<QList<qint64>>("collections");
+        QTest::addColumn<qsizetype>("expectedCount");
+
+        constexpr int count = 30000;
+        QTest::addRow("subject word") << query(term(QStringLiteral("subject"), QStringLiteral("quarterly"))) << QList<qint64>{} << qsizetype(count / 3);
+        QTest::addRow("sender address") << query(term(QStringLiteral("from"), QStringLiteral("alice@example.org"), CondEqual)) << QList<qint64>{}
+                                        << qsizetype(count / 2);
+        QTest::addRow("body prefix") << query(term(QStringLiteral("message"), QStringLiteral("budg"))) << QList<qint64>{} << qsizetype(count / 5);
+        QTest::addRow("body phrase") << query(term(QStringLiteral("body"), QStringLiteral("review the budget"), CondEqual)) << QList<qint64>{}
+                                     << qsizetype(count / 5);
+        QTest::addRow("and group in one collection")
+            << query(group(RelAnd, {term(QStringLiteral("subject"), QStringLiteral("quarterly")), term(QStringLiteral("body"), QStringLiteral("budget"))}))
+            << QList<qint64>{0} << qsizetype(count / 30);
+        QTest::addRow("limited") << query(term(QStringLiteral("body"), QStringLiteral("lorem")), 100) << QList<qint64>{} << qsizetype(100);
+    }
+
+    void benchmarkQueries()
+    {
+        QFETCH(QString, searchQuery);
+        QFETCH(QList<qint64>, collections);
+        QFETCH(qsizetype, expectedCount);
+
+        auto index = createIndex(QStringLiteral("queries.db"));
+        if (!index) {
+            QSKIP("SQLite was built without FTS5");
+        }
+        constexpr int count = 30000;
+        if (index->documentCount() == 0) {
+            // Ids start at 1 so that the expected counts are exact multiples
+            for (int first = 1; first <= count; first += 1000) {
+                QVERIFY(index->addDocuments(documents(first, 1000)));
+            }
+        }
+
+        constexpr int runs = 20;
+        QSet<qint64> result;
+        QElapsedTimer timer;
+        QBENCHMARK_ONCE {
+            timer.start();
+            for (int run = 0; run < runs; ++run) {
+                result = index->search(searchQuery, collections, {QStringLiteral("message/rfc822")});
+            }
+        }
+        const qint64 elapsed = timer.elapsed();
+        QCOMPARE(result.size(), expectedCount);
+
+        qDebug() << QTest::currentDataTag() << ":" << result.size() << "results," << (elapsed > 0 ? runs * 1000LL / elapsed : runs) << "queries/s";
+    }
+};
+
+AKTEST_MAIN(FullTextIndexBenchmark)
+
+#include "fulltextindexbenchmark.moc"
@@ -27,8 +27,10 @@
 #include "handler/itemlinkhandler.h"
 #include "handler/itemmodifyhandler.h"
 #include "handler/itemmovehandler.h"
+#include "handler/itemsyncmanifesthandler.h"
 #include "handler/loginhandler.h"
 #include "handler/logouthandler.h"
+#include "handler/preprocessitemshandler.h"
 #include "handler/resourceselecthandler.h"
 #include "handler/searchcreatehandler.h"
 #include "handler/searchhandler.h"
@@ -77,8 +79,10 @@ private:
         MAKE_CMD_ROW(Protocol::Command::CopyCollection, CollectionCopyHandler)
         MAKE_CMD_ROW(Protocol::Command::LinkItems, ItemLinkHandler)
         MAKE_CMD_ROW(Protocol::Command::SelectResource, ResourceSelectHandler)
+        MAKE_CMD_ROW(Protocol::Command::PreprocessItems, PreprocessItemsHandler)
         MAKE_CMD_ROW(Protocol::Command::DeleteItems, ItemDeleteHandler)
         MAKE_CMD_ROW(Protocol::Command::MoveItems, ItemMoveHandler)
+        MAKE_CMD_ROW(Protocol::Command::ItemSyncManifest, ItemSyncManifestHandler)
         MAKE_CMD_ROW(Protocol::Command::MoveCollection, CollectionMoveHandler)
     }
 
@@ -13,6 +13,7 @@
 #include "shared/akranges.h"
 #include "shared/aktest.h"
 
+#include "storage/partstreamer.h"
 #include "storage/selectquerybuilder.h"
 
 #include <QHashFunctions>
@@ -273,6 +274,39 @@ private Q_SLOTS:
 
         TestScenario inScenario;
         TestScenario outScenario;
+
+        notification = Protocol::ItemChangeNotificationPtr::create(*notification);
+        updatePimItem(pimItem, QStringLiteral("TEST-INLINE"), 20);
+        updateParts(parts, {{QLatin1StringView("PLD:DATA"), "Inline Data", 11}, {QLatin1StringView("PLD:PLDTEST"), "Test Data", 9}});
+        updateNotifcationEntity(notification, pimItem);
+        ++uidnext;
+        {
+            auto cmd = createCommand(pimItem, datetime, {"PLD:DATA", "PLD:PLDTEST"});
+            cmd->setInlineParts({Protocol::StreamPayloadResponse("PLD:DATA", Protocol::PartMetaData("PLD:DATA", 11), "Inline Data")});
+            inScenario = TestScenario::create(5, TestScenario::ClientCmd, cmd);
+        }
+        scenarios.clear();
+        // Only the part which was not sent inline is requested from the client
+        scenarios
+            << FakeAkonadiServer::loginScenario() << inScenario
+            << TestScenario::create(5,
+                                    TestScenario::ServerCmd,
+                                    Protocol::StreamPayloadCommandPtr::create("PLD:PLDTEST", Protocol::StreamPayloadCommand::MetaData))
+            << TestScenario::create(5,
+                                    TestScenario::ClientCmd,
+                                    Protocol::StreamPayloadResponsePtr::create("PLD:PLDTEST", Protocol::PartMetaData("PLD:PLDTEST", 9, 0)))
+            << TestScenario::create(5, TestScenario::ServerCmd, Protocol::StreamPayloadCommandPtr::create("PLD:PLDTEST", Protocol::StreamPayloadCommand::Data))
+            << TestScenario::create(5, TestScenario::ClientCmd, Protocol::StreamPayloadResponsePtr::create("PLD:PLDTEST", "Test Data"))
+            << TestScenario::create(5,
+                                    TestScenario::ServerCmd,
+                                    createResponse(uidnext,
+                                                   pimItem,
+                                                   datetime,
+                                                   {Protocol::StreamPayloadResponse("PLD:DATA", Protocol::PartMetaData("PLD:DATA", 11), "Inline Data"),
+                                                    Protocol::StreamPayloadResponse("PLD:PLDTEST", Protocol::PartMetaData("PLD:PLDTEST", 9), "Test Data")}))
+            << TestScenario::create(5, TestScenario::ServerCmd, Protocol::CreateItemResponsePtr::create());
+        QTest::newRow("inline-part") << scenarios << Notifications{notification} << pimItem << parts << flags << tags << uidnext << datetime << false;
+
         {
             auto cmd = Protocol::CreateItemCommandPtr::create();
             cmd->setCollection(Scope(100));
@@ -356,6 +390,18 @@ private Q_SLOTS:
         QTest::newRow("part data larger than advertised")
             << scenarios << Notifications{} << PimItem() << QList<FakePart>() << QList<Flag>() << QList<FakeTag>() << -1ll << QDateTime() << true;
 
+        {
+            const QByteArray data(PartStreamer::MaxInlinePartSize + 1, 'X');
+            auto cmd = createCommand(pimItem, datetime, {"PLD:DATA"});
+            cmd->setInlineParts({Protocol::StreamPayloadResponse("PLD:DATA", Protocol::PartMetaData("PLD:DATA", data.size()), data)});
+            inScenario = TestScenario::create(5, TestScenario::ClientCmd, cmd);
+        }
+        scenarios.clear();
+        scenarios << FakeAkonadiServer::loginScenario() << inScenario
+                  << errorResponse(QStringLiteral("Client sent more than %1 bytes of inline parts.").arg(PartStreamer::MaxInlinePartSize));
+        QTest::newRow("inline parts too large") << scenarios << Notifications{} << PimItem() << QList<FakePart>() << QList<Flag>() << QList<FakeTag>() << -1ll
+                                                << QDateTime() << true;
+
         notification = Protocol::ItemChangeNotificationPtr::create(*notification);
         updatePimItem(pimItem, QStringLiteral("TEST-5"), 0);
         updateParts(parts, {{QLatin1StringView("PLD:DATA"), QByteArray(), 0}});
@@ -0,0 +1,209 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "aktest.h"
+#include "entities.h"
+#include "fakeakonadiserver.h"
+#include "partfilereclaimer.h"
+#include "storage/datastore.h"
+#include "storage/parthelper.h"
+#include "storage/parttypehelper.h"
+#include "storage/querybuilder.h"
+#include "storage/transaction.h"
+
+#include "private/externalpartstorage_p.h"
+#include "private/standarddirs_p.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSettings>
+#include <QTest>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+class ItemDeleteBenchmark : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    ItemDeleteBenchmark()
+    {
+        // Store all parts in external files
+        const QString serverConfigFile = StandardDirs::serverConfigFile(StandardDirs::ReadWrite);
+        QSettings settings(serverConfigFile, QSettings::IniFormat);
+        settings.setValue(QStringLiteral("General/SizeThreshold"), 5);
+
+        mAkonadi.init();
+    }
+
+    PimItem::List createItems(int count, QStringList &files)
+    {
+        const Collection col = Collection::retrieveByName(QStringLiteral("Collection A"));
+        const MimeType mimeType = MimeType::retrieveByName(QStringLiteral("application/octet-stream"));
+        const PartType partType = PartTypeHelper::fromFqName(QStringLiteral("PLD"), QStringLiteral("RFC822"));
+        const Flag flag = Flag::retrieveByNameOrCreate(QStringLiteral("\\SEEN"));
+
+        Transaction transaction(DataStore::self(), QStringLiteral("CREATE ITEMS"));
+        PimItem::List items;
+        items.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            PimItem item;
+            item.setCollectionId(col.id());
+            item.setMimeTypeId(mimeType.id());
+            item.setRemoteId(QStringLiteral("delete-%1").arg(i));
+            item.setSize(64);
+            if (!item.insert() || !item.addFlag(flag)) {
+                return {};
+            }
+
+            Part part;
+            part.setPimItemId(item.id());
+            part.setPartTypeId(partType.id());
+            part.setData(QByteArray(64, 'a' + (i % 26)));
+            part.setDatasize(64);
+            if (!PartHelper::insert(&part) || part.storage() != Part::External) {
+                return {};
+            }
+            files.push_back(ExternalPartStorage::resolveAbsolutePath(part.data()));
+            items.push_back(item);
+        }
+        if (!transaction.commit()) {
+            return {};
+        }
+        return items;
+    }
+
+    qint64 tombstoneCount()
+    {
+        QueryBuilder qb(PartFileTombstone::tableName());
+        qb.addAggregation(PartFileTombstone::idColumn(), QStringLiteral("count"));
+        if (!qb.exec() || !qb.query().next()) {
+            return -1;
+        }
+        const qint64 count = qb.query().value(0).toLongLong();
+        qb.query().finish();
+        return count;
+    }
+
+private Q_SLOTS:
+    void testRemoveItems()
+    {
+        QStringList files;
+        const auto items = createItems(10, files);
+        QCOMPARE(items.size(), 10);
+        for (const auto &file : std::as_const(files)) {
+            QVERIFY(QFile::exists(file));
+        }
+
+        Transaction transaction(DataStore::self(), QStringLiteral("REMOVE ITEMS"));
+        QVERIFY(DataStore::self()->cleanupPimItems(items, DataStore::Silent));
+        // Nothing is deleted before the transaction is committed
+        QCOMPARE(tombstoneCount(), 10);
+        for (const auto &file : std::as_const(files)) {
+            QVERIFY(QFile::exists(file));
+        }
+        QVERIFY(transaction.commit());
+
+        const Flag flag = Flag::retrieveByName(QStringLiteral("\\SEEN"));
+        for (const auto &item : items) {
+            QVERIFY(!PimItem::retrieveById(item.id()).isValid());
+            QVERIFY(Part::retrieveFiltered(Part::pimItemIdColumn(), item.id()).isEmpty());
+            QVERIFY(!PimItem::relatesToFlag(item.id(), flag.id()));
+        }
+        for (const auto &file : std::as_const(files)) {
+            QTRY_VERIFY(!QFile::exists(file));
+        }
+        QTRY_COMPARE(tombstoneCount(), 0);
+    }
+
+    void testRollback()
+    {
+        QStringList files;
+        const auto items = createItems(10, files);
+        QCOMPARE(items.size(), 10);
+
+        {
+            // Rolled back when going out of scope
+            Transaction transaction(DataStore::self(), QStringLiteral("REMOVE ITEMS"));
+            QVERIFY(DataStore::self()->cleanupPimItems(items, DataStore::Silent));
+        }
+
+        QCOMPARE(tombstoneCount(), 0);
+        for (const auto &item : items) {
+            QVERIFY(PimItem::retrieveById(item.id()).isValid());
+        }
+        for (const auto &file : std::as_const(files)) {
+            QVERIFY(QFile::exists(file));
+        }
+
+        // Clean up for the other tests
+        QVERIFY(DataStore::self()->cleanupPimItems(items, DataStore::Silent));
+        QTRY_COMPARE(tombstoneCount(), 0);
+    }
+
+    void testReclaimLeftovers()
+    {
+        // Tombstones left over by a server which stopped before deleting the files
+        QByteArray fileName;
+        QVERIFY(ExternalPartStorage::self()->createPartFile("leftover", 999999, fileName));
+        const QString path = ExternalPartStorage::resolveAbsolutePath(fileName);
+        QVERIFY(QFile::exists(path));
+
+        PartFileTombstone tombstone;
+        tombstone.setFileName(fileName);
+        QVERIFY(tombstone.insert());
+        PartFileTombstone missing;
+        missing.setFileName("999998_r0");
+        QVERIFY(missing.insert());
+
+        // The reclaimer thread might be processing them as well
+        QVERIFY(PartFileReclaimer::reclaimPending() >= 0);
+        QVERIFY(!QFile::exists(path));
+        QCOMPARE(tombstoneCount(), 0);
+    }
+
+    void benchmarkRemoveItems_data()
+    {
+        QTest::addColumn<int>("count");
+        // Small by default, as the benchmark runs with the other tests. Set the variable for meaningful numbers, e.g. 10000
+        const int count =
+            qEnvironmentVariableIsSet("AKONADI_ITEMDELETE_BENCHMARK_COUNT") ? qEnvironmentVariableIntValue("AKONADI_ITEMDELETE_BENCHMARK_COUNT") : 200;
+        QTest::newRow(qPrintable(QStringLiteral("%1 items").arg(count))) << count;
+    }
+
+    void benchmarkRemoveItems()
+    {
+        QFETCH(int, count);
+
+        QStringList files;
+        const auto items = createItems(count, files);
+        QCOMPARE(items.size(), count);
+
+        QElapsedTimer timer;
+        QBENCHMARK_ONCE {
+            timer.start();
+            Transaction transaction(DataStore::self(), QStringLiteral("REMOVE ITEMS"));
+            QVERIFY(DataStore::self()->cleanupPimItems(items, DataStore::Silent));
+            QVERIFY(transaction.commit());
+        }
+        qDebug() << "Transaction for" << count << "items took" << timer.elapsed() << "ms";
+
+        QTRY_COMPARE_WITH_TIMEOUT(tombstoneCount(), 0, 60000);
+        qDebug() << "Files of" << count << "items were deleted after" << timer.elapsed() << "ms";
+        for (const auto &file : std::as_const(files)) {
+            QVERIFY(!QFile::exists(file));
+        }
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(ItemDeleteBenchmark)
+
+#include "itemdeletebenchmark.moc"
@@ -0,0 +1,237 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "aktest.h"
+#include "entities.h"
+#include "fakeakonadiserver.h"
+#include "storage/countquerybuilder.h"
+#include "storage/datastore.h"
+#include "storage/dbtype.h"
+#include "storage/itemmergeindex.h"
+#include "storage/notificationcollector.h"
+#include "storage/transaction.h"
+
+#include <QSqlQuery>
+#include <QTest>
+
+#include <optional>
+
+using namespace Akonadi::Server;
+
+class IntrospectableItemMergeIndex : public ItemMergeIndex
+{
+public:
+    int loadCount() const
+    {
+        return mLoadCount;
+    }
+
+    // When set, used instead of the items in the database
+    std::optional<QList<Entry>> entries;
+
+protected:
+    bool loadEntries(Collection::Id collectionId, QList<Entry> &result) override
+    {
+        ++mLoadCount;
+        if (entries.has_value()) {
+            result = *entries;
+            return true;
+        }
+        return ItemMergeIndex::loadEntries(collectionId, result);
+    }
+
+private:
+    int mLoadCount = 0;
+};
+
+class ItemMergeIndexTest : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    ItemMergeIndexTest()
+    {
+        mAkonadi.init();
+    }
+
+private Q_SLOTS:
+    void testLookup()
+    {
+        const Collection col = Collection::retrieveByName(QStringLiteral("Collection B"));
+        QVERIFY(col.isValid());
+        IntrospectableItemMergeIndex index;
+
+        // RID merge
+        QVERIFY(index.mayContain(col.id(), true, QStringLiteral("A"), false, QString()));
+        QCOMPARE(index.loadCount(), 1);
+        QVERIFY(!index.mayContain(col.id(), true, QStringLiteral("new"), false, QString()));
+        // The database might compare case-insensitively
+        QVERIFY(index.mayContain(col.id(), true, QStringLiteral("a "), false, QString()));
+        // An empty RID can't be ruled out
+        QVERIFY(index.mayContain(col.id(), true, QString(), false, QString()));
+
+        // GID merge, which also matches an item without GID with the same RID
+        QVERIFY(index.mayContain(col.id(), false, QStringLiteral("new"), true, QStringLiteral("B")));
+        QVERIFY(!index.mayContain(col.id(), false, QStringLiteral("new"), true, QStringLiteral("new")));
+        QVERIFY(index.mayContain(col.id(), false, QStringLiteral("C"), true, QStringLiteral("new")));
+
+        // RID and GID merge
+        QVERIFY(!index.mayContain(col.id(), true, QStringLiteral("new"), true, QStringLiteral("A")));
+        QVERIFY(index.mayContain(col.id(), true, QStringLiteral("A"), true, QStringLiteral("new")));
+
+        // Other collections have their own filter
+        const Collection otherCol = Collection::retrieveByName(QStringLiteral("Collection A"));
+        QVERIFY(!index.mayContain(otherCol.id(), true, QStringLiteral("A"), false, QString()));
+        QCOMPARE(index.loadCount(), 2);
+    }
+
+    void testAddEntries()
+    {
+        const Collection col = Collection::retrieveByName(QStringLiteral("Collection B"));
+        IntrospectableItemMergeIndex index;
+
+        // Nothing to add to before the filter is built
+        index.addEntries({{col.id(), QStringLiteral("new"), QStringLiteral("newGid")}});
+        QVERIFY(!index.mayContain(col.id(), true, QStringLiteral("new"), false, QString()));
+
+        index.addEntries({{col.id(), QStringLiteral("new"), QStringLiteral("newGid")}});
+        QVERIFY(index.mayContain(col.id(), true, QStringLiteral("new"), false, QString()));
+        QVERIFY(index.mayContain(col.id(), false, QString(), true, QStringLiteral("newGid")));
+        QCOMPARE(index.loadCount(), 1);
+
+        index.invalidateCollection(col.id());
+        QVERIFY(!index.mayContain(col.id(), true, QStringLiteral("new"), false, QString()));
+        QCOMPARE(index.loadCount(), 2);
+    }
+
+    void testNotificationCollector()
+    {
+        const Collection col = Collection::retrieveByName(QStringLiteral("Collection B"));
+        auto &index = mAkonadi.itemMergeIndex();
+        QVERIFY(!index.mayContain(col.id(), true, QStringLiteral("collected"), false, QString()));
+
+        PimItem item;
+        item.setRemoteId(QStringLiteral("collected"));
+        item.setGid(QStringLiteral("collectedGid"));
+        item.setCollectionId(col.id());
+        DataStore::self()->notificationCollector()->itemAdded(item, false, col);
+        QVERIFY(index.mayContain(col.id(), true, QStringLiteral("collected"), false, QString()));
+
+        item.setRemoteId(QStringLiteral("modified"));
+        DataStore::self()->notificationCollector()->itemIdentifiersChanged(item);
+        QVERIFY(index.mayContain(col.id(), true, QStringLiteral("modified"), false, QString()));
+
+        DataStore::self()->notificationCollector()->collectionRemoved(col);
+        QVERIFY(!index.mayContain(col.id(), true, QStringLiteral("collected"), false, QString()));
+    }
+
+    void testUncommittedItems()
+    {
+        const Collection col = Collection::retrieveByName(QStringLiteral("Collection B"));
+        IntrospectableItemMergeIndex index;
+
+        Transaction transaction(DataStore::self(), QStringLiteral("ItemMergeIndexTest"));
+        PimItem item;
+        item.setRemoteId(QStringLiteral("uncommitted"));
+        item.setCollectionId(col.id());
+        item.setMimeTypeId(MimeType::retrieveByName(QStringLiteral("application/octet-stream")).id());
+        QVERIFY(item.insert());
+
+        // The items written by the transaction itself are only visible to it
+        QVERIFY(index.mayContain(col.id(), true, QStringLiteral("uncommitted"), false, QString()));
+        QVERIFY(index.mayContain(col.id(), true, QStringLiteral("A"), false, QString()));
+    }
+
+    void testConcurrentCommit()
+    {
+        if (DbType::type(DataStore::self()->database()) == DbType::Sqlite) {
+            QSKIP("SQLite does not commit concurrent transactions");
+        }
+        const Collection col = Collection::retrieveByName(QStringLiteral("Collection B"));
+        const MimeType mimeType = MimeType::retrieveByName(QStringLiteral("application/octet-stream"));
+        IntrospectableItemMergeIndex index;
+        const QString connectionName = QStringLiteral("ItemMergeIndexTest-writer");
+
+        {
+            Transaction transaction(DataStore::self(), QStringLiteral("ItemMergeIndexTest"));
+            // Start the snapshot of the transaction
+            CountQueryBuilder qb(PimItem::tableName());
+            QVERIFY(qb.exec());
+
+            // Committed by another connection after the snapshot was taken
+            QSqlDatabase db = QSqlDatabase::cloneDatabase(DataStore::self()->database(), connectionName);
+            QVERIFY(db.open());
+            QSqlQuery query(db);
+            QVERIFY(query.prepare(QStringLiteral("INSERT INTO PimItemTable (remoteId, collectionId, mimeTypeId, dirty) VALUES (?, ?, ?, ?)")));
+            query.addBindValue(QStringLiteral("concurrent"));
+            query.addBindValue(col.id());
+            query.addBindValue(mimeType.id());
+            query.addBindValue(false);
+            QVERIFY(query.exec());
+
+            QVERIFY(index.mayContain(col.id(), true, QStringLiteral("concurrent"), false, QString()));
+        }
+
+        {
+            QSqlDatabase db = QSqlDatabase::database(connectionName);
+            QSqlQuery query(db);
+            QVERIFY(query.prepare(QStringLiteral("DELETE FROM PimItemTable WHERE remoteId = ?")));
+            query.addBindValue(QStringLiteral("concurrent"));
+            QVERIFY(query.exec());
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+
+    void testRebuildWhenFull()
+    {
+        IntrospectableItemMergeIndex index;
+        index.entries = QList<ItemMergeIndex::Entry>{};
+        QVERIFY(!index.mayContain(1, true, QStringLiteral("0"), false, QString()));
+
+        QList<ItemMergeIndex::Entry> entries;
+        for (int i = 0; i < 10000; ++i) {
+            entries.push_back({1, QString::number(i), QString()});
+        }
+        index.addEntries(entries);
+        // The filter is rebuilt from the items in the database
+        index.entries = entries;
+        QVERIFY(index.mayContain(1, true, QStringLiteral("0"), false, QString()));
+        QCOMPARE(index.loadCount(), 2);
+    }
+
+    void testFalsePositiveRate()
+    {
+        IntrospectableItemMergeIndex index;
+        constexpr int count = 100'000;
+        QList<ItemMergeIndex::Entry> entries;
+        entries.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            entries.push_back({1, QStringLiteral("%1.mbox:2,S").arg(i), QStringLiteral("<%1@localhost>").arg(i)});
+        }
+        index.entries = entries;
+
+        int falsePositives = 0;
+        for (int i = count; i < 2 * count; ++i) {
+            if (index.mayContain(1, true, QStringLiteral("%1.mbox:2,S").arg(i), false, QString())) {
+                ++falsePositives;
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(index.mayContain(1, true, entries[i].remoteId, false, QString()));
+        }
+        qDebug() << "False positive rate:" << double(falsePositives) / count;
+        QVERIFY(falsePositives < count / 50);
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(ItemMergeIndexTest)
+
+#include "itemmergeindextest.moc"
@@ -5,6 +5,7 @@
 */
 #include <QObject>
 
+#include "storage/collectionstatistics.h"
 #include "storage/entity.h"
 
 #include "aktest.h"
@@ -119,6 +120,47 @@ private Q_SLOTS:
             }
         }
     }
+
+    void testStatistics()
+    {
+        const Collection srcCol = Collection::retrieveByName(QStringLiteral("Collection A"));
+        const Collection destCol = Collection::retrieveByName(QStringLiteral("Collection B"));
+
+        auto &statistics = mAkonadi.collectionStatistics();
+        // Make sure the statistics of both collections are cached
+        const auto srcBefore = statistics.statistics(srcCol);
+        const auto destBefore = statistics.statistics(destCol);
+        QVERIFY(srcBefore.count > 0);
+
+        auto cmd = Protocol::MoveItemsCommandPtr::create(1, destCol.id());
+        TestScenario::List scenarios;
+        scenarios << FakeAkonadiServer::loginScenario() << TestScenario::create(5, TestScenario::ClientCmd, cmd)
+                  << TestScenario::create(5, TestScenario::ServerCmd, Protocol::MoveItemsResponsePtr::create());
+        mAkonadi.setScenarios(scenarios);
+        mAkonadi.runTest();
+
+        const PimItem item = PimItem::retrieveById(1);
+        QCOMPARE(item.collectionId(), destCol.id());
+
+        // The cached statistics are updated incrementally and match the database
+        const auto srcAfter = statistics.statistics(srcCol);
+        const auto destAfter = statistics.statistics(destCol);
+        QCOMPARE(srcAfter.count, srcBefore.count - 1);
+        QCOMPARE(destAfter.count, destBefore.count + 1);
+        QCOMPARE(srcAfter.size + destAfter.size, srcBefore.size + destBefore.size);
+        QCOMPARE(srcAfter.read + destAfter.read, srcBefore.read + destBefore.read);
+
+        statistics.invalidateCollection(srcCol);
+        statistics.invalidateCollection(destCol);
+        const auto srcCalculated = statistics.statistics(srcCol);
+        const auto destCalculated = statistics.statistics(destCol);
+        QCOMPARE(srcAfter.count, srcCalculated.count);
+        QCOMPARE(srcAfter.size, srcCalculated.size);
+        QCOMPARE(srcAfter.read, srcCalculated.read);
+        QCOMPARE(destAfter.count, destCalculated.count);
+        QCOMPARE(destAfter.size, destCalculated.size);
+        QCOMPARE(destAfter.read, destCalculated.read);
+    }
 };
 
 AKTEST_FAKESERVER_MAIN(ItemMoveHandlerTest)
@@ -0,0 +1,122 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+#include <QObject>
+
+#include "storage/entity.h"
+
+#include "aktest.h"
+#include "entities.h"
+#include "fakeakonadiserver.h"
+
+#include <QTest>
+
+#include <algorithm>
+#include <limits>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+class ItemSyncManifestHandlerTest : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    ItemSyncManifestHandlerTest()
+    {
+        mAkonadi.init();
+    }
+
+    static TestScenario::List manifestScenario(qint64 collectionId, const QStringList &remoteIds, const QStringList &remoteRevisions)
+    {
+        TestScenario::List scenarios;
+        scenarios << FakeAkonadiServer::loginScenario()
+                  << TestScenario::create(5, TestScenario::ClientCmd, Protocol::ItemSyncManifestCommandPtr::create(collectionId, remoteIds, remoteRevisions));
+        return scenarios;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Items in the test data have no remote revision
+        for (const auto &rid : {QStringLiteral("A"), QStringLiteral("B"), QStringLiteral("C")}) {
+            auto items = PimItem::retrieveFiltered(PimItem::remoteIdColumn(), rid);
+            QCOMPARE(items.size(), 1);
+            items[0].setRemoteRevision(QStringLiteral("1"));
+            QVERIFY(items[0].update());
+        }
+    }
+
+    void testManifest_data()
+    {
+        QTest::addColumn<TestScenario::List>("scenarios");
+
+        const Collection col = Collection::retrieveByName(QStringLiteral("Collection B"));
+        const Collection emptyCol = Collection::retrieveByName(QStringLiteral("Collection D"));
+
+        {
+            QList<qint64> deleted;
+            const auto items = PimItem::retrieveFiltered(PimItem::collectionIdColumn(), col.id());
+            for (const PimItem &item : items) {
+                if (item.remoteId() > QLatin1StringView("C")) {
+                    deleted.push_back(item.id());
+                }
+            }
+            std::sort(deleted.begin(), deleted.end());
+            QCOMPARE(deleted.size(), 9);
+
+            auto scenarios = manifestScenario(col.id(),
+                                              {QStringLiteral("A"), QStringLiteral("B"), QStringLiteral("C"), QStringLiteral("new")},
+                                              {QStringLiteral("1"), QStringLiteral("2"), QString(), QStringLiteral("1")});
+            auto resp = Protocol::ItemSyncManifestResponsePtr::create();
+            resp->setChangedRemoteIds({QStringLiteral("B"), QStringLiteral("C"), QStringLiteral("new")});
+            resp->setDeletedItems(deleted);
+            scenarios << TestScenario::create(5, TestScenario::ServerCmd, resp);
+            QTest::newRow("changed, new and deleted items") << scenarios;
+        }
+
+        {
+            auto scenarios = manifestScenario(emptyCol.id(), {QStringLiteral("X"), QStringLiteral("X")}, {QStringLiteral("1"), QStringLiteral("1")});
+            auto resp = Protocol::ItemSyncManifestResponsePtr::create();
+            resp->setChangedRemoteIds({QStringLiteral("X")});
+            scenarios << TestScenario::create(5, TestScenario::ServerCmd, resp);
+            QTest::newRow("duplicate remote id in empty collection") << scenarios;
+        }
+
+        {
+            auto scenarios = manifestScenario(col.id(), {QStringLiteral("A")}, {});
+            auto resp = Protocol::ItemSyncManifestResponsePtr::create();
+            resp->setError(1, QStringLiteral("Malformed item manifest"));
+            scenarios << TestScenario::create(5, TestScenario::ServerCmd, resp);
+            QTest::newRow("malformed manifest") << scenarios;
+        }
+
+        {
+            auto scenarios = manifestScenario(std::numeric_limits<qint32>::max(), {}, {});
+            auto resp = Protocol::ItemSyncManifestResponsePtr::create();
+            resp->setError(1, QStringLiteral("Invalid collection"));
+            scenarios << TestScenario::create(5, TestScenario::ServerCmd, resp);
+            QTest::newRow("invalid collection") << scenarios;
+        }
+    }
+
+    void testManifest()
+    {
+        QFETCH(TestScenario::List, scenarios);
+
+        mAkonadi.setScenarios(scenarios);
+        mAkonadi.runTest();
+
+        // The manifest must not change anything
+        QVERIFY(mAkonadi.notificationSpy()->isEmpty()
+                || mAkonadi.notificationSpy()->takeFirst().first().value<Protocol::ChangeNotificationList>().isEmpty());
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(ItemSyncManifestHandlerTest)
+
+#include "itemsyncmanifesthandlertest.moc"
@@ -0,0 +1,191 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "aktest.h"
+#include "entities.h"
+#include "fakeakonadiserver.h"
+#include "storage/packedpartstorage.h"
+#include "storage/parthelper.h"
+#include "storage/parttypehelper.h"
+
+#include "private/externalpartstorage_p.h"
+#include "private/standarddirs_p.h"
+
+#include <QFile>
+#include <QSettings>
+#include <QTest>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+namespace
+{
+constexpr qint64 PackedPartThreshold = 16 * 1024;
+
+} // namespace
+
+class PackedPartStorageTest : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    PackedPartStorageTest()
+    {
+        // Parts bigger than the default size threshold of 4 KiB are packed up to 16 KiB
+        const QString serverConfigFile = StandardDirs::serverConfigFile(StandardDirs::ReadWrite);
+        QSettings settings(serverConfigFile, QSettings::IniFormat);
+        settings.setValue(QStringLiteral("General/PackedPartThreshold"), PackedPartThreshold);
+
+        mAkonadi.init();
+    }
+
+    PimItem createItem(const QString &remoteId)
+    {
+        PimItem item;
+        item.setCollectionId(Collection::retrieveByName(QStringLiteral("Collection A")).id());
+        item.setMimeTypeId(MimeType::retrieveByName(QStringLiteral("application/octet-stream")).id());
+        item.setRemoteId(remoteId);
+        if (!item.insert()) {
+            return {};
+        }
+        return item;
+    }
+
+    Part insertPart(const PimItem &item, const QByteArray &name, const QByteArray &data)
+    {
+        Part part;
+        part.setPimItemId(item.id());
+        part.setPartTypeId(PartTypeHelper::fromFqName(QStringLiteral("PLD"), QString::fromLatin1(name)).id());
+        part.setData(data);
+        part.setDatasize(data.size());
+        if (!PartHelper::insert(&part)) {
+            return {};
+        }
+        return part;
+    }
+
+private Q_SLOTS:
+    void testLocation()
+    {
+        const PackedPartStorage::Location location{3, 4096, 120};
+        QCOMPARE(location.toByteArray(), QByteArray("3:4096:120"));
+        const auto parsed = PackedPartStorage::Location::fromByteArray(location.toByteArray());
+        QVERIFY(parsed.isValid());
+        QCOMPARE(parsed.segment, 3LL);
+        QCOMPARE(parsed.offset, 4096LL);
+        QCOMPARE(parsed.size, 120LL);
+
+        QVERIFY(!PackedPartStorage::Location::fromByteArray("3:4096").isValid());
+        QVERIFY(!PackedPartStorage::Location::fromByteArray("3:abc:120").isValid());
+        QVERIFY(!PackedPartStorage::Location().isValid());
+    }
+
+    void testAppendAndRead()
+    {
+        auto *storage = PackedPartStorage::self();
+        QByteArray location1;
+        QByteArray location2;
+        QVERIFY(storage->appendPart("first part", location1));
+        QVERIFY(storage->appendPart(QByteArray(10000, 'x'), location2));
+        storage->sync();
+        QVERIFY(storage->activeSegment() >= 0);
+
+        QByteArray data;
+        QVERIFY(storage->readPart(location1, data));
+        QCOMPARE(data, QByteArray("first part"));
+        QVERIFY(storage->readPart(location2, data));
+        QCOMPARE(data, QByteArray(10000, 'x'));
+
+        // A location which doesn't point to the start of a record is rejected
+        auto location = PackedPartStorage::Location::fromByteArray(location1);
+        ++location.offset;
+        QVERIFY(!storage->readPart(location.toByteArray(), data));
+        location = PackedPartStorage::Location::fromByteArray(location1);
+        ++location.size;
+        QVERIFY(!storage->readPart(location.toByteArray(), data));
+        QVERIFY(!storage->readPart("garbage", data));
+    }
+
+    void testRetireSegment()
+    {
+        auto *storage = PackedPartStorage::self();
+        QByteArray location;
+        QVERIFY(storage->appendPart("data", location));
+        const qint64 active = storage->activeSegment();
+        QVERIFY(!storage->retireSegment(active));
+
+        // A segment left over by a previous compaction
+        const qint64 segment = active + 100;
+        QFile file(PackedPartStorage::segmentPath(segment));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.close();
+        QVERIFY(storage->segmentSizes().contains(segment));
+
+        QVERIFY(storage->retireSegment(segment));
+        QVERIFY(!storage->segmentSizes().contains(segment));
+        QCOMPARE(storage->removeRetiredSegments(std::chrono::hours(1)), 0);
+        QVERIFY(QFile::exists(file.fileName()));
+        QCOMPARE(storage->removeRetiredSegments(std::chrono::seconds(0)), 1);
+        QVERIFY(!QFile::exists(file.fileName()));
+
+        // The active segment is still readable
+        QByteArray data;
+        QVERIFY(storage->readPart(location, data));
+        QCOMPARE(data, QByteArray("data"));
+    }
+
+    void testPartHelper()
+    {
+        const PimItem item = createItem(QStringLiteral("packed-parthelper"));
+        QVERIFY(item.isValid());
+
+        Part part = insertPart(item, "RFC822", QByteArray(5000, 'a'));
+        QVERIFY(part.isValid());
+        QCOMPARE(part.storage(), Part::Packed);
+        QVERIFY(PackedPartStorage::Location::fromByteArray(part.data()).isValid());
+        QCOMPARE(PartHelper::translateData(Part::retrieveById(part.id())), QByteArray(5000, 'a'));
+        const Part other = insertPart(item, "HEAD", QByteArray(6000, 'b'));
+        QCOMPARE(other.storage(), Part::Packed);
+
+        // Updating appends a new record, the old one is left to the compaction
+        const QByteArray oldLocation = part.data();
+        PartHelper::update(&part, QByteArray(6000, 'c'), 6000);
+        QCOMPARE(part.storage(), Part::Packed);
+        QVERIFY(part.data() != oldLocation);
+        QCOMPARE(PartHelper::translateData(Part::retrieveById(part.id())), QByteArray(6000, 'c'));
+
+        // Parts leave the segments when they grow or shrink beyond the thresholds
+        PartHelper::update(&part, QByteArray(PackedPartThreshold + 1, 'd'), PackedPartThreshold + 1);
+        QCOMPARE(part.storage(), Part::External);
+        const QString file = ExternalPartStorage::resolveAbsolutePath(part.data());
+        QVERIFY(QFile::exists(file));
+        PartHelper::update(&part, QByteArray(5000, 'e'), 5000);
+        QCOMPARE(part.storage(), Part::Packed);
+        QVERIFY(!QFile::exists(file));
+        QCOMPARE(PartHelper::translateData(Part::retrieveById(part.id())), QByteArray(5000, 'e'));
+        PartHelper::update(&part, "small", 5);
+        QCOMPARE(part.storage(), Part::Internal);
+        QCOMPARE(Part::retrieveById(part.id()).data(), QByteArray("small"));
+
+        // Removing a packed part leaves the other records alone
+        Part packed = insertPart(item, "BODY", QByteArray(7000, 'f'));
+        QCOMPARE(packed.storage(), Part::Packed);
+        QVERIFY(PartHelper::remove(&packed));
+        QVERIFY(!Part::retrieveById(packed.id()).isValid());
+        QCOMPARE(PartHelper::translateData(Part::retrieveById(other.id())), QByteArray(6000, 'b'));
+        Part stored = Part::retrieveById(other.id());
+        QVERIFY(PartHelper::verify(stored));
+        QCOMPARE(stored.storage(), Part::Packed);
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(PackedPartStorageTest)
+
+#include "packedpartstoragetest.moc"
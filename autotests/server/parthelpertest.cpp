@@ -10,6 +10,7 @@
 
 #include <QDir>
 #include <QObject>
+#include <QTemporaryFile>
 #include <QTest>
 
 #define QL1S(x) QString::fromLatin1(x)
@@ -97,6 +98,22 @@ private Q_SLOTS:
     }
 #endif
 
+    void testContentHash()
+    {
+        const QByteArray data("Hello World!");
+        const QString hash = PartHelper::contentHash(data);
+        QCOMPARE(hash.size(), 64);
+        QCOMPARE(PartHelper::contentHash(data), hash);
+        QVERIFY(PartHelper::contentHash("Hello World?") != hash);
+
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        file.write(data);
+        file.close();
+        QCOMPARE(PartHelper::fileContentHash(file.fileName()), hash);
+        QVERIFY(PartHelper::fileContentHash(file.fileName() + QL1S(".missing")).isEmpty());
+    }
+
 #if 0
     void testResolveAbsolutePath()
     {
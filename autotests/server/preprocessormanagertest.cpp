@@ -0,0 +1,182 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "entities.h"
+#include "fakeakonadiserver.h"
+#include "preprocessormanager.h"
+#include "shared/aktest.h"
+#include "storage/datastore.h"
+
+#include <QElapsedTimer>
+#include <QTest>
+
+#include <memory>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+using namespace std::chrono_literals;
+
+namespace
+{
+/// Preprocessor instance without a D-Bus connection to an agent, only usable in batched mode
+class TestPreprocessorInstance : public PreprocessorInstance
+{
+public:
+    TestPreprocessorInstance(const QString &id, PreprocessorManager &manager, Tracer &tracer)
+        : PreprocessorInstance(id, manager, tracer)
+    {
+    }
+
+protected:
+    bool init() override
+    {
+        return true;
+    }
+};
+
+class TestPreprocessorManager : public PreprocessorManager
+{
+public:
+    using PreprocessorManager::PreprocessorManager;
+
+protected:
+    PreprocessorInstance *createInstance(const QString &id) override
+    {
+        return new TestPreprocessorInstance(id, *this, mTracer);
+    }
+};
+
+} // namespace
+
+class PreprocessorManagerTest : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    PreprocessorManagerTest()
+    {
+        mAkonadi.init();
+    }
+
+    /// Creates a manager with the preprocessors @p ids, which are switched to batched mode
+    std::unique_ptr<PreprocessorManager> createManager(const QStringList &ids)
+    {
+        auto manager = std::make_unique<TestPreprocessorManager>(mAkonadi.tracer());
+        for (const auto &id : ids) {
+            manager->registerInstance(id);
+            if (!manager->waitForItemBatch(id, 1, 0ms).isEmpty()) {
+                return {};
+            }
+        }
+        return manager;
+    }
+
+    QList<qint64> createItems(PreprocessorManager &manager, int count)
+    {
+        QList<qint64> ids;
+        for (int i = 0; i < count; ++i) {
+            PimItem item;
+            item.setCollectionId(Collection::retrieveByName(QStringLiteral("Collection A")).id());
+            item.setMimeTypeId(MimeType::retrieveByName(QStringLiteral("application/octet-stream")).id());
+            item.setRemoteId(QStringLiteral("preprocessed-%1").arg(mItemCounter++));
+            if (!item.insert()) {
+                return {};
+            }
+            manager.beginHandleItem(item, DataStore::self());
+            ids.push_back(item.id());
+        }
+        return ids;
+    }
+
+private:
+    int mItemCounter = 0;
+
+private Q_SLOTS:
+    void testHandOut()
+    {
+        auto manager = createManager({QStringLiteral("pp1")});
+        QVERIFY(manager);
+        const auto ids = createItems(*manager, 3);
+        QCOMPARE(ids.size(), 3);
+
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp1"), 2, 0ms), ids.mid(0, 2));
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp1"), 2, 0ms), ids.mid(2));
+
+        // Without results, a preprocessor with items in progress waits for new items
+        QElapsedTimer timer;
+        timer.start();
+        QVERIFY(manager->waitForItemBatch(QStringLiteral("pp1"), 2, 200ms).isEmpty());
+        QVERIFY(timer.elapsed() >= 200);
+
+        // With results it gets an answer right away, so that it can report the remaining items
+        manager->batchItemsProcessed(QStringLiteral("pp1"), {ids[0]}, {}, {});
+        timer.restart();
+        QVERIFY(manager->waitForItemBatch(QStringLiteral("pp1"), 2, 10s, false, true).isEmpty());
+        QVERIFY(timer.elapsed() < 5000);
+    }
+
+    void testFinishItems()
+    {
+        auto manager = createManager({QStringLiteral("pp1")});
+        QVERIFY(manager);
+        const auto ids = createItems(*manager, 3);
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp1"), 3, 0ms), ids);
+
+        // Each item is finished on its own, whatever its result
+        manager->batchItemsProcessed(QStringLiteral("pp1"), {ids[0]}, {ids[1]}, {});
+        const auto more = createItems(*manager, 1);
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp1"), 3, 0ms, false, true), more);
+
+        // Items which were not handed out, or were already reported, are ignored
+        manager->batchItemsProcessed(QStringLiteral("pp1"), {ids[0], ids[2] + 1000}, {}, {ids[2]});
+        manager->batchItemsProcessed(QStringLiteral("pp1"), more, {}, {});
+        QVERIFY(manager->waitForItemBatch(QStringLiteral("pp1"), 3, 0ms, false, true).isEmpty());
+        QVERIFY(manager->waitForItemBatch(QStringLiteral("pp1"), 3, 0ms).isEmpty());
+    }
+
+    void testChain()
+    {
+        auto manager = createManager({QStringLiteral("pp1"), QStringLiteral("pp2")});
+        QVERIFY(manager);
+        const auto ids = createItems(*manager, 2);
+
+        // Items start at the first preprocessor and are passed on as soon as it has finished them
+        QVERIFY(manager->waitForItemBatch(QStringLiteral("pp2"), 2, 0ms).isEmpty());
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp1"), 2, 0ms), ids);
+        manager->batchItemsProcessed(QStringLiteral("pp1"), {}, {}, {ids[1]});
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp2"), 2, 0ms), ids.mid(1));
+        manager->batchItemsProcessed(QStringLiteral("pp1"), {ids[0]}, {}, {});
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp2"), 2, 0ms, false, true), ids.mid(0, 1));
+
+        // Items in progress are passed on when a preprocessor goes away
+        const auto more = createItems(*manager, 1);
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp1"), 2, 0ms), more);
+        manager->unregisterInstance(QStringLiteral("pp1"));
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp2"), 2, 0ms), more);
+    }
+
+    void testRestart()
+    {
+        auto manager = createManager({QStringLiteral("pp1")});
+        QVERIFY(manager);
+        const auto ids = createItems(*manager, 3);
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp1"), 2, 0ms), ids.mid(0, 2));
+        manager->batchItemsProcessed(QStringLiteral("pp1"), {ids[0]}, {}, {});
+
+        // A new process of the preprocessor gets the unfinished items of the previous one again
+        QCOMPARE(manager->waitForItemBatch(QStringLiteral("pp1"), 3, 0ms, true), ids.mid(1));
+        manager->batchItemsProcessed(QStringLiteral("pp1"), ids.mid(1), {}, {});
+        QVERIFY(manager->waitForItemBatch(QStringLiteral("pp1"), 3, 0ms, false, true).isEmpty());
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(PreprocessorManagerTest)
+
+#include "preprocessormanagertest.moc"
@@ -0,0 +1,123 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "fakeakonadiserver.h"
+#include "protocolcapturewriter.h"
+#include "shared/aktest.h"
+
+#include "private/protocolcapture_p.h"
+#include "private/scope_p.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+class ProtocolCaptureTest : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    ProtocolCaptureTest()
+    {
+        mAkonadi.init();
+    }
+
+    TestScenario::List linkScenario(const QByteArray &sessionId)
+    {
+        auto response = Protocol::LinkItemsResponsePtr::create();
+        response->setError(1, QStringLiteral("Can't link items to non-virtual collections"));
+        auto scenarios = FakeAkonadiServer::loginScenario(sessionId);
+        scenarios << TestScenario::create(5,
+                                          TestScenario::ClientCmd,
+                                          Protocol::LinkItemsCommandPtr::create(Protocol::LinkItemsCommand::Link, Scope{1, 2, 3}, 3))
+                  << TestScenario::create(5, TestScenario::ServerCmd, response);
+        return scenarios;
+    }
+
+    bool readCapture(const QString &fileName, ProtocolCapture::Capture &capture)
+    {
+        QFile file(fileName);
+        return file.open(QIODevice::ReadOnly) && ProtocolCapture::read(&file, capture);
+    }
+
+private Q_SLOTS:
+    void testCapture()
+    {
+        QTemporaryDir dir;
+        const QString fileName = dir.filePath(QStringLiteral("capture"));
+        auto *capture = mAkonadi.protocolCapture();
+        QVERIFY(capture->start(fileName, QStringLiteral("^captured")));
+        QVERIFY(capture->isActive());
+
+        const auto scenarios = linkScenario("captured-session");
+        mAkonadi.setScenarios(scenarios);
+        mAkonadi.runTest();
+        mAkonadi.setScenarios(linkScenario("ignored-session"));
+        mAkonadi.runTest();
+
+        capture->stop();
+        QVERIFY(!capture->isActive());
+
+        ProtocolCapture::Capture result;
+        QVERIFY(readCapture(fileName, result));
+        QCOMPARE(result.header.protocolVersion, Protocol::version());
+        QVERIFY(result.header.startTime > 0);
+        QCOMPARE(result.sessions.size(), 1);
+
+        const auto &session = result.sessions.constFirst();
+        QCOMPARE(session.sessionId, QByteArray("captured-session"));
+        // The frames are exactly what the client has sent
+        QList<QByteArray> expected;
+        for (const auto &scenario : scenarios) {
+            if (scenario.action == TestScenario::ClientCmd) {
+                expected.push_back(scenario.data);
+            }
+        }
+        QCOMPARE(session.frames.size(), expected.size());
+        for (qsizetype i = 0; i < expected.size(); ++i) {
+            QCOMPARE(session.frames[i].data, expected[i]);
+            QVERIFY(session.frames[i].timestamp >= session.begin);
+        }
+    }
+
+    void testTruncatedCapture()
+    {
+        QTemporaryDir dir;
+        const QString fileName = dir.filePath(QStringLiteral("capture"));
+        QVERIFY(mAkonadi.protocolCapture()->start(fileName));
+        mAkonadi.setScenarios(linkScenario("truncated-session"));
+        mAkonadi.runTest();
+        mAkonadi.protocolCapture()->stop();
+
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.resize(file.size() - 3));
+        file.close();
+
+        ProtocolCapture::Capture result;
+        QVERIFY(readCapture(fileName, result));
+        QCOMPARE(result.sessions.size(), 1);
+        QVERIFY(!result.sessions.constFirst().frames.isEmpty());
+    }
+
+    void testInvalidFilter()
+    {
+        QTemporaryDir dir;
+        QVERIFY(!mAkonadi.protocolCapture()->start(dir.filePath(QStringLiteral("capture")), QStringLiteral("(")));
+        QVERIFY(!mAkonadi.protocolCapture()->isActive());
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(ProtocolCaptureTest)
+
+#include "protocolcapturetest.moc"
@@ -8,12 +8,66 @@
 #include "aktest.h"
 #include "entities.h"
 #include "fakeakonadiserver.h"
+#include "fakesearchmanager.h"
 #include "handler/searchhelper.h"
+#include "search/abstractsearchplugin.h"
+#include "search/searchrequest.h"
 
 #include <QTest>
 
+using namespace Akonadi;
 using namespace Akonadi::Server;
 
+namespace
+{
+/// Delivers ranked results in batches
+class StreamingSearchPlugin : public AbstractSearchPlugin
+{
+public:
+    QList<SearchResult> results;
+    qsizetype batchSize = 3;
+    int batches = 0;
+    bool cancelled = false;
+
+    QSet<qint64> search(const QString &, const QList<qint64> &, const QStringList &) override
+    {
+        QSet<qint64> ids;
+        for (const auto &result : std::as_const(results)) {
+            ids.insert(result.id);
+        }
+        return ids;
+    }
+
+    bool searchIncrementally(const QString &, const QList<qint64> &, const QStringList &, int limit, const ResultCallback &callback) override
+    {
+        const qsizetype count = limit >= 0 ? std::min<qsizetype>(limit, results.size()) : results.size();
+        for (qsizetype i = 0; i < count; i += batchSize) {
+            ++batches;
+            if (!callback(results.mid(i, std::min(batchSize, count - i)))) {
+                cancelled = true;
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/// Only implements the original, blocking interface
+class BlockingSearchPlugin : public AbstractSearchPlugin
+{
+public:
+    QSet<qint64> results;
+    int searches = 0;
+
+    QSet<qint64> search(const QString &, const QList<qint64> &, const QStringList &) override
+    {
+        ++searches;
+        return results;
+    }
+};
+
+} // namespace
+
 Q_DECLARE_METATYPE(QList<qint64>)
 Q_DECLARE_METATYPE(QList<QString>)
 
@@ -117,6 +171,77 @@ private Q_SLOTS:
         QCOMPARE(results.size(), expectedResults.size());
         QCOMPARE(results, expectedResults);
     }
+
+    void testSearchRequest_data()
+    {
+        QTest::addColumn<int>("limit");
+        QTest::addColumn<int>("cancelAfterBatches");
+        QTest::addColumn<QSet<qint64>>("expectedResults");
+        QTest::addColumn<int>("expectedBatches");
+        QTest::addColumn<int>("expectedBlockingSearches");
+
+        QTest::newRow("all results") << -1 << -1 << QSet<qint64>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11} << 4 << 1;
+        QTest::newRow("limited") << 5 << -1 << QSet<qint64>{1, 2, 3, 4, 5} << 2 << 0;
+        QTest::newRow("limit above streamed results") << 11 << -1 << QSet<qint64>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11} << 4 << 1;
+        QTest::newRow("cancelled") << -1 << 1 << QSet<qint64>{1, 2, 3} << 1 << 0;
+    }
+
+    void testSearchRequest()
+    {
+        QFETCH(int, limit);
+        QFETCH(int, cancelAfterBatches);
+        QFETCH(QSet<qint64>, expectedResults);
+        QFETCH(int, expectedBatches);
+        QFETCH(int, expectedBlockingSearches);
+
+        // Most relevant first
+        StreamingSearchPlugin streaming;
+        for (qint64 id = 1; id <= 10; ++id) {
+            streaming.results.push_back({id, 1.0 / double(id)});
+        }
+        BlockingSearchPlugin blocking;
+        blocking.results = {9, 10, 11};
+
+        auto &searchManager = static_cast<FakeSearchManager &>(mAkonadi.searchManager());
+        searchManager.setSearchPlugins({&streaming, &blocking});
+
+        SearchRequest request("searchtest", searchManager, mAkonadi.agentSearchManager());
+        request.setQuery(QStringLiteral("{}"));
+        request.setLimit(limit);
+        QList<QSet<qint64>> emitted;
+        connect(&request, &SearchRequest::resultsAvailable, this, [&](const QSet<qint64> &results) {
+            emitted.push_back(results);
+            if (emitted.size() == cancelAfterBatches) {
+                request.cancel();
+            }
+        });
+        request.exec();
+        searchManager.setSearchPlugins({});
+
+        QCOMPARE(request.results(), expectedResults);
+        QCOMPARE(streaming.batches, expectedBatches);
+        QCOMPARE(blocking.searches, expectedBlockingSearches);
+        QCOMPARE(request.isCancelled(), cancelAfterBatches > 0);
+        QCOMPARE(streaming.cancelled, cancelAfterBatches > 0 || (limit >= 0 && limit < 10));
+
+        // Every result is emitted once, as soon as its batch is delivered
+        QSet<qint64> allEmitted;
+        for (const auto &batch : std::as_const(emitted)) {
+            QVERIFY(!batch.isEmpty());
+            QVERIFY(!allEmitted.intersects(batch));
+            allEmitted.unite(batch);
+        }
+        QCOMPARE(allEmitted, expectedResults);
+        QVERIFY(emitted.size() >= expectedBatches);
+    }
+
+    void testLimitFromQuery()
+    {
+        QCOMPARE(SearchRequest::limitFromQuery(QStringLiteral(R"({"rel":0,"subTerms":[],"limit":25})")), 25);
+        QCOMPARE(SearchRequest::limitFromQuery(QStringLiteral(R"({"rel":0,"subTerms":[],"limit":-1})")), -1);
+        QCOMPARE(SearchRequest::limitFromQuery(QStringLiteral(R"({"rel":0,"subTerms":[]})")), -1);
+        QCOMPARE(SearchRequest::limitFromQuery(QStringLiteral("{ }")), -1);
+    }
 };
 
 AKTEST_FAKESERVER_MAIN(SearchTest)
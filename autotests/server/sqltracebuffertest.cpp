@@ -0,0 +1,262 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "aktest.h"
+#include "entities.h"
+#include "fakeakonadiserver.h"
+#include "storage/datastore.h"
+#include "storage/querybuilder.h"
+#include "storage/sqltracebuffer.h"
+#include "storage/transaction.h"
+
+#include "private/protocol_p.h"
+#include "private/standarddirs_p.h"
+
+#include <QFile>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+namespace
+{
+const auto *const sStore = reinterpret_cast<const DataStore *>(0x1234);
+const QString sSelect = QStringLiteral("SELECT id FROM PimItemTable WHERE collectionId = :0");
+const QString sUpdate = QStringLiteral("UPDATE PimItemTable SET dirty = :0 WHERE id = :1");
+
+} // namespace
+
+class SqlTraceBufferTest : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    SqlTraceBufferTest()
+    {
+        // Trace every command
+        QSettings settings(StandardDirs::serverConfigFile(StandardDirs::ReadWrite), QSettings::IniFormat);
+        settings.setValue(QStringLiteral("Debug/SqlTraceSampleRate"), 1);
+        settings.sync();
+
+        mAkonadi.init();
+    }
+
+private Q_SLOTS:
+    void testRecordCommand()
+    {
+        SqlTraceBuffer buffer(1, 16);
+        buffer.beginCommand(static_cast<quint16>(Protocol::Command::FetchItems));
+        QVERIFY(buffer.isRecording());
+        for (int i = 0; i < 3; ++i) {
+            buffer.recordQuery(sStore, sSelect, 100, 1, false);
+        }
+        buffer.recordTransactionBegin(sStore, 50);
+        buffer.recordQuery(sStore, sUpdate, 200, 1, false);
+        buffer.recordTransactionEnd(sStore, true, 400);
+        buffer.endCommand();
+
+        const auto trace = buffer.snapshot();
+        QCOMPARE(trace.records.size(), 6);
+        QCOMPARE(trace.statements.size(), 2);
+        QCOMPARE(trace.statements.value(SqlTrace::statementHash(sSelect)), sSelect);
+
+        const auto &first = trace.records.at(0);
+        QCOMPARE(first.type, SqlTrace::EventType::Query);
+        QCOMPARE(first.connectionId, reinterpret_cast<qint64>(sStore));
+        QCOMPARE(first.statementHash, SqlTrace::statementHash(sSelect));
+        QCOMPARE(first.duration, 100U);
+        QCOMPARE(first.rows, 1);
+        QCOMPARE(first.commandType, static_cast<quint16>(Protocol::Command::FetchItems));
+        QVERIFY(first.command > 0);
+        QCOMPARE(first.transaction, 0U);
+
+        const auto &update = trace.records.at(4);
+        QVERIFY(update.transaction > 0);
+        QCOMPARE(update.command, first.command);
+        QCOMPARE(trace.records.at(5).type, SqlTrace::EventType::TransactionCommit);
+        QCOMPARE(trace.records.at(5).transaction, update.transaction);
+
+        const auto repeated = SqlTrace::repeatedStatements(trace, 3);
+        QCOMPARE(repeated.size(), 1);
+        QCOMPARE(repeated[0].statementHash, SqlTrace::statementHash(sSelect));
+        QCOMPARE(repeated[0].count, 3);
+
+        const auto top = SqlTrace::topStatements(trace);
+        QCOMPARE(top.size(), 2);
+        QCOMPARE(top[0].statementHash, SqlTrace::statementHash(sSelect));
+        QCOMPARE(top[0].totalDuration, 300);
+
+        const auto transactions = SqlTrace::transactions(trace);
+        QCOMPARE(transactions.size(), 1);
+        QVERIFY(transactions[0].committed);
+        QCOMPARE(transactions[0].beginDuration, 50);
+        QCOMPARE(transactions[0].holdDuration, 400);
+        QCOMPARE(transactions[0].statements, 1);
+    }
+
+    void testSampling()
+    {
+        SqlTraceBuffer buffer(4, 64);
+        for (int i = 0; i < 20; ++i) {
+            buffer.beginCommand(static_cast<quint16>(Protocol::Command::FetchItems));
+            if (buffer.isRecording()) {
+                buffer.recordQuery(sStore, sSelect, 10, 1, false);
+                buffer.recordQuery(sStore, sSelect, 10, 1, false);
+            }
+            buffer.endCommand();
+        }
+        // Commands are sampled as a whole
+        QCOMPARE(buffer.snapshot().records.size(), 10);
+    }
+
+    void testDisabled()
+    {
+        SqlTraceBuffer buffer(0, 64);
+        buffer.beginCommand(static_cast<quint16>(Protocol::Command::FetchItems));
+        QVERIFY(!buffer.isRecording());
+        buffer.endCommand();
+        QCOMPARE(buffer.capacity(), 0);
+        QVERIFY(buffer.snapshot().records.isEmpty());
+    }
+
+    void testOverwrite()
+    {
+        SqlTraceBuffer buffer(1, 4);
+        QCOMPARE(buffer.capacity(), 4);
+        for (int i = 0; i < 10; ++i) {
+            buffer.recordQuery(sStore, sSelect, i, i, false);
+        }
+        const auto trace = buffer.snapshot();
+        QCOMPARE(trace.dropped, 6U);
+        QCOMPARE(trace.records.size(), 4);
+        QCOMPARE(trace.records.first().duration, 6U);
+        QCOMPARE(trace.records.last().duration, 9U);
+    }
+
+    void testStatementsBounded()
+    {
+        SqlTraceBuffer buffer(1, 16);
+        buffer.recordQuery(sStore, sSelect, 1, 1, false);
+        // Statements with literals, or IN lists of varying length, must not accumulate
+        for (int i = 0; i < 1000; ++i) {
+            buffer.recordQuery(sStore, QStringLiteral("SELECT id FROM PimItemTable WHERE id = %1").arg(i), 1, 1, false);
+        }
+        auto trace = buffer.snapshot();
+        QCOMPARE(trace.records.size(), 16);
+        QVERIFY(trace.statements.size() <= 2 * buffer.capacity());
+        QVERIFY(!trace.statements.contains(SqlTrace::statementHash(sSelect)));
+        for (const auto &record : std::as_const(trace.records)) {
+            QVERIFY(trace.statements.contains(record.statementHash));
+        }
+
+        // A statement which has been dropped is registered again with its next record
+        buffer.recordQuery(sStore, sSelect, 1, 1, false);
+        trace = buffer.snapshot();
+        QCOMPARE(trace.statements.value(SqlTrace::statementHash(sSelect)), sSelect);
+    }
+
+    void testConcurrentWriters()
+    {
+        SqlTraceBuffer buffer(1, 1024);
+        std::vector<std::unique_ptr<QThread>> threads;
+        for (int thread = 1; thread <= 8; ++thread) {
+            threads.emplace_back(QThread::create([&buffer, thread]() {
+                for (int i = 0; i < 10000; ++i) {
+                    buffer.recordQuery(reinterpret_cast<const DataStore *>(quintptr(thread)), sSelect, thread, thread, false);
+                }
+            }));
+            threads.back()->start();
+        }
+
+        // Snapshots taken while writing must not contain torn records
+        for (int i = 0; i < 20; ++i) {
+            const auto trace = buffer.snapshot();
+            for (const auto &record : trace.records) {
+                QCOMPARE(record.connectionId, qint64(record.duration));
+                QCOMPARE(record.rows, qint64(record.duration));
+            }
+        }
+        for (const auto &thread : threads) {
+            QVERIFY(thread->wait());
+        }
+        // Records are only dropped if a thread is preempted while the buffer wraps around
+        const auto count = buffer.snapshot().records.size();
+        QVERIFY(count > 1000 && count <= 1024);
+    }
+
+    void testDump()
+    {
+        SqlTraceBuffer buffer(1, 16);
+        buffer.beginCommand(static_cast<quint16>(Protocol::Command::ModifyItems));
+        buffer.recordTransactionBegin(sStore, 5);
+        buffer.recordQuery(sStore, sUpdate, 20, 3, true);
+        buffer.recordTransactionEnd(sStore, false, 30);
+        buffer.endCommand();
+
+        QTemporaryDir dir;
+        const QString fileName = dir.filePath(QStringLiteral("trace"));
+        QVERIFY(buffer.dump(fileName));
+
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        SqlTrace::Trace trace;
+        QVERIFY(SqlTrace::read(&file, trace));
+
+        const auto expected = buffer.snapshot();
+        QCOMPARE(trace.startTime, expected.startTime);
+        QCOMPARE(trace.statements, expected.statements);
+        QCOMPARE(trace.records.size(), 3);
+        QCOMPARE(trace.records[1].flags, quint8(SqlTrace::Error));
+        QCOMPARE(trace.records[1].rows, 3);
+        QCOMPARE(trace.records[2].type, SqlTrace::EventType::TransactionRollback);
+        QVERIFY(!SqlTrace::transactions(trace).constFirst().committed);
+    }
+
+    void testQueryBuilder()
+    {
+        auto *buffer = SqlTraceBuffer::self();
+        QCOMPARE(buffer->sampleRate(), 1U);
+
+        buffer->beginCommand(static_cast<quint16>(Protocol::Command::FetchItems));
+        {
+            Transaction transaction(DataStore::self(), QStringLiteral("TRACE"));
+            QueryBuilder qb(PimItem::tableName());
+            qb.addColumn(PimItem::idColumn());
+            QVERIFY(qb.exec());
+            qb.query().finish();
+            QVERIFY(transaction.commit());
+        }
+        buffer->endCommand();
+
+        // Other threads might be recording as well
+        auto records = buffer->snapshot().records;
+        const auto connectionId = reinterpret_cast<qint64>(DataStore::self());
+        records.removeIf([connectionId](const SqlTrace::Record &record) {
+            return record.connectionId != connectionId;
+        });
+        QCOMPARE(records.size(), 3);
+        QCOMPARE(records[0].type, SqlTrace::EventType::TransactionBegin);
+        QCOMPARE(records[1].type, SqlTrace::EventType::Query);
+        QCOMPARE(records[1].commandType, static_cast<quint16>(Protocol::Command::FetchItems));
+        QCOMPARE(records[1].transaction, records[0].transaction);
+        QVERIFY(buffer->snapshot().statements.value(records[1].statementHash).contains(PimItem::tableName()));
+        QCOMPARE(records[2].type, SqlTrace::EventType::TransactionCommit);
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(SqlTraceBufferTest)
+
+#include "sqltracebuffertest.moc"
@@ -0,0 +1,227 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QObject>
+
+#include "entities.h"
+#include "fakeakonadiserver.h"
+#include "shared/aktest.h"
+#include "storage/datastore.h"
+#include "storage/packedpartstorage.h"
+#include "storage/parthelper.h"
+#include "storage/parttypehelper.h"
+#include "storagejanitor.h"
+
+#include "private/standarddirs_p.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QSettings>
+#include <QTest>
+
+#include <algorithm>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+class StorageJanitorTest : public QObject
+{
+    Q_OBJECT
+
+    FakeAkonadiServer mAkonadi;
+
+public:
+    StorageJanitorTest()
+    {
+        // Parts bigger than the default size threshold of 4 KiB are packed up to 16 KiB
+        const QString serverConfigFile = StandardDirs::serverConfigFile(StandardDirs::ReadWrite);
+        QSettings settings(serverConfigFile, QSettings::IniFormat);
+        settings.setValue(QStringLiteral("General/PackedPartThreshold"), 16 * 1024);
+
+        mAkonadi.init();
+    }
+
+    struct CheckResult {
+        QStringList messages;
+        QList<int> progress;
+        bool done = false;
+    };
+
+    void runCheck(CheckResult &result)
+    {
+        auto janitor = AkThread::create<StorageJanitor>(&mAkonadi);
+        // Queued, the signals are emitted from the janitor threads
+        connect(janitor.get(), &StorageJanitor::information, this, [&result](const QString &msg) {
+            result.messages.push_back(msg);
+        });
+        connect(janitor.get(), &StorageJanitor::progress, this, [&result](int percent) {
+            result.progress.push_back(percent);
+        });
+        connect(janitor.get(), &StorageJanitor::done, this, [&result]() {
+            result.done = true;
+        });
+        QMetaObject::invokeMethod(janitor.get(), &StorageJanitor::check, Qt::QueuedConnection);
+        QTRY_VERIFY_WITH_TIMEOUT(result.done, 60000);
+        janitor.reset();
+        // Deliver the signals emitted right before done()
+        QCoreApplication::processEvents();
+    }
+
+    /// The tasks querying the agent manager and the search plugins have nothing to check against in the fake server
+    void writeCheckpoint(const QStringList &finishedTasks)
+    {
+        QSettings checkpoint(StorageJanitor::checkpointFileName(), QSettings::IniFormat);
+        checkpoint.setValue(QStringLiteral("Check/Started"), QDateTime::currentDateTime());
+        checkpoint.setValue(QStringLiteral("Check/FinishedTasks"),
+                            QStringList{QStringLiteral("findOrphanedResources"), QStringLiteral("findOrphanSearchIndexEntries")} + finishedTasks);
+    }
+
+    /// Inserts a part bypassing PartHelper, so that it is stored as @p storage regardless of its size
+    Part insertPart(const PimItem &item, const QString &name, const QByteArray &data, Part::Storage storage)
+    {
+        Part part;
+        part.setPimItemId(item.id());
+        part.setPartTypeId(PartTypeHelper::fromFqName(QStringLiteral("PLD"), name).id());
+        part.setDatasize(data.size());
+        part.setStorage(storage);
+        if (storage == Part::Packed) {
+            QByteArray location;
+            if (!PackedPartStorage::self()->appendPart(data, location)) {
+                return {};
+            }
+            part.setData(location);
+        } else {
+            part.setData(data);
+        }
+        if (!part.insert()) {
+            return {};
+        }
+        return part;
+    }
+
+private Q_SLOTS:
+    void testCheck()
+    {
+        writeCheckpoint({});
+
+        CheckResult result;
+        runCheck(result);
+        QVERIFY(result.done);
+        QVERIFY(result.messages.contains(QLatin1StringView("Consistency check done.")));
+        QVERIFY(!result.progress.isEmpty());
+        // The lanes report their progress concurrently, so only the maximum is well defined
+        QCOMPARE(*std::max_element(result.progress.cbegin(), result.progress.cend()), 100);
+        QVERIFY(!QFile::exists(StorageJanitor::checkpointFileName()));
+    }
+
+    void testResume()
+    {
+        writeCheckpoint({QStringLiteral("findDuplicateFlags"), QStringLiteral("verifyExternalParts")});
+
+        CheckResult result;
+        runCheck(result);
+        QVERIFY(result.done);
+        QVERIFY(std::any_of(result.messages.cbegin(), result.messages.cend(), [](const QString &msg) {
+            return msg.startsWith(QLatin1StringView("Resuming the consistency check"));
+        }));
+        for (const auto &msg : result.messages) {
+            QVERIFY2(!msg.contains(QLatin1StringView("Looking for duplicate item flags...")), qPrintable(msg));
+            QVERIFY2(!msg.contains(QLatin1StringView("Verifying external parts...")), qPrintable(msg));
+        }
+        QVERIFY(result.messages.contains(QLatin1StringView("Consistency check done.")));
+        QVERIFY(result.progress.contains(100));
+        QVERIFY(!QFile::exists(StorageJanitor::checkpointFileName()));
+    }
+
+    void testPackedParts()
+    {
+        auto *storage = PackedPartStorage::self();
+
+        PimItem item;
+        item.setCollectionId(Collection::retrieveByName(QStringLiteral("Collection A")).id());
+        item.setMimeTypeId(MimeType::retrieveByName(QStringLiteral("application/octet-stream")).id());
+        item.setRemoteId(QStringLiteral("janitor-packed"));
+        QVERIFY(item.insert());
+
+        // Packed parts in a segment which is mostly occupied by unused records
+        const Part packed = insertPart(item, QStringLiteral("RFC822"), QByteArray(5000, 'a'), Part::Packed);
+        QVERIFY(packed.isValid());
+        const qint64 oldSegment = PackedPartStorage::Location::fromByteArray(packed.data()).segment;
+        QByteArray location;
+        QVERIFY(storage->appendPart(QByteArray(PackedPartStorage::MaxSegmentSize / 2, 'x'), location));
+        QCOMPARE(PackedPartStorage::Location::fromByteArray(location).segment, oldSegment);
+        // Starts a new segment
+        QVERIFY(storage->appendPart(QByteArray(PackedPartStorage::MaxSegmentSize / 2, 'x'), location));
+        QVERIFY(storage->activeSegment() > oldSegment);
+        storage->sync();
+
+        // Parts whose size no longer matches their storage
+        const Part toPack = insertPart(item, QStringLiteral("HEAD"), QByteArray(6000, 'b'), Part::Internal);
+        QVERIFY(toPack.isValid());
+        const Part toUnpack = insertPart(item, QStringLiteral("BODY"), "small", Part::Packed);
+        QVERIFY(toUnpack.isValid());
+        storage->sync();
+
+        writeCheckpoint({});
+        CheckResult result;
+        runCheck(result);
+        QVERIFY(result.messages.contains(QLatin1StringView("Consistency check done.")));
+
+        // verifyExternalParts() must not take the segments for unreferenced files
+        const Part compacted = Part::retrieveById(packed.id());
+        QCOMPARE(compacted.storage(), Part::Packed);
+        QCOMPARE(PartHelper::translateData(compacted), QByteArray(5000, 'a'));
+        QVERIFY(PackedPartStorage::Location::fromByteArray(compacted.data()).segment != oldSegment);
+        QVERIFY(!storage->segmentSizes().contains(oldSegment));
+        QVERIFY(QFile::exists(PackedPartStorage::segmentPath(storage->activeSegment())));
+
+        const Part packedNow = Part::retrieveById(toPack.id());
+        QCOMPARE(packedNow.storage(), Part::Packed);
+        QCOMPARE(PartHelper::translateData(packedNow), QByteArray(6000, 'b'));
+        const Part unpackedNow = Part::retrieveById(toUnpack.id());
+        QCOMPARE(unpackedNow.storage(), Part::Internal);
+        QCOMPARE(unpackedNow.data(), QByteArray("small"));
+
+        // The compacted segment is removed once no reader can refer to it anymore
+        QCOMPARE(storage->removeRetiredSegments(std::chrono::seconds(0)), 1);
+        QVERIFY(!QFile::exists(PackedPartStorage::segmentPath(oldSegment)));
+    }
+
+    void testPendingPackedParts()
+    {
+        auto *storage = PackedPartStorage::self();
+
+        // A record of a transaction which has not been committed yet, in a segment without any committed parts
+        QByteArray location;
+        QVERIFY(storage->appendPart(QByteArray(5000, 'p'), location, DataStore::self()));
+        const qint64 pendingSegment = PackedPartStorage::Location::fromByteArray(location).segment;
+        QVERIFY(storage->pendingSegments().contains(pendingSegment));
+        while (storage->activeSegment() == pendingSegment) {
+            QVERIFY(storage->appendPart(QByteArray(PackedPartStorage::MaxSegmentSize / 2, 'x'), location));
+        }
+        storage->sync();
+
+        writeCheckpoint({});
+        CheckResult result;
+        runCheck(result);
+        QVERIFY(result.messages.contains(QLatin1StringView("Consistency check done.")));
+        QVERIFY(storage->segmentSizes().contains(pendingSegment));
+
+        // Once the transaction has finished, the unreferenced record is dropped
+        storage->releasePendingRecords(DataStore::self());
+        QVERIFY(!storage->pendingSegments().contains(pendingSegment));
+        writeCheckpoint({});
+        CheckResult secondResult;
+        runCheck(secondResult);
+        QVERIFY(secondResult.messages.contains(QLatin1StringView("Consistency check done.")));
+        QVERIFY(!storage->segmentSizes().contains(pendingSegment));
+    }
+};
+
+AKTEST_FAKESERVER_MAIN(StorageJanitorTest)
+
+#include "storagejanitortest.moc"
@@ -26,13 +26,52 @@ void PreprocessorBase::finishProcessing(ProcessingResult result)
     Q_D(PreprocessorBase);
 
     Q_ASSERT_X(result != ProcessingDelayed, "PreprocessorBase::terminateProcessing", "You should never pass ProcessingDelayed to this function");
-    Q_ASSERT_X(d->mInDelayedProcessing, "PreprocessorBase::terminateProcessing", "terminateProcessing() called while not in delayed processing mode");
-    Q_UNUSED(result)
+    Q_ASSERT_X(d->mInDelayedProcessing || !d->mDelayedItems.isEmpty(),
+               "PreprocessorBase::terminateProcessing",
+               "terminateProcessing() called while not in delayed processing mode");
+
+    if (!d->mDelayedItems.isEmpty()) {
+        Q_ASSERT_X(d->mDelayedItems.size() == 1, "PreprocessorBase::finishProcessing", "Use finishProcessing(item, result) for concurrent items");
+        d->batchItemProcessed(*d->mDelayedItems.cbegin(), result);
+        return;
+    }
 
+    Q_UNUSED(result)
     d->mInDelayedProcessing = false;
     Q_EMIT d->itemProcessed(d->mDelayedProcessingItemId);
 }
 
+void PreprocessorBase::finishProcessing(const Item &item, ProcessingResult result)
+{
+    Q_D(PreprocessorBase);
+
+    Q_ASSERT_X(result != ProcessingDelayed, "PreprocessorBase::finishProcessing", "You should never pass ProcessingDelayed to this function");
+
+    if (d->mDelayedItems.contains(item.id())) {
+        d->batchItemProcessed(item.id(), result);
+        return;
+    }
+
+    // The item was handed to us via D-Bus
+    Q_ASSERT_X(d->mInDelayedProcessing && d->mDelayedProcessingItemId == item.id(),
+               "PreprocessorBase::finishProcessing",
+               "finishProcessing() called for an item which is not in delayed processing");
+    d->mInDelayedProcessing = false;
+    Q_EMIT d->itemProcessed(item.id());
+}
+
+void PreprocessorBase::setBatchProcessing(int maxBatchSize, int maxConcurrentItems)
+{
+    Q_D(PreprocessorBase);
+
+    Q_ASSERT(maxBatchSize > 0);
+    Q_ASSERT(maxConcurrentItems > 0);
+
+    d->mBatchMode = true;
+    d->mMaxBatchSize = maxBatchSize;
+    d->mMaxConcurrentItems = maxConcurrentItems;
+}
+
 void PreprocessorBase::setFetchScope(const ItemFetchScope &fetchScope)
 {
     Q_D(PreprocessorBase);
@@ -34,6 +34,11 @@ class PreprocessorBasePrivate;
  *
  * The method all the preprocessors must implement is processItem().
  *
+ * By default the items are handed to the preprocessor one at a time.
+ * Preprocessors that have to keep up with large imports can enable batched
+ * processing with setBatchProcessing(), in which case the items are delivered
+ * in batches and several of them may be processed at the same time.
+ *
  * \class Akonadi::PreprocessorBase
  * \inheaderfile Akonadi/PreprocessorBase
  * \inmodule AkonadiAgentBase
@@ -116,6 +121,41 @@ public:
      */
     void finishProcessing(ProcessingResult result);
 
+    /*!
+     * This method must be called when the asynchronous processing of
+     * \a item has finished, if several items may be processed at the same
+     * time, see setBatchProcessing().
+     *
+     * \a item the item for which processItem() returned ProcessingDelayed
+     *
+     * \a result the processing result, ProcessingCompleted, ProcessingRefused
+     * or ProcessingFailed
+     *
+     * \since 6.9
+     */
+    void finishProcessing(const Item &item, ProcessingResult result);
+
+    /*!
+     * Enables batched processing of the items.
+     *
+     * Instead of being notified about each new item via D-Bus, the preprocessor
+     * receives batches of up to \a maxBatchSize items over its connection
+     * to the Akonadi server, fetches them at once and reports the result of
+     * each item back with the next request. Up to \a maxConcurrentItems items
+     * are processed at the same time, that is processItem() is called for the
+     * next item while up to \a maxConcurrentItems - 1 items are in delayed
+     * processing. With more than one concurrent item, delayed processing
+     * has to be finished with finishProcessing(const Item &, ProcessingResult).
+     *
+     * As with single items, the server asks the preprocessor to abort if it
+     * makes no progress on a batch for two minutes and restarts it eventually.
+     *
+     * This should be called from the constructor of the preprocessor.
+     *
+     * \since 6.9
+     */
+    void setBatchProcessing(int maxBatchSize, int maxConcurrentItems = 1);
+
     /*!
      * Sets the item fetch scope.
      *
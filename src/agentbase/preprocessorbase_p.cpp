@@ -9,11 +9,21 @@
 #include "preprocessoradaptor.h"
 #include "servermanager.h"
 #include <QDBusConnection>
+#include <QTimer>
 
 #include "akonadiagentbase_debug.h"
 #include "itemfetchjob.h"
+#include "preprocessitemsjob_p.h"
+#include "session.h"
 
 using namespace Akonadi;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Delay before a failed request for a batch is repeated
+constexpr auto BatchRetryInterval = 5s;
+}
 
 PreprocessorBasePrivate::PreprocessorBasePrivate(PreprocessorBase *parent)
     : AgentBasePrivate(parent)
@@ -33,6 +43,11 @@ void PreprocessorBasePrivate::delayedInit()
         qCCritical(AKONADIAGENTBASE_LOG) << "Unable to register service at D-Bus: " << QDBusConnection::sessionBus().lastError().message();
     }
     AgentBasePrivate::delayedInit();
+
+    if (mBatchMode) {
+        mBatchSession = new Session(mId.toLatin1() + "-preprocessor", this);
+        requestBatch();
+    }
 }
 
 void PreprocessorBasePrivate::beginProcessItem(qlonglong itemId, qlonglong collectionId, const QString &mimeType)
@@ -83,4 +98,152 @@ void PreprocessorBasePrivate::itemFetched(KJob *job)
     }
 }
 
+void PreprocessorBasePrivate::requestBatch()
+{
+    if (mBatchRequestRunning) {
+        // The results are reported with the next request
+        return;
+    }
+
+    const bool haveResults = !mCompletedItems.isEmpty() || !mFailedItems.isEmpty() || !mRefusedItems.isEmpty();
+    const auto maxBatchSize = mMaxBatchSize - mUnfinishedItems.size();
+    // Without results the request is sent only once all items are finished, as the server waits for new items then
+    if (maxBatchSize <= 0 || (!haveResults && !mUnfinishedItems.isEmpty())) {
+        return;
+    }
+
+    auto job = new PreprocessItemsJob(mId, static_cast<int>(maxBatchSize), mBatchSession);
+    job->setCompletedItems(std::exchange(mCompletedItems, {}));
+    job->setFailedItems(std::exchange(mFailedItems, {}));
+    job->setRefusedItems(std::exchange(mRefusedItems, {}));
+    // Items handed out to a previous process of this preprocessor, which crashed or was restarted, are not lost
+    job->setFirstRequest(!mBatchSessionStarted);
+    connect(job, &PreprocessItemsJob::result, this, &PreprocessorBasePrivate::batchReceived);
+    mBatchRequestRunning = true;
+}
+
+void PreprocessorBasePrivate::batchReceived(KJob *job)
+{
+    mBatchRequestRunning = false;
+
+    if (job->error()) {
+        qCWarning(AKONADIAGENTBASE_LOG) << "PreprocessorBase: failed to request items:" << job->errorString();
+        // Report the results again, the server ignores items it has already been told about
+        const auto batchJob = qobject_cast<PreprocessItemsJob *>(job);
+        mCompletedItems += batchJob->completedItems();
+        mFailedItems += batchJob->failedItems();
+        mRefusedItems += batchJob->refusedItems();
+        QTimer::singleShot(BatchRetryInterval, this, &PreprocessorBasePrivate::requestBatch);
+        return;
+    }
+    mBatchSessionStarted = true;
+
+    const auto ids = qobject_cast<PreprocessItemsJob *>(job)->items();
+    if (ids.isEmpty()) {
+        // Nothing arrived while the server waited: ask again. Otherwise the next
+        // request is sent once items in progress are finished
+        if (mUnfinishedItems.isEmpty()) {
+            requestBatch();
+        }
+        return;
+    }
+
+    qCDebug(AKONADIAGENTBASE_LOG) << "PreprocessorBase: about to process a batch of" << ids.size() << "items";
+
+    Item::List items;
+    items.reserve(ids.size());
+    for (qint64 id : ids) {
+        mUnfinishedItems.insert(id);
+        items.push_back(Item(id));
+    }
+
+    auto fetchJob = new ItemFetchJob(items, this);
+    fetchJob->setFetchScope(mFetchScope);
+    fetchJob->setProperty("ids", QVariant::fromValue(ids));
+    connect(fetchJob, &ItemFetchJob::result, this, &PreprocessorBasePrivate::batchFetched);
+}
+
+void PreprocessorBasePrivate::batchFetched(KJob *job)
+{
+    const auto ids = job->property("ids").value<QList<qint64>>();
+    if (job->error()) {
+        qCWarning(AKONADIAGENTBASE_LOG) << "PreprocessorBase: failed to fetch a batch of items:" << job->errorString();
+        for (qint64 id : ids) {
+            recordResult(id, PreprocessorBase::ProcessingFailed);
+        }
+        requestBatch();
+        return;
+    }
+
+    const auto items = qobject_cast<ItemFetchJob *>(job)->items();
+    QSet<qint64> fetched;
+    fetched.reserve(items.size());
+    for (const Item &item : items) {
+        fetched.insert(item.id());
+        mPendingItems.push_back(item);
+    }
+    // Items deleted in the meantime
+    for (qint64 id : ids) {
+        if (!fetched.contains(id)) {
+            recordResult(id, PreprocessorBase::ProcessingFailed);
+        }
+    }
+
+    processPendingItems();
+}
+
+void PreprocessorBasePrivate::processPendingItems()
+{
+    Q_Q(PreprocessorBase);
+
+    // finishProcessing() may be called from within processItem()
+    if (mProcessingPendingItems) {
+        return;
+    }
+    mProcessingPendingItems = true;
+
+    while (!mPendingItems.empty() && mDelayedItems.size() < mMaxConcurrentItems) {
+        const Item item = mPendingItems.front();
+        mPendingItems.pop_front();
+
+        const auto result = q->processItem(item);
+        if (result == PreprocessorBase::ProcessingDelayed) {
+            qCDebug(AKONADIAGENTBASE_LOG) << "PreprocessorBase: item processing delayed (" << item.id() << ")";
+            mDelayedItems.insert(item.id());
+        } else {
+            recordResult(item.id(), result);
+        }
+    }
+
+    mProcessingPendingItems = false;
+
+    requestBatch();
+}
+
+void PreprocessorBasePrivate::batchItemProcessed(qint64 itemId, PreprocessorBase::ProcessingResult result)
+{
+    mDelayedItems.remove(itemId);
+    recordResult(itemId, result);
+    processPendingItems();
+}
+
+void PreprocessorBasePrivate::recordResult(qint64 itemId, PreprocessorBase::ProcessingResult result)
+{
+    mUnfinishedItems.remove(itemId);
+
+    switch (result) {
+    case PreprocessorBase::ProcessingCompleted:
+        mCompletedItems.push_back(itemId);
+        break;
+    case PreprocessorBase::ProcessingFailed:
+        mFailedItems.push_back(itemId);
+        break;
+    case PreprocessorBase::ProcessingRefused:
+        mRefusedItems.push_back(itemId);
+        break;
+    case PreprocessorBase::ProcessingDelayed:
+        Q_UNREACHABLE();
+    }
+}
+
 #include "moc_preprocessorbase_p.cpp"
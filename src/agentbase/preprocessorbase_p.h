@@ -11,10 +11,16 @@
 #include "itemfetchscope.h"
 #include "preprocessorbase.h"
 
+#include <QSet>
+
+#include <deque>
+
 class KJob;
 
 namespace Akonadi
 {
+class Session;
+
 class PreprocessorBasePrivate : public AgentBasePrivate
 {
     Q_OBJECT
@@ -26,17 +32,49 @@ public:
 
     void beginProcessItem(qlonglong itemId, qlonglong collectionId, const QString &mimeType);
 
+    /// Records the result of an item of a batch and continues with the next items
+    void batchItemProcessed(qint64 itemId, PreprocessorBase::ProcessingResult result);
+
 Q_SIGNALS:
     void itemProcessed(qlonglong id);
 
 private Q_SLOTS:
     void itemFetched(KJob *job);
 
+private:
+    /// Reports the finished items and requests more, if there is room for them
+    void requestBatch();
+    void batchReceived(KJob *job);
+    void batchFetched(KJob *job);
+    void processPendingItems();
+    void recordResult(qint64 itemId, PreprocessorBase::ProcessingResult result);
+
 public:
     bool mInDelayedProcessing = false;
     qlonglong mDelayedProcessingItemId = 0;
     ItemFetchScope mFetchScope;
 
+    // Batched processing
+    bool mBatchMode = false;
+    int mMaxBatchSize = 1;
+    int mMaxConcurrentItems = 1;
+    /// Dedicated to the requests for batches, which wait on the server
+    Session *mBatchSession = nullptr;
+    bool mBatchRequestRunning = false;
+    /// Set once the server has answered a request of this process
+    bool mBatchSessionStarted = false;
+    bool mProcessingPendingItems = false;
+    /// Items handed out by the server whose result has not been recorded yet
+    QSet<qint64> mUnfinishedItems;
+    /// Fetched items waiting for processItem()
+    std::deque<Item> mPendingItems;
+    /// Items in delayed processing
+    QSet<qint64> mDelayedItems;
+    /// Results to report with the next request
+    QList<qint64> mCompletedItems;
+    QList<qint64> mFailedItems;
+    QList<qint64> mRefusedItems;
+
     Q_DECLARE_PUBLIC(PreprocessorBase)
 };
 
@@ -198,6 +198,17 @@ static void runJanitor(const QString &operation)
     QObject::connect(&janitor, &org::freedesktop::Akonadi::Janitor::information, &janitor, [](const QString &msg) {
         std::cout << msg.toStdString() << std::endl;
     });
+    QObject::connect(&janitor, &org::freedesktop::Akonadi::Janitor::progress, &janitor, [lastPercent = -1](int percent, qlonglong remainingSeconds) mutable {
+        if (percent == lastPercent) {
+            return;
+        }
+        lastPercent = percent;
+        std::cout << "Progress: " << percent << "%";
+        if (remainingSeconds >= 0) {
+            std::cout << " (about " << remainingSeconds << " s remaining)";
+        }
+        std::cout << std::endl;
+    });
     QObject::connect(&janitor, &org::freedesktop::Akonadi::Janitor::done, &janitor, []() {
         qApp->exit();
     });
@@ -0,0 +1,142 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "shared/akapplication.h"
+
+#include "private/protocol_p.h"
+#include "private/sqltrace_p.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+
+using namespace Akonadi;
+
+namespace
+{
+QString commandName(quint16 commandType)
+{
+    if (commandType == 0) {
+        return QStringLiteral("(none)");
+    }
+    QString name;
+    QDebug(&name).noquote().nospace() << static_cast<Protocol::Command::Type>(commandType);
+    return name;
+}
+
+QString statementText(const SqlTrace::Trace &trace, quint32 hash)
+{
+    return trace.statements.value(hash, QStringLiteral("<unknown statement %1>").arg(hash, 8, 16, QLatin1Char('0')));
+}
+
+QString milliseconds(qint64 microseconds)
+{
+    return QString::number(microseconds / 1000.0, 'f', 3);
+}
+
+void printTopStatements(QTextStream &out, const SqlTrace::Trace &trace, int limit)
+{
+    out << "Top statements by total duration\n";
+    out << "      count     total ms       avg ms       max ms  errors  statement\n";
+    const auto stats = SqlTrace::topStatements(trace);
+    for (const auto &stat : stats.first(std::min<qsizetype>(limit, stats.size()))) {
+        out << qSetFieldWidth(11) << stat.count << qSetFieldWidth(13) << milliseconds(stat.totalDuration) << milliseconds(stat.totalDuration / stat.count)
+            << milliseconds(stat.maxDuration) << qSetFieldWidth(8) << stat.errors << qSetFieldWidth(0) << "  " << statementText(trace, stat.statementHash)
+            << "\n";
+    }
+    out << "\n";
+}
+
+void printRepeatedStatements(QTextStream &out, const SqlTrace::Trace &trace, qint64 threshold, int limit)
+{
+    out << "Statements executed at least " << threshold << " times by a single command (N+1 patterns)\n";
+    out << "      count     total ms  command                        statement\n";
+    const auto repeated = SqlTrace::repeatedStatements(trace, threshold);
+    for (const auto &stat : repeated.first(std::min<qsizetype>(limit, repeated.size()))) {
+        out << qSetFieldWidth(11) << stat.count << qSetFieldWidth(13) << milliseconds(stat.totalDuration) << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(30) << Qt::left << commandName(stat.commandType) << qSetFieldWidth(0) << Qt::right << " "
+            << statementText(trace, stat.statementHash) << "\n";
+    }
+    out << "\n";
+}
+
+void printTransactions(QTextStream &out, const SqlTrace::Trace &trace, int limit)
+{
+    const auto transactions = SqlTrace::transactions(trace);
+    qint64 totalHold = 0;
+    qint64 totalBegin = 0;
+    qint64 rolledBack = 0;
+    for (const auto &transaction : transactions) {
+        totalHold += transaction.holdDuration;
+        totalBegin += std::max<qint64>(transaction.beginDuration, 0);
+        rolledBack += transaction.committed ? 0 : 1;
+    }
+    out << "Transactions: " << transactions.size() << " finished, " << rolledBack << " rolled back, " << milliseconds(totalHold) << " ms held, "
+        << milliseconds(totalBegin) << " ms waiting to begin\n";
+    out << "    held ms   begin ms  statements  result    command\n";
+    for (const auto &transaction : transactions.first(std::min<qsizetype>(limit, transactions.size()))) {
+        out << qSetFieldWidth(11) << milliseconds(transaction.holdDuration)
+            << (transaction.beginDuration >= 0 ? milliseconds(transaction.beginDuration) : QStringLiteral("-")) << qSetFieldWidth(12)
+            << transaction.statements << qSetFieldWidth(0) << "  " << qSetFieldWidth(10) << Qt::left
+            << (transaction.committed ? QStringLiteral("commit") : QStringLiteral("rollback")) << qSetFieldWidth(0) << Qt::right
+            << commandName(transaction.commandType) << "\n";
+    }
+    out << "\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    AkCoreApplication app(argc, argv);
+    app.setDescription(
+        QStringLiteral("Akonadi SQL trace analyzer\n"
+                       "Analyzes SQL traces written by the Akonadi server, e.g. with\n"
+                       "qdbus org.freedesktop.Akonadi /storageDebug dumpSqlTrace /tmp/akonadi.sqltrace\n"
+                       "This is a development tool, only use this if you know what you are doing."));
+
+    app.addCommandLineOptions(
+        QCommandLineOption(QStringLiteral("limit"), QStringLiteral("Number of entries to print per section"), QStringLiteral("n"), QStringLiteral("20")));
+    app.addCommandLineOptions(QCommandLineOption(QStringLiteral("repeat-threshold"),
+                                                 QStringLiteral("Minimum number of executions of a statement by a single command to report it"),
+                                                 QStringLiteral("n"),
+                                                 QStringLiteral("10")));
+    app.addPositionalCommandLineOption(QStringLiteral("trace"), QStringLiteral("SQL trace file to analyze"));
+    app.parseCommandLine();
+
+    const auto &args = app.commandLineArguments();
+    if (args.positionalArguments().isEmpty()) {
+        app.printUsage();
+        return -1;
+    }
+
+    QFile file(args.positionalArguments().constFirst());
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Failed to open" << file.fileName() << ":" << file.errorString();
+        return 1;
+    }
+    SqlTrace::Trace trace;
+    if (!SqlTrace::read(&file, trace)) {
+        qCritical() << file.fileName() << "is not a valid SQL trace";
+        return 1;
+    }
+
+    const int limit = args.value(QStringLiteral("limit")).toInt();
+    const qint64 threshold = args.value(QStringLiteral("repeat-threshold")).toLongLong();
+
+    QTextStream out(stdout);
+    out << trace.records.size() << " records, sample rate 1/" << trace.sampleRate << ", " << trace.dropped << " records overwritten\n\n";
+    printTopStatements(out, trace, limit);
+    printRepeatedStatements(out, trace, threshold, limit);
+    printTransactions(out, trace, limit);
+
+    return 0;
+}
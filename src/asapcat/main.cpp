@@ -4,11 +4,82 @@
  *   SPDX-License-Identifier: LGPL-2.0-or-later                            *
  ***************************************************************************/
 
+#include "replaysession.h"
 #include "session.h"
 
 #include "shared/akapplication.h"
 
+#include "private/protocol_p.h"
+#include "private/protocolcapture_p.h"
+
+#include <QCommandLineOption>
 #include <QCoreApplication>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTimer>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Akonadi;
+
+static int replay(AkCoreApplication &app, const QString &fileName)
+{
+    const auto &args = app.commandLineArguments();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qFatal("Failed to open %s", qPrintable(fileName));
+    }
+    ProtocolCapture::Capture capture;
+    if (!ProtocolCapture::read(&file, capture)) {
+        qFatal("%s is not a valid protocol capture", qPrintable(fileName));
+    }
+    if (capture.header.protocolVersion != Protocol::version()) {
+        std::cerr << "Warning: the capture was recorded with protocol version " << capture.header.protocolVersion << ", this is version "
+                  << Protocol::version() << std::endl;
+    }
+
+    const QRegularExpression filter(args.value(QStringLiteral("session")));
+    if (!filter.isValid()) {
+        qFatal("Invalid session filter: %s", qPrintable(filter.errorString()));
+    }
+    const double speed = args.value(QStringLiteral("speed")).toDouble();
+
+    std::vector<std::unique_ptr<ReplaySession>> sessions;
+    int running = 0;
+    // The replay starts with the first session which is replayed
+    qint64 replayBegin = -1;
+    for (const auto &session : std::as_const(capture.sessions)) {
+        if (!filter.match(QString::fromUtf8(session.sessionId)).hasMatch()) {
+            continue;
+        }
+        if (replayBegin < 0) {
+            replayBegin = session.begin;
+        }
+        const qint64 delay = speed > 0 ? qint64((session.begin - replayBegin) / 1000 / speed) : 0;
+        auto replaySession = std::make_unique<ReplaySession>(session, speed);
+        QObject::connect(replaySession.get(), &ReplaySession::finished, QCoreApplication::instance(), [&running]() {
+            if (--running == 0) {
+                QCoreApplication::quit();
+            }
+        });
+        QTimer::singleShot(delay, replaySession.get(), &ReplaySession::connectToHost);
+        sessions.push_back(std::move(replaySession));
+        ++running;
+    }
+    if (sessions.empty()) {
+        std::cerr << "No sessions to replay" << std::endl;
+        return 0;
+    }
+
+    const int result = app.exec();
+    for (const auto &session : sessions) {
+        session->printStats();
+    }
+    return result;
+}
 
 int main(int argc, char **argv)
 {
@@ -17,6 +88,16 @@ int main(int argc, char **argv)
         QStringLiteral("Akonadi ASAP cat\n"
                        "This is a development tool, only use this if you know what you are doing."));
 
+    app.addCommandLineOptions(QCommandLineOption(QStringLiteral("replay"),
+                                                 QStringLiteral("Replay the sessions of a protocol capture recorded by the server, e.g. with\n"
+                                                                "qdbus org.freedesktop.Akonadi /debug startProtocolCapture /tmp/akonadi.capture \"\"")));
+    app.addCommandLineOptions(QCommandLineOption(QStringLiteral("speed"),
+                                                 QStringLiteral("Speed up the replay by the given factor, 0 sends all commands right away"),
+                                                 QStringLiteral("factor"),
+                                                 QStringLiteral("1")));
+    app.addCommandLineOptions(QCommandLineOption(QStringLiteral("session"),
+                                                 QStringLiteral("Only replay sessions of which the id matches the regular expression"),
+                                                 QStringLiteral("regexp")));
     app.addPositionalCommandLineOption(QStringLiteral("input"), QStringLiteral("Input file to read commands from"));
     app.parseCommandLine();
 
@@ -26,6 +107,10 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    if (app.commandLineArguments().isSet(QStringLiteral("replay"))) {
+        return replay(app, args[0]);
+    }
+
     Session session(args[0]);
     QObject::connect(&session, &Session::disconnected, QCoreApplication::instance(), &QCoreApplication::quit);
     QMetaObject::invokeMethod(&session, &Session::connectToHost, Qt::QueuedConnection);
@@ -0,0 +1,176 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "replaysession.h"
+#include "session.h"
+
+#include "private/datastream_p_p.h"
+#include "private/protocol_p.h"
+
+#include <QBuffer>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+using namespace Akonadi;
+using namespace std::chrono_literals;
+
+namespace
+{
+// The server answers the commands of a session in order, so once it has answered
+// the Logout command sent after the last frame all the other commands are answered
+// as well, and the server closes the connection. Commands of the capture may be
+// waiting for something that never happens in the replay though.
+constexpr auto ResponseTimeout = 5min;
+
+qint64 frameTag(const ProtocolCapture::Frame &frame)
+{
+    QByteArray data = frame.data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    Protocol::DataStream stream(&buffer);
+    qint64 tag = -1;
+    try {
+        stream >> tag;
+    } catch (const ProtocolException &) {
+        return -1;
+    }
+    return tag;
+}
+
+} // namespace
+
+ReplaySession::ReplaySession(const ProtocolCapture::Session &session, double speed, QObject *parent)
+    : QObject(parent)
+    , m_session(session)
+    , m_speed(speed)
+{
+    m_sendTimer.setSingleShot(true);
+    connect(&m_sendTimer, &QTimer::timeout, this, &ReplaySession::sendFrames);
+    m_responseTimer.setSingleShot(true);
+    m_responseTimer.setInterval(ResponseTimeout);
+    connect(&m_responseTimer, &QTimer::timeout, this, [this]() {
+        std::cerr << m_session.sessionId.constData() << ": timed out waiting for the server to answer all commands" << std::endl;
+        finish();
+    });
+
+    for (const auto &frame : std::as_const(m_session.frames)) {
+        m_logoutTag = std::max(m_logoutTag, frameTag(frame) + 1);
+    }
+}
+
+ReplaySession::~ReplaySession()
+{
+}
+
+void ReplaySession::connectToHost()
+{
+    m_socket = new QLocalSocket(this);
+    connect(m_socket, &QLocalSocket::errorOccurred, this, &ReplaySession::serverError);
+    connect(m_socket, &QLocalSocket::disconnected, this, &ReplaySession::serverDisconnected);
+    connect(m_socket, &QIODevice::readyRead, this, &ReplaySession::serverRead);
+    connect(m_socket, &QLocalSocket::connected, this, &ReplaySession::sendFrames);
+
+    m_socket->connectToServer(Session::serverAddress());
+
+    m_connectionTime.start();
+}
+
+qint64 ReplaySession::dueTime(qint64 timestamp) const
+{
+    if (m_speed <= 0) {
+        return 0;
+    }
+    return qint64((timestamp - m_session.begin) / 1000 / m_speed);
+}
+
+void ReplaySession::sendFrames()
+{
+    if (m_finished || m_socket->state() != QLocalSocket::ConnectedState) {
+        return;
+    }
+
+    while (m_nextFrame < m_session.frames.size()) {
+        const auto &frame = m_session.frames[m_nextFrame];
+        const qint64 delay = dueTime(frame.timestamp) - m_connectionTime.elapsed();
+        if (delay > 0) {
+            m_sendTimer.start(delay);
+            return;
+        }
+        m_socket->write(frame.data);
+        m_sentBytes += frame.data.size();
+        ++m_nextFrame;
+    }
+
+    sendLogout();
+}
+
+void ReplaySession::sendLogout()
+{
+    if (m_responseTimer.isActive()) {
+        return;
+    }
+    QByteArray data;
+    {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        Protocol::DataStream stream(&buffer);
+        stream << m_logoutTag;
+        Protocol::serialize(stream, Protocol::LogoutCommandPtr::create());
+        stream.flush();
+    }
+    m_socket->write(data);
+    m_responseTimer.start();
+}
+
+void ReplaySession::serverRead()
+{
+    QByteArray buffer(1024, Qt::Uninitialized);
+    qint64 readSize = 0;
+
+    while ((readSize = m_socket->read(buffer.data(), buffer.size())) > 0) {
+        m_receivedBytes += readSize;
+    }
+    m_lastResponseTime = m_connectionTime.elapsed();
+}
+
+void ReplaySession::serverDisconnected()
+{
+    finish();
+}
+
+void ReplaySession::serverError(QLocalSocket::LocalSocketError socketError)
+{
+    if (socketError != QLocalSocket::PeerClosedError) {
+        std::cerr << m_session.sessionId.constData() << ": " << qPrintable(m_socket->errorString()) << std::endl;
+    }
+    finish();
+}
+
+void ReplaySession::finish()
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_sendTimer.stop();
+    m_responseTimer.stop();
+    m_socket->disconnectFromServer();
+    Q_EMIT finished();
+}
+
+void ReplaySession::printStats() const
+{
+    std::cerr << m_session.sessionId.constData() << ": sent " << m_nextFrame << " of " << m_session.frames.size() << " commands (" << m_sentBytes
+              << " bytes), received " << m_receivedBytes << " bytes, last response after " << m_lastResponseTime << " ms";
+    if (m_session.end >= 0) {
+        std::cerr << " (originally " << (m_session.end - m_session.begin) / 1000 << " ms session)";
+    }
+    std::cerr << std::endl;
+}
+
+#include "moc_replaysession.cpp"
@@ -0,0 +1,62 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "private/protocolcapture_p.h"
+
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QObject>
+#include <QTimer>
+
+/** Replays a session of a protocol capture recorded by the server. */
+class ReplaySession : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * The commands are sent with the timing of the original session, accelerated
+     * by @p speed. With a @p speed of 0 all commands are sent right away.
+     */
+    explicit ReplaySession(const Akonadi::ProtocolCapture::Session &session, double speed, QObject *parent = nullptr);
+    ~ReplaySession() override;
+
+    void printStats() const;
+
+public Q_SLOTS:
+    void connectToHost();
+
+Q_SIGNALS:
+    void finished();
+
+private Q_SLOTS:
+    void sendFrames();
+    void serverDisconnected();
+    void serverError(QLocalSocket::LocalSocketError socketError);
+    void serverRead();
+
+private:
+    void finish();
+    /// Logs out after the last frame, the server disconnects once it has answered all commands
+    void sendLogout();
+    /// Milliseconds after connecting at which the command sent at @p timestamp is due
+    qint64 dueTime(qint64 timestamp) const;
+
+    const Akonadi::ProtocolCapture::Session m_session;
+    const double m_speed;
+    QLocalSocket *m_socket = nullptr;
+    QTimer m_sendTimer;
+    QTimer m_responseTimer;
+    qsizetype m_nextFrame = 0;
+    qint64 m_logoutTag = 1;
+    bool m_finished = false;
+
+    QElapsedTimer m_connectionTime;
+    qint64 m_lastResponseTime = 0;
+    qint64 m_receivedBytes = 0;
+    qint64 m_sentBytes = 0;
+};
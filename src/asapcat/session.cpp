@@ -44,7 +44,7 @@ Session::~Session()
 {
 }
 
-void Session::connectToHost()
+QString Session::serverAddress()
 {
     const QSettings connectionSettings(Akonadi::StandardDirs::connectionConfigFile(), QSettings::IniFormat);
 
@@ -57,7 +57,11 @@ void Session::connectToHost()
     if (serverAddress.isEmpty()) {
         qFatal("Unable to determine server address.");
     }
+    return serverAddress;
+}
 
+void Session::connectToHost()
+{
     auto socket = new QLocalSocket(this);
     connect(socket, &QLocalSocket::errorOccurred, this, &Session::serverError);
     connect(socket, &QLocalSocket::disconnected, this, &Session::serverDisconnected);
@@ -65,7 +69,7 @@ void Session::connectToHost()
     connect(socket, &QLocalSocket::connected, this, &Session::inputAvailable);
 
     m_session = socket;
-    socket->connectToServer(serverAddress);
+    socket->connectToServer(serverAddress());
 
     m_connectionTime.start();
 }
@@ -23,6 +23,9 @@ public:
 
     void printStats() const;
 
+    /** Address of the command socket of the running server. */
+    static QString serverAddress();
+
 public Q_SLOTS:
     void connectToHost();
 
@@ -244,7 +244,8 @@ void Connection::handleIncomingData()
 
         Protocol::CommandPtr cmd;
         try {
-            cmd = Protocol::deserialize(mSocket.data());
+            // Notifications may be queued for a long time, don't let them pin arena chunks
+            cmd = Protocol::deserialize(mSocket.data(), mConnectionType == CommandConnection ? &mArena : nullptr);
         } catch (const Akonadi::ProtocolException &e) {
             qCWarning(AKONADICORE_LOG) << "Protocol exception:" << e.what();
             // cmd's type will be Invalid by default, so fall-through
@@ -77,6 +77,8 @@ private:
     QFile *mLogFile = nullptr;
     QByteArray mSessionId;
     CommandBuffer *mCommandBuffer;
+    // Backs lazily decoded responses, only used on command connections
+    Protocol::Arena mArena;
     bool mIncomingDataRecursing = false;
 
     friend class Akonadi::SessionThread;
@@ -14,14 +14,64 @@
 #include "itemdeletejob.h"
 #include "itemfetchjob.h"
 #include "itemfetchscope.h"
+#include "itemsyncmanifestjob_p.h"
 #include "job_p.h"
 #include "protocol_p.h"
 #include "transactionsequence.h"
 
 #include "akonadicore_debug.h"
 
+#include <algorithm>
+#include <vector>
+
 using namespace Akonadi;
 
+namespace
+{
+/**
+ * @internal
+ * The remote identifiers listed during a full sync.
+ *
+ * Only a 64 bit hash of each remote identifier is kept, so that syncing very large
+ * collections doesn't require keeping all their remote identifiers in memory. A hash
+ * collision makes a local item appear to be listed, so at worst an item that was
+ * removed remotely is not deleted locally until the next sync.
+ */
+class ListedRemoteIds
+{
+public:
+    void insert(const QString &remoteId)
+    {
+        mHashes.push_back(hash(remoteId));
+        mSorted = false;
+    }
+
+    [[nodiscard]] bool contains(const QString &remoteId)
+    {
+        if (!mSorted) {
+            std::sort(mHashes.begin(), mHashes.end());
+            mHashes.erase(std::unique(mHashes.begin(), mHashes.end()), mHashes.end());
+            mSorted = true;
+        }
+        return std::binary_search(mHashes.cbegin(), mHashes.cend(), hash(remoteId));
+    }
+
+private:
+    static quint64 hash(const QString &remoteId)
+    {
+        quint64 result = qHash(remoteId, 0x9e3779b9U);
+        if constexpr (sizeof(size_t) < sizeof(quint64)) {
+            result = (result << 32) | qHash(remoteId, 0x85ebca6bU);
+        }
+        return result;
+    }
+
+    std::vector<quint64> mHashes;
+    bool mSorted = true;
+};
+
+} // namespace
+
 /**
  * @internal
  */
@@ -55,6 +105,7 @@ public:
     void slotLocalListDone(KJob *job);
     void slotLocalDeleteDone(KJob *job);
     void slotLocalChangeDone(KJob *job);
+    void slotManifestDone(KJob *job);
     void execute();
     void processItems();
     void processBatch();
@@ -67,8 +118,13 @@ public:
     bool allProcessed() const;
 
     Q_DECLARE_PUBLIC(ItemSync)
+    // Number of local items listed at once to find the items to delete
+    static constexpr int LocalItemsBatchSize = 500;
+
     Collection mSyncCollection;
-    QSet<QString> mListedItems;
+    ListedRemoteIds mListedItems;
+    // Remote revisions of the items that the manifest found unchanged
+    QHash<QString, QString> mUnchangedItems;
 
     ItemSync::TransactionMode mTransactionMode;
     TransactionSequence *mCurrentTransaction = nullptr;
@@ -79,6 +135,9 @@ public:
     Akonadi::Item::List mCurrentBatchRemoteItems;
     Akonadi::Item::List mCurrentBatchRemovedRemoteItems;
     Akonadi::Item::List mItemsToDelete;
+    // Highest id of the local items listed so far, and the number of items in the last batch
+    Akonadi::Item::Id mLocalItemsCursor = -1;
+    int mLocalItemsBatchCount = 0;
 
     QDateTime mItemSyncStart;
 
@@ -95,6 +154,8 @@ public:
     bool mFullListingDone;
     bool mProcessingBatch;
     bool mDisableAutomaticDeliveryDone;
+    bool mManifest = false;
+    bool mManifestPending = false;
 
     int mBatchSize;
     Akonadi::ItemSync::MergeMode mMergeMode;
@@ -199,7 +260,7 @@ void ItemSync::setFullSyncItems(const Item::List &items)
 {
     /*
      * We received a list of items from the server:
-     * * fetch all local id's + rid's only
+     * * fetch all local id's + rid's only, in batches
      * * check each full sync item whether it's locally available
      * * if it is modify the item
      * * if it's not create it
@@ -220,6 +281,58 @@ void ItemSync::setFullSyncItems(const Item::List &items)
     d->execute();
 }
 
+void ItemSync::setFullSyncManifest(const Item::List &items)
+{
+    /*
+     * We received the remote identifiers and revisions of all remote items:
+     * * let the server compare them against the local items
+     * * only items that are new or changed need to be created or merged
+     * * the server tells us which local items to delete, no need to list them
+     */
+    Q_D(ItemSync);
+    Q_ASSERT(!d->mIncremental);
+    Q_ASSERT(!d->mManifest);
+    d->mManifest = true;
+    d->mManifestPending = true;
+    d->mUnchangedItems.reserve(items.size());
+    for (const Item &item : items) {
+        d->mUnchangedItems.insert(item.remoteId(), item.remoteRevision());
+    }
+
+    d->requestTransaction();
+    d->mPendingJobs++;
+    auto job = new ItemSyncManifestJob(d->mSyncCollection, items, d->subjobParent());
+    connect(job, &ItemSyncManifestJob::result, this, [d](KJob *job) {
+        d->slotManifestDone(job);
+    });
+}
+
+void ItemSyncPrivate::slotManifestDone(KJob *job)
+{
+    Q_Q(ItemSync);
+    mPendingJobs--;
+    mManifestPending = false;
+    if (job->error()) {
+        qCWarning(AKONADICORE_LOG) << "Comparing the item manifest failed:" << job->errorString();
+        mUnchangedItems.clear();
+        mRemoteItemQueue.clear(); // the transaction is rolled back, don't process any more items
+        execute();
+        return;
+    }
+
+    const auto manifestJob = qobject_cast<ItemSyncManifestJob *>(job);
+    const QStringList changedRemoteIds = manifestJob->changedRemoteIds();
+    for (const QString &remoteId : changedRemoteIds) {
+        mUnchangedItems.remove(remoteId);
+    }
+    mItemsToDelete = manifestJob->deletedItems();
+    qCDebug(AKONADICORE_LOG) << "Item manifest of collection" << mSyncCollection.id() << ":" << changedRemoteIds.size() << "changed,"
+                             << mUnchangedItems.size() << "unchanged," << mItemsToDelete.size() << "deleted";
+
+    Q_EMIT q->manifestProcessed(changedRemoteIds);
+    execute();
+}
+
 void ItemSync::setTotalItems(int amount)
 {
     Q_D(ItemSync);
@@ -277,10 +390,15 @@ void ItemSyncPrivate::fetchLocalItemsToDelete()
         qFatal("This must not be called while in incremental mode");
         return;
     }
+    // List the local items in batches, and only their ids and remote ids, so that
+    // large collections don't have to be kept in memory at once
+    mLocalItemsBatchCount = 0;
     auto job = new ItemFetchJob(mSyncCollection, subjobParent());
     job->fetchScope().setFetchRemoteIdentification(true);
     job->fetchScope().setFetchModificationTime(false);
+    job->fetchScope().setFetchGid(false);
     job->setDeliveryOption(ItemFetchJob::EmitItemsIndividually);
+    job->setLimitAfter(LocalItemsBatchSize, mLocalItemsCursor, Qt::AscendingOrder);
     // we only can fetch parts already in the cache, otherwise this will deadlock
     job->fetchScope().setCacheOnly(true);
 
@@ -296,6 +414,8 @@ void ItemSyncPrivate::fetchLocalItemsToDelete()
 void ItemSyncPrivate::slotItemsReceived(const Item::List &items)
 {
     for (const Akonadi::Item &item : items) {
+        mLocalItemsCursor = std::max(mLocalItemsCursor, item.id());
+        ++mLocalItemsBatchCount;
         // Don't delete items that have not yet been synchronized
         if (item.remoteId().isEmpty()) {
             continue;
@@ -308,11 +428,17 @@ void ItemSyncPrivate::slotItemsReceived(const Item::List &items)
 
 void ItemSyncPrivate::slotLocalListDone(KJob *job)
 {
+    Q_Q(ItemSync);
     mPendingJobs--;
     if (job->error()) {
         qCWarning(AKONADICORE_LOG) << job->errorString();
     }
+    // Delete the items of this batch before listing the next one
     deleteItems(mItemsToDelete);
+    mItemsToDelete.clear();
+    if (!job->error() && !q->error() && mLocalItemsBatchCount == LocalItemsBatchSize) {
+        fetchLocalItemsToDelete();
+    }
     checkDone();
 }
 
@@ -331,6 +457,10 @@ void ItemSyncPrivate::execute()
         Q_ASSERT(false);
         return;
     }
+    // the items to process depend on the result of the manifest
+    if (mManifestPending) {
+        return;
+    }
     // not doing anything, start processing
     if (!mProcessingBatch) {
         if (mRemoteItemQueue.size() >= mBatchSize || mDeliveryDone) {
@@ -373,7 +503,12 @@ void ItemSyncPrivate::processBatch()
     // removed
     if (!mIncremental && allProcessed()) {
         // the full listing is done and we know which items to remove
-        fetchLocalItemsToDelete();
+        if (mManifest) {
+            deleteItems(mItemsToDelete);
+            mItemsToDelete.clear();
+        } else {
+            fetchLocalItemsToDelete();
+        }
     } else {
         deleteItems(mCurrentBatchRemovedRemoteItems);
         mCurrentBatchRemovedRemoteItems.clear();
@@ -390,8 +525,16 @@ void ItemSyncPrivate::processItems()
             qCWarning(AKONADICORE_LOG) << "Item " << remoteItem.id() << " does not have a remote identifier";
             continue;
         }
-        if (!mIncremental) {
-            mListedItems << remoteItem.remoteId();
+        if (mManifest) {
+            // Items listed in the manifest as unchanged need not be merged,
+            // unless they changed since the manifest has been created
+            const auto unchanged = mUnchangedItems.constFind(remoteItem.remoteId());
+            if (unchanged != mUnchangedItems.cend() && !unchanged->isEmpty() && *unchanged == remoteItem.remoteRevision()) {
+                mProgress++;
+                continue;
+            }
+        } else if (!mIncremental) {
+            mListedItems.insert(remoteItem.remoteId());
         }
         createOrMerge(remoteItem);
     }
@@ -410,19 +553,22 @@ void ItemSyncPrivate::deleteItems(const Item::List &itemsToDelete)
         return;
     }
 
-    mPendingJobs++;
-    auto job = new ItemDeleteJob(itemsToDelete, mSyncCollection, subjobParent());
-    q->connect(job, &ItemDeleteJob::result, q, [this](KJob *job) {
-        slotLocalDeleteDone(job);
-    });
+    // Keep the size of each delete command bounded
+    for (qsizetype offset = 0; offset < itemsToDelete.size(); offset += LocalItemsBatchSize) {
+        mPendingJobs++;
+        auto job = new ItemDeleteJob(itemsToDelete.mid(offset, LocalItemsBatchSize), mSyncCollection, subjobParent());
+        q->connect(job, &ItemDeleteJob::result, q, [this](KJob *job) {
+            slotLocalDeleteDone(job);
+        });
 
-    // It can happen that the groupware servers report us deleted items
-    // twice, in this case this item delete job will fail on the second try.
-    // To avoid a rollback of the complete transaction we gracefully allow the job
-    // to fail :)
-    auto transaction = qobject_cast<TransactionSequence *>(subjobParent());
-    if (transaction) {
-        transaction->setIgnoreJobFailure(job);
+        // It can happen that the groupware servers report us deleted items
+        // twice, in this case this item delete job will fail on the second try.
+        // To avoid a rollback of the complete transaction we gracefully allow the job
+        // to fail :)
+        auto transaction = qobject_cast<TransactionSequence *>(subjobParent());
+        if (transaction) {
+            transaction->setIgnoreJobFailure(job);
+        }
     }
 }
 
@@ -78,6 +78,28 @@ public:
      */
     void setFullSyncItems(const Item::List &items);
 
+    /*!
+     * Sets the remote identifiers and remote revisions of all items of the
+     * collection before delivering the items themselves for a full sync.
+     *
+     * The server compares the manifest with the stored items and reports
+     * the remote identifiers of the new and changed items through
+     * manifestProcessed(). Only those items have to be retrieved and delivered
+     * with setFullSyncItems() afterwards, delivered items that the manifest
+     * found unchanged are skipped. Local items that are not listed in the
+     * manifest are deleted, without listing all local items.
+     *
+     * Items without a remote revision are always considered changed.
+     *
+     * \note This must be called at most once, before any items are delivered.
+     *       Call setFullSyncItems() with an empty list (or deliveryDone() when
+     *       streaming) if no item has changed.
+     *
+     * \a items Items with only the remote identifier and remote revision set.
+     * \since 6.9
+     */
+    void setFullSyncManifest(const Item::List &items);
+
     /*!
      * Set the amount of items which you are going to return in total
      * by using the setFullSyncItems()/setIncrementalSyncItems() methods.
@@ -210,6 +232,16 @@ Q_SIGNALS:
      */
     void readyForNextBatch(int remainingBatchSize);
 
+    /*!
+     * Emitted when the server has compared the manifest set by
+     * setFullSyncManifest() with the stored items.
+     *
+     * \a changedRemoteIds the remote identifiers of the items that are new or changed
+     *
+     * \since 6.9
+     */
+    void manifestProcessed(const QStringList &changedRemoteIds);
+
     /*!
      * \internal
      * Emitted whenever a transaction is committed. This is for testing only.
@@ -48,6 +48,8 @@ public:
         QByteArray name;
         QByteArray data;
     } mPendingPart;
+    // Parts serialized for inlining which turned out to be too large
+    QHash<QByteArray, Protocol::StreamPayloadResponse> mSerializedParts;
     ItemCreateJob::MergeOptions mMergeOptions = ItemCreateJob::NoMerge;
     bool mItemReceived = false;
 };
@@ -79,6 +81,11 @@ Protocol::PartMetaData ItemCreateJobPrivate::preparePart(const QByteArray &partN
         mPendingPart = PendingPart{.name = partName, .data = mItem.d_ptr->mPayloadPath.toUtf8()};
         const auto size = QFile(mItem.d_ptr->mPayloadPath).size();
         return Protocol::PartMetaData(partName, size, version, Protocol::PartMetaData::Foreign);
+    } else if (const auto serialized = mSerializedParts.constFind(partLabel); serialized != mSerializedParts.cend()) {
+        mPendingPart = PendingPart{.name = partName, .data = serialized->data()};
+        const auto metaData = serialized->metaData();
+        mSerializedParts.erase(serialized);
+        return metaData;
     } else {
         mPendingPart.clear();
         mPendingPart.name = partName;
@@ -173,6 +180,9 @@ void ItemCreateJob::doStart()
         parts.insert(ProtocolHelper::encodePartIdentifier(ProtocolHelper::PartPayload, part));
     }
     cmd->setParts(parts);
+    // Small parts are sent along with the command, the server requests the others
+    d->mSerializedParts.clear();
+    cmd->setInlineParts(ProtocolHelper::inlinePayloadParts(d->mItem, d->mParts - d->mForeignParts, d->maxInlinePartSize(), d->mSerializedParts));
 
     d->sendCommand(cmd);
 }
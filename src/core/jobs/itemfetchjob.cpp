@@ -316,6 +316,16 @@ void ItemFetchJob::setLimit(int limit, int start, Qt::SortOrder order)
     Q_D(ItemFetchJob);
     d->mItemsLimit.setLimit(limit);
     d->mItemsLimit.setLimitOffset(start);
+    d->mItemsLimit.setAfterId(-1);
+    d->mItemsLimit.setSortOrder(order);
+}
+
+void ItemFetchJob::setLimitAfter(int limit, Item::Id afterId, Qt::SortOrder order)
+{
+    Q_D(ItemFetchJob);
+    d->mItemsLimit.setLimit(limit);
+    d->mItemsLimit.setLimitOffset(-1);
+    d->mItemsLimit.setAfterId(afterId);
     d->mItemsLimit.setSortOrder(order);
 }
 #include "moc_itemfetchjob.cpp"
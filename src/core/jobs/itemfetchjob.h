@@ -234,6 +234,22 @@ public:
 
     void setLimit(int limit, int start, Qt::SortOrder order = Qt::DescendingOrder);
 
+    /*!
+     * Sets the limit of fetched items, starting after the item with the given ID.
+     *
+     * Unlike setLimit(), which has to skip \a start items on the server for every
+     * page, this allows to page through large collections at constant cost per page
+     * by passing the ID of the last item of the previous page as \a afterId.
+     *
+     * \a limit the maximum number of items to retrieve.
+     * \a afterId only items following this ID in \a order are retrieved, -1 to start with the first item.
+     * \a order specifies whether items will be fetched
+     * starting with the highest or lowest ID of the item.
+     *
+     * \since 6.9
+     */
+    void setLimitAfter(int limit, Akonadi::Item::Id afterId, Qt::SortOrder order = Qt::DescendingOrder);
+
 Q_SIGNALS:
     /*!
      * This signal is emitted whenever new items have been fetched completely.
@@ -18,6 +18,8 @@
 #include "gidextractor_p.h"
 #include "protocolhelper_p.h"
 
+#include <KLocalizedString>
+
 #include <functional>
 
 #include <QFile>
@@ -47,13 +49,18 @@ Protocol::PartMetaData ItemModifyJobPrivate::preparePart(const QByteArray &partN
 
     mPendingData.clear();
     int version = 0;
-    const auto item = mItems.first();
+    const auto item = mItems.at(mCurrentItem);
     if (mForeignParts.contains(partLabel)) {
         mPendingData = item.d_ptr->mPayloadPath.toUtf8();
         const auto size = QFile(item.d_ptr->mPayloadPath).size();
         return Protocol::PartMetaData(partName, size, version, Protocol::PartMetaData::Foreign);
+    } else if (const auto serialized = mSerializedParts.constFind(partLabel); serialized != mSerializedParts.cend()) {
+        mPendingData = serialized->data();
+        const auto metaData = serialized->metaData();
+        mSerializedParts.erase(serialized);
+        return metaData;
     } else {
-        ItemSerializer::serialize(mItems.first(), partLabel, mPendingData, version);
+        ItemSerializer::serialize(item, partLabel, mPendingData, version);
         return Protocol::PartMetaData(partName, mPendingData.size(), version);
     }
 }
@@ -77,11 +84,13 @@ void ItemModifyJobPrivate::conflictResolveError(const QString &message)
 
 void ItemModifyJobPrivate::doUpdateItemRevision(Akonadi::Item::Id itemId, int oldRevision, int newRevision)
 {
-    auto it = std::find_if(mItems.begin(), mItems.end(), [&itemId](const Item &item) -> bool {
-        return item.id() == itemId;
-    });
-    if (it != mItems.end() && (*it).revision() == oldRevision) {
-        (*it).setRevision(newRevision);
+    const auto it = mItemIndex.constFind(itemId);
+    if (it == mItemIndex.cend()) {
+        return;
+    }
+    Item &item = mItems[*it];
+    if (item.revision() == oldRevision) {
+        item.setRevision(newRevision);
     }
 }
 
@@ -127,6 +136,41 @@ bool ItemModifyJobPrivate::nextBatch()
     return false;
 }
 
+void ItemModifyJobPrivate::nextItem()
+{
+    Q_Q(ItemModifyJob);
+
+    for (; mCurrentItem < mItems.size(); ++mCurrentItem) {
+        const Item &item = mItems.at(mCurrentItem);
+        mParts = mIgnorePayload ? QSet<QByteArray>() : item.loadedPayloadParts();
+        mForeignParts = item.payloadPath().isEmpty() ? QSet<QByteArray>() : ItemSerializer::allowedForeignParts(item);
+        mRemainingItems = std::span(mItems).subspan(mCurrentItem, 1);
+
+        Protocol::ModifyItemsCommandPtr command;
+        try {
+            command = fullCommand();
+        } catch (const Exception &e) {
+            q->setError(Job::Unknown);
+            q->setErrorText(QString::fromUtf8(e.what()));
+            endTransaction(Protocol::TransactionCommand::Rollback);
+            return;
+        }
+
+        if (command->modifiedParts() != Protocol::ModifyItemsCommand::None) {
+            sendCommand(command);
+            return;
+        }
+    }
+
+    endTransaction(Protocol::TransactionCommand::Commit);
+}
+
+void ItemModifyJobPrivate::endTransaction(Protocol::TransactionCommand::Mode mode)
+{
+    mTransactionMode = mode;
+    sendCommand(Protocol::TransactionCommandPtr::create(mode));
+}
+
 ItemModifyJob::ItemModifyJob(const Item &item, QObject *parent)
     : Job(new ItemModifyJobPrivate(this), parent)
 {
@@ -236,6 +280,9 @@ Protocol::ModifyItemsCommandPtr ItemModifyJobPrivate::fullCommand() const
             parts.insert(ProtocolHelper::encodePartIdentifier(ProtocolHelper::PartPayload, part));
         }
         cmd->setParts(parts);
+        // Small parts are sent along with the command, the server requests the others
+        mSerializedParts.clear();
+        cmd->setInlineParts(ProtocolHelper::inlinePayloadParts(item, mParts - mForeignParts, maxInlinePartSize(), mSerializedParts));
     }
 
     const AttributeStorage &attributeStorage = ItemChangeLog::instance()->attributeStorage(item.d_ptr);
@@ -277,6 +324,18 @@ void ItemModifyJob::doStart()
 {
     Q_D(ItemModifyJob);
 
+    d->mItemIndex.clear();
+    d->mItemIndex.reserve(d->mItems.size());
+    for (qsizetype i = 0; i < d->mItems.size(); ++i) {
+        d->mItemIndex.insert(d->mItems.at(i).id(), i);
+    }
+
+    if (d->mModifyIndividually) {
+        d->mCurrentItem = 0;
+        d->endTransaction(Protocol::TransactionCommand::Begin);
+        return;
+    }
+
     d->mRemainingItems = std::span(d->mItems);
     d->nextBatch();
 }
@@ -304,6 +363,70 @@ bool ItemModifyJob::doHandleResponse(qint64 tag, const Protocol::CommandPtr &res
         return false;
     }
 
+    if (d->mModifyIndividually && response->isResponse() && response->type() == Protocol::Command::Transaction) {
+        const auto &resp = Protocol::cmdCast<Protocol::TransactionResponse>(response);
+        if (resp.isError()) {
+            setError(Unknown);
+            setErrorText(resp.errorMessage());
+            return true;
+        }
+
+        switch (d->mTransactionMode) {
+        case Protocol::TransactionCommand::Begin:
+            d->nextItem();
+            return false;
+        case Protocol::TransactionCommand::Commit:
+            for (const Item &item : std::as_const(d->mItems)) {
+                ChangeMediator::invalidateItem(item);
+            }
+            if (!d->mConflictingItems.isEmpty()) {
+                setError(Unknown);
+                setErrorText(i18np("One item was modified elsewhere and has not been stored.",
+                                   "%1 items were modified elsewhere and have not been stored.",
+                                   d->mConflictingItems.size()));
+            }
+            return true;
+        default:
+            // Rolled back after an error, which has already been set
+            return true;
+        }
+    }
+
+    if (d->mModifyIndividually && response->isResponse() && response->type() == Protocol::Command::ModifyItems) {
+        const auto &resp = Protocol::cmdCast<Protocol::ModifyItemsResponse>(response);
+        if (resp.errorCode()) {
+            // The server checks for conflicts before touching the item, so we can carry on with the others
+            if (resp.errorMessage().contains(QLatin1StringView("[LLCONFLICT]")) || resp.errorMessage().contains(QLatin1StringView("[LRCONFLICT]"))) {
+                qCDebug(AKONADICORE_LOG) << "Conflict while modifying item" << d->mItems.at(d->mCurrentItem).id() << ":" << resp.errorMessage();
+                d->mConflictingItems.push_back(d->mItems.at(d->mCurrentItem));
+                ++d->mCurrentItem;
+                d->nextItem();
+                return false;
+            }
+            setError(Unknown);
+            setErrorText(resp.errorMessage());
+            d->endTransaction(Protocol::TransactionCommand::Rollback);
+            return false;
+        }
+
+        if (resp.modificationDateTime().isValid()) {
+            Item &item = d->mItems[d->mCurrentItem];
+            item.setModificationTime(resp.modificationDateTime());
+            item.d_ptr->resetChangeLog();
+            ++d->mCurrentItem;
+            d->nextItem();
+        } else if (const auto it = d->mItemIndex.constFind(resp.id()); it != d->mItemIndex.cend()) {
+            Item &item = d->mItems[*it];
+            const int newRev = resp.newRevision();
+            const int oldRev = item.revision();
+            if (newRev >= oldRev && newRev >= 0) {
+                d->itemRevisionChanged(item.id(), oldRev, newRev);
+                item.setRevision(newRev);
+            }
+        }
+        return false;
+    }
+
     if (response->isResponse() && response->type() == Protocol::Command::ModifyItems) {
         const auto &resp = Protocol::cmdCast<Protocol::ModifyItemsResponse>(response);
         if (resp.errorCode()) {
@@ -332,19 +455,18 @@ bool ItemModifyJob::doHandleResponse(qint64 tag, const Protocol::CommandPtr &res
             item.setModificationTime(resp.modificationDateTime());
             item.d_ptr->resetChangeLog();
         } else if (resp.id() > -1) {
-            auto it = std::find_if(d->mItems.begin(), d->mItems.end(), [&resp](const Item &item) -> bool {
-                return item.id() == resp.id();
-            });
-            if (it == d->mItems.end()) {
+            const auto it = d->mItemIndex.constFind(resp.id());
+            if (it == d->mItemIndex.cend()) {
                 qCDebug(AKONADICORE_LOG) << "Received STORE response for an item we did not modify: " << tag << Protocol::debugString(response);
                 return true;
             }
 
+            Item &item = d->mItems[*it];
             const int newRev = resp.newRevision();
-            const int oldRev = (*it).revision();
+            const int oldRev = item.revision();
             if (newRev >= oldRev && newRev >= 0) {
-                d->itemRevisionChanged((*it).id(), oldRev, newRev);
-                (*it).setRevision(newRev);
+                d->itemRevisionChanged(item.id(), oldRev, newRev);
+                item.setRevision(newRev);
             }
             // There will be more responses, either for other modified items,
             // or the final response with invalid ID, but with modification datetime
@@ -414,6 +536,45 @@ void ItemModifyJob::disableRevisionCheck()
     d->mRevCheck = false;
 }
 
+void ItemModifyJob::setModifyItemsIndividually(bool individually)
+{
+    Q_D(ItemModifyJob);
+
+    if (d->mModifyIndividually == individually) {
+        return;
+    }
+
+    d->mModifyIndividually = individually;
+    if (individually) {
+        d->mIgnorePayload = false;
+        d->mRevCheck = true;
+        d->mOperations.insert(ItemModifyJobPrivate::RemoteId);
+        d->mOperations.insert(ItemModifyJobPrivate::RemoteRevision);
+    } else if (d->mItems.size() > 1) {
+        // back to the bulk modification defaults
+        d->mIgnorePayload = true;
+        d->mRevCheck = false;
+        d->mParts.clear();
+        d->mForeignParts.clear();
+        d->mOperations.remove(ItemModifyJobPrivate::RemoteId);
+        d->mOperations.remove(ItemModifyJobPrivate::RemoteRevision);
+    }
+}
+
+bool ItemModifyJob::modifyItemsIndividually() const
+{
+    Q_D(const ItemModifyJob);
+
+    return d->mModifyIndividually;
+}
+
+Item::List ItemModifyJob::conflictingItems() const
+{
+    Q_D(const ItemModifyJob);
+
+    return d->mConflictingItems;
+}
+
 void ItemModifyJob::disableAutomaticConflictHandling()
 {
     Q_D(ItemModifyJob);
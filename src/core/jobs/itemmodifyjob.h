@@ -108,6 +108,9 @@ public:
      * Currently the following modifications are supported:
      * - flag changes
      *
+     * To store a set of items with distinct changes each, e.g. updated
+     * payloads after a sync, see setModifyItemsIndividually().
+     *
      * \note Since this does not do payload modifications, it implies
      *       setIgnorePayload( true ) and disableRevisionCheck().
      * \a items The list of items to modify, must not be empty.
@@ -186,6 +189,39 @@ public:
      */
     void disableAutomaticConflictHandling();
 
+    /*!
+     * Sets whether each item of a bulk modification is stored with its own
+     * changes, including payload parts, attributes, remote identifier and
+     * remote revision, rather than applying the changes of the first item
+     * to all of them.
+     *
+     * The items are stored one after another within a single transaction.
+     * The revision of each item is checked individually (unless
+     * disableRevisionCheck() is called afterwards). Items that were modified
+     * elsewhere are skipped and returned by conflictingItems(), the remaining
+     * items are stored nonetheless and the job finishes with an error.
+     * Automatic conflict handling is not available in this mode.
+     *
+     * \a individually store each item with its own changes if set as \\ true
+     * \since 6.9
+     */
+    void setModifyItemsIndividually(bool individually);
+
+    /*!
+     * Returns whether each item is stored with its own changes.
+     * \since 6.9
+     */
+    [[nodiscard]] bool modifyItemsIndividually() const;
+
+    /*!
+     * Returns the items that have not been stored because they were
+     * modified elsewhere.
+     *
+     * \note Only available when setModifyItemsIndividually() is enabled.
+     * \since 6.9
+     */
+    [[nodiscard]] Item::List conflictingItems() const;
+
 protected:
     void doStart() override;
     bool doHandleResponse(qint64 tag, const Protocol::CommandPtr &response) override;
@@ -9,18 +9,14 @@
 #include "akonadicore_export.h"
 #include "itemmodifyjob.h"
 #include "job_p.h"
+#include "private/protocol_p.h"
+
+#include <QHash>
+
 #include <span>
 
 namespace Akonadi
 {
-namespace Protocol
-{
-class PartMetaData;
-class Command;
-class ModifyItemsCommand;
-using ModifyItemsCommandPtr = QSharedPointer<ModifyItemsCommand>;
-}
-
 /*!
  * \internal
  *
@@ -53,6 +49,8 @@ public:
     QString jobDebuggingString() const override;
     Protocol::ModifyItemsCommandPtr fullCommand() const;
     bool nextBatch();
+    void nextItem();
+    void endTransaction(Protocol::TransactionCommand::Mode mode);
 
     void setSilent(bool silent);
 
@@ -66,9 +64,19 @@ public:
     QSet<QByteArray> mParts;
     QSet<QByteArray> mForeignParts;
     QByteArray mPendingData;
+    // Parts serialized for inlining which turned out to be too large
+    mutable QHash<QByteArray, Protocol::StreamPayloadResponse> mSerializedParts;
     bool mIgnorePayload = false;
     bool mAutomaticConflictHandlingEnabled = true;
     bool mSilent = false;
+
+    // Per-item modification: each item is sent as a separate command, all
+    // of them within a single transaction
+    bool mModifyIndividually = false;
+    qsizetype mCurrentItem = 0;
+    Protocol::TransactionCommand::Mode mTransactionMode = Protocol::TransactionCommand::Invalid;
+    Item::List mConflictingItems;
+    QHash<Item::Id, qsizetype> mItemIndex;
 };
 
 }
@@ -0,0 +1,89 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "itemsyncmanifestjob_p.h"
+#include "collection.h"
+#include "job_p.h"
+
+#include "private/protocol_p.h"
+
+namespace Akonadi
+{
+class ItemSyncManifestJobPrivate : public Akonadi::JobPrivate
+{
+public:
+    explicit ItemSyncManifestJobPrivate(ItemSyncManifestJob *parent)
+        : JobPrivate(parent)
+    {
+    }
+
+    QString jobDebuggingString() const override
+    {
+        return QStringLiteral("Collection id: %1 Manifest size: %2").arg(collection.id()).arg(remoteIds.size());
+    }
+
+    Collection collection;
+    QStringList remoteIds;
+    QStringList remoteRevisions;
+    QStringList changedRemoteIds;
+    Item::List deletedItems;
+};
+
+} // namespace Akonadi
+
+using namespace Akonadi;
+
+ItemSyncManifestJob::ItemSyncManifestJob(const Collection &collection, const Item::List &manifest, QObject *parent)
+    : Job(new ItemSyncManifestJobPrivate(this), parent)
+{
+    Q_D(ItemSyncManifestJob);
+    Q_ASSERT(collection.isValid());
+
+    d->collection = collection;
+    d->remoteIds.reserve(manifest.size());
+    d->remoteRevisions.reserve(manifest.size());
+    for (const Item &item : manifest) {
+        d->remoteIds.push_back(item.remoteId());
+        d->remoteRevisions.push_back(item.remoteRevision());
+    }
+}
+
+ItemSyncManifestJob::~ItemSyncManifestJob() = default;
+
+QStringList ItemSyncManifestJob::changedRemoteIds() const
+{
+    return d_func()->changedRemoteIds;
+}
+
+Item::List ItemSyncManifestJob::deletedItems() const
+{
+    return d_func()->deletedItems;
+}
+
+void ItemSyncManifestJob::doStart()
+{
+    Q_D(ItemSyncManifestJob);
+    d->sendCommand(Protocol::ItemSyncManifestCommandPtr::create(d->collection.id(), d->remoteIds, d->remoteRevisions));
+}
+
+bool ItemSyncManifestJob::doHandleResponse(qint64 tag, const Protocol::CommandPtr &response)
+{
+    Q_D(ItemSyncManifestJob);
+    if (!response->isResponse() || response->type() != Protocol::Command::ItemSyncManifest) {
+        return Job::doHandleResponse(tag, response);
+    }
+
+    const auto &resp = Protocol::cmdCast<Protocol::ItemSyncManifestResponse>(response);
+    d->changedRemoteIds = resp.changedRemoteIds();
+    const auto deletedItems = resp.deletedItems();
+    d->deletedItems.reserve(deletedItems.size());
+    for (qint64 id : deletedItems) {
+        d->deletedItems.push_back(Item(id));
+    }
+    return true;
+}
+
+#include "moc_itemsyncmanifestjob_p.cpp"
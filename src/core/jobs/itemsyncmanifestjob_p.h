@@ -0,0 +1,56 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akonadicore_export.h"
+#include "item.h"
+#include "job.h"
+
+namespace Akonadi
+{
+class Collection;
+class ItemSyncManifestJobPrivate;
+
+/*!
+ * Sends the remote identifiers and remote revisions of all items of a
+ * collection to the server and retrieves which of them are new or changed
+ * and which local items no longer exist remotely.
+ *
+ * \class Akonadi::ItemSyncManifestJob
+ * \inheaderfile Akonadi/ItemSyncManifestJob
+ * \inmodule AkonadiCore
+ *
+ * \internal
+ */
+class AKONADICORE_EXPORT ItemSyncManifestJob : public Akonadi::Job
+{
+    Q_OBJECT
+public:
+    /*!
+     * \a manifest Items with the remote identifier and remote revision set
+     */
+    explicit ItemSyncManifestJob(const Collection &collection, const Item::List &manifest, QObject *parent = nullptr);
+    ~ItemSyncManifestJob() override;
+
+    /*!
+     * Returns the remote identifiers of the items that need to be stored.
+     */
+    [[nodiscard]] QStringList changedRemoteIds() const;
+
+    /*!
+     * Returns the local items that are not part of the manifest.
+     */
+    [[nodiscard]] Item::List deletedItems() const;
+
+protected:
+    void doStart() override;
+    bool doHandleResponse(qint64 tag, const Protocol::CommandPtr &response) override;
+
+private:
+    Q_DECLARE_PRIVATE(ItemSyncManifestJob)
+};
+}
@@ -295,6 +295,11 @@ int JobPrivate::protocolVersion() const
 {
     return mSession->d->protocolVersion;
 }
+
+qint64 JobPrivate::maxInlinePartSize() const
+{
+    return mSession->d->maxInlinePartSize;
+}
 /// @endcond
 
 Job::Job(QObject *parent)
@@ -98,6 +98,12 @@ public:
 
     [[nodiscard]] int protocolVersion() const;
 
+    /**
+     * Returns the largest payload part the server accepts inline with
+     * a command, or 0 if parts have to be streamed on request.
+     */
+    [[nodiscard]] qint64 maxInlinePartSize() const;
+
     Job *q_ptr;
     Q_DECLARE_PUBLIC(Job)
 
@@ -0,0 +1,123 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "preprocessitemsjob_p.h"
+#include "job_p.h"
+
+#include "private/protocol_p.h"
+
+namespace Akonadi
+{
+class PreprocessItemsJobPrivate : public Akonadi::JobPrivate
+{
+public:
+    explicit PreprocessItemsJobPrivate(PreprocessItemsJob *parent)
+        : JobPrivate(parent)
+    {
+    }
+
+    QString jobDebuggingString() const override
+    {
+        return QStringLiteral("Preprocessor: %1 Batch size: %2 Processed: %3")
+            .arg(preprocessorId)
+            .arg(maxBatchSize)
+            .arg(completedItems.size() + failedItems.size() + refusedItems.size());
+    }
+
+    QString preprocessorId;
+    int maxBatchSize = 1;
+    QList<qint64> completedItems;
+    QList<qint64> failedItems;
+    QList<qint64> refusedItems;
+    QList<qint64> items;
+    bool firstRequest = false;
+};
+
+} // namespace Akonadi
+
+using namespace Akonadi;
+
+PreprocessItemsJob::PreprocessItemsJob(const QString &preprocessorId, int maxBatchSize, QObject *parent)
+    : Job(new PreprocessItemsJobPrivate(this), parent)
+{
+    Q_D(PreprocessItemsJob);
+    Q_ASSERT(maxBatchSize > 0);
+
+    d->preprocessorId = preprocessorId;
+    d->maxBatchSize = maxBatchSize;
+}
+
+PreprocessItemsJob::~PreprocessItemsJob() = default;
+
+void PreprocessItemsJob::setCompletedItems(const QList<qint64> &ids)
+{
+    d_func()->completedItems = ids;
+}
+
+QList<qint64> PreprocessItemsJob::completedItems() const
+{
+    return d_func()->completedItems;
+}
+
+void PreprocessItemsJob::setFailedItems(const QList<qint64> &ids)
+{
+    d_func()->failedItems = ids;
+}
+
+QList<qint64> PreprocessItemsJob::failedItems() const
+{
+    return d_func()->failedItems;
+}
+
+void PreprocessItemsJob::setRefusedItems(const QList<qint64> &ids)
+{
+    d_func()->refusedItems = ids;
+}
+
+QList<qint64> PreprocessItemsJob::refusedItems() const
+{
+    return d_func()->refusedItems;
+}
+
+void PreprocessItemsJob::setFirstRequest(bool firstRequest)
+{
+    d_func()->firstRequest = firstRequest;
+}
+
+bool PreprocessItemsJob::isFirstRequest() const
+{
+    return d_func()->firstRequest;
+}
+
+QList<qint64> PreprocessItemsJob::items() const
+{
+    return d_func()->items;
+}
+
+void PreprocessItemsJob::doStart()
+{
+    Q_D(PreprocessItemsJob);
+
+    auto cmd = Protocol::PreprocessItemsCommandPtr::create(d->preprocessorId, d->maxBatchSize);
+    cmd->setCompletedItems(d->completedItems);
+    cmd->setFailedItems(d->failedItems);
+    cmd->setRefusedItems(d->refusedItems);
+    cmd->setFirstRequest(d->firstRequest);
+    d->sendCommand(cmd);
+}
+
+bool PreprocessItemsJob::doHandleResponse(qint64 tag, const Protocol::CommandPtr &response)
+{
+    Q_D(PreprocessItemsJob);
+    if (!response->isResponse() || response->type() != Protocol::Command::PreprocessItems) {
+        return Job::doHandleResponse(tag, response);
+    }
+
+    d->items = Protocol::cmdCast<Protocol::PreprocessItemsResponse>(response).items();
+    return true;
+}
+
+#include "moc_preprocessitemsjob_p.cpp"
@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akonadicore_export.h"
+#include "job.h"
+
+namespace Akonadi
+{
+class PreprocessItemsJobPrivate;
+
+/*!
+ * Reports the items a preprocessor has processed since the last job and
+ * retrieves the identifiers of the next batch of items to preprocess.
+ *
+ * If the preprocessor has no items left in progress, the server waits a
+ * while for new items, so the job should be run in a session dedicated
+ * to it.
+ *
+ * \class Akonadi::PreprocessItemsJob
+ * \inheaderfile Akonadi/PreprocessItemsJob
+ * \inmodule AkonadiCore
+ *
+ * \internal
+ */
+class AKONADICORE_EXPORT PreprocessItemsJob : public Akonadi::Job
+{
+    Q_OBJECT
+public:
+    explicit PreprocessItemsJob(const QString &preprocessorId, int maxBatchSize, QObject *parent = nullptr);
+    ~PreprocessItemsJob() override;
+
+    void setCompletedItems(const QList<qint64> &ids);
+    [[nodiscard]] QList<qint64> completedItems() const;
+    void setFailedItems(const QList<qint64> &ids);
+    [[nodiscard]] QList<qint64> failedItems() const;
+    void setRefusedItems(const QList<qint64> &ids);
+    [[nodiscard]] QList<qint64> refusedItems() const;
+
+    /*!
+     * Marks the job as the first one of the preprocessor process, so that the
+     * server hands out the items given to a previous process again.
+     */
+    void setFirstRequest(bool firstRequest);
+    [[nodiscard]] bool isFirstRequest() const;
+
+    /*!
+     * Returns the identifiers of the items to preprocess next, which may be empty.
+     */
+    [[nodiscard]] QList<qint64> items() const;
+
+protected:
+    void doStart() override;
+    bool doHandleResponse(qint64 tag, const Protocol::CommandPtr &response) override;
+
+private:
+    Q_DECLARE_PRIVATE(PreprocessItemsJob)
+};
+}
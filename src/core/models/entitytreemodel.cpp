@@ -17,6 +17,8 @@
 
 #include <QUrlQuery>
 
+#include <algorithm>
+
 #include "collectionmodifyjob.h"
 #include "entitydisplayattribute.h"
 #include "itemmodifyjob.h"
@@ -821,8 +823,10 @@ bool EntityTreeModel::setData(const QModelIndex &index, const QVariant &value, i
 
 bool EntityTreeModel::canFetchMore(const QModelIndex &parent) const
 {
-    Q_UNUSED(parent)
-    return false;
+    Q_D(const EntityTreeModel);
+    // Only let views page through windowed collections when scrolling, the other
+    // strategies fetch all items of a collection at once
+    return d->isWindowed() && d->canFetchMore(parent);
 }
 
 void EntityTreeModel::fetchMore(const QModelIndex &parent)
@@ -840,7 +844,7 @@ void EntityTreeModel::fetchMore(const QModelIndex &parent)
     if (d->m_itemPopulation == ImmediatePopulation) {
         // Nothing to do. The items are already in the model.
         return;
-    } else if (d->m_itemPopulation == LazyPopulation) {
+    } else if (d->m_itemPopulation == LazyPopulation || d->m_itemPopulation == WindowedPopulation) {
         const Collection collection = parent.data(CollectionRole).value<Collection>();
 
         if (!collection.isValid()) {
@@ -864,7 +868,7 @@ bool EntityTreeModel::hasChildren(const QModelIndex &parent) const
     // There is probably no way to tell if a collection
     // has child items in akonadi without first attempting an itemFetchJob...
     // Figure out a way to fix this. (Statistics)
-    return ((rowCount(parent) > 0) || (d->canFetchMore(parent) && d->m_itemPopulation == LazyPopulation));
+    return ((rowCount(parent) > 0) || (d->canFetchMore(parent) && (d->m_itemPopulation == LazyPopulation || d->m_itemPopulation == WindowedPopulation)));
 }
 
 bool EntityTreeModel::isCollectionTreeFetched() const
@@ -984,6 +988,32 @@ void EntityTreeModel::setItemPopulationStrategy(ItemPopulationStrategy strategy)
     d->endResetModel();
 }
 
+void EntityTreeModel::setItemWindowSize(int size)
+{
+    Q_D(EntityTreeModel);
+    d->m_itemWindowSize = std::max(size, 1);
+}
+
+int EntityTreeModel::itemWindowSize() const
+{
+    Q_D(const EntityTreeModel);
+    return d->m_itemWindowSize;
+}
+
+void EntityTreeModel::evictItems(const QModelIndex &parent, int keep)
+{
+    Q_D(EntityTreeModel);
+    if (!d->isWindowed()) {
+        return;
+    }
+
+    const Collection::Id collectionId = parent.data(CollectionIdRole).toLongLong();
+    if (collectionId <= 0 || !d->m_collections.contains(collectionId)) {
+        return;
+    }
+    d->evictItems(collectionId, keep);
+}
+
 EntityTreeModel::ItemPopulationStrategy EntityTreeModel::itemPopulationStrategy() const
 {
     Q_D(const EntityTreeModel);
@@ -401,7 +401,8 @@ public:
     enum ItemPopulationStrategy {
         NoItemPopulation, ///< Do not include items in the model.
         ImmediatePopulation, ///< Retrieve items immediately when their parent is in the model. This is the default.
-        LazyPopulation ///< Fetch items only when requested (using canFetchMore/fetchMore)
+        LazyPopulation, ///< Fetch items only when requested (using canFetchMore/fetchMore)
+        WindowedPopulation ///< Fetch items newest first, one window of itemWindowSize() items per fetchMore() call. \since 6.9
     };
 
     /*!
@@ -458,6 +459,34 @@ public:
      */
     [[nodiscard]] ItemPopulationStrategy itemPopulationStrategy() const;
 
+    /*!
+     * Sets the number of items fetched at once with the WindowedPopulation strategy.
+     *
+     * The default is 500 items.
+     *
+     * \since 6.9
+     * \sa evictItems()
+     */
+    void setItemWindowSize(int size);
+
+    /*!
+     * Returns the number of items fetched at once with the WindowedPopulation strategy.
+     *
+     * \since 6.9
+     */
+    [[nodiscard]] int itemWindowSize() const;
+
+    /*!
+     * Removes all but the \a keep newest items of the collection at \a parent from the model.
+     *
+     * Views can use this to release the items of large collections which have been scrolled
+     * far out of the viewport. The evicted items are fetched again by further fetchMore() calls.
+     * Only has an effect with the WindowedPopulation strategy.
+     *
+     * \since 6.9
+     */
+    void evictItems(const QModelIndex &parent, int keep);
+
     /*!
      * Sets whether the root collection shall be provided by the model.
      * \a include enables root collection if set as \\ true
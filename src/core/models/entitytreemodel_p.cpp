@@ -33,6 +33,9 @@
 
 #include <QElapsedTimer>
 #include <QIcon>
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <unordered_map>
 
 // clazy:excludeall=old-style-connect
@@ -202,6 +205,10 @@ void EntityTreeModelPrivate::fetchItems(const Collection &parent)
     itemFetchJob->fetchScope().setAncestorRetrieval(ItemFetchScope::All);
     itemFetchJob->fetchScope().setIgnoreRetrievalErrors(true);
     itemFetchJob->setDeliveryOption(ItemFetchJob::EmitItemsInBatches);
+    if (isWindowed()) {
+        // Items are listed newest first, the next window starts after the oldest item received so far
+        itemFetchJob->setLimitAfter(m_itemWindowSize, m_itemWindowCursors.value(parent.id(), -1), Qt::DescendingOrder);
+    }
 
     itemFetchJob->setProperty(s_fetchCollectionId, QVariant(parent.id()));
 
@@ -480,6 +487,17 @@ void EntityTreeModelPrivate::itemsFetched(const Collection::Id collectionId, con
         m_collectionsWithoutItems.remove(collectionId);
     }
 
+    if (isWindowed() && !items.isEmpty()) {
+        // Also includes the items filtered out below, so that the next window doesn't return them again
+        const Item::Id oldestId = std::min_element(items.cbegin(), items.cend(), [](const Item &lhs, const Item &rhs) {
+                                      return lhs.id() < rhs.id();
+                                  })->id();
+        const auto cursor = m_itemWindowCursors.constFind(collectionId);
+        if (cursor == m_itemWindowCursors.cend() || oldestId < *cursor) {
+            m_itemWindowCursors.insert(collectionId, oldestId);
+        }
+    }
+
     Item::List itemsToInsert;
     for (const auto &item : items) {
         if (isHidden(item)) {
@@ -1322,14 +1340,17 @@ void EntityTreeModelPrivate::itemFetchJobDone(Collection::Id collectionId, KJob
     qCDebug(DebugETM) << "Fetch job took " << jobTimeTracker.take(job).elapsed() << "msec";
     qCDebug(DebugETM) << "was item fetch job: items:" << iJob->count();
 
-    if (iJob->count() == 0) {
+    if (iJob->count() == 0 && (!isWindowed() || !m_itemWindowCursors.contains(collectionId))) {
         m_collectionsWithoutItems.insert(collectionId);
     } else {
         m_collectionsWithoutItems.remove(collectionId);
     }
 
-    m_populatedCols.insert(collectionId);
-    Q_EMIT q_ptr->collectionPopulated(collectionId);
+    // A full window means there may be more items, which fetchMore() retrieves with the next window
+    if (!isWindowed() || iJob->count() < m_itemWindowSize) {
+        m_populatedCols.insert(collectionId);
+        Q_EMIT q_ptr->collectionPopulated(collectionId);
+    }
 
     // If collections are not in the model, there will be no valid index for them.
     if (m_collectionFetchStrategy != EntityTreeModel::FetchCollectionsMerged && //
@@ -1432,7 +1453,7 @@ void EntityTreeModelPrivate::startFirstListJob()
     // retrieved now.
     // Only fetch items NOT if there is NoItemPopulation, or if there is Lazypopulation and the root is visible
     // (if the root is not visible the lazy population can not be triggered)
-    if ((m_itemPopulation != EntityTreeModel::NoItemPopulation) && !((m_itemPopulation == EntityTreeModel::LazyPopulation) && m_showRootCollection)) {
+    if ((m_itemPopulation != EntityTreeModel::NoItemPopulation) && !((m_itemPopulation == EntityTreeModel::LazyPopulation || m_itemPopulation == EntityTreeModel::WindowedPopulation) && m_showRootCollection)) {
         if (m_rootCollection != Collection::root()) {
             fetchItems(m_rootCollection);
         }
@@ -1741,6 +1762,7 @@ void EntityTreeModelPrivate::endResetModel()
     }
     m_collections.clear();
     m_collectionsWithoutItems.clear();
+    m_itemWindowCursors.clear();
     m_populatedCols.clear();
     m_items.clear();
     m_pendingCollectionFetchJobs.clear();
@@ -1867,12 +1889,95 @@ bool EntityTreeModelPrivate::canFetchMore(const QModelIndex &parent) const
             return false;
         }
 
+        // Windowed collections are listed in several steps, so they can have items already
+        if (isWindowed()) {
+            return true;
+        }
+
         // Only try to fetch more from a collection if we don't already have items in it.
         // Otherwise we'd spend all the time listing items in collections.
         return m_childEntities.value(collectionId) | Actions::none(Node::isItem);
     }
 }
 
+bool EntityTreeModelPrivate::isWindowed() const
+{
+    // Without collections in the model all items are listed below the root collection
+    return m_itemPopulation == EntityTreeModel::WindowedPopulation && //
+        m_collectionFetchStrategy != EntityTreeModel::FetchCollectionsMerged && //
+        m_collectionFetchStrategy != EntityTreeModel::FetchNoCollections;
+}
+
+void EntityTreeModelPrivate::evictItems(Collection::Id id, int keep)
+{
+    Q_Q(EntityTreeModel);
+
+    const auto it = m_childEntities.find(id);
+    if (it == m_childEntities.end()) {
+        return;
+    }
+    QList<Node *> &childEntities = *it;
+
+    QList<Node::Id> itemIds;
+    for (const Node *node : std::as_const(childEntities)) {
+        if (node->type == Node::Item) {
+            itemIds.push_back(node->id);
+        }
+    }
+    keep = std::max(keep, 0);
+    if (itemIds.size() <= keep) {
+        return;
+    }
+
+    // Items are listed by descending id, so the items with the highest ids are the ones the next window follows
+    Node::Id threshold = std::numeric_limits<Node::Id>::max();
+    if (keep > 0) {
+        std::nth_element(itemIds.begin(), itemIds.begin() + keep - 1, itemIds.end(), std::greater<>());
+        threshold = itemIds[keep - 1];
+    }
+
+    const QModelIndex parentIndex = indexForCollection(m_collections.value(id));
+    const auto isEvicted = [threshold](const Node *node) {
+        return node->type == Node::Item && node->id < threshold;
+    };
+
+    // Remove contiguous blocks of evicted items, starting from the end so that the rows of the
+    // remaining blocks stay valid
+    int row = childEntities.size() - 1;
+    while (row >= 0) {
+        if (!isEvicted(childEntities.at(row))) {
+            --row;
+            continue;
+        }
+        const int last = row;
+        while (row > 0 && isEvicted(childEntities.at(row - 1))) {
+            --row;
+        }
+
+        q->beginRemoveRows(parentIndex, row, last);
+        for (int i = row; i <= last; ++i) {
+            Node *node = childEntities.at(i);
+            m_items.unref(node->id);
+            delete node;
+        }
+        childEntities.remove(row, last - row + 1);
+        q->endRemoveRows();
+        --row;
+    }
+
+    // The evicted items are fetched again by the next windows
+    if (keep > 0) {
+        m_itemWindowCursors.insert(id, threshold);
+    } else {
+        m_itemWindowCursors.remove(id);
+    }
+    if (m_populatedCols.remove(id) && (m_showRootCollection || id != m_rootCollection.id())) {
+        const QModelIndex index = indexForCollection(m_collections.value(id));
+        // To notify about the changed population state
+        dataChanged(index, index);
+    }
+}
+
 QIcon EntityTreeModelPrivate::iconForName(const QString &name) const
 {
     if (m_iconThemeName != QIcon::themeName()) {
@@ -253,6 +253,8 @@ public:
     QHash<Collection::Id, QList<Node *>> m_childEntities;
     QSet<Collection::Id> m_populatedCols;
     QSet<Collection::Id> m_collectionsWithoutItems;
+    // Lowest item ID received so far for windowed collections, the next window starts after it
+    QHash<Collection::Id, Item::Id> m_itemWindowCursors;
 
     QList<Item::Id> m_pendingCutItems;
     QList<Item::Id> m_pendingCutCollections;
@@ -272,6 +274,7 @@ public:
     MimeTypeChecker m_mimeChecker;
     EntityTreeModel::CollectionFetchStrategy m_collectionFetchStrategy = EntityTreeModel::FetchCollectionsRecursive;
     EntityTreeModel::ItemPopulationStrategy m_itemPopulation = EntityTreeModel::ImmediatePopulation;
+    int m_itemWindowSize = 500;
     CollectionFetchScope::ListFilter m_listFilter = CollectionFetchScope::NoFilter;
     bool m_includeStatistics = false;
     bool m_showRootCollection = false;
@@ -391,6 +394,17 @@ public:
 
     bool canFetchMore(const QModelIndex &parent) const;
 
+    /**
+      Returns true if items are fetched in windows of m_itemWindowSize items.
+    */
+    bool isWindowed() const;
+
+    /**
+      Removes all but the @p keep newest items from the Collection @p id, which can be
+      fetched again through fetchMore() afterwards.
+    */
+    void evictItems(Collection::Id id, int keep);
+
     /**
      * Returns true if the collection matches all filters and should be part of the model.
      * This method checks all properties that could change by modifying the collection.
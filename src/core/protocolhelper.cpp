@@ -14,6 +14,7 @@
 #include "itemserializer_p.h"
 #include "persistentsearchattribute.h"
 #include "protocolhelper_p.h"
+#include "sharedvaluepool_p.h"
 #include "tag_p.h"
 #include "tagfetchscope.h"
 
@@ -23,11 +24,65 @@
 #include "shared/akranges.h"
 
 #include <QFile>
+#include <QIODevice>
 #include <QVarLengthArray>
 
+#include <utility>
+
 using namespace Akonadi;
 using namespace AkRanges;
 
+namespace
+{
+/// Write-only buffer which drops its data once more than its capacity has been written
+class BoundedBuffer : public QIODevice
+{
+public:
+    explicit BoundedBuffer(qint64 capacity)
+        : mCapacity(capacity)
+    {
+        open(QIODevice::WriteOnly);
+    }
+
+    [[nodiscard]] bool overflowed() const
+    {
+        return mOverflowed;
+    }
+
+    [[nodiscard]] QByteArray takeData()
+    {
+        return std::exchange(mData, {});
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        Q_UNUSED(data)
+        Q_UNUSED(maxSize)
+        return -1;
+    }
+
+    qint64 writeData(const char *data, qint64 size) override
+    {
+        if (!mOverflowed && mData.size() + size > mCapacity) {
+            mOverflowed = true;
+            mData = QByteArray();
+        }
+        if (!mOverflowed) {
+            mData.append(data, size);
+        }
+        // Pretend to have written the data, so that the serializer doesn't fail
+        return size;
+    }
+
+private:
+    QByteArray mData;
+    const qint64 mCapacity;
+    bool mOverflowed = false;
+};
+
+} // namespace
+
 CachePolicy ProtocolHelper::parseCachePolicy(const Protocol::CachePolicy &policy)
 {
     CachePolicy cp;
@@ -54,7 +109,7 @@ template<typename T>
 inline static void parseAttributesImpl(const Protocol::Attributes &attributes, T *entity)
 {
     for (auto iter = attributes.cbegin(), end = attributes.cend(); iter != end; ++iter) {
-        Attribute *attribute = AttributeFactory::createAttribute(iter.key());
+        Attribute *attribute = AttributeFactory::createAttribute(Internal::attributeTypePool().sharedValue(iter.key()));
         if (!attribute) {
             qCWarning(AKONADICORE_LOG) << "Warning: unknown attribute" << iter.key();
             continue;
@@ -556,7 +611,7 @@ TagFetchScope ProtocolHelper::parseTagFetchScope(const Protocol::TagFetchScope &
     return tfs;
 }
 
-static Item::Flags convertFlags(const QList<QByteArray> &flags, ProtocolHelperValuePool *valuePool)
+static Item::Flags convertFlags(const QList<QByteArray> &flags)
 {
 #if __cplusplus >= 201103L || defined(__GNUC__) || defined(__clang__)
     // When the compiler supports thread-safe static initialization (mandated by the C++11 memory model)
@@ -570,12 +625,9 @@ static Item::Flags convertFlags(const QList<QByteArray> &flags, ProtocolHelperVa
 
     Item::Flags convertedFlags;
     convertedFlags.reserve(flags.size());
+    auto &pool = Internal::flagPool();
     for (const QByteArray &flag : flags) {
-        if (valuePool) {
-            convertedFlags.insert(valuePool->flagPool.sharedValue(flag));
-        } else {
-            convertedFlags.insert(flag);
-        }
+        convertedFlags.insert(pool.sharedValue(flag));
     }
     return convertedFlags;
 }
@@ -587,6 +639,8 @@ Item ProtocolHelper::parseItemFetchResult(const Protocol::FetchItemsResponse &da
     Item item;
     item.setId(data.id());
     item.setRevision(data.revision());
+    // String properties of the response may be stored in an arena and are only
+    // decoded when accessed, so don't touch what the fetch scope doesn't want
     if (!fetchScope || fetchScope->fetchRemoteIdentification()) {
         item.setRemoteId(data.remoteId());
         item.setRemoteRevision(data.remoteRevision());
@@ -594,17 +648,13 @@ Item ProtocolHelper::parseItemFetchResult(const Protocol::FetchItemsResponse &da
     item.setGid(data.gid());
     item.setStorageCollectionId(data.parentId());
 
-    if (valuePool) {
-        item.setMimeType(valuePool->mimeTypePool.sharedValue(data.mimeType()));
-    } else {
-        item.setMimeType(data.mimeType());
-    }
+    item.setMimeType(Internal::mimeTypePool().sharedValue(data.mimeType()));
 
     if (!item.isValid()) {
         return Item();
     }
 
-    item.setFlags(convertFlags(data.flags(), valuePool));
+    item.setFlags(convertFlags(data.flags()));
 
     const auto fetchedTags = data.tags();
     if ((!fetchScope || fetchScope->fetchTags()) && !fetchedTags.isEmpty()) {
@@ -630,8 +680,9 @@ Item ProtocolHelper::parseItemFetchResult(const Protocol::FetchItemsResponse &da
     if (!cachedParts.isEmpty()) {
         QSet<QByteArray> cp;
         cp.reserve(cachedParts.size());
+        auto &pool = Internal::partNamePool();
         for (const QByteArray &ba : cachedParts) {
-            cp.insert(ba);
+            cp.insert(pool.sharedValue(ba));
         }
         item.setCachedPayloadParts(cp);
     }
@@ -658,7 +709,7 @@ Item ProtocolHelper::parseItemFetchResult(const Protocol::FetchItemsResponse &da
             if (fetchScope && !fetchScope->allAttributes() && !fetchScope->attributes().contains(plainKey)) {
                 continue;
             }
-            Attribute *attr = AttributeFactory::createAttribute(plainKey);
+            Attribute *attr = AttributeFactory::createAttribute(Internal::attributeTypePool().sharedValue(plainKey));
             Q_ASSERT(attr);
             if (metaData.storageType() == Protocol::PartMetaData::External) {
                 const QString filename = ExternalPartStorage::resolveAbsolutePath(part.data());
@@ -729,6 +780,38 @@ bool ProtocolHelper::streamPayloadToFile(const QString &fileName, const QByteArr
     return true;
 }
 
+QList<Protocol::StreamPayloadResponse> ProtocolHelper::inlinePayloadParts(const Item &item,
+                                                                          const QSet<QByteArray> &partLabels,
+                                                                          qint64 maxSize,
+                                                                          QHash<QByteArray, Protocol::StreamPayloadResponse> &streamedParts)
+{
+    QList<Protocol::StreamPayloadResponse> parts;
+    qint64 remainingSize = maxSize;
+    for (const QByteArray &partLabel : partLabels) {
+        if (remainingSize <= 0) {
+            break;
+        }
+        // Large parts are not kept in memory, they are serialized again when the server requests them
+        BoundedBuffer buffer(maxSize);
+        int version = 0;
+        ItemSerializer::serialize(item, partLabel, buffer, version);
+        if (buffer.overflowed()) {
+            continue;
+        }
+        const QByteArray data = buffer.takeData();
+        const QByteArray partName = encodePartIdentifier(PartPayload, partLabel);
+        Protocol::StreamPayloadResponse part(partName, Protocol::PartMetaData(partName, data.size(), version), data);
+        if (data.size() > remainingSize) {
+            // Keep it for when the server requests it
+            streamedParts.insert(partLabel, std::move(part));
+            continue;
+        }
+        remainingSize -= data.size();
+        parts.push_back(std::move(part));
+    }
+    return parts;
+}
+
 Akonadi::Tristate ProtocolHelper::listPreference(Collection::ListPreference pref)
 {
     switch (pref) {
@@ -12,7 +12,6 @@
 #include "collectionutils.h"
 #include "item.h"
 #include "itemfetchscope.h"
-#include "sharedvaluepool_p.h"
 #include "tag.h"
 
 #include "private/protocol_p.h"
@@ -32,12 +31,9 @@ using namespace AkRanges;
 
 namespace Akonadi
 {
+// Flags, mime types, part names and attribute types are shared process-wide
+// through the pools in sharedvaluepool_p.h, this only caches per-job data
 struct ProtocolHelperValuePool {
-    using FlagPool = Internal::SharedValuePool<QByteArray, QList>;
-    using MimeTypePool = Internal::SharedValuePool<QString, QList>;
-
-    FlagPool flagPool;
-    MimeTypePool mimeTypePool;
     QHash<Collection::Id, Collection> ancestorCollections;
 };
 
@@ -219,6 +215,20 @@ public:
 
     static bool streamPayloadToFile(const QString &file, const QByteArray &data, QByteArray &error);
 
+    /**
+     * Serializes the payload parts @p partLabels of @p item to be sent inline with
+     * a CreateItem or ModifyItems command, as long as their total size doesn't exceed
+     * @p maxSize. The remaining parts are requested by the server as usual.
+     *
+     * Parts up to @p maxSize which were serialized but did not fit are returned in
+     * @p streamedParts, keyed by their label, so that they don't have to be serialized
+     * again when the server requests them. Larger parts are dropped while they are being serialized.
+     */
+    static QList<Protocol::StreamPayloadResponse> inlinePayloadParts(const Item &item,
+                                                                     const QSet<QByteArray> &partLabels,
+                                                                     qint64 maxSize,
+                                                                     QHash<QByteArray, Protocol::StreamPayloadResponse> &streamedParts);
+
     static Akonadi::Tristate listPreference(const Collection::ListPreference pref);
 
 private:
@@ -115,7 +115,14 @@ bool SessionPrivate::handleCommands()
             Internal::setServerProtocolVersion(protocolVersion);
             Internal::setGeneration(hello.generation());
 
-            sendCommand(nextTag(), Protocol::LoginCommandPtr::create(sessionId));
+            if (protocolVersion != Protocol::version()) {
+                // Any other response might have a different layout, so don't even log in
+                maxInlinePartSize = 0;
+                connected = true;
+                startNext();
+            } else {
+                sendCommand(nextTag(), Protocol::LoginCommandPtr::create(sessionId));
+            }
         } else if (cmd->type() == Protocol::Command::Login) {
             const auto &login = Protocol::cmdCast<Protocol::LoginResponse>(cmd);
             if (login.isError()) {
@@ -127,6 +134,8 @@ bool SessionPrivate::handleCommands()
                 return false;
             }
 
+            // The environment variable allows comparing with the StreamPayload round trips
+            maxInlinePartSize = qEnvironmentVariableIsSet("AKONADI_DISABLE_INLINE_PARTS") ? 0 : login.maxInlinePartSize();
             connected = true;
             startNext();
         } else if (currentJob) {
@@ -127,6 +127,7 @@ public:
     bool connected;
     qint64 theNextTag;
     int protocolVersion;
+    qint64 maxInlinePartSize = 0;
 
     CommandBuffer mCommandBuffer;
 
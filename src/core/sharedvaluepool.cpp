@@ -0,0 +1,34 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "sharedvaluepool_p.h"
+
+using namespace Akonadi::Internal;
+
+Q_GLOBAL_STATIC(SharedValuePool<QByteArray>, s_flagPool) // NOLINT(readability-redundant-member-init)
+Q_GLOBAL_STATIC(SharedValuePool<QString>, s_mimeTypePool) // NOLINT(readability-redundant-member-init)
+Q_GLOBAL_STATIC(SharedValuePool<QByteArray>, s_partNamePool) // NOLINT(readability-redundant-member-init)
+Q_GLOBAL_STATIC(SharedValuePool<QByteArray>, s_attributeTypePool) // NOLINT(readability-redundant-member-init)
+
+SharedValuePool<QByteArray> &Akonadi::Internal::flagPool()
+{
+    return *s_flagPool;
+}
+
+SharedValuePool<QString> &Akonadi::Internal::mimeTypePool()
+{
+    return *s_mimeTypePool;
+}
+
+SharedValuePool<QByteArray> &Akonadi::Internal::partNamePool()
+{
+    return *s_partNamePool;
+}
+
+SharedValuePool<QByteArray> &Akonadi::Internal::attributeTypePool()
+{
+    return *s_attributeTypePool;
+}
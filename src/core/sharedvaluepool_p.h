@@ -6,7 +6,12 @@
 
 #pragma once
 
-#include <algorithm>
+#include "akonadicore_export.h"
+
+#include <QByteArray>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
 
 namespace Akonadi
 {
@@ -15,26 +20,72 @@ namespace Internal
 /**
  * Pool of implicitly shared values, use for optimizing memory use
  * when having a large amount of copies from a small set of different values.
+ *
+ * Lookups are hashed and the pool can be used from multiple threads at the
+ * same time. As values are never removed from the pool, it stops growing once
+ * it holds maxSize() values and returns any further values unshared.
  */
-template<typename T, template<typename> class Container>
+template<typename T>
 class SharedValuePool
 {
 public:
+    static constexpr qsizetype DefaultMaxSize = 4096;
+
+    explicit SharedValuePool(qsizetype maxSize = DefaultMaxSize)
+        : m_maxSize(maxSize)
+    {
+    }
+
     /** Returns the shared value equal to \p value .*/
     T sharedValue(const T &value)
     {
-        // for small pool sizes this is actually faster than using lower_bound and a sorted vector
-        typename Container<T>::const_iterator it = std::find(m_pool.constBegin(), m_pool.constEnd(), value);
+        {
+            QReadLocker locker(&m_lock);
+            const auto it = m_pool.constFind(value);
+            if (it != m_pool.constEnd()) {
+                return *it;
+            }
+        }
+
+        QWriteLocker locker(&m_lock);
+        // Another thread might have added the value in the meantime
+        const auto it = m_pool.constFind(value);
         if (it != m_pool.constEnd()) {
             return *it;
         }
-        m_pool.push_back(value);
+        if (m_pool.size() < m_maxSize) {
+            m_pool.insert(value);
+        }
         return value;
     }
 
+    /** Returns the number of distinct values in the pool. */
+    [[nodiscard]] qsizetype size() const
+    {
+        QReadLocker locker(&m_lock);
+        return m_pool.size();
+    }
+
+    /** Returns the maximum number of distinct values kept in the pool. */
+    [[nodiscard]] qsizetype maxSize() const
+    {
+        return m_maxSize;
+    }
+
 private:
-    Container<T> m_pool;
+    mutable QReadWriteLock m_lock;
+    QSet<T> m_pool;
+    const qsizetype m_maxSize;
 };
 
+/**
+ * Process-wide pools for the values that are repeated in nearly every
+ * item received from the server.
+ */
+AKONADICORE_EXPORT SharedValuePool<QByteArray> &flagPool();
+AKONADICORE_EXPORT SharedValuePool<QString> &mimeTypePool();
+AKONADICORE_EXPORT SharedValuePool<QByteArray> &partNamePool();
+AKONADICORE_EXPORT SharedValuePool<QByteArray> &attributeTypePool();
+
 }
 }
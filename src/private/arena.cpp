@@ -0,0 +1,143 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "arena_p.h"
+#include "datastream_p_p.h"
+#include "protocol_exception_p.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace Akonadi
+{
+namespace Protocol
+{
+class ArenaChunk
+{
+public:
+    explicit ArenaChunk(qsizetype capacity)
+        : data(new char[capacity])
+        , capacity(capacity)
+    {
+    }
+
+    std::unique_ptr<char[]> data;
+    const qsizetype capacity;
+    // Only accessed by the Arena that owns the chunk
+    qsizetype used = 0;
+};
+
+} // namespace Protocol
+} // namespace Akonadi
+
+using namespace Akonadi;
+using namespace Akonadi::Protocol;
+
+QString LazyData::toString(Ref ref) const
+{
+    if (ref.size == Null) {
+        return QString();
+    } else if (ref.size == 0) {
+        return QString(QLatin1StringView(""));
+    }
+    Q_ASSERT(mChunk);
+    return QString(reinterpret_cast<const QChar *>(mChunk->data.get() + mOffset + ref.offset), ref.size / sizeof(QChar));
+}
+
+QByteArray LazyData::toByteArray(Ref ref) const
+{
+    if (ref.size <= 0) {
+        // DataStream decodes empty byte arrays as null
+        return QByteArray();
+    }
+    Q_ASSERT(mChunk);
+    return QByteArray(mChunk->data.get() + mOffset + ref.offset, ref.size);
+}
+
+Arena::Arena(qsizetype chunkSize)
+    : mChunkSize(chunkSize)
+{
+}
+
+Arena::~Arena() = default;
+
+qsizetype Arena::allocatedChunks() const
+{
+    return mAllocatedChunks;
+}
+
+LazyData::Ref Arena::readString(DataStream &stream, LazyData &data)
+{
+    return read(stream, data, true);
+}
+
+LazyData::Ref Arena::readByteArray(DataStream &stream, LazyData &data)
+{
+    return read(stream, data, false);
+}
+
+LazyData::Ref Arena::read(DataStream &stream, LazyData &data, bool isString)
+{
+    quint32 bytes = 0;
+    stream >> bytes;
+    if (bytes == 0xffffffff) {
+        return {0, LazyData::Null};
+    }
+    if (Q_UNLIKELY(bytes > quint32(std::numeric_limits<qint32>::max()) || (isString && (bytes & 0x1)))) {
+        throw Akonadi::ProtocolException("Read corrupt data");
+    }
+
+    char *dest = reserve(data, bytes);
+    const LazyData::Ref ref{quint32(dest - data.mChunk->data.get() - data.mOffset), qint32(bytes)};
+
+    const quint32 step = 1024 * 1024;
+    quint32 done = 0;
+    while (done < bytes) {
+        const quint32 blockSize = qMin(step, bytes - done);
+        stream.waitForData(blockSize);
+        if (stream.readRawData(dest + done, blockSize) != qint64(blockSize)) {
+            throw Akonadi::ProtocolException("Failed to read enough data from stream");
+        }
+        done += blockSize;
+    }
+    mChunk->used += bytes;
+
+    return ref;
+}
+
+char *Arena::reserve(LazyData &data, qsizetype size)
+{
+    // Values are aligned to two bytes so that strings can be read as QChars
+    const auto align = [](qsizetype offset) {
+        return (offset + 1) & ~qsizetype(1);
+    };
+
+    const bool continuesObject = data.mChunk && data.mChunk == mChunk;
+    if (mChunk && align(mChunk->used) + size <= mChunk->capacity) {
+        mChunk->used = align(mChunk->used);
+        if (!continuesObject) {
+            data.mChunk = mChunk;
+            data.mOffset = mChunk->used;
+        }
+        return mChunk->data.get() + mChunk->used;
+    }
+
+    // All values of an object must live in the same chunk, so move the
+    // values of the current object that have been read so far
+    const qsizetype objectSize = continuesObject ? mChunk->used - data.mOffset : 0;
+    auto chunk = QSharedPointer<ArenaChunk>::create(std::max(mChunkSize, align(objectSize) + size));
+    ++mAllocatedChunks;
+    if (objectSize > 0) {
+        std::memcpy(chunk->data.get(), mChunk->data.get() + data.mOffset, objectSize);
+        chunk->used = align(objectSize);
+    }
+    mChunk = chunk;
+    data.mChunk = chunk;
+    data.mOffset = 0;
+    return mChunk->data.get() + mChunk->used;
+}
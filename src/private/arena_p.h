@@ -0,0 +1,104 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akonadiprivate_export.h"
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+
+namespace Akonadi
+{
+namespace Protocol
+{
+class Arena;
+class ArenaChunk;
+class DataStream;
+
+/**
+  Encoded values of the lazy properties of a single protocol object.
+
+  Properties marked as lazy in protocol.xml are not decoded when the object
+  is deserialized from a stream that has an Arena set. Their encoded bytes
+  are kept in a chunk of the arena instead and each property is only decoded
+  into a QString or QByteArray when its getter is called.
+
+  The chunk is shared by all objects deserialized from the same arena and
+  stays alive as long as any of them refers to it, so lazy objects can be
+  safely copied and passed between threads.
+*/
+class AKONADIPRIVATE_EXPORT LazyData
+{
+public:
+    enum : qint32 {
+        NotLazy = -2, ///< The value is stored in the property itself
+        Null = -1, ///< The value is a null string
+    };
+
+    /**
+      Location of a single encoded value, relative to the start of the object.
+    */
+    struct Ref {
+        quint32 offset = 0;
+        qint32 size = NotLazy;
+    };
+
+    static inline bool isLazy(Ref ref)
+    {
+        return ref.size != NotLazy;
+    }
+
+    [[nodiscard]] QString toString(Ref ref) const;
+    [[nodiscard]] QByteArray toByteArray(Ref ref) const;
+
+private:
+    friend class Arena;
+
+    QSharedPointer<const ArenaChunk> mChunk;
+    qsizetype mOffset = 0;
+};
+
+/**
+  Backing storage for lazy properties of deserialized protocol objects.
+
+  Instead of allocating a QString or QByteArray for every lazy property, the
+  encoded values are appended into large chunks. The arena is only ever used
+  from the thread that deserializes, readers only access values that have
+  been completely written before the object was handed over to them.
+
+  @see DataStream::setArena()
+*/
+class AKONADIPRIVATE_EXPORT Arena
+{
+public:
+    static constexpr qsizetype DefaultChunkSize = 256 * 1024;
+
+    explicit Arena(qsizetype chunkSize = DefaultChunkSize);
+    ~Arena();
+
+    LazyData::Ref readString(DataStream &stream, LazyData &data);
+    LazyData::Ref readByteArray(DataStream &stream, LazyData &data);
+
+    /**
+      Returns the number of chunks allocated by the arena so far.
+    */
+    [[nodiscard]] qsizetype allocatedChunks() const;
+
+private:
+    Q_DISABLE_COPY_MOVE(Arena)
+
+    LazyData::Ref read(DataStream &stream, LazyData &data, bool isString);
+    char *reserve(LazyData &data, qsizetype size);
+
+    QSharedPointer<ArenaChunk> mChunk;
+    const qsizetype mChunkSize;
+    qsizetype mAllocatedChunks = 0;
+};
+
+} // namespace Protocol
+} // namespace Akonadi
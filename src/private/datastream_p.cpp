@@ -101,6 +101,16 @@ void DataStream::setWaitTimeout(std::chrono::milliseconds timeout)
     mWaitTimeout = timeout;
 }
 
+Arena *DataStream::arena() const
+{
+    return mArena;
+}
+
+void DataStream::setArena(Arena *arena)
+{
+    mArena = arena;
+}
+
 void DataStream::waitForData(quint32 size)
 {
     checkDevice();
@@ -20,6 +20,7 @@
 
 namespace Akonadi::Protocol
 {
+class Arena;
 
 class AKONADIPRIVATE_EXPORT DataStream
 {
@@ -36,6 +37,13 @@ public:
     std::chrono::milliseconds waitTimeout() const;
     void setWaitTimeout(std::chrono::milliseconds timeout);
 
+    /**
+     * Sets the arena used to store lazy properties of deserialized objects.
+     * When no arena is set (the default) all properties are decoded immediately.
+     */
+    Arena *arena() const;
+    void setArena(Arena *arena);
+
     void flush();
 
     template<typename T>
@@ -77,6 +85,7 @@ private:
     }
 
     QIODevice *mDev;
+    Arena *mArena = nullptr;
     QByteArray mWriteBuffer;
     std::chrono::milliseconds mWaitTimeout = std::chrono::seconds{30};
 };
@@ -14,8 +14,34 @@
 #include <QMutexLocker>
 #include <QThread>
 
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#endif
+
 using namespace Akonadi;
 
+namespace
+{
+bool linkFile(const QString &sourcePath, const QString &targetPath)
+{
+#ifdef Q_OS_UNIX
+    if (::link(QFile::encodeName(sourcePath).constData(), QFile::encodeName(targetPath).constData()) == 0) {
+        return true;
+    }
+    // EXDEV, EMLINK or a filesystem without hard links, copying still works
+    qCDebug(AKONADIPRIVATE_LOG) << "Failed to link" << targetPath << "to" << sourcePath << ":" << strerror(errno) << ", copying the file instead";
+#endif
+    if (!QFile::copy(sourcePath, targetPath)) {
+        qCWarning(AKONADIPRIVATE_LOG) << "Error: failed to copy part file" << sourcePath << "to" << targetPath;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
 ExternalPartStorageTransaction::ExternalPartStorageTransaction()
 {
     ExternalPartStorage::self()->beginTransaction();
@@ -177,6 +203,70 @@ bool ExternalPartStorage::updatePartFile(const QByteArray &newData, const QByteA
     return true;
 }
 
+bool ExternalPartStorage::createPartFileLink(const QByteArray &sourcePartFile, qint64 partId, QByteArray &partFileName)
+{
+    bool exists = false;
+    const QString sourcePath = resolveAbsolutePath(sourcePartFile, &exists);
+    if (!exists) {
+        qCWarning(AKONADIPRIVATE_LOG) << "Error: asked to link to a non-existent part" << sourcePartFile;
+        return false;
+    }
+
+    partFileName = updateFileNameRevision(QByteArray::number(partId));
+    const QString path = resolveAbsolutePath(partFileName, &exists);
+    if (exists) {
+        qCWarning(AKONADIPRIVATE_LOG) << "Error: asked to create a part" << partFileName << ", which already exists!";
+        return false;
+    }
+
+    if (!linkFile(sourcePath, path)) {
+        return false;
+    }
+
+    if (inTransaction()) {
+        addToTransaction({{Operation::Create, path}});
+    }
+    return true;
+}
+
+bool ExternalPartStorage::updatePartFileLink(const QByteArray &sourcePartFile, const QByteArray &partFile, QByteArray &newPartFile)
+{
+    bool exists = false;
+    const QString sourcePath = resolveAbsolutePath(sourcePartFile, &exists);
+    if (!exists) {
+        qCWarning(AKONADIPRIVATE_LOG) << "Error: asked to link to a non-existent part" << sourcePartFile;
+        return false;
+    }
+
+    const QString currentPartPath = resolveAbsolutePath(partFile, &exists);
+    if (!exists) {
+        qCWarning(AKONADIPRIVATE_LOG) << "Error: asked to update a non-existent part, aborting update";
+        return false;
+    }
+
+    newPartFile = updateFileNameRevision(partFile);
+    const QString newPartPath = resolveAbsolutePath(newPartFile, &exists);
+    if (exists) {
+        qCWarning(AKONADIPRIVATE_LOG) << "Error: asked to update part" << partFile << ", but" << newPartFile << "already exists, aborting update";
+        return false;
+    }
+
+    if (!linkFile(sourcePath, newPartPath)) {
+        return false;
+    }
+
+    if (inTransaction()) {
+        addToTransaction({{Operation::Create, newPartPath}, {Operation::Delete, currentPartPath}});
+    } else {
+        if (!QFile::remove(currentPartPath)) {
+            // Not a reason to fail the operation
+            qCWarning(AKONADIPRIVATE_LOG) << "Error: failed to remove old part payload file" << currentPartPath;
+        }
+    }
+
+    return true;
+}
+
 bool ExternalPartStorage::removePartFile(const QString &partFile)
 {
     if (inTransaction()) {
@@ -52,6 +52,22 @@ public:
 
     bool updatePartFile(const QByteArray &newData, const QByteArray &partFile, QByteArray &newPartFile);
     bool createPartFile(const QByteArray &newData, qint64 partId, QByteArray &partFileName);
+
+    /**
+     * Like createPartFile(), but shares the content of the existing part file
+     * @p sourcePartFile instead of writing new data.
+     *
+     * Part files are never modified once written, so the new file is a hard link
+     * to the source file where the filesystem supports it, and the content is
+     * only released once all parts referencing it are removed. Falls back to
+     * copying the file otherwise.
+     */
+    bool createPartFileLink(const QByteArray &sourcePartFile, qint64 partId, QByteArray &partFileName);
+    /**
+     * Like updatePartFile(), but shares the content of the existing part file
+     * @p sourcePartFile instead of writing new data, see createPartFileLink().
+     */
+    bool updatePartFileLink(const QByteArray &sourcePartFile, const QByteArray &partFile, QByteArray &newPartFile);
     bool removePartFile(const QString &partFile);
 
     bool inTransaction() const;
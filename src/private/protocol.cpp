@@ -67,6 +67,8 @@ QDebug operator<<(QDebug _dbg, Command::Type type)
         return dbg << "ModifyItems";
     case Command::MoveItems:
         return dbg << "MoveItems";
+    case Command::ItemSyncManifest:
+        return dbg << "ItemSyncManifest";
 
     case Command::CreateCollection:
         return dbg << "CreateCollection";
@@ -101,6 +103,8 @@ QDebug operator<<(QDebug _dbg, Command::Type type)
 
     case Command::SelectResource:
         return dbg << "SelectResource";
+    case Command::PreprocessItems:
+        return dbg << "PreprocessItems";
 
     case Command::StreamPayload:
         return dbg << "StreamPayload";
@@ -138,7 +142,7 @@ DataStream &operator<<(DataStream &stream, const QSharedPointer<T> &ptr)
 template<typename T>
 DataStream &operator>>(DataStream &stream, QSharedPointer<T> &ptr)
 {
-    ptr = Protocol::deserialize(stream.device()).staticCast<T>();
+    ptr = Protocol::deserialize(stream.device(), stream.arena()).staticCast<T>();
     return stream;
 }
 
@@ -179,6 +183,7 @@ void Command::toJson(QJsonObject &json) const
         case_label(LinkItems)
         case_label(ModifyItems)
         case_label(MoveItems)
+        case_label(ItemSyncManifest)
 
         case_label(CreateCollection)
         case_label(CopyCollection)
@@ -198,6 +203,7 @@ void Command::toJson(QJsonObject &json) const
         case_label(ModifyTag)
 
         case_label(SelectResource)
+        case_label(PreprocessItems)
 
         case_label(StreamPayload)
         case_label(CreateSubscription)
@@ -263,6 +269,7 @@ void toJson(const Akonadi::Protocol::Command *command, QJsonObject &json)
     case_commandlabel(LinkItems, LinkItemsCommand, LinkItemsResponse)
     case_commandlabel(ModifyItems, ModifyItemsCommand, ModifyItemsResponse)
     case_commandlabel(MoveItems, MoveItemsCommand, MoveItemsResponse)
+    case_commandlabel(ItemSyncManifest, ItemSyncManifestCommand, ItemSyncManifestResponse)
 
    case_commandlabel(CreateCollection, CreateCollectionCommand, CreateCollectionResponse)
    case_commandlabel(CopyCollection, CopyCollectionCommand, CopyCollectionResponse)
@@ -282,6 +289,7 @@ void toJson(const Akonadi::Protocol::Command *command, QJsonObject &json)
    case_commandlabel(ModifyTag, ModifyTagCommand, ModifyTagResponse)
 
     case_commandlabel(SelectResource, SelectResourceCommand, SelectResourceResponse)
+    case_commandlabel(PreprocessItems, PreprocessItemsCommand, PreprocessItemsResponse)
 
     case_commandlabel(StreamPayload, StreamPayloadCommand, StreamPayloadResponse)
 
@@ -373,6 +381,7 @@ public:
         registerType<Command::LinkItems, LinkItemsCommand, LinkItemsResponse>();
         registerType<Command::ModifyItems, ModifyItemsCommand, ModifyItemsResponse>();
         registerType<Command::MoveItems, MoveItemsCommand, MoveItemsResponse>();
+        registerType<Command::ItemSyncManifest, ItemSyncManifestCommand, ItemSyncManifestResponse>();
 
         // Collections
         registerType<Command::CreateCollection, CreateCollectionCommand, CreateCollectionResponse>();
@@ -396,6 +405,7 @@ public:
 
         // Resources
         registerType<Command::SelectResource, SelectResourceCommand, SelectResourceResponse>();
+        registerType<Command::PreprocessItems, PreprocessItemsCommand, PreprocessItemsResponse>();
 
         // Other...?
         registerType<Command::StreamPayload, StreamPayloadCommand, StreamPayloadResponse>();
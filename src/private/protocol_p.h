@@ -18,6 +18,7 @@
 #include <QList>
 #include <QSharedPointer>
 
+#include "arena_p.h"
 #include "scope_p.h"
 #include "tristate_p.h"
 
@@ -80,6 +81,7 @@ public:
         LinkItems,
         ModifyItems,
         MoveItems,
+        ItemSyncManifest,
 
         // Collections
         CreateCollection = 40,
@@ -103,6 +105,7 @@ public:
 
         // Resources
         SelectResource = 90,
+        PreprocessItems,
 
         // Other
         StreamPayload = 100,
@@ -270,7 +273,7 @@ private:
 };
 
 AKONADIPRIVATE_EXPORT void serialize(DataStream &stream, const CommandPtr &command);
-AKONADIPRIVATE_EXPORT CommandPtr deserialize(QIODevice *device);
+AKONADIPRIVATE_EXPORT CommandPtr deserialize(QIODevice *device, Arena *arena = nullptr);
 AKONADIPRIVATE_EXPORT QString debugString(const Command &command);
 AKONADIPRIVATE_EXPORT inline QString debugString(const CommandPtr &command)
 {
@@ -0,0 +1,100 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "protocolcapture_p.h"
+
+#include <QDataStream>
+#include <QHash>
+#include <QIODevice>
+
+using namespace Akonadi;
+using namespace Akonadi::ProtocolCapture;
+
+namespace
+{
+constexpr char Magic[] = {'A', 'K', 'P', 'R', 'O', 'C', 'A', 'P'};
+constexpr quint32 FormatVersion = 1;
+
+void prepareStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream.setByteOrder(QDataStream::LittleEndian);
+}
+
+} // namespace
+
+bool ProtocolCapture::writeHeader(QIODevice *device, const Header &header)
+{
+    if (device->write(Magic, sizeof(Magic)) != sizeof(Magic)) {
+        return false;
+    }
+
+    QDataStream stream(device);
+    prepareStream(stream);
+    stream << FormatVersion << header.startTime << qint32(header.protocolVersion);
+    return stream.status() == QDataStream::Ok;
+}
+
+bool ProtocolCapture::writeRecord(QIODevice *device, const Record &record)
+{
+    QDataStream stream(device);
+    prepareStream(stream);
+    stream << quint8(record.type) << record.session << record.timestamp << record.data;
+    return stream.status() == QDataStream::Ok;
+}
+
+bool ProtocolCapture::read(QIODevice *device, Capture &capture)
+{
+    if (device->read(sizeof(Magic)) != QByteArrayView(Magic, sizeof(Magic))) {
+        return false;
+    }
+
+    QDataStream stream(device);
+    prepareStream(stream);
+    quint32 version = 0;
+    qint32 protocolVersion = 0;
+    stream >> version;
+    if (version != FormatVersion) {
+        return false;
+    }
+
+    capture = {};
+    stream >> capture.header.startTime >> protocolVersion;
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    capture.header.protocolVersion = protocolVersion;
+
+    QHash<quint32, qsizetype> sessions;
+    while (!stream.atEnd()) {
+        quint8 type = 0;
+        Record record;
+        stream >> type >> record.session >> record.timestamp >> record.data;
+        if (stream.status() != QDataStream::Ok) {
+            // The server stopped in the middle of writing the record
+            break;
+        }
+
+        switch (static_cast<RecordType>(type)) {
+        case RecordType::SessionBegin:
+            sessions.insert(record.session, capture.sessions.size());
+            capture.sessions.push_back(Session{.id = record.session, .sessionId = record.data, .begin = record.timestamp, .end = -1, .frames = {}});
+            break;
+        case RecordType::Input:
+            if (const auto it = sessions.constFind(record.session); it != sessions.cend()) {
+                capture.sessions[*it].frames.push_back(Frame{.timestamp = record.timestamp, .data = record.data});
+            }
+            break;
+        case RecordType::SessionEnd:
+            if (const auto it = sessions.constFind(record.session); it != sessions.cend()) {
+                capture.sessions[*it].end = record.timestamp;
+            }
+            break;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,83 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akonadiprivate_export.h"
+
+#include <QByteArray>
+#include <QList>
+
+class QIODevice;
+
+namespace Akonadi
+{
+/**
+ * Binary format of the protocol captures recorded by the Akonadi server.
+ *
+ * A capture contains the commands sent by the clients of the captured
+ * sessions exactly as they were framed on the wire (the tag followed by the
+ * serialized command), so that they can be replayed against another server,
+ * e.g. with asapcat --replay. The file is written incrementally while the
+ * server is running, a capture that was cut short by a crash of the server
+ * can still be read up to its last complete record.
+ */
+namespace ProtocolCapture
+{
+enum class RecordType : quint8 {
+    /// A client logged in, the data is the session id
+    SessionBegin = 1,
+    /// A command sent by the client, the data is the tag and the serialized command
+    Input = 2,
+    /// The client disconnected
+    SessionEnd = 3,
+};
+
+struct Record {
+    /// Microseconds since Header::startTime
+    qint64 timestamp = 0;
+    /// Identifies the session within the capture
+    quint32 session = 0;
+    RecordType type = RecordType::Input;
+    QByteArray data;
+};
+
+struct Header {
+    /// Milliseconds since epoch at which the server started capturing
+    qint64 startTime = 0;
+    /// Protocol version of the server which recorded the capture
+    int protocolVersion = 0;
+};
+
+struct Frame {
+    /// Microseconds since Header::startTime
+    qint64 timestamp = 0;
+    QByteArray data;
+};
+
+struct Session {
+    quint32 id = 0;
+    QByteArray sessionId;
+    qint64 begin = 0;
+    /// -1 if the session was still connected when the capture ended
+    qint64 end = -1;
+    QList<Frame> frames;
+};
+
+struct Capture {
+    Header header;
+    /// Ordered by the time the sessions began
+    QList<Session> sessions;
+};
+
+[[nodiscard]] AKONADIPRIVATE_EXPORT bool writeHeader(QIODevice *device, const Header &header);
+[[nodiscard]] AKONADIPRIVATE_EXPORT bool writeRecord(QIODevice *device, const Record &record);
+
+/// Reads the whole capture, a truncated last record is ignored
+[[nodiscard]] AKONADIPRIVATE_EXPORT bool read(QIODevice *device, Capture &capture);
+
+} // namespace ProtocolCapture
+} // namespace Akonadi
@@ -155,9 +155,10 @@ void CppGenerator::writeImplSerializer(DocumentNode const *node)
     mImpl << "    }\n"
              "}\n\n";
 
-    mImpl << "CommandPtr deserialize(QIODevice *device)\n"
+    mImpl << "CommandPtr deserialize(QIODevice *device, Arena *arena)\n"
              "{\n"
              "    DataStream stream(device);\n"
+             "    stream.setArena(arena);\n"
              "    stream.waitForData(sizeof(Command::Type));\n"
              "    Command::Type cmdType;\n"
              "    if (Q_UNLIKELY(device->peek((char *) &cmdType, sizeof(Command::Type)) != sizeof(Command::Type))) {\n"
@@ -247,6 +248,18 @@ void CppGenerator::writeImplSerializer(DocumentNode const *node)
              "\n";
 }
 
+QString CppGenerator::lazyGetter(PropertyNode const *node)
+{
+    const QString ref = node->mRefVariableName();
+    const QString decode = node->type() == QLatin1StringView("QString") ? QStringLiteral("toString") : QStringLiteral("toByteArray");
+    return QStringLiteral("LazyData::isLazy(%1) ? mLazyData.%2(%1) : %3").arg(ref, decode, node->mVariableName());
+}
+
+QString CppGenerator::propertyValue(PropertyNode const *node)
+{
+    return node->isLazy() ? node->name() + QStringLiteral("()") : node->mVariableName();
+}
+
 void CppGenerator::writeHeaderEnum(EnumNode const *node)
 {
     mHeader << "    enum " << node->name() << " {\n";
@@ -352,6 +365,19 @@ void CppGenerator::writeHeaderClass(ClassNode const *node)
     for (const auto *child : node->children()) {
         if (child->type() == Node::Property) {
             const auto *const prop = static_cast<PropertyNode const *>(child);
+            if (prop->isLazy()) {
+                mHeader << "    inline " << prop->type() << " " << prop->name() << "() const { return " << lazyGetter(prop) << "; }\n";
+                if (!prop->readOnly()) {
+                    mHeader << "    inline void " << prop->setterName() << "(const " << prop->type() << " &" << prop->name() << ") { " << prop->mVariableName()
+                            << " = " << prop->name() << "; " << prop->mRefVariableName()
+                            << " = {}; }\n"
+                               "    inline void "
+                            << prop->setterName() << "(" << prop->type() << " &&" << prop->name() << ") { " << prop->mVariableName() << " = std::move("
+                            << prop->name() << "); " << prop->mRefVariableName() << " = {}; }\n";
+                }
+                mHeader << "\n";
+                continue;
+            }
             if (prop->asReference()) {
                 mHeader << "    inline const " << prop->type() << " &" << prop->name() << "() const { return " << prop->mVariableName()
                         << "; }\n"
@@ -409,6 +435,14 @@ void CppGenerator::writeHeaderClass(ClassNode const *node)
         }
         mHeader << ";\n";
     }
+    if (node->hasLazyProperties()) {
+        for (const auto *prop : properties) {
+            if (prop->isLazy()) {
+                mHeader << "    LazyData::Ref " << prop->mRefVariableName() << ";\n";
+            }
+        }
+        mHeader << "    LazyData mLazyData;\n";
+    }
 
     mHeader << "\n"
                "private:\n"
@@ -433,6 +467,29 @@ void CppGenerator::writeHeaderClass(ClassNode const *node)
 
 void CppGenerator::writeImplSerializer(PropertyNode const *node, const char *streamingOperator)
 {
+    if (node->isLazy()) {
+        if (qstrcmp(streamingOperator, "<<") == 0) {
+            mImpl << "    stream << obj." << node->name() << "();\n";
+        } else {
+            mImpl << "    if (Arena *arena = stream.arena()) {\n"
+                     "        obj."
+                  << node->mRefVariableName() << " = arena->" << (node->type() == QLatin1StringView("QString") ? "readString" : "readByteArray")
+                  << "(stream, obj.mLazyData);\n"
+                     "        obj."
+                  << node->mVariableName() << " = " << node->type()
+                  << "();\n"
+                     "    } else {\n"
+                     "        stream >> obj."
+                  << node->mVariableName()
+                  << ";\n"
+                     "        obj."
+                  << node->mRefVariableName()
+                  << " = {};\n"
+                     "    }\n";
+        }
+        return;
+    }
+
     const auto deps = node->dependencies();
     if (deps.isEmpty()) {
         mImpl << "    stream " << streamingOperator << " obj." << node->mVariableName() << ";\n";
@@ -517,6 +574,8 @@ void CppGenerator::writeImplClass(ClassNode const *node)
             mImpl << "        && *" << prop->mVariableName() << " == *other." << prop->mVariableName() << "\n";
         } else if (TypeHelper::isContainer(prop->type())) {
             mImpl << "        && containerComparator(" << prop->mVariableName() << ", other." << prop->mVariableName() << ")\n";
+        } else if (prop->isLazy()) {
+            mImpl << "        && " << prop->name() << "() == other." << prop->name() << "()\n";
         } else {
             mImpl << "        && " << prop->mVariableName() << " == other." << prop->mVariableName() << "\n";
         }
@@ -596,6 +655,9 @@ void CppGenerator::writeImplClass(ClassNode const *node)
     if (!parentClass.isEmpty()) {
         mImpl << "    stream >> static_cast<" << parentClass << " &>(obj);\n";
     }
+    if (node->hasLazyProperties()) {
+        mImpl << "    obj.mLazyData = LazyData();\n";
+    }
     for (const auto *prop : std::as_const(serializeProperties)) {
         writeImplSerializer(prop, ">>");
     }
@@ -631,6 +693,8 @@ void CppGenerator::writeImplClass(ClassNode const *node)
             mImpl << " << \"\\n\";\n"
                      "    }\n"
                      "    dbg.noquote() << \"]\\n\"\n";
+        } else if (prop->isLazy()) {
+            mImpl << "        << \"" << prop->name() << ":\" << obj." << prop->name() << "() << \"\\n\"\n";
         } else {
             mImpl << "        << \"" << prop->name() << ":\" << obj." << prop->mVariableName() << " << \"\\n\"\n";
         }
@@ -707,7 +771,7 @@ void CppGenerator::writeImplClass(ClassNode const *node)
             } else if (prop->type() == QLatin1StringView("QDateTime")) {
                 mImpl << "    json[QStringLiteral(\"" << prop->name() << "\")] = " << prop->mVariableName() << ".toString()/* " << prop->type() << " */;\n";
             } else if (prop->type() == QLatin1StringView("QByteArray")) {
-                mImpl << "    json[QStringLiteral(\"" << prop->name() << "\")] = QString::fromUtf8(" << prop->mVariableName() << ")/* " << prop->type()
+                mImpl << "    json[QStringLiteral(\"" << prop->name() << "\")] = QString::fromUtf8(" << propertyValue(prop) << ")/* " << prop->type()
                       << " */;\n";
             } else if (prop->type() == QLatin1StringView("Scope")) {
                 mImpl << "    {\n"
@@ -759,7 +823,7 @@ void CppGenerator::writeImplClass(ClassNode const *node)
                 mImpl << "    json[QStringLiteral(\"" << prop->name() << "\")] = static_cast<int>(" << prop->mVariableName() << ");/* " << prop->type()
                       << "*/\n";
             } else {
-                mImpl << "    json[QStringLiteral(\"" << prop->name() << "\")] = " << prop->mVariableName() << ";/* " << prop->type() << "*/\n";
+                mImpl << "    json[QStringLiteral(\"" << prop->name() << "\")] = " << propertyValue(prop) << ";/* " << prop->type() << "*/\n";
             }
         } else {
             mImpl << "    {\n"
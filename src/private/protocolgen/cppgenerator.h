@@ -41,6 +41,9 @@ private:
 
     void writeImplPropertyDependencies(PropertyNode const *node);
 
+    static QString lazyGetter(PropertyNode const *node);
+    static QString propertyValue(PropertyNode const *node);
+
 private:
     QFile mHeaderFile;
     QTextStream mHeader;
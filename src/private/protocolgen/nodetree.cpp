@@ -8,6 +8,8 @@
 #include "cpphelper.h"
 #include "typehelper.h"
 
+#include <algorithm>
+
 namespace
 {
 
@@ -155,6 +157,14 @@ QList<PropertyNode const *> ClassNode::properties() const
     return rv;
 }
 
+bool ClassNode::hasLazyProperties() const
+{
+    const auto props = properties();
+    return std::any_of(props.cbegin(), props.cend(), [](const PropertyNode *prop) {
+        return prop->isLazy();
+    });
+}
+
 CtorNode::CtorNode(const QList<Argument> &args, ClassNode *parent)
     : Node(Ctor, parent)
     , mArgs(args)
@@ -246,6 +256,7 @@ PropertyNode::PropertyNode(const QString &name, const QString &type, ClassNode *
     , mSetter(nullptr)
     , mReadOnly(false)
     , mAsReference(false)
+    , mLazy(false)
 {
 }
 
@@ -294,6 +305,16 @@ void PropertyNode::setAsReference(bool asReference)
     mAsReference = asReference;
 }
 
+bool PropertyNode::isLazy() const
+{
+    return mLazy;
+}
+
+void PropertyNode::setLazy(bool lazy)
+{
+    mLazy = lazy;
+}
+
 bool PropertyNode::isPointer() const
 {
     return TypeHelper::isPointerType(mType);
@@ -339,6 +360,11 @@ QString PropertyNode::mVariableName() const
     return QStringLiteral("m") + mName[0].toUpper() + QStringView(mName).mid(1);
 }
 
+QString PropertyNode::mRefVariableName() const
+{
+    return mVariableName() + QStringLiteral("Ref");
+}
+
 QString PropertyNode::setterName() const
 {
     return QStringLiteral("set") + mName[0].toUpper() + QStringView(mName).mid(1);
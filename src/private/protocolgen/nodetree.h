@@ -71,6 +71,7 @@ public:
     QString className() const;
     QString parentClassName() const;
     QList<PropertyNode const *> properties() const;
+    bool hasLazyProperties() const;
 
     static ClassType elementNameToType(QStringView name);
 
@@ -164,6 +165,9 @@ public:
     bool asReference() const;
     void setAsReference(bool asReference);
 
+    bool isLazy() const;
+    void setLazy(bool lazy);
+
     bool isPointer() const;
     bool isEnum() const;
 
@@ -174,6 +178,7 @@ public:
     void setSetter(Setter *setter);
 
     QString mVariableName() const;
+    QString mRefVariableName() const;
     QString setterName() const;
 
 private:
@@ -184,4 +189,5 @@ private:
     Setter *mSetter;
     bool mReadOnly;
     bool mAsReference;
+    bool mLazy;
 };
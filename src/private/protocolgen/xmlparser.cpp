@@ -218,6 +218,9 @@ bool XmlParser::parseParam(ClassNode *classNode)
     if (attrs.hasAttribute(QLatin1StringView("asReference"))) {
         paramNode->setAsReference(attrs.value(QLatin1StringView("asReference")) == QLatin1StringView("true"));
     }
+    if (attrs.hasAttribute(QLatin1StringView("lazy"))) {
+        paramNode->setLazy(attrs.value(QLatin1StringView("lazy")) == QLatin1StringView("true"));
+    }
 
     while (!mReader.atEnd() && !(mReader.isEndElement() && mReader.name() == QLatin1StringView("param"))) {
         mReader.readNext();
@@ -242,6 +245,17 @@ bool XmlParser::parseParam(ClassNode *classNode)
         }
     }
 
+    if (paramNode->isLazy()) {
+        if (type != QLatin1StringView("QString") && type != QLatin1StringView("QByteArray")) {
+            printError(QStringLiteral("Only QString and QByteArray params can be lazy"));
+            return false;
+        }
+        if (paramNode->asReference() || paramNode->setter() || !paramNode->dependencies().isEmpty()) {
+            printError(QStringLiteral("Lazy params cannot have a custom setter, dependencies or be returned by reference"));
+            return false;
+        }
+    }
+
     return true;
 }
 
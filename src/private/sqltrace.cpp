@@ -0,0 +1,196 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "sqltrace_p.h"
+
+#include <QDataStream>
+#include <QIODevice>
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+using namespace Akonadi;
+using namespace Akonadi::SqlTrace;
+
+namespace
+{
+constexpr char Magic[] = {'A', 'K', 'S', 'Q', 'L', 'T', 'R', 'C'};
+constexpr quint32 FormatVersion = 1;
+
+void prepareStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream.setByteOrder(QDataStream::LittleEndian);
+}
+
+} // namespace
+
+quint32 SqlTrace::statementHash(QStringView statement)
+{
+    // FNV-1a, so that hashes of the same statement can be compared across traces
+    quint32 hash = 2166136261U;
+    for (const QChar c : statement) {
+        hash = (hash ^ c.unicode()) * 16777619U;
+    }
+    return hash;
+}
+
+bool SqlTrace::write(QIODevice *device, const Trace &trace)
+{
+    if (device->write(Magic, sizeof(Magic)) != sizeof(Magic)) {
+        return false;
+    }
+
+    QDataStream stream(device);
+    prepareStream(stream);
+    stream << FormatVersion << trace.startTime << trace.sampleRate << trace.dropped;
+
+    stream << quint32(trace.statements.size());
+    for (auto it = trace.statements.cbegin(), end = trace.statements.cend(); it != end; ++it) {
+        stream << it.key() << it.value();
+    }
+
+    stream << quint64(trace.records.size());
+    for (const auto &record : trace.records) {
+        stream << record.timestamp << record.connectionId << record.statementHash << record.duration << record.rows << record.command << record.commandType
+               << quint8(record.type) << record.flags << record.transaction;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool SqlTrace::read(QIODevice *device, Trace &trace)
+{
+    if (device->read(sizeof(Magic)) != QByteArrayView(Magic, sizeof(Magic))) {
+        return false;
+    }
+
+    QDataStream stream(device);
+    prepareStream(stream);
+    quint32 version = 0;
+    stream >> version;
+    if (version != FormatVersion) {
+        return false;
+    }
+
+    trace = {};
+    stream >> trace.startTime >> trace.sampleRate >> trace.dropped;
+
+    quint32 statementCount = 0;
+    stream >> statementCount;
+    for (quint32 i = 0; i < statementCount && stream.status() == QDataStream::Ok; ++i) {
+        quint32 hash = 0;
+        QString statement;
+        stream >> hash >> statement;
+        trace.statements.insert(hash, statement);
+    }
+
+    quint64 recordCount = 0;
+    stream >> recordCount;
+    for (quint64 i = 0; i < recordCount && stream.status() == QDataStream::Ok; ++i) {
+        Record record;
+        quint8 type = 0;
+        stream >> record.timestamp >> record.connectionId >> record.statementHash >> record.duration >> record.rows >> record.command >> record.commandType
+            >> type >> record.flags >> record.transaction;
+        record.type = static_cast<EventType>(type);
+        trace.records.push_back(record);
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+QList<StatementStats> SqlTrace::topStatements(const Trace &trace)
+{
+    QHash<quint32, StatementStats> stats;
+    for (const auto &record : trace.records) {
+        if (record.type != EventType::Query) {
+            continue;
+        }
+        auto &stat = stats[record.statementHash];
+        stat.statementHash = record.statementHash;
+        ++stat.count;
+        if (record.flags & Error) {
+            ++stat.errors;
+        }
+        stat.totalDuration += record.duration;
+        stat.maxDuration = std::max<qint64>(stat.maxDuration, record.duration);
+        stat.totalRows += std::max<qint64>(record.rows, 0);
+    }
+
+    auto result = stats.values();
+    std::sort(result.begin(), result.end(), [](const StatementStats &lhs, const StatementStats &rhs) {
+        return std::tie(rhs.totalDuration, rhs.count) < std::tie(lhs.totalDuration, lhs.count);
+    });
+    return result;
+}
+
+QList<RepeatedStatement> SqlTrace::repeatedStatements(const Trace &trace, qint64 threshold)
+{
+    // The connection, and the command and the statement packed into a single value
+    using Key = std::pair<qint64, quint64>;
+    QHash<Key, RepeatedStatement> repeated;
+    for (const auto &record : trace.records) {
+        if (record.type != EventType::Query || record.command == 0) {
+            continue;
+        }
+        auto &stat = repeated[Key{record.connectionId, (quint64(record.command) << 32) | record.statementHash}];
+        stat.connectionId = record.connectionId;
+        stat.command = record.command;
+        stat.commandType = record.commandType;
+        stat.statementHash = record.statementHash;
+        ++stat.count;
+        stat.totalDuration += record.duration;
+    }
+
+    QList<RepeatedStatement> result;
+    for (const auto &stat : std::as_const(repeated)) {
+        if (stat.count >= threshold) {
+            result.push_back(stat);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const RepeatedStatement &lhs, const RepeatedStatement &rhs) {
+        return std::tie(rhs.count, rhs.totalDuration) < std::tie(lhs.count, lhs.totalDuration);
+    });
+    return result;
+}
+
+QList<TransactionStats> SqlTrace::transactions(const Trace &trace)
+{
+    using Key = std::pair<qint64, quint64>;
+    QHash<Key, TransactionStats> pending;
+    QList<TransactionStats> result;
+    for (const auto &record : trace.records) {
+        if (record.transaction == 0) {
+            continue;
+        }
+        const Key key{record.connectionId, record.transaction};
+        switch (record.type) {
+        case EventType::Query:
+            ++pending[key].statements;
+            break;
+        case EventType::TransactionBegin:
+            pending[key].beginDuration = record.duration;
+            break;
+        case EventType::TransactionCommit:
+        case EventType::TransactionRollback: {
+            auto stat = pending.take(key);
+            stat.connectionId = record.connectionId;
+            stat.transaction = record.transaction;
+            stat.commandType = record.commandType;
+            stat.committed = record.type == EventType::TransactionCommit;
+            stat.holdDuration = record.duration;
+            result.push_back(stat);
+            break;
+        }
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const TransactionStats &lhs, const TransactionStats &rhs) {
+        return rhs.holdDuration < lhs.holdDuration;
+    });
+    return result;
+}
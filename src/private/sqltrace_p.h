@@ -0,0 +1,125 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akonadiprivate_export.h"
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+
+namespace Akonadi
+{
+/**
+ * Binary format of the SQL traces recorded by the Akonadi server, and their analysis.
+ *
+ * The server records every executed statement of the sampled commands in an
+ * in-memory ring buffer, which can be written to a file on demand with the
+ * dumpSqlTrace() D-Bus method of the StorageDebugger. The trace only contains
+ * the hashes of the statements in its records and the text of every statement
+ * once.
+ */
+namespace SqlTrace
+{
+enum class EventType : quint8 {
+    Query = 0,
+    /// The duration is the time it took to start the transaction, including waiting for locks
+    TransactionBegin = 1,
+    /// The duration is the time the transaction was held open
+    TransactionCommit = 2,
+    /// The duration is the time the transaction was held open
+    TransactionRollback = 3,
+};
+
+enum RecordFlag : quint8 {
+    NoFlags = 0x00,
+    Error = 0x01,
+};
+
+struct Record {
+    /// Microseconds since Trace::startTime
+    qint64 timestamp = 0;
+    /// Identifies the database connection of the executing thread
+    qint64 connectionId = 0;
+    quint32 statementHash = 0;
+    /// Microseconds
+    quint32 duration = 0;
+    /// Number of returned or affected rows, -1 if unknown
+    qint64 rows = -1;
+    /// Serial number of the command within the connection, 0 for statements executed outside of a command
+    quint32 command = 0;
+    /// Protocol::Command::Type of the command
+    quint16 commandType = 0;
+    EventType type = EventType::Query;
+    quint8 flags = NoFlags;
+    /// Serial number of the transaction within the connection, 0 for statements executed outside of a transaction
+    quint64 transaction = 0;
+};
+
+struct Trace {
+    /// Milliseconds since epoch at which the server started recording
+    qint64 startTime = 0;
+    /// Every n-th command is recorded
+    quint32 sampleRate = 1;
+    /// Number of records which were overwritten before the trace was written
+    quint64 dropped = 0;
+    QHash<quint32, QString> statements;
+    /// Ordered by timestamp
+    QList<Record> records;
+};
+
+[[nodiscard]] AKONADIPRIVATE_EXPORT quint32 statementHash(QStringView statement);
+
+[[nodiscard]] AKONADIPRIVATE_EXPORT bool write(QIODevice *device, const Trace &trace);
+[[nodiscard]] AKONADIPRIVATE_EXPORT bool read(QIODevice *device, Trace &trace);
+
+struct StatementStats {
+    quint32 statementHash = 0;
+    qint64 count = 0;
+    qint64 errors = 0;
+    /// Microseconds
+    qint64 totalDuration = 0;
+    qint64 maxDuration = 0;
+    qint64 totalRows = 0;
+};
+
+/// A statement that was executed repeatedly by a single command, typically once for every row of a previous result
+struct RepeatedStatement {
+    qint64 connectionId = 0;
+    quint32 command = 0;
+    quint16 commandType = 0;
+    quint32 statementHash = 0;
+    qint64 count = 0;
+    /// Microseconds
+    qint64 totalDuration = 0;
+};
+
+struct TransactionStats {
+    qint64 connectionId = 0;
+    quint64 transaction = 0;
+    quint16 commandType = 0;
+    bool committed = false;
+    /// Microseconds it took to start the transaction, -1 if the start is not part of the trace
+    qint64 beginDuration = -1;
+    /// Microseconds the transaction was held open
+    qint64 holdDuration = 0;
+    qint64 statements = 0;
+};
+
+/// Statements sorted by their total duration, most expensive first
+[[nodiscard]] AKONADIPRIVATE_EXPORT QList<StatementStats> topStatements(const Trace &trace);
+
+/// Statements executed at least @p threshold times by a single command, most frequent first
+[[nodiscard]] AKONADIPRIVATE_EXPORT QList<RepeatedStatement> repeatedStatements(const Trace &trace, qint64 threshold);
+
+/// Finished transactions sorted by the time they were held open, longest first
+[[nodiscard]] AKONADIPRIVATE_EXPORT QList<TransactionStats> transactions(const Trace &trace);
+
+} // namespace SqlTrace
+} // namespace Akonadi
@@ -12,17 +12,25 @@
 
 #include "aklocalserver.h"
 #include "cachecleaner.h"
+#include "commandscheduler.h"
+#include "databasemaintenance.h"
 #include "debuginterface.h"
+#include "entities.h"
 #include "intervalcheck.h"
 #include "notificationmanager.h"
+#include "partfilereclaimer.h"
 #include "preprocessormanager.h"
+#include "protocolcapturewriter.h"
 #include "resourcemanager.h"
+#include "search/fulltextindexer.h"
 #include "search/searchmanager.h"
 #include "search/searchtaskmanager.h"
 #include "storage/collectionstatistics.h"
 #include "storage/datastore.h"
 #include "storage/dbconfig.h"
+#include "storage/itemmergeindex.h"
 #include "storage/itemretrievalmanager.h"
+#include "storage/querybuilder.h"
 #include "storagejanitor.h"
 #include "tracer.h"
 #include "utils.h"
@@ -39,6 +47,7 @@
 #include <QDBusServiceWatcher>
 #include <QDir>
 #include <QSettings>
+#include <QThread>
 #include <QTimer>
 
 using namespace Akonadi;
@@ -89,6 +98,7 @@ AkonadiServer::AkonadiServer()
 bool AkonadiServer::init()
 {
     qCInfo(AKONADISERVER_LOG) << "Starting up the Akonadi Server...";
+    mStartupTimer.start();
 
     const QString serverConfigFile = StandardDirs::serverConfigFile(StandardDirs::ReadWrite);
     QSettings settings(serverConfigFile, QSettings::IniFormat);
@@ -114,21 +124,31 @@ bool AkonadiServer::init()
         quit();
         return false;
     }
+    startupPhaseFinished(QStringLiteral("sockets"));
 
     const auto searchManagers = settings.value(QStringLiteral("Search/Manager"), QStringList{QStringLiteral("Agent")}).toStringList();
 
     mTracer = std::make_unique<Tracer>();
-    mCollectionStats = std::make_unique<CollectionStatistics>();
+    mProtocolCapture = std::make_unique<ProtocolCaptureWriter>();
+    // Prefetched by runDeferredStartupTasks(), until then the statistics are calculated on demand
+    mCollectionStats = std::make_unique<CollectionStatistics>(false);
+    mItemMergeIndex = std::make_unique<ItemMergeIndex>();
+    mCommandScheduler = std::make_unique<CommandScheduler>();
     mCacheCleaner = AkThread::create<CacheCleaner>();
     mItemRetrieval = AkThread::create<ItemRetrievalManager>();
     mAgentSearchManager = AkThread::create<SearchTaskManager>();
 
-    mDebugInterface = std::make_unique<DebugInterface>(*mTracer);
+    mDebugInterface = std::make_unique<DebugInterface>(*mTracer, *mProtocolCapture);
     mResourceManager = std::make_unique<ResourceManager>(*mTracer);
     mPreprocessorManager = std::make_unique<PreprocessorManager>(*mTracer);
     mIntervalCheck = AkThread::create<IntervalCheck>(*mItemRetrieval);
+    if (FullTextIndexer::isEnabled()) {
+        mFullTextIndexer = AkThread::create<FullTextIndexer>();
+    }
     mSearchManager = AkThread::create<SearchManager>(searchManagers, *mAgentSearchManager);
     mStorageJanitor = AkThread::create<StorageJanitor>(this);
+    mPartFileReclaimer = AkThread::create<PartFileReclaimer>();
+    mDatabaseMaintenance = AkThread::create<DatabaseMaintenance>(*mCommandScheduler);
 
     if (settings.value(QStringLiteral("General/DisablePreprocessing"), false).toBool()) {
         mPreprocessorManager->setEnabled(false);
@@ -144,12 +164,7 @@ bool AkonadiServer::init()
         quit();
     });
 
-    // Unhide all the items that are actually hidden.
-    // The hidden flag was probably left out after an (abrupt)
-    // server quit. We don't attempt to resume preprocessing
-    // for the items as we don't actually know at which stage the
-    // operation was interrupted...
-    DataStore::self()->unhideAllPimItems();
+    startupPhaseFinished(QStringLiteral("services"));
 
     // We are ready, now register org.freedesktop.Akonadi service to DBus and
     // the fun can begin
@@ -158,10 +173,83 @@ bool AkonadiServer::init()
         quit();
         return false;
     }
+    startupPhaseFinished(QStringLiteral("dbus"));
+    qCInfo(AKONADISERVER_LOG) << "Akonadi Server ready after" << mStartupTimer.elapsed() << "ms";
+
+    runDeferredStartupTasks();
 
     return true;
 }
 
+void AkonadiServer::runDeferredStartupTasks()
+{
+    // Items created from now on may be hidden while they are being preprocessed
+    PimItem::Id maxItemId = -1;
+    QueryBuilder qb(PimItem::tableName());
+    qb.addAggregation(PimItem::idColumn(), QStringLiteral("max"));
+    if (qb.exec() && qb.query().next()) {
+        maxItemId = qb.query().value(0).isNull() ? 0 : qb.query().value(0).toLongLong();
+        qb.query().finish();
+    } else {
+        qCWarning(AKONADISERVER_LOG) << "Failed to query the highest item id, unhiding items before accepting commands";
+        DataStore::self()->unhideAllPimItems();
+        maxItemId = 0;
+    }
+
+    // Neither is required to serve clients, so they do not delay the startup
+    mDeferredStartup.reset(QThread::create([this, maxItemId]() {
+        QElapsedTimer timer;
+        timer.start();
+        // Unhide all the items that are actually hidden.
+        // The hidden flag was probably left out after an (abrupt)
+        // server quit. We don't attempt to resume preprocessing
+        // for the items as we don't actually know at which stage the
+        // operation was interrupted...
+        if (maxItemId > 0) {
+            DataStore::self()->unhideAllPimItems(maxItemId);
+        }
+        const qint64 unhideTime = timer.restart();
+
+        mCollectionStats->prefetch();
+        const qint64 statisticsTime = timer.elapsed();
+
+        DataStore::self()->close();
+        QMetaObject::invokeMethod(
+            this,
+            [this, unhideTime, statisticsTime]() {
+                addStartupPhase(QStringLiteral("deferred unhide items"), unhideTime);
+                addStartupPhase(QStringLiteral("deferred collection statistics"), statisticsTime);
+            },
+            Qt::QueuedConnection);
+    }));
+    mDeferredStartup->setObjectName(QStringLiteral("DeferredStartup"));
+    mDeferredStartup->start(QThread::LowPriority);
+}
+
+void AkonadiServer::startupPhaseFinished(const QString &phase)
+{
+    const qint64 now = mStartupTimer.elapsed();
+    addStartupPhase(phase, now - mLastStartupPhaseEnd);
+    mLastStartupPhaseEnd = now;
+}
+
+void AkonadiServer::addStartupPhase(const QString &phase, qint64 duration)
+{
+    qCInfo(AKONADISERVER_LOG) << "Startup phase" << phase << "took" << duration << "ms";
+    mStartupPhases.push_back({phase, duration});
+}
+
+QVariantMap AkonadiServer::startupTimes() const
+{
+    QVariantMap times;
+    for (const auto &[phase, duration] : mStartupPhases) {
+        times.insert(phase, duration);
+    }
+    // Time until the server was ready to accept clients
+    times.insert(QStringLiteral("total"), mLastStartupPhaseEnd);
+    return times;
+}
+
 AkonadiServer::~AkonadiServer() = default;
 
 bool AkonadiServer::quit()
@@ -172,12 +260,23 @@ bool AkonadiServer::quit()
     mAlreadyShutdown = true;
 
     qCDebug(AKONADISERVER_LOG) << "terminating connection threads";
+    // Preprocessors waiting for items would keep their connections busy
+    if (mPreprocessorManager) {
+        mPreprocessorManager->cancelBatchRequests();
+    }
     mConnections.clear();
 
     qCDebug(AKONADISERVER_LOG) << "terminating service threads";
+    if (mDeferredStartup) {
+        mDeferredStartup->wait();
+        mDeferredStartup.reset();
+    }
     // Keep this order in sync (reversed) with the order of initialization
+    mDatabaseMaintenance.reset();
+    mPartFileReclaimer.reset();
     mStorageJanitor.reset();
     mSearchManager.reset();
+    mFullTextIndexer.reset();
     mIntervalCheck.reset();
     mPreprocessorManager.reset();
     mResourceManager.reset();
@@ -186,7 +285,10 @@ bool AkonadiServer::quit()
     mAgentSearchManager.reset();
     mItemRetrieval.reset();
     mCacheCleaner.reset();
+    mCommandScheduler.reset();
+    mItemMergeIndex.reset();
     mCollectionStats.reset();
+    mProtocolCapture.reset();
     mTracer.reset();
 
     if (DbConfig::isConfigured()) {
@@ -251,6 +353,7 @@ bool AkonadiServer::setupDatabase()
             return false;
         }
     }
+    startupPhaseFinished(QStringLiteral("database process"));
 
     DbConfig::configuredDatabase()->setup();
 
@@ -264,6 +367,7 @@ bool AkonadiServer::setupDatabase()
         qCCritical(AKONADISERVER_LOG) << "Unable to initialize database.";
         return false;
     }
+    startupPhaseFinished(QStringLiteral("database schema"));
 
     return true;
 }
@@ -404,6 +508,21 @@ CacheCleaner *AkonadiServer::cacheCleaner()
     return mCacheCleaner.get();
 }
 
+FullTextIndexer *AkonadiServer::fullTextIndexer()
+{
+    return mFullTextIndexer.get();
+}
+
+PartFileReclaimer *AkonadiServer::partFileReclaimer()
+{
+    return mPartFileReclaimer.get();
+}
+
+CommandScheduler *AkonadiServer::commandScheduler()
+{
+    return mCommandScheduler.get();
+}
+
 IntervalCheck &AkonadiServer::intervalChecker()
 {
     return *mIntervalCheck;
@@ -424,6 +543,11 @@ CollectionStatistics &AkonadiServer::collectionStatistics()
     return *mCollectionStats;
 }
 
+ItemMergeIndex &AkonadiServer::itemMergeIndex()
+{
+    return *mItemMergeIndex;
+}
+
 PreprocessorManager &AkonadiServer::preprocessorManager()
 {
     return *mPreprocessorManager;
@@ -449,6 +573,11 @@ Tracer &AkonadiServer::tracer()
     return *mTracer;
 }
 
+ProtocolCaptureWriter *AkonadiServer::protocolCapture()
+{
+    return mProtocolCapture.get();
+}
+
 QString AkonadiServer::serverPath() const
 {
     return StandardDirs::saveDir("config");
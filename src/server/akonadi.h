@@ -6,13 +6,16 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QList>
 #include <QObject>
+#include <QVariantMap>
 
 #include <memory>
 
 class QDBusServiceWatcher;
 class QSettings;
+class QThread;
 
 namespace Akonadi
 {
@@ -24,13 +27,19 @@ class SearchTaskManager;
 class SearchManager;
 class StorageJanitor;
 class CacheCleaner;
+class FullTextIndexer;
+class CommandScheduler;
+class DatabaseMaintenance;
+class PartFileReclaimer;
 class IntervalCheck;
 class AkLocalServer;
 class NotificationManager;
 class ResourceManager;
 class CollectionStatistics;
+class ItemMergeIndex;
 class PreprocessorManager;
 class Tracer;
+class ProtocolCaptureWriter;
 class DebugInterface;
 
 class AkonadiServer : public QObject
@@ -46,6 +55,21 @@ public:
      */
     CacheCleaner *cacheCleaner();
 
+    /**
+     * Can return a nullptr, the full-text index is disabled by default
+     */
+    FullTextIndexer *fullTextIndexer();
+
+    /**
+     * Can return a nullptr
+     */
+    PartFileReclaimer *partFileReclaimer();
+
+    /**
+     * Can return a nullptr
+     */
+    CommandScheduler *commandScheduler();
+
     /**
      * Returns the IntervalCheck instance. Never nullptr.
      */
@@ -55,6 +79,8 @@ public:
 
     CollectionStatistics &collectionStatistics();
 
+    ItemMergeIndex &itemMergeIndex();
+
     PreprocessorManager &preprocessorManager();
 
     SearchTaskManager &agentSearchManager();
@@ -65,6 +91,11 @@ public:
 
     Tracer &tracer();
 
+    /**
+     * Can return a nullptr
+     */
+    ProtocolCaptureWriter *protocolCapture();
+
     /**
      * Instance-aware server .config directory
      */
@@ -75,6 +106,12 @@ public:
      */
     NotificationManager *notificationManager();
 
+    /**
+     * Returns how long each phase of the server startup took in milliseconds.
+     * Phases which are run after the server is ready are prefixed with "deferred".
+     */
+    [[nodiscard]] QVariantMap startupTimes() const;
+
 public Q_SLOTS:
     /**
      * Triggers a clean server shutdown.
@@ -96,6 +133,10 @@ private:
     void stopDatabaseProcess();
     bool createServers(QSettings &settings, QSettings &connectionSettings);
     [[nodiscard]] bool setupDatabase();
+    void runDeferredStartupTasks();
+    /// Records the time since the previous phase has finished
+    void startupPhaseFinished(const QString &phase);
+    void addStartupPhase(const QString &phase, qint64 duration);
 
 protected:
     std::unique_ptr<QDBusServiceWatcher> mControlWatcher;
@@ -106,18 +147,29 @@ protected:
     std::unique_ptr<ResourceManager> mResourceManager;
     std::unique_ptr<DebugInterface> mDebugInterface;
     std::unique_ptr<CollectionStatistics> mCollectionStats;
+    std::unique_ptr<ItemMergeIndex> mItemMergeIndex;
+    std::unique_ptr<CommandScheduler> mCommandScheduler;
     std::unique_ptr<PreprocessorManager> mPreprocessorManager;
     std::unique_ptr<NotificationManager> mNotificationManager;
     std::unique_ptr<CacheCleaner> mCacheCleaner;
     std::unique_ptr<IntervalCheck> mIntervalCheck;
     std::unique_ptr<StorageJanitor> mStorageJanitor;
+    std::unique_ptr<PartFileReclaimer> mPartFileReclaimer;
+    std::unique_ptr<DatabaseMaintenance> mDatabaseMaintenance;
     std::unique_ptr<ItemRetrievalManager> mItemRetrieval;
     std::unique_ptr<SearchTaskManager> mAgentSearchManager;
+    std::unique_ptr<FullTextIndexer> mFullTextIndexer;
     std::unique_ptr<SearchManager> mSearchManager;
     std::unique_ptr<Tracer> mTracer;
+    std::unique_ptr<ProtocolCaptureWriter> mProtocolCapture;
 
     std::vector<std::unique_ptr<Connection>> mConnections;
     bool mAlreadyShutdown = false;
+
+    std::unique_ptr<QThread> mDeferredStartup;
+    QElapsedTimer mStartupTimer;
+    qint64 mLastStartupPhaseEnd = 0;
+    QList<std::pair<QString, qint64>> mStartupPhases;
 };
 
 } // namespace Server
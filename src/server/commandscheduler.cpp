@@ -0,0 +1,160 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "commandscheduler.h"
+
+#include "private/standarddirs_p.h"
+
+#include <QSettings>
+#include <QThread>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+namespace
+{
+// The scheduler whose execution slot is held by the current thread
+thread_local CommandScheduler *tActiveScheduler = nullptr;
+// Whether the slot was acquired by a session with an open transaction
+thread_local bool tActiveInTransaction = false;
+
+int readSetting(const QString &key, int defaultValue)
+{
+    const QSettings settings(StandardDirs::serverConfigFile(), QSettings::IniFormat);
+    return settings.value(key, defaultValue).toInt();
+}
+
+} // namespace
+
+CommandScheduler::Yield::Yield()
+    : mScheduler(tActiveScheduler)
+    , mInTransaction(tActiveInTransaction)
+{
+    if (mScheduler) {
+        mScheduler->endCommand();
+    }
+}
+
+CommandScheduler::Yield::~Yield()
+{
+    if (mScheduler) {
+        mScheduler->beginCommand(mInTransaction);
+    }
+}
+
+CommandScheduler::CommandScheduler(int maxRunningCommands, int maxIdleDbConnections)
+    : mMaxRunningCommands(maxRunningCommands)
+    , mMaxIdleDbConnections(maxIdleDbConnections)
+{
+    mIdleTimer.start();
+}
+
+int CommandScheduler::defaultMaxRunningCommands()
+{
+    return readSetting(QStringLiteral("General/MaxRunningCommands"), std::max(4, QThread::idealThreadCount()));
+}
+
+int CommandScheduler::defaultMaxIdleDbConnections()
+{
+    return readSetting(QStringLiteral("General/MaxIdleDbConnections"), 16);
+}
+
+int CommandScheduler::maxRunningCommands() const
+{
+    return mMaxRunningCommands;
+}
+
+int CommandScheduler::maxIdleDbConnections() const
+{
+    return mMaxIdleDbConnections;
+}
+
+int CommandScheduler::runningCommands() const
+{
+    QMutexLocker locker(&mLock);
+    return mRunningCommands;
+}
+
+int CommandScheduler::idleDbConnections() const
+{
+    QMutexLocker locker(&mLock);
+    return static_cast<int>(mIdleDbConnections.size());
+}
+
+std::chrono::milliseconds CommandScheduler::idleTime() const
+{
+    QMutexLocker locker(&mLock);
+    if (mRunningCommands > 0) {
+        return std::chrono::milliseconds::zero();
+    }
+    return std::chrono::milliseconds(mIdleTimer.elapsed());
+}
+
+void CommandScheduler::beginCommand(bool inTransaction)
+{
+    Q_ASSERT(tActiveScheduler == nullptr);
+
+    QMutexLocker locker(&mLock);
+    if (inTransaction) {
+        // May exceed the limit, see the class documentation
+        ++mRunningCommands;
+    } else {
+        const quint64 ticket = mNextTicket++;
+        while (ticket != mServedTicket || (mMaxRunningCommands > 0 && mRunningCommands >= mMaxRunningCommands)) {
+            mSlotReleased.wait(&mLock);
+        }
+        ++mServedTicket;
+        ++mRunningCommands;
+        // Let the next ticket check for a free slot
+        mSlotReleased.wakeAll();
+    }
+
+    tActiveScheduler = this;
+    tActiveInTransaction = inTransaction;
+}
+
+void CommandScheduler::endCommand()
+{
+    Q_ASSERT(tActiveScheduler == this);
+    tActiveScheduler = nullptr;
+    tActiveInTransaction = false;
+
+    QMutexLocker locker(&mLock);
+    Q_ASSERT(mRunningCommands > 0);
+    --mRunningCommands;
+    mIdleTimer.start();
+    mSlotReleased.wakeAll();
+}
+
+void CommandScheduler::keepIdleDbConnection(const void *owner, std::function<void()> evict)
+{
+    QMutexLocker locker(&mLock);
+    Q_ASSERT(std::ranges::find(mIdleDbConnections, owner, &decltype(mIdleDbConnections)::value_type::first) == mIdleDbConnections.end());
+    mIdleDbConnections.emplace_back(owner, std::move(evict));
+    while (mMaxIdleDbConnections > 0 && std::ssize(mIdleDbConnections) > mMaxIdleDbConnections) {
+        // Called with the lock held, so that the owner cannot go away in the meantime
+        mIdleDbConnections.front().second();
+        mIdleDbConnections.pop_front();
+    }
+}
+
+void CommandScheduler::releaseIdleDbConnection(const void *owner)
+{
+    QMutexLocker locker(&mLock);
+    // Evicted connections are not registered anymore
+    mIdleDbConnections.remove_if([owner](const auto &entry) {
+        return entry.first == owner;
+    });
+}
+
+bool CommandScheduler::isIdleDbConnectionKept(const void *owner) const
+{
+    QMutexLocker locker(&mLock);
+    return std::ranges::find(mIdleDbConnections, owner, &decltype(mIdleDbConnections)::value_type::first) != mIdleDbConnections.end();
+}
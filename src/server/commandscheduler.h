@@ -0,0 +1,134 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <chrono>
+#include <functional>
+#include <list>
+
+namespace Akonadi
+{
+namespace Server
+{
+/**
+ * Bounds the number of commands executed at the same time and the number of
+ * database connections kept open by idle connections.
+ *
+ * Every Connection handles the commands of its session in its own thread and
+ * with its own DataStore, which keeps the commands of a session ordered and
+ * binds transactions to their session. With many agents and clients however
+ * the server would execute as many commands concurrently as there are busy
+ * sessions, and keep a database connection open for each of them.
+ *
+ * Connections therefore acquire an execution slot before executing a command,
+ * in the order in which the commands were received, and release it afterwards.
+ * A command that waits for another session, for example for a resource to
+ * deliver an item, gives up its slot while waiting, see Yield, so that the other
+ * session can make progress.
+ *
+ * Commands of a session with an open transaction neither wait in the queue nor
+ * for a free slot. The session holds database locks which the commands occupying
+ * all slots may be waiting for, so queueing it could deadlock the server.
+ *
+ * Between commands connections keep their database connections open, as
+ * reopening them drops all prepared statements. When more than
+ * maxIdleDbConnections() connections are idle, the connection which has been
+ * idle the longest is asked to close its database connection, which is then
+ * reopened by its next command. Connections inside a transaction are not
+ * counted, as their database connections cannot be closed.
+ */
+class CommandScheduler
+{
+public:
+    /**
+     * Gives up the execution slot held by the current thread, if any, for the
+     * lifetime of the object and waits for a free slot again on destruction.
+     */
+    class Yield
+    {
+    public:
+        explicit Yield();
+        ~Yield();
+
+    private:
+        Q_DISABLE_COPY_MOVE(Yield)
+        CommandScheduler *mScheduler = nullptr;
+        bool mInTransaction = false;
+    };
+
+    /**
+     * Creates a scheduler which runs at most @p maxRunningCommands commands and
+     * keeps at most @p maxIdleDbConnections idle database connections.
+     * A value of 0 or less disables the respective limit.
+     */
+    explicit CommandScheduler(int maxRunningCommands = defaultMaxRunningCommands(), int maxIdleDbConnections = defaultMaxIdleDbConnections());
+
+    /** Reads General/MaxRunningCommands from the server configuration. */
+    static int defaultMaxRunningCommands();
+    /** Reads General/MaxIdleDbConnections from the server configuration. */
+    static int defaultMaxIdleDbConnections();
+
+    int maxRunningCommands() const;
+    int maxIdleDbConnections() const;
+
+    /** Returns the number of commands currently holding an execution slot. */
+    int runningCommands() const;
+    /** Returns the number of idle database connections currently kept open. */
+    int idleDbConnections() const;
+    /**
+     * Returns the time since the last command has finished, or zero while
+     * commands are being executed.
+     */
+    std::chrono::milliseconds idleTime() const;
+
+    /**
+     * Blocks until the current thread may execute a command. Returns right away
+     * if the session of the command is @p inTransaction.
+     */
+    void beginCommand(bool inTransaction = false);
+
+    /**
+     * Releases the execution slot acquired by beginCommand().
+     */
+    void endCommand();
+
+    /**
+     * Registers the idle database connection of @p owner, which has to call
+     * releaseIdleDbConnection() once it uses or closes the database connection
+     * again. If more than maxIdleDbConnections() connections are idle, the
+     * connection idle the longest is unregistered and its @p evict callback is
+     * called, which must make its owner close the database connection. The
+     * callback is called with an internal lock held, so it must not block.
+     */
+    void keepIdleDbConnection(const void *owner, std::function<void()> evict);
+    void releaseIdleDbConnection(const void *owner);
+    /** Returns true if the idle database connection of @p owner is registered. */
+    bool isIdleDbConnectionKept(const void *owner) const;
+
+private:
+    Q_DISABLE_COPY_MOVE(CommandScheduler)
+
+    const int mMaxRunningCommands;
+    const int mMaxIdleDbConnections;
+
+    mutable QMutex mLock;
+    QWaitCondition mSlotReleased;
+    // Slots are handed out in the order of the calls to beginCommand()
+    quint64 mNextTicket = 0;
+    quint64 mServedTicket = 0;
+    int mRunningCommands = 0;
+    // Least recently idle first
+    std::list<std::pair<const void *, std::function<void()>>> mIdleDbConnections;
+    QElapsedTimer mIdleTimer;
+};
+
+} // namespace Server
+} // namespace Akonadi
@@ -7,16 +7,20 @@
 #include "connection.h"
 #include "akonadiserver_debug.h"
 
-#include <QEventLoop>
+#include <QScopeGuard>
 #include <QSettings>
 #include <QThreadStorage>
 
+#include "commandscheduler.h"
 #include "handler.h"
 #include "notificationmanager.h"
+#include "protocolcapturewriter.h"
 #include "storage/datastore.h"
 #include "storage/dbdeadlockcatcher.h"
+#include "storage/sqltracebuffer.h"
 
 #include <cassert>
+#include <utility>
 
 #ifndef Q_OS_WIN
 #include <cxxabi.h>
@@ -65,6 +69,7 @@ void Connection::init()
 
     m_socket = std::move(socket);
     connect(m_socket.get(), &QLocalSocket::disconnected, this, &Connection::slotSocketDisconnected);
+    connect(m_socket.get(), &QLocalSocket::readyRead, this, &Connection::handleIncomingData);
 
     m_idleTimer = std::make_unique<QTimer>();
     connect(m_idleTimer.get(), &QTimer::timeout, this, &Connection::slotConnectionIdle);
@@ -94,7 +99,11 @@ void Connection::quit()
     }
 
     m_akonadi.tracer().endConnection(m_identifier, QString());
+    if (m_captureSession > 0 && m_akonadi.protocolCapture()) {
+        m_akonadi.protocolCapture()->endSession(std::exchange(m_captureSession, 0));
+    }
 
+    releaseIdleDbConnection();
     m_socket.reset();
     m_idleTimer.reset();
 
@@ -144,6 +153,7 @@ void Connection::slotConnectionIdle()
         }
         m_backend->close();
     }
+    releaseIdleDbConnection();
 }
 
 void Connection::slotSocketDisconnected()
@@ -171,31 +181,15 @@ void Connection::parseStream(const Protocol::CommandPtr &cmd)
 
 void Connection::handleIncomingData()
 {
-    for (;;) {
-        if (m_connectionClosing || !m_socket || m_socket->state() != QLocalSocket::ConnectedState) {
-            break;
-        }
-
-        // Blocks with event loop until some data arrive, allows us to still use QTimers
-        // and similar while waiting for some data to arrive
-        if (m_socket->bytesAvailable() < int(sizeof(qint64))) {
-            QEventLoop loop;
-            connect(m_socket.get(), &QLocalSocket::readyRead, &loop, &QEventLoop::quit);
-            connect(m_socket.get(), &QLocalSocket::stateChanged, &loop, &QEventLoop::quit);
-            connect(this, &Connection::connectionClosing, &loop, &QEventLoop::quit);
-            loop.exec();
-
-            // RAII fails to clean QT's slot/signal connections above, leaking memory. Manually disconnect.
-            disconnect(m_socket.get(), &QLocalSocket::readyRead, &loop, &QEventLoop::quit);
-            disconnect(m_socket.get(), &QLocalSocket::stateChanged, &loop, &QEventLoop::quit);
-            disconnect(this, &Connection::connectionClosing, &loop, &QEventLoop::quit);
-        }
-
-        if (m_connectionClosing || !m_socket || m_socket->state() != QLocalSocket::ConnectedState) {
-            break;
-        }
+    // Data received while a command is being handled, e.g. from a nested event
+    // loop, is handled once the current command has finished
+    if (m_currentHandler) {
+        return;
+    }
 
+    if (!m_connectionClosing && m_socket && m_socket->state() == QLocalSocket::ConnectedState && m_socket->bytesAvailable() >= int(sizeof(qint64))) {
         m_idleTimer->stop();
+        releaseIdleDbConnection();
 
         // will only open() a previously idle backend.
         // Otherwise, a new backend could lazily be constructed by later calls.
@@ -231,6 +225,7 @@ void Connection::handleIncomingData()
             // Tag context and collection context is not persistent.
             m_context.setTag(std::nullopt);
             m_context.setCollection({});
+            captureCommand(tag, cmd);
             if (m_akonadi.tracer().currentTracer() != QLatin1StringView("null")) {
                 m_akonadi.tracer().connectionInput(m_identifier, tag, cmd);
             }
@@ -245,6 +240,19 @@ void Connection::handleIncomingData()
                 startTime();
             }
 
+            auto *scheduler = m_akonadi.commandScheduler();
+            if (scheduler) {
+                scheduler->beginCommand(m_backend && m_backend->inTransaction());
+            }
+            auto *sqlTrace = SqlTraceBuffer::self();
+            sqlTrace->beginCommand(static_cast<quint16>(cmd->type()));
+            const auto endCommand = qScopeGuard([scheduler, sqlTrace]() {
+                sqlTrace->endCommand();
+                if (scheduler) {
+                    scheduler->endCommand();
+                }
+            });
+
             m_currentHandler->setConnection(this);
             m_currentHandler->setTag(tag);
             m_currentHandler->setCommand(cmd);
@@ -313,21 +321,71 @@ void Connection::handleIncomingData()
             }
         }
 
+        keepIdleDbConnection();
         // reset, arm the timer
         m_idleTimer->start(IDLE_TIMER_TIMEOUT);
-
-        if (m_connectionClosing) {
-            break;
-        }
     }
 
-    if (m_connectionClosing) {
+    if (m_connectionClosing && m_socket) {
         m_socket->disconnect(this);
         m_socket->close();
         QTimer::singleShot(0, this, &Connection::quit);
     }
 }
 
+void Connection::keepIdleDbConnection()
+{
+    auto *scheduler = m_akonadi.commandScheduler();
+    if (!scheduler || !m_backend || !m_backend->isOpened() || m_idleDbConnection) {
+        return;
+    }
+    // An open transaction is bound to the database connection of this session
+    if (m_backend->inTransaction()) {
+        return;
+    }
+    m_idleDbConnection = true;
+    scheduler->keepIdleDbConnection(this, [this]() {
+        QMetaObject::invokeMethod(this, &Connection::closeEvictedDbConnection, Qt::QueuedConnection);
+    });
+}
+
+void Connection::releaseIdleDbConnection()
+{
+    if (std::exchange(m_idleDbConnection, false)) {
+        m_akonadi.commandScheduler()->releaseIdleDbConnection(this);
+    }
+}
+
+void Connection::closeEvictedDbConnection()
+{
+    // The connection may have been used and become idle again since it was evicted
+    if (!m_idleDbConnection || m_currentHandler || m_akonadi.commandScheduler()->isIdleDbConnectionKept(this)) {
+        return;
+    }
+    m_idleDbConnection = false;
+    if (m_backend && m_backend->isOpened() && !m_backend->inTransaction()) {
+        m_backend->close();
+    }
+}
+
+void Connection::captureCommand(qint64 tag, const Protocol::CommandPtr &cmd)
+{
+    auto *capture = m_akonadi.protocolCapture();
+    if (!capture || !capture->isActive()) {
+        return;
+    }
+    // The session id is only known once the client logs in, so that is where capturing a session starts
+    if (cmd->type() == Protocol::Command::Login) {
+        if (m_captureSession > 0) {
+            capture->endSession(m_captureSession);
+        }
+        m_captureSession = capture->beginSession(Protocol::cmdCast<Protocol::LoginCommand>(cmd).sessionId());
+    }
+    if (m_captureSession > 0) {
+        capture->captureCommand(m_captureSession, tag, cmd);
+    }
+}
+
 const CommandContext &Connection::context() const
 {
     return m_context;
@@ -454,6 +512,12 @@ void Connection::reportTime() const
     }
 }
 
+bool Connection::isClientConnected() const
+{
+    // The state is updated when writing the responses fails
+    return !m_connectionClosing && m_socket && m_socket->state() == QLocalSocket::ConnectedState;
+}
+
 void Connection::sendResponse(qint64 tag, const Protocol::CommandPtr &response)
 {
     if (m_akonadi.tracer().currentTracer() != QLatin1StringView("null")) {
@@ -484,7 +548,9 @@ Protocol::CommandPtr Connection::readCommand()
     stream >> tag;
 
     // TODO: compare tag with m_currentHandler->tag() ?
-    return Protocol::deserialize(m_socket.get());
+    auto cmd = Protocol::deserialize(m_socket.get());
+    captureCommand(tag, cmd);
+    return cmd;
 }
 
 #include "moc_connection.cpp"
@@ -73,6 +73,12 @@ public:
 
     void setState(ConnectionState state);
 
+    /**
+     * Returns @c false once the client has disconnected or the connection is
+     * being closed. Long-running handlers can use it to stop early.
+     */
+    bool isClientConnected() const;
+
     template<typename T>
     inline typename std::enable_if<std::is_base_of<Protocol::Command, T>::value>::type sendResponse(T &&response);
 
@@ -121,9 +127,18 @@ protected:
     QHash<QString, qint64> m_executionsByHandler;
 
     bool m_connectionClosing = false;
+    /// The open database connection has been registered as idle with the CommandScheduler
+    bool m_idleDbConnection = false;
+    /// Id of the session in the ProtocolCaptureWriter, 0 if the session is not captured
+    quint32 m_captureSession = 0;
 
 private:
     void parseStream(const Protocol::CommandPtr &cmd);
+    /// Keeps the database connection open while idle, until the idle timeout or until the CommandScheduler evicts it
+    void keepIdleDbConnection();
+    void releaseIdleDbConnection();
+    void closeEvictedDbConnection();
+    void captureCommand(qint64 tag, const Protocol::CommandPtr &cmd);
     template<typename T>
     inline typename std::enable_if<std::is_base_of<Protocol::Command, T>::value>::type sendResponse(qint64 tag, T &&response);
 
@@ -0,0 +1,343 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "databasemaintenance.h"
+#include "akonadiserver_debug.h"
+#include "commandscheduler.h"
+#include "entities.h"
+#include "storage/datastore.h"
+#include "storage/dbtype.h"
+
+#include "private/standarddirs_p.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QSettings>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTimer>
+
+#include <algorithm>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr auto IdleCheckInterval = 30s;
+// Pages freed by a single incremental_vacuum, so that the time limit is checked in between
+constexpr qint64 VacuumBatchPages = 256;
+// Rows sampled per index by PRAGMA optimize, as recommended for long-running connections
+constexpr int SqliteAnalysisLimit = 400;
+
+/// The tables which are modified the most and of which the statistics drift
+QStringList hotTables()
+{
+    return {PimItem::tableName(),
+            Part::tableName(),
+            PimItemFlagRelation::tableName(),
+            PimItemTagRelation::tableName(),
+            CollectionPimItemRelation::tableName(),
+            Collection::tableName()};
+}
+
+// Row counts of the tables at the last ANALYZE TABLE, see mysqlAnalyze()
+QMutex sAnalyzedRowCountsLock;
+QHash<QString, qint64> sAnalyzedRowCounts;
+
+bool execQuery(QSqlQuery &query, const QString &statement)
+{
+    if (!query.exec(statement)) {
+        qCWarning(AKONADISERVER_LOG) << "Database maintenance query" << statement << "failed:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool sqliteIncrementalVacuum(const QSqlDatabase &db, const QDeadlineTimer &deadline, QString &details)
+{
+    QSqlQuery query(db);
+    if (!execQuery(query, QStringLiteral("PRAGMA auto_vacuum")) || !query.next()) {
+        return false;
+    }
+    // Databases created before incremental vacuum was enabled are converted by `akonadictl vacuum`
+    if (query.value(0).toInt() != 2) {
+        details = QStringLiteral("incremental vacuum not enabled");
+        return true;
+    }
+
+    qint64 freedPages = 0;
+    while (!deadline.hasExpired()) {
+        if (!execQuery(query, QStringLiteral("PRAGMA freelist_count")) || !query.next()) {
+            return false;
+        }
+        const qint64 pages = std::min(query.value(0).toLongLong(), VacuumBatchPages);
+        if (pages == 0) {
+            break;
+        }
+        if (!execQuery(query, QStringLiteral("PRAGMA incremental_vacuum(%1)").arg(pages))) {
+            return false;
+        }
+        // The pragma frees one page per step of the statement
+        while (query.next()) { }
+        freedPages += pages;
+    }
+    details = QStringLiteral("freed %1 pages").arg(freedPages);
+    return true;
+}
+
+bool sqliteOptimize(const QSqlDatabase &db, const QDeadlineTimer &deadline, QString &details)
+{
+    // analysis_limit bounds the time spent by the ANALYZE run by optimize
+    const QStringList statements = {QStringLiteral("PRAGMA analysis_limit=%1").arg(SqliteAnalysisLimit), QStringLiteral("PRAGMA optimize")};
+    QSqlQuery query(db);
+    qsizetype executed = 0;
+    for (const QString &statement : statements) {
+        if (deadline.hasExpired()) {
+            break;
+        }
+        if (!execQuery(query, statement)) {
+            return false;
+        }
+        ++executed;
+    }
+    details = QStringLiteral("executed %1 of %2 statements").arg(executed).arg(statements.size());
+    return true;
+}
+
+bool sqliteWalCheckpoint(const QSqlDatabase &db, const QDeadlineTimer &deadline, QString &details)
+{
+    // A passive checkpoint does not wait for readers or writers
+    QSqlQuery query(db);
+    if (!execQuery(query, QStringLiteral("PRAGMA wal_checkpoint(PASSIVE)")) || !query.next()) {
+        return false;
+    }
+    const bool busy = query.value(0).toInt() != 0;
+    const qint64 logFrames = query.value(1).toLongLong();
+    const qint64 checkpointedFrames = query.value(2).toLongLong();
+    details = QStringLiteral("checkpointed %1 of %2 frames").arg(checkpointedFrames).arg(logFrames);
+    query.finish();
+
+    // Once all frames are in the database, the log can be truncated without waiting
+    if (!busy && logFrames > 0 && checkpointedFrames == logFrames && !deadline.hasExpired()) {
+        if (!execQuery(query, QStringLiteral("PRAGMA wal_checkpoint(TRUNCATE)"))) {
+            return false;
+        }
+        details += QStringLiteral(", truncated the log");
+    }
+    return true;
+}
+
+bool postgresAnalyze(const QSqlDatabase &db, const QDeadlineTimer &deadline, QString &details)
+{
+    QSqlQuery query(db);
+    if (!execQuery(query,
+                   QStringLiteral("SELECT relname FROM pg_stat_user_tables WHERE n_mod_since_analyze > 0 ORDER BY n_mod_since_analyze DESC"))) {
+        return false;
+    }
+    const QStringList tables = hotTables();
+    QStringList modifiedTables;
+    while (query.next()) {
+        // Unquoted table names are folded to lower case
+        const QString relation = query.value(0).toString();
+        const auto it = std::find_if(tables.cbegin(), tables.cend(), [&relation](const QString &table) {
+            return table.compare(relation, Qt::CaseInsensitive) == 0;
+        });
+        if (it != tables.cend()) {
+            modifiedTables.push_back(*it);
+        }
+    }
+    query.finish();
+
+    qsizetype analyzed = 0;
+    for (const QString &table : std::as_const(modifiedTables)) {
+        if (deadline.hasExpired()) {
+            break;
+        }
+        if (!execQuery(query, QStringLiteral("ANALYZE ") + table)) {
+            return false;
+        }
+        ++analyzed;
+    }
+    details = QStringLiteral("analyzed %1 of %2 modified tables").arg(analyzed).arg(modifiedTables.size());
+    return true;
+}
+
+bool mysqlAnalyze(const QSqlDatabase &db, const QDeadlineTimer &deadline, QString &details)
+{
+    QSqlQuery query(db);
+    // MySQL caches the row counts in the information schema for a day by default. MariaDB has no such
+    // cache and no such variable, so a failure is expected there.
+    query.exec(QStringLiteral("SET SESSION information_schema_stats_expiry = 0"));
+
+    if (!execQuery(query, QStringLiteral("SELECT TABLE_NAME, TABLE_ROWS FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE()"))) {
+        return false;
+    }
+    const QStringList tables = hotTables();
+    QHash<QString, qint64> rowCounts;
+    while (query.next()) {
+        const QString relation = query.value(0).toString();
+        const auto it = std::find_if(tables.cbegin(), tables.cend(), [&relation](const QString &table) {
+            return table.compare(relation, Qt::CaseInsensitive) == 0;
+        });
+        if (it != tables.cend()) {
+            rowCounts.insert(*it, query.value(1).toLongLong());
+        }
+    }
+    query.finish();
+
+    // The statistics of tables which have not grown or shrunk since they were analyzed are still accurate
+    QStringList changedTables;
+    {
+        QMutexLocker locker(&sAnalyzedRowCountsLock);
+        for (const QString &table : tables) {
+            const auto analyzedRows = sAnalyzedRowCounts.constFind(table);
+            if (analyzedRows == sAnalyzedRowCounts.cend() || *analyzedRows != rowCounts.value(table, -1)) {
+                changedTables.push_back(table);
+            }
+        }
+    }
+
+    qsizetype analyzed = 0;
+    for (const QString &table : std::as_const(changedTables)) {
+        if (deadline.hasExpired()) {
+            break;
+        }
+        if (!execQuery(query, QStringLiteral("ANALYZE TABLE ") + table)) {
+            return false;
+        }
+        // ANALYZE TABLE returns a result set, which has to be consumed
+        while (query.next()) { }
+        query.finish();
+        ++analyzed;
+
+        // The row count is an estimate, which is updated by the analysis
+        if (!execQuery(query,
+                       QStringLiteral("SELECT TABLE_ROWS FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = '%1'").arg(table))
+            || !query.next()) {
+            return false;
+        }
+        const qint64 rows = query.value(0).toLongLong();
+        query.finish();
+        QMutexLocker locker(&sAnalyzedRowCountsLock);
+        sAnalyzedRowCounts.insert(table, rows);
+    }
+    details = QStringLiteral("analyzed %1 of %2 changed tables").arg(analyzed).arg(changedTables.size());
+    return true;
+}
+
+} // namespace
+
+DatabaseMaintenance::DatabaseMaintenance(CommandScheduler &commandScheduler, StartMode startMode)
+    : AkThread(QStringLiteral("DatabaseMaintenance"), startMode, QThread::IdlePriority)
+    , mCommandScheduler(commandScheduler)
+{
+    const QSettings settings(StandardDirs::serverConfigFile(), QSettings::IniFormat);
+    mEnabled = settings.value(QStringLiteral("Maintenance/Enabled"), true).toBool();
+    mIdleTime = std::chrono::seconds(settings.value(QStringLiteral("Maintenance/IdleTime"), 120).toInt());
+    mInterval = std::chrono::minutes(settings.value(QStringLiteral("Maintenance/Interval"), 60).toInt());
+    mStepTimeLimit = std::chrono::milliseconds(settings.value(QStringLiteral("Maintenance/StepTimeLimit"), 500).toInt());
+}
+
+DatabaseMaintenance::~DatabaseMaintenance()
+{
+    quitThread();
+}
+
+void DatabaseMaintenance::init()
+{
+    AkThread::init();
+
+    if (!mEnabled) {
+        qCInfo(AKONADISERVER_LOG) << "Idle-time database maintenance is disabled";
+        return;
+    }
+
+    mIdleCheckTimer = new QTimer(this);
+    mIdleCheckTimer->setInterval(IdleCheckInterval);
+    connect(mIdleCheckTimer, &QTimer::timeout, this, &DatabaseMaintenance::maybeRunMaintenance);
+    mIdleCheckTimer->start();
+}
+
+void DatabaseMaintenance::quit()
+{
+    delete mIdleCheckTimer;
+    mIdleCheckTimer = nullptr;
+
+    AkThread::quit();
+}
+
+QList<DatabaseMaintenance::Step> DatabaseMaintenance::steps(const QSqlDatabase &db)
+{
+    switch (DbType::type(db)) {
+    case DbType::Sqlite:
+        return {{QStringLiteral("incremental vacuum"), &sqliteIncrementalVacuum},
+                {QStringLiteral("optimize"), &sqliteOptimize},
+                {QStringLiteral("WAL checkpoint"), &sqliteWalCheckpoint}};
+    case DbType::PostgreSQL:
+        return {{QStringLiteral("analyze"), &postgresAnalyze}};
+    case DbType::MySQL:
+        return {{QStringLiteral("analyze"), &mysqlAnalyze}};
+    case DbType::Unknown:
+        break;
+    }
+    return {};
+}
+
+DatabaseMaintenance::StepResult DatabaseMaintenance::runStep(const Step &step, const QSqlDatabase &db, std::chrono::milliseconds stepTimeLimit)
+{
+    StepResult result{.name = step.name};
+    QElapsedTimer timer;
+    timer.start();
+    result.success = step.func(db, QDeadlineTimer(stepTimeLimit), result.details);
+    result.duration = std::chrono::milliseconds(timer.elapsed());
+
+    if (result.success) {
+        qCInfo(AKONADISERVER_LOG) << "Database maintenance:" << result.name << "took" << result.duration.count() << "ms," << result.details;
+    } else {
+        qCWarning(AKONADISERVER_LOG) << "Database maintenance:" << result.name << "failed after" << result.duration.count() << "ms";
+    }
+    return result;
+}
+
+QList<DatabaseMaintenance::StepResult> DatabaseMaintenance::runAllSteps(std::chrono::milliseconds stepTimeLimit)
+{
+    const QSqlDatabase db = DataStore::self()->database();
+    QList<StepResult> results;
+    const auto allSteps = steps(db);
+    for (const auto &step : allSteps) {
+        results.push_back(runStep(step, db, stepTimeLimit));
+    }
+    return results;
+}
+
+void DatabaseMaintenance::maybeRunMaintenance()
+{
+    if (mCommandScheduler.idleTime() < mIdleTime) {
+        return;
+    }
+    // A run which was interrupted by clients is continued in the next idle period
+    if (mNextStep == 0 && mLastRun.isValid() && mLastRun.durationElapsed() < mInterval) {
+        return;
+    }
+
+    const QSqlDatabase db = DataStore::self()->database();
+    const auto allSteps = steps(db);
+    while (mNextStep < allSteps.size()) {
+        if (mCommandScheduler.idleTime() < mIdleTime) {
+            qCDebug(AKONADISERVER_LOG) << "Database maintenance postponed, the server is no longer idle";
+            return;
+        }
+        runStep(allSteps[mNextStep], db, mStepTimeLimit);
+        ++mNextStep;
+    }
+
+    mNextStep = 0;
+    mLastRun.start();
+}
+
+#include "moc_databasemaintenance.cpp"
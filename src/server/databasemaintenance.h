@@ -0,0 +1,99 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akthread.h"
+
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include <QSqlDatabase>
+
+#include <chrono>
+
+class QTimer;
+
+namespace Akonadi
+{
+namespace Server
+{
+class CommandScheduler;
+
+/**
+ * Performs incremental database maintenance while the server is idle.
+ *
+ * Unlike StorageJanitor::vacuum(), which rebuilds the whole database and
+ * blocks for a long time, the maintenance consists of small steps, each of
+ * which is limited in time:
+ * - SQLite: incremental_vacuum, PRAGMA optimize and a WAL checkpoint
+ * - PostgreSQL: ANALYZE of the frequently modified tables
+ * - MySQL: ANALYZE TABLE of the frequently modified tables whose row count
+ *   has changed since they were last analyzed
+ *
+ * The server is considered idle once no command has been executed for
+ * Maintenance/IdleTime seconds (default 120). Maintenance runs at most every
+ * Maintenance/Interval minutes (default 60), each step takes at most
+ * Maintenance/StepTimeLimit milliseconds (default 500). When clients become
+ * active again, the remaining steps are postponed to the next idle period.
+ * Setting Maintenance/Enabled to false disables the maintenance.
+ */
+class DatabaseMaintenance : public AkThread
+{
+    Q_OBJECT
+
+protected:
+    /**
+     * Use AkThread::create() to create and start a new DatabaseMaintenance thread.
+     */
+    explicit DatabaseMaintenance(CommandScheduler &commandScheduler, StartMode startMode = AutoStart);
+
+public:
+    struct StepResult {
+        QString name;
+        bool success = false;
+        std::chrono::milliseconds duration{};
+        QString details;
+    };
+
+    ~DatabaseMaintenance() override;
+
+    /**
+     * Runs all maintenance steps for the database of the current thread,
+     * regardless of whether the server is idle.
+     */
+    static QList<StepResult> runAllSteps(std::chrono::milliseconds stepTimeLimit);
+
+protected:
+    void init() override;
+    void quit() override;
+
+private:
+    struct Step {
+        QString name;
+        bool (*func)(const QSqlDatabase &db, const QDeadlineTimer &deadline, QString &details);
+    };
+
+    static QList<Step> steps(const QSqlDatabase &db);
+    static StepResult runStep(const Step &step, const QSqlDatabase &db, std::chrono::milliseconds stepTimeLimit);
+
+    void maybeRunMaintenance();
+
+    CommandScheduler &mCommandScheduler;
+    QTimer *mIdleCheckTimer = nullptr;
+
+    bool mEnabled = true;
+    std::chrono::milliseconds mIdleTime;
+    std::chrono::milliseconds mInterval;
+    std::chrono::milliseconds mStepTimeLimit;
+
+    QElapsedTimer mLastRun;
+    // The step to continue with in the next idle period
+    qsizetype mNextStep = 0;
+};
+
+} // namespace Server
+} // namespace Akonadi
@@ -47,7 +47,10 @@
 
 #include <KLocalizedString>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <utility>
 
 using namespace Akonadi;
 using namespace Akonadi::Server;
@@ -59,7 +62,12 @@ Q_DECLARE_METATYPE(UIDelegate::Result);
 namespace
 {
 
-constexpr size_t maxTransactionSize = 1000; // Arbitrary guess
+// Rows copied per transaction. With multi-row INSERTs of up to maxRowsPerInsert rows this is 20 statements,
+// which keeps the commit overhead low without letting the rollback journal and lock set of a single transaction grow
+// with the size of the table.
+constexpr size_t maxTransactionSize = 10000;
+constexpr int maxRowsPerInsert = 500;
+constexpr int maxParallelTables = 4;
 
 class MigratorDataStoreFactory : public DataStoreFactory
 {
@@ -278,6 +286,50 @@ bool analyzeTable(const QString &table, DataStore *store)
     return true;
 }
 
+int maxBindValuesPerStatement(DataStore *store)
+{
+    switch (DbType::type(store->database())) {
+    case DbType::MySQL:
+    case DbType::PostgreSQL:
+        // Both protocols use a 16-bit counter for statement parameters
+        return 65535;
+    case DbType::Sqlite:
+    case DbType::Unknown:
+        // SQLITE_MAX_VARIABLE_NUMBER defaults to 999 in SQLite < 3.32
+        return 999;
+    }
+    return 999;
+}
+
+int parallelTableCount(DataStore *destStore)
+{
+    // SQLite serializes all writers on a database-wide lock, additional
+    // connections would only contend for it.
+    if (DbType::type(destStore->database()) == DbType::Sqlite) {
+        return 1;
+    }
+    return std::clamp(QThread::idealThreadCount(), 1, maxParallelTables);
+}
+
+QVariant convertColumnValue(const ColumnDescription &column, const QVariant &value)
+{
+    if (column.type == QLatin1StringView("QDateTime")) {
+        return value.toDateTime();
+    } else if (column.type == QLatin1StringView("bool")) {
+        return value.toBool();
+    } else if (column.type == QLatin1StringView("QByteArray")) {
+        return Utils::variantToByteArray(value);
+    } else if (column.type == QLatin1StringView("QString")) {
+        return Utils::variantToString(value);
+    }
+    return value;
+}
+
+double rowsPerSecond(qint64 rows, const QElapsedTimer &timer)
+{
+    return rows * 1000.0 / std::max<qint64>(timer.elapsed(), 1);
+}
+
 QString createTmpAkonadiServerRc(const QString &targetEngine)
 {
     const auto origFileName = StandardDirs::serverConfigFile(StandardDirs::ReadWrite);
@@ -552,7 +604,7 @@ bool DbMigrator::runMigrationThread()
     emitInfo(i18nc("@info:status", "Running fsck on the source database"));
     runStorageJanitor(sourceConfig.get());
 
-    const bool migrationSuccess = migrateTables(sourceStore.get(), destStore.get(), destConfig.get());
+    const bool migrationSuccess = migrateTables(sourceStore.get(), destStore.get(), sourceConfig.get(), destConfig.get());
 
     // Stop database servers and close connections. Make sure we always reach here, even if the migration failed
     cleanupDatabase(sourceStore.get(), sourceConfig.get());
@@ -601,7 +653,7 @@ bool DbMigrator::runMigrationThread()
     return true;
 }
 
-bool DbMigrator::migrateTables(DataStore *sourceStore, DataStore *destStore, DbConfig *destConfig)
+bool DbMigrator::migrateTables(DataStore *sourceStore, DataStore *destStore, DbConfig *sourceConfig, DbConfig *destConfig)
 {
     // Disable foreign key constraint checks
     if (!destConfig->disableConstraintChecks(destStore->database())) {
@@ -609,28 +661,80 @@ bool DbMigrator::migrateTables(DataStore *sourceStore, DataStore *destStore, DbC
     }
 
     AkonadiSchema schema;
-    const int totalTables = schema.tables().size() + schema.relations().size();
-    int doneTables = 0;
-
-    // Copy regular tables
+    std::vector<std::pair<TableDescription, int>> tables;
+    tables.reserve(schema.tables().size() + schema.relations().size());
+    const auto countRows = [sourceStore](const QString &table) {
+        CountQueryBuilder countQb(sourceStore, table);
+        countQb.exec();
+        return countQb.result();
+    };
     for (const auto &table : schema.tables()) {
-        ++doneTables;
-        emitProgress(table.name, doneTables, totalTables);
-        if (!copyTable(sourceStore, destStore, table)) {
-            emitError(i18nc("@info:shell", "Error has occurred while migrating table %1", table.name));
-            return false;
-        }
+        tables.emplace_back(table, countRows(table.name));
     }
-
-    // Copy relational tables
     for (const auto &relation : schema.relations()) {
         const RelationTableDescription table{relation};
-        ++doneTables;
-        emitProgress(table.name, doneTables, totalTables);
-        if (!copyTable(sourceStore, destStore, table)) {
-            emitError(i18nc("@info:shell", "Error has occurred while migrating table %1", table.name));
-            return false;
+        tables.emplace_back(table, countRows(table.name));
+    }
+    // Constraint checks are disabled, so the tables can be copied in any order. Start with
+    // the largest ones so that the parallel workers finish at roughly the same time.
+    std::stable_sort(tables.begin(), tables.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.second > rhs.second;
+    });
+
+    const int totalTables = tables.size();
+    std::atomic<int> nextTable = 0;
+    std::atomic<int> doneTables = 0;
+    std::atomic<bool> failed = false;
+
+    const auto copyTables = [&](DataStore *source, DataStore *dest) {
+        while (!failed) {
+            const int idx = nextTable++;
+            if (idx >= totalTables) {
+                return;
+            }
+            const auto &[table, totalRows] = tables[idx];
+            emitProgress(table.name, ++doneTables, totalTables);
+            if (!copyTable(source, dest, table, totalRows)) {
+                emitError(i18nc("@info:shell", "Error has occurred while migrating table %1", table.name));
+                failed = true;
+            }
         }
+    };
+
+    // Each worker needs its own connections: QSqlDatabase cannot be shared between threads.
+    std::vector<std::unique_ptr<QThread>> workers;
+    for (int i = 1; i < parallelTableCount(destStore); ++i) {
+        workers.emplace_back(QThread::create([&]() {
+            std::unique_ptr<DataStore> source{MigratorDataStoreFactory(sourceConfig).createStore()};
+            std::unique_ptr<DataStore> dest{MigratorDataStoreFactory(destConfig).createStore()};
+            const auto closeStores = qScopeGuard([&source, &dest]() {
+                source->close();
+                dest->close();
+            });
+            if (!source->database().isOpen() || !dest->database().isOpen()) {
+                qCWarning(AKONADIDBMIGRATOR_LOG) << "Failed to open database connection for a migration worker";
+                failed = true;
+                return;
+            }
+            // FOREIGN_KEY_CHECKS is a per-session setting in MySQL, PostgreSQL has the triggers
+            // disabled on the tables themselves already.
+            if (DbType::type(dest->database()) == DbType::MySQL && !destConfig->disableConstraintChecks(dest->database())) {
+                failed = true;
+                return;
+            }
+            copyTables(source.get(), dest.get());
+        }));
+        workers.back()->start();
+    }
+
+    copyTables(sourceStore, destStore);
+
+    for (const auto &worker : workers) {
+        worker->wait();
+    }
+
+    if (failed) {
+        return false;
     }
 
     // Re-enable foreign key constraint checks
@@ -749,20 +853,13 @@ bool DbMigrator::moveDatabaseToMainLocation(DbConfig *destConfig, const QString
     return true;
 }
 
-bool DbMigrator::copyTable(DataStore *sourceStore, DataStore *destStore, const TableDescription &table)
+bool DbMigrator::copyTable(DataStore *sourceStore, DataStore *destStore, const TableDescription &table, int totalRows)
 {
     const auto columns = table.columns | Views::transform([](const auto &tbl) {
                              return tbl.name;
                          })
         | Actions::toQList;
 
-    // Count number of items in the current table
-    const auto totalRows = [](DataStore *store, const QString &table) {
-        CountQueryBuilder countQb(store, table);
-        countQb.exec();
-        return countQb.result();
-    }(sourceStore, table.name);
-
     // Fetch *everything* from the current able
     QueryBuilder sourceQb(sourceStore, table.name);
     sourceQb.addColumns(columns);
@@ -775,38 +872,43 @@ bool DbMigrator::copyTable(DataStore *sourceStore, DataStore *destStore, const T
         clearQb.exec();
     }
 
+    // Rows are inserted using multi-row INSERTs. All full batches produce the same
+    // statement, so the prepared query is re-used from the QueryCache.
+    const int columnCount = table.columns.size();
+    const int batchSize = std::clamp(maxBindValuesPerStatement(destStore) / std::max(columnCount, 1), 1, maxRowsPerInsert);
+    std::vector<QVariantList> batch(columnCount);
+    for (auto &values : batch) {
+        values.reserve(batchSize);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
     // Begin insertion transaction
     Transaction transaction(destStore, QStringLiteral("Migrator"));
     size_t trxSize = 0;
-    size_t processed = 0;
+    int processed = 0;
 
-    // Loop over source results
-    while (sourceQuery.next()) {
-        // Insert the current row into the new database
+    const auto flushBatch = [&]() {
+        if (batch.empty() || batch.front().isEmpty()) {
+            return true;
+        }
+
+        const auto rows = batch.front().size();
         QueryBuilder destQb(destStore, table.name, QueryBuilder::Insert);
         destQb.setIdentificationColumn({});
-        for (int col = 0; col < table.columns.size(); ++col) {
-            QVariant value;
-            if (table.columns[col].type == QLatin1StringView("QDateTime")) {
-                value = sourceQuery.value(col).toDateTime();
-            } else if (table.columns[col].type == QLatin1StringView("bool")) {
-                value = sourceQuery.value(col).toBool();
-            } else if (table.columns[col].type == QLatin1StringView("QByteArray")) {
-                value = Utils::variantToByteArray(sourceQuery.value(col));
-            } else if (table.columns[col].type == QLatin1StringView("QString")) {
-                value = Utils::variantToString(sourceQuery.value(col));
-            } else {
-                value = sourceQuery.value(col);
-            }
-            destQb.setColumnValue(table.columns[col].name, value);
+        for (int col = 0; col < columnCount; ++col) {
+            destQb.setColumnValues(table.columns[col].name, std::exchange(batch[col], {}));
+            batch[col].reserve(batchSize);
         }
         if (!destQb.exec()) {
-            qCWarning(AKONADIDBMIGRATOR_LOG) << "Failed to insert row into table" << table.name << ":" << destQb.query().lastError().text();
+            qCWarning(AKONADIDBMIGRATOR_LOG) << "Failed to insert rows into table" << table.name << ":" << destQb.query().lastError().text();
             return false;
         }
 
-        // Commit the transaction after every "maxTransactionSize" inserts to make it reasonably fast
-        if (++trxSize > maxTransactionSize) {
+        // Commit the transaction after every "maxTransactionSize" rows to make it reasonably fast
+        trxSize += rows;
+        if (trxSize >= maxTransactionSize) {
             if (!transaction.commit()) {
                 qCWarning(AKONADIDBMIGRATOR_LOG) << "Failed to commit transaction:" << destStore->database().lastError().text();
                 return false;
@@ -815,7 +917,23 @@ bool DbMigrator::copyTable(DataStore *sourceStore, DataStore *destStore, const T
             transaction.begin();
         }
 
-        emitTableProgress(table.name, ++processed, totalRows);
+        processed += rows;
+        emitTableProgress(table.name, processed, totalRows, rowsPerSecond(processed, timer));
+        return true;
+    };
+
+    // Loop over source results
+    while (sourceQuery.next()) {
+        for (int col = 0; col < columnCount; ++col) {
+            batch[col].push_back(convertColumnValue(table.columns[col], sourceQuery.value(col)));
+        }
+        if (batch.front().size() >= batchSize && !flushBatch()) {
+            return false;
+        }
+    }
+
+    if (!flushBatch()) {
+        return false;
     }
 
     // Commit whatever is left in the transaction
@@ -824,6 +942,14 @@ bool DbMigrator::copyTable(DataStore *sourceStore, DataStore *destStore, const T
         return false;
     }
 
+    if (processed > 0) {
+        emitInfo(i18nc("@info:status",
+                       "Copied %1 rows of table %2 (%3 rows/s)",
+                       processed,
+                       table.name,
+                       QString::number(rowsPerSecond(processed, timer), 'f', 0)));
+    }
+
     // Synchronize next autoincrement value (if the table has one)
     if (const auto cnt = std::count_if(table.columns.begin(),
                                        table.columns.end(),
@@ -877,12 +1003,12 @@ void DbMigrator::emitProgress(const QString &table, int done, int total)
         Qt::QueuedConnection);
 }
 
-void DbMigrator::emitTableProgress(const QString &table, int done, int total)
+void DbMigrator::emitTableProgress(const QString &table, int done, int total, double rowsPerSecond)
 {
     QMetaObject::invokeMethod(
         this,
-        [this, table, done, total]() {
-            Q_EMIT tableProgress(table, done, total);
+        [this, table, done, total, rowsPerSecond]() {
+            Q_EMIT tableProgress(table, done, total, rowsPerSecond);
         },
         Qt::QueuedConnection);
 }
@@ -50,15 +50,15 @@ Q_SIGNALS:
     void info(const QString &message);
     void error(const QString &message);
     void progress(const QString &message, int tablesDone, int tablesTotal);
-    void tableProgress(const QString &table, int rowsDone, int rowsTotal);
+    void tableProgress(const QString &table, int rowsDone, int rowsTotal, double rowsPerSecond);
 
     void migrationCompleted(bool success);
 
 private:
     [[nodiscard]] bool runMigrationThread();
-    bool copyTable(DataStore *sourceStore, DataStore *destStore, const TableDescription &table);
+    bool copyTable(DataStore *sourceStore, DataStore *destStore, const TableDescription &table, int totalRows);
 
-    [[nodiscard]] bool migrateTables(DataStore *sourceStore, DataStore *destStore, DbConfig *destConfig);
+    [[nodiscard]] bool migrateTables(DataStore *sourceStore, DataStore *destStore, DbConfig *sourceConfig, DbConfig *destConfig);
     [[nodiscard]] bool moveDatabaseToMainLocation(DbConfig *destConfig, const QString &destServerCfgFile);
     std::optional<QString> moveDatabaseToBackupLocation(DbConfig *config);
     std::optional<QString> backupAkonadiServerRc();
@@ -67,7 +67,7 @@ private:
     void emitInfo(const QString &message);
     void emitError(const QString &message);
     void emitProgress(const QString &message, int tablesDone, int tablesTotal);
-    void emitTableProgress(const QString &table, int done, int total);
+    void emitTableProgress(const QString &table, int done, int total, double rowsPerSecond);
     void emitCompletion(bool success);
     [[nodiscard]] UIDelegate::Result questionYesNo(const QString &question);
     [[nodiscard]] UIDelegate::Result questionYesNoSkip(const QString &question);
@@ -15,6 +15,7 @@
 #include <QCommandLineOption>
 #include <QCommandLineParser>
 #include <QCoreApplication>
+#include <QHash>
 
 #include <iostream>
 
@@ -112,20 +113,25 @@ int main(int argc, char **argv)
     QObject::connect(&migrator, &DbMigrator::progress, &app, [](const QString &table, int tablesDone, int tablesTotal) {
         std::cout << qUtf8Printable(i18nc("@info:progress", "Migrating table %1 (%2/%3)...", table, tablesDone, tablesTotal)) << std::endl;
     });
-    QString lastTable;
-    int lastPerc = -1;
-    QObject::connect(&migrator, &DbMigrator::tableProgress, &app, [&lastTable, &lastPerc](const QString &table, int rowsDone, int rowsTotal) {
-        const int perc = rowsDone * 100 / rowsTotal;
-        if (lastTable != table) {
-            lastPerc = -1;
-        }
-        if (perc % 10 != 0 || perc == lastPerc) {
-            return;
-        }
-        lastPerc = perc;
-        lastTable = table;
-        std::cout << qUtf8Printable(i18nc("@info:progress", "%1%...", perc)) << std::endl;
-    });
+    // Tables may be migrated in parallel, so keep track of the last reported percentage for each
+    QHash<QString, int> lastPerc;
+    QObject::connect(&migrator,
+                     &DbMigrator::tableProgress,
+                     &app,
+                     [&lastPerc](const QString &table, int rowsDone, int rowsTotal, double rowsPerSecond) {
+                         const int perc = rowsTotal > 0 ? static_cast<int>(qint64(rowsDone) * 100 / rowsTotal) : 100;
+                         auto &last = lastPerc[table];
+                         if (perc / 10 == last / 10) {
+                             return;
+                         }
+                         last = perc;
+                         std::cout << qUtf8Printable(i18nc("@info:progress %1 is table name, %2 is percentage, %3 is number of rows per second",
+                                                           "%1: %2% (%3 rows/s)...",
+                                                           table,
+                                                           perc,
+                                                           QString::number(rowsPerSecond, 'f', 0)))
+                                   << std::endl;
+                     });
 
     QMetaObject::invokeMethod(&migrator, &DbMigrator::startMigration, Qt::QueuedConnection);
 
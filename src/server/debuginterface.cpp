@@ -6,14 +6,16 @@
 
 #include "debuginterface.h"
 #include "debuginterfaceadaptor.h"
+#include "protocolcapturewriter.h"
 #include "tracer.h"
 
 #include <QDBusConnection>
 
 using namespace Akonadi::Server;
 
-DebugInterface::DebugInterface(Tracer &tracer)
+DebugInterface::DebugInterface(Tracer &tracer, ProtocolCaptureWriter &protocolCapture)
     : m_tracer(tracer)
+    , m_protocolCapture(protocolCapture)
 {
     new DebugInterfaceAdaptor(this);
     QDBusConnection::sessionBus().registerObject(QStringLiteral("/debug"), this, QDBusConnection::ExportAdaptors);
@@ -29,4 +31,14 @@ void DebugInterface::setTracer(const QString &tracer)
     m_tracer.activateTracer(tracer);
 }
 
+bool DebugInterface::startProtocolCapture(const QString &fileName, const QString &sessionFilter)
+{
+    return m_protocolCapture.start(fileName, sessionFilter);
+}
+
+void DebugInterface::stopProtocolCapture()
+{
+    m_protocolCapture.stop();
+}
+
 #include "moc_debuginterface.cpp"
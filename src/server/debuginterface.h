@@ -12,6 +12,7 @@ namespace Akonadi
 {
 namespace Server
 {
+class ProtocolCaptureWriter;
 class Tracer;
 
 /**
@@ -23,14 +24,23 @@ class DebugInterface : public QObject
     Q_CLASSINFO("D-Bus Interface", "org.freedesktop.Akonadi.DebugInterface")
 
 public:
-    explicit DebugInterface(Tracer &tracer);
+    explicit DebugInterface(Tracer &tracer, ProtocolCaptureWriter &protocolCapture);
 
 public Q_SLOTS:
     Q_SCRIPTABLE QString tracer() const;
     Q_SCRIPTABLE void setTracer(const QString &tracer);
 
+    /**
+     * Captures the commands of the sessions which log in from now on, and of
+     * which the session id matches the regular expression @p sessionFilter,
+     * to @p fileName. The capture can be replayed with asapcat --replay.
+     */
+    Q_SCRIPTABLE bool startProtocolCapture(const QString &fileName, const QString &sessionFilter);
+    Q_SCRIPTABLE void stopProtocolCapture();
+
 private:
     Tracer &m_tracer;
+    ProtocolCaptureWriter &m_protocolCapture;
 };
 
 } // namespace Server
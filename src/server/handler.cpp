@@ -21,8 +21,10 @@
 #include "handler/itemlinkhandler.h"
 #include "handler/itemmodifyhandler.h"
 #include "handler/itemmovehandler.h"
+#include "handler/itemsyncmanifesthandler.h"
 #include "handler/loginhandler.h"
 #include "handler/logouthandler.h"
+#include "handler/preprocessitemshandler.h"
 #include "handler/resourceselecthandler.h"
 #include "handler/searchcreatehandler.h"
 #include "handler/searchhandler.h"
@@ -89,6 +91,8 @@ std::unique_ptr<Handler> Handler::findHandlerForCommandAuthenticated(Protocol::C
         return std::make_unique<ItemModifyHandler>(akonadi);
     case Protocol::Command::MoveItems:
         return std::make_unique<ItemMoveHandler>(akonadi);
+    case Protocol::Command::ItemSyncManifest:
+        return std::make_unique<ItemSyncManifestHandler>(akonadi);
 
     case Protocol::Command::CreateCollection:
         return std::make_unique<CollectionCreateHandler>(akonadi);
@@ -123,6 +127,8 @@ std::unique_ptr<Handler> Handler::findHandlerForCommandAuthenticated(Protocol::C
 
     case Protocol::Command::SelectResource:
         return std::make_unique<ResourceSelectHandler>(akonadi);
+    case Protocol::Command::PreprocessItems:
+        return std::make_unique<PreprocessItemsHandler>(akonadi);
 
     case Protocol::Command::StreamPayload:
         Q_ASSERT_X(cmd != Protocol::Command::StreamPayload, __FUNCTION__, "StreamPayload command is not allowed in this context");
@@ -40,9 +40,12 @@ bool ItemCopyHandler::copyItem(const PimItem &item, const Collection &target)
     newParts.reserve(parts.size());
     for (const Part &part : parts) {
         Part newPart(part);
-        newPart.setData(PartHelper::translateData(newPart.data(), part.storage()));
         newPart.setPimItemId(-1);
-        newPart.setStorage(Part::Internal);
+        if (part.storage() != Part::External) {
+            newPart.setData(PartHelper::translateData(newPart.data(), part.storage()));
+            newPart.setStorage(Part::Internal);
+        }
+        // External parts keep the file name, PartHelper::insert() shares the file with the copy
         newParts << newPart;
     }
 
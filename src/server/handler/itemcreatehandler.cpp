@@ -14,6 +14,7 @@
 #include "private/externalpartstorage_p.h"
 #include "storage/datastore.h"
 #include "storage/dbconfig.h"
+#include "storage/itemmergeindex.h"
 #include "storage/itemretrievalmanager.h"
 #include "storage/parthelper.h"
 #include "storage/partstreamer.h"
@@ -105,6 +106,11 @@ bool ItemCreateHandler::insertItem(const Protocol::CreateItemCommand &cmd, PimIt
     // Handle individual parts
     qint64 partSizes = 0;
     PartStreamer streamer(connection(), item);
+    try {
+        streamer.setInlineParts(cmd.inlineParts());
+    } catch (const PartStreamerException &e) {
+        return failureResponse(e.what());
+    }
     const auto parts = cmd.parts();
     for (const QByteArray &partName : parts) {
         qint64 partSize = 0;
@@ -263,6 +269,11 @@ bool ItemCreateHandler::mergeItem(const Protocol::CreateItemCommand &cmd, PimIte
     }
 
     PartStreamer streamer(connection(), currentItem);
+    try {
+        streamer.setInlineParts(cmd.inlineParts());
+    } catch (const PartStreamerException &e) {
+        return failureResponse(e.what());
+    }
     const auto partNames = cmd.parts();
     for (const QByteArray &partName : partNames) {
         bool changed = false;
@@ -422,7 +433,15 @@ bool ItemCreateHandler::parseStream()
         return false;
     }
 
-    if ((cmd.mergeModes() & ~Protocol::CreateItemCommand::Silent) == 0) {
+    const bool merge = (cmd.mergeModes() & ~Protocol::CreateItemCommand::Silent) != 0;
+    // When merging, skip the query if there's certainly no item to merge into, which is the common
+    // case for new items during a sync
+    if (!merge
+        || !akonadi().itemMergeIndex().mayContain(parentCol.id(),
+                                                  cmd.mergeModes().testFlag(Protocol::CreateItemCommand::RemoteID),
+                                                  item.remoteId(),
+                                                  cmd.mergeModes().testFlag(Protocol::CreateItemCommand::GID),
+                                                  item.gid())) {
         if (!insertItem(cmd, item, parentCol)) {
             return false;
         }
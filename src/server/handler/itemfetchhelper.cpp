@@ -14,6 +14,7 @@
 #include "shared/akranges.h"
 #include "storage/itemqueryhelper.h"
 #include "storage/itemretrievalmanager.h"
+#include "storage/parthelper.h"
 #include "storage/parttypehelper.h"
 #include "storage/selectquerybuilder.h"
 #include "storage/transaction.h"
@@ -173,6 +174,13 @@ QueryBuilder ItemFetchHelper::buildItemQuery()
 #undef ADD_COLUMN
 
     itemQuery.addSortColumn(PimItem::idFullColumnName(), static_cast<Query::SortOrder>(mItemsLimit.sortOrder()));
+    if (mItemsLimit.afterId() > 0) {
+        // Keyset pagination: seeking to the first item of the page using the primary key index is much cheaper
+        // than skipping an offset, also for the part, flag and tag queries which select from this query
+        itemQuery.addValueCondition(PimItem::idFullColumnName(),
+                                    mItemsLimit.sortOrder() == Qt::AscendingOrder ? Query::Greater : Query::Less,
+                                    mItemsLimit.afterId());
+    }
     if (mItemsLimit.limit() > 0) {
         itemQuery.setLimit(mItemsLimit.limit(), mItemsLimit.limitOffset());
     }
@@ -599,11 +607,18 @@ bool ItemFetchHelper::fetchItems(std::function<void(Protocol::FetchItemsResponse
                         skipItem = true;
                         break;
                     }
-                    metaPart.setStorageType(static_cast<Protocol::PartMetaData::StorageType>(partQuery.value(PartQueryStorageColumn).toInt()));
-                    if (data.isEmpty()) {
-                        partData.setData(QByteArray(""));
+                    const auto storage = static_cast<Part::Storage>(partQuery.value(PartQueryStorageColumn).toInt());
+                    if (storage == Part::Packed) {
+                        // Clients can only read separate files, send the payload of packed parts along
+                        metaPart.setStorageType(Protocol::PartMetaData::Internal);
+                        partData.setData(PartHelper::translateData(data, storage));
                     } else {
-                        partData.setData(data);
+                        metaPart.setStorageType(static_cast<Protocol::PartMetaData::StorageType>(storage));
+                        if (data.isEmpty()) {
+                            partData.setData(QByteArray(""));
+                        } else {
+                            partData.setData(data);
+                        }
                     }
                     partData.setMetaData(metaPart);
 
@@ -282,6 +282,11 @@ bool ItemModifyHandler::parseStream()
 
     if (item.isValid() && cmd.modifiedParts() & Protocol::ModifyItemsCommand::Parts) {
         PartStreamer streamer(connection(), item);
+        try {
+            streamer.setInlineParts(cmd.inlineParts());
+        } catch (const PartStreamerException &e) {
+            return failureResponse(e.what());
+        }
         const auto partNames = cmd.parts();
         for (const QByteArray &partName : partNames) {
             qint64 partSize = 0;
@@ -359,6 +364,8 @@ bool ItemModifyHandler::parseStream()
                 // Don't send FLAGS notification in itemChanged
                 changes.remove(AKONADI_PARAM_FLAGS);
                 store->notificationCollector()->itemChanged(item, changes);
+            } else if (changes.contains(AKONADI_PARAM_REMOTEID) || changes.contains(AKONADI_PARAM_GID)) {
+                store->notificationCollector()->itemIdentifiersChanged(item);
             }
 
             if (!cmd.noResponse()) {
@@ -49,6 +49,10 @@ namespace Server
   Conflict detection:
   - only available when modifying a single item
   - requires the previous item revision to be provided (@c REV)
+
+  Conflicts are detected before any change is made, so a client can store
+  a set of items with distinct changes by sending one command per item within
+  a single transaction and carry on with the remaining items after a conflict.
 */
 
 class ItemModifyHandler : public Handler
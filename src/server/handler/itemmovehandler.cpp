@@ -10,6 +10,7 @@
 #include "cachecleaner.h"
 #include "connection.h"
 #include "handlerhelper.h"
+#include "storage/collectionstatistics.h"
 #include "storage/datastore.h"
 #include "storage/itemqueryhelper.h"
 #include "storage/itemretrievalmanager.h"
@@ -17,6 +18,8 @@
 #include "storage/selectquerybuilder.h"
 #include "storage/transaction.h"
 
+#include <algorithm>
+
 using namespace Akonadi;
 using namespace Akonadi::Server;
 
@@ -26,83 +29,113 @@ ItemMoveHandler::ItemMoveHandler(AkonadiServer &akonadi)
 }
 
 void ItemMoveHandler::itemsRetrieved(const QList<qint64> &ids)
+{
+    // Move the items in batches of neighbouring IDs, so that each batch needs only a
+    // constant number of statements and the rows are not locked for too long
+    QList<qint64> sortedIds = ids;
+    std::sort(sortedIds.begin(), sortedIds.end());
+    for (qsizetype i = 0; i < sortedIds.size(); i += BatchSize) {
+        if (!moveItems(sortedIds.mid(i, BatchSize))) {
+            return;
+        }
+    }
+}
+
+bool ItemMoveHandler::moveItems(const QList<qint64> &ids)
 {
     DataStore *store = connection()->storageBackend();
     Transaction transaction(store, QStringLiteral("MOVE"));
 
+    // The items are still needed for the notifications
     SelectQueryBuilder<PimItem> qb;
     qb.setForUpdate();
     ItemQueryHelper::itemSetToQuery(ids, qb);
     qb.addValueCondition(PimItem::collectionIdFullColumnName(), Query::NotEquals, mDestination.id());
 
     if (!qb.exec()) {
-        failureResponse("Unable to execute query");
-        return;
+        return failureResponse("Unable to execute query");
     }
 
-    const QList<PimItem> items = qb.result();
+    PimItem::List items = qb.result();
     if (items.isEmpty()) {
-        return;
+        return true;
     }
 
-    const QDateTime mtime = QDateTime::currentDateTimeUtc();
-    // Split the list by source collection
-    QMultiMap<Entity::Id /* collection */, PimItem> toMove;
-    QMap<Entity::Id /* collection */, Collection> sources;
     QList<PimItem::Id> toMoveIds;
     toMoveIds.reserve(items.size());
-    for (PimItem item : items) {
+    for (const PimItem &item : std::as_const(items)) {
         if (!item.isValid()) {
-            failureResponse("Invalid item in result set!?");
-            return;
+            return failureResponse("Invalid item in result set!?");
         }
-
-        const Collection source = item.collection();
-        if (!source.isValid()) {
-            failureResponse("Item without collection found!?");
-            return;
-        }
-        if (!sources.contains(source.id())) {
-            sources.insert(source.id(), source);
-        }
-
         Q_ASSERT(item.collectionId() != mDestination.id());
+        toMoveIds.push_back(item.id());
+    }
 
-        item.setCollectionId(mDestination.id());
-        item.setAtime(mtime);
-        item.setDatetime(mtime);
-        // if the resource moved itself, we assume it did so because the change happened in the backend
-        if (connection()->context().resource().id() != mDestination.resourceId()) {
-            item.setDirty(true);
-        }
+    // Statistics of the moved items by source collection, calculated before they are moved
+    auto &collectionStatistics = akonadi().collectionStatistics();
+    const auto sourceStatistics = collectionStatistics.itemStatistics(toMoveIds);
 
-        if (!item.update()) {
-            failureResponse("Unable to update item");
-            return;
-        }
+    const QDateTime mtime = QDateTime::currentDateTimeUtc();
+    // if the resource moved itself, we assume it did so because the change happened in the backend
+    const bool markDirty = connection()->context().resource().id() != mDestination.resourceId();
+
+    QueryBuilder updateQb(PimItem::tableName(), QueryBuilder::Update);
+    updateQb.setColumnValue(PimItem::collectionIdColumn(), mDestination.id());
+    updateQb.setColumnValue(PimItem::atimeColumn(), mtime);
+    updateQb.setColumnValue(PimItem::datetimeColumn(), mtime);
+    if (markDirty) {
+        updateQb.setColumnValue(PimItem::dirtyColumn(), true);
+    }
+    updateQb.addValueCondition(PimItem::idColumn(), Query::In, toMoveIds);
+    if (!updateQb.exec()) {
+        return failureResponse("Unable to update items");
+    }
 
-        toMove.insert(source.id(), item);
-        toMoveIds.push_back(item.id());
+    // Applied when the move is committed, so that no other connection caches statistics
+    // which already contain the moved items before the delta is applied
+    if (sourceStatistics) {
+        for (auto it = sourceStatistics->cbegin(), end = sourceStatistics->cend(); it != end; ++it) {
+            store->notificationCollector()->itemStatisticsMoved(Collection::retrieveById(it.key()), mDestination, it.value());
+        }
     }
 
     if (!transaction.commit()) {
-        failureResponse("Unable to commit transaction.");
-        return;
+        return failureResponse("Unable to commit transaction.");
     }
 
-    // Emit notification for each source collection separately
+    // Split the list by source collection and emit notification for each source
+    // collection separately, the items of each collection are listed in the reverse
+    // order of the query as they always have been
+    std::reverse(items.begin(), items.end());
+    std::stable_sort(items.begin(), items.end(), [](const PimItem &lhs, const PimItem &rhs) {
+        return lhs.collectionId() < rhs.collectionId();
+    });
     Collection source;
     PimItem::List itemsToMove;
-    for (auto it = toMove.cbegin(), end = toMove.cend(); it != end; ++it) {
-        if (source.id() != it.key()) {
+    for (PimItem &item : items) {
+        if (source.id() != item.collectionId()) {
             if (!itemsToMove.isEmpty()) {
                 store->notificationCollector()->itemsMoved(itemsToMove, source, mDestination);
             }
-            source = sources.value(it.key());
+            source = Collection::retrieveById(item.collectionId());
+            if (!source.isValid()) {
+                return failureResponse("Item without collection found!?");
+            }
+            if (!sourceStatistics || !sourceStatistics->contains(source.id())) {
+                // The statistics are recalculated when they are requested next
+                collectionStatistics.invalidateCollection(source);
+                collectionStatistics.invalidateCollection(mDestination);
+            }
             itemsToMove.clear();
         }
 
-        itemsToMove.push_back(*it);
+        item.setCollectionId(mDestination.id());
+        item.setAtime(mtime);
+        item.setDatetime(mtime);
+        if (markDirty) {
+            item.setDirty(true);
+        }
+        itemsToMove.push_back(item);
     }
 
     if (!itemsToMove.isEmpty()) {
@@ -116,11 +149,12 @@ void ItemMoveHandler::itemsRetrieved(const QList<qint64> &ids)
     // retrieve the RID
     QueryBuilder qb2(PimItem::tableName(), QueryBuilder::Update);
     qb2.setColumnValue(PimItem::remoteIdColumn(), QString());
-    ItemQueryHelper::itemSetToQuery(toMoveIds, connection()->context(), qb2);
+    qb2.addValueCondition(PimItem::idColumn(), Query::In, toMoveIds);
     if (!qb2.exec()) {
-        failureResponse("Unable to update RID");
-        return;
+        return failureResponse("Unable to update RID");
     }
+
+    return true;
 }
 
 bool ItemMoveHandler::parseStream()
@@ -34,7 +34,11 @@ public:
     bool parseStream() override;
 
 private:
+    /// Number of items moved with a single UPDATE statement
+    static constexpr qsizetype BatchSize = 1000;
+
     void itemsRetrieved(const QList<qint64> &ids);
+    bool moveItems(const QList<qint64> &ids);
 
     Collection mDestination;
 };
@@ -0,0 +1,86 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "itemsyncmanifesthandler.h"
+
+#include "connection.h"
+#include "storage/querybuilder.h"
+#include "utils.h"
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+ItemSyncManifestHandler::ItemSyncManifestHandler(AkonadiServer &akonadi)
+    : Handler(akonadi)
+{
+}
+
+bool ItemSyncManifestHandler::parseStream()
+{
+    const auto &cmd = Protocol::cmdCast<Protocol::ItemSyncManifestCommand>(m_command);
+
+    const Collection collection = Collection::retrieveById(cmd.collectionId());
+    if (!collection.isValid()) {
+        return failureResponse(QStringLiteral("Invalid collection"));
+    }
+    if (collection.isVirtual()) {
+        return failureResponse(QStringLiteral("Cannot synchronize items of a virtual collection"));
+    }
+
+    const auto remoteIds = cmd.remoteIds();
+    const auto remoteRevisions = cmd.remoteRevisions();
+    if (remoteIds.size() != remoteRevisions.size()) {
+        return failureResponse(QStringLiteral("Malformed item manifest"));
+    }
+
+    QHash<QString, QString> manifest;
+    manifest.reserve(remoteIds.size());
+    for (qsizetype i = 0; i < remoteIds.size(); ++i) {
+        manifest.insert(remoteIds[i], remoteRevisions[i]);
+    }
+
+    QueryBuilder qb(PimItem::tableName());
+    qb.addColumn(PimItem::idFullColumnName());
+    qb.addColumn(PimItem::remoteIdFullColumnName());
+    qb.addColumn(PimItem::remoteRevisionFullColumnName());
+    qb.addValueCondition(PimItem::collectionIdFullColumnName(), Query::Equals, collection.id());
+    qb.addSortColumn(PimItem::idFullColumnName(), Query::Ascending);
+    if (!qb.exec()) {
+        return failureResponse(QStringLiteral("Failed to query items of the collection"));
+    }
+
+    QList<qint64> deletedItems;
+    // Remote IDs that need not be reported as changed
+    QSet<QString> handled;
+    auto &query = qb.query();
+    while (query.next()) {
+        const QString remoteId = Utils::variantToString(query.value(1));
+        if (remoteId.isEmpty()) {
+            continue;
+        }
+        const auto it = manifest.constFind(remoteId);
+        if (it == manifest.cend()) {
+            deletedItems.push_back(query.value(0).toLongLong());
+        } else if (!it->isEmpty() && *it == Utils::variantToString(query.value(2))) {
+            handled.insert(remoteId);
+        }
+    }
+    query.finish();
+
+    QStringList changedRemoteIds;
+    for (const QString &remoteId : remoteIds) {
+        if (!handled.contains(remoteId)) {
+            changedRemoteIds.push_back(remoteId);
+            // Report remote IDs listed multiple times only once
+            handled.insert(remoteId);
+        }
+    }
+
+    Protocol::ItemSyncManifestResponse resp;
+    resp.setChangedRemoteIds(changedRemoteIds);
+    resp.setDeletedItems(deletedItems);
+    return successResponse(std::move(resp));
+}
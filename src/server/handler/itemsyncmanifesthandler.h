@@ -0,0 +1,43 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "handler.h"
+
+namespace Akonadi
+{
+namespace Server
+{
+/**
+  @ingroup akonadi_server_handler
+
+  Handler for the item sync manifest command.
+
+  <h4>Semantics</h4>
+  Compares a list of (remote identifier, remote revision) pairs describing
+  the complete remote content of a collection with the items stored in it.
+
+  Remote identifiers of items that do not exist locally yet, of items whose
+  stored remote revision differs from the listed one and of items for which
+  either revision is empty are returned as changed. Local items whose remote
+  identifier is not listed are returned as deleted, items without a remote
+  identifier are ignored as they have not been synchronized yet.
+
+  Nothing is modified by this command, it only allows ItemSync to skip the
+  items that have not changed.
+*/
+class ItemSyncManifestHandler : public Handler
+{
+public:
+    ItemSyncManifestHandler(AkonadiServer &akonadi);
+    ~ItemSyncManifestHandler() override = default;
+
+    bool parseStream() override;
+};
+
+} // namespace Server
+} // namespace Akonadi
@@ -7,6 +7,7 @@
 #include "loginhandler.h"
 
 #include "connection.h"
+#include "storage/partstreamer.h"
 
 using namespace Akonadi;
 using namespace Akonadi::Server;
@@ -27,5 +28,7 @@ bool LoginHandler::parseStream()
     connection()->setSessionId(cmd.sessionId());
     connection()->setState(Server::Authenticated);
 
-    return successResponse<Protocol::LoginResponse>();
+    Protocol::LoginResponse response;
+    response.setMaxInlinePartSize(PartStreamer::MaxInlinePartSize);
+    return successResponse(std::move(response));
 }
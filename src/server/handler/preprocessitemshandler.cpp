@@ -0,0 +1,54 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "preprocessitemshandler.h"
+
+#include "akonadi.h"
+#include "commandscheduler.h"
+#include "connection.h"
+#include "preprocessormanager.h"
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Bounds how long the connection is blocked, the preprocessor repeats the command
+constexpr auto BatchWaitTimeout = 20s;
+}
+
+PreprocessItemsHandler::PreprocessItemsHandler(AkonadiServer &akonadi)
+    : Handler(akonadi)
+{
+}
+
+bool PreprocessItemsHandler::parseStream()
+{
+    const auto &cmd = Protocol::cmdCast<Protocol::PreprocessItemsCommand>(m_command);
+
+    if (cmd.preprocessorId().isEmpty()) {
+        return failureResponse(QStringLiteral("No preprocessor specified"));
+    }
+    if (cmd.maxBatchSize() < 1) {
+        return failureResponse(QStringLiteral("Invalid batch size"));
+    }
+
+    auto &manager = akonadi().preprocessorManager();
+    manager.batchItemsProcessed(cmd.preprocessorId(), cmd.completedItems(), cmd.failedItems(), cmd.refusedItems());
+
+    const bool reportedResults = !cmd.completedItems().isEmpty() || !cmd.failedItems().isEmpty() || !cmd.refusedItems().isEmpty();
+    QList<qint64> items;
+    {
+        // New items are created by other connections, so do not block an execution slot while waiting for them
+        CommandScheduler::Yield yield;
+        items = manager.waitForItemBatch(cmd.preprocessorId(), cmd.maxBatchSize(), BatchWaitTimeout, cmd.firstRequest(), reportedResults);
+    }
+
+    Protocol::PreprocessItemsResponse resp;
+    resp.setItems(items);
+    return successResponse(std::move(resp));
+}
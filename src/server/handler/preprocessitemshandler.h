@@ -0,0 +1,45 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "handler.h"
+
+namespace Akonadi
+{
+namespace Server
+{
+/**
+  @ingroup akonadi_server_handler
+
+  Handler for the preprocess items command.
+
+  <h4>Semantics</h4>
+  Used by preprocessor agents to receive newly created items in batches
+  over their connection instead of one at a time via D-Bus. The first
+  command switches the preprocessor to batched mode.
+
+  The items the preprocessor has completed, failed or refused are passed on
+  to the next preprocessor in the chain, then the next batch of at most
+  maxBatchSize items is returned. If the preprocessor has no items left in
+  progress, the handler waits for new items and returns an empty batch if
+  none arrived in time, so that the preprocessor can simply repeat the
+  command.
+
+  The time the preprocessor takes for a batch is checked by the heartbeat
+  of the PreprocessorManager, like the time for a single item in D-Bus mode.
+*/
+class PreprocessItemsHandler : public Handler
+{
+public:
+    PreprocessItemsHandler(AkonadiServer &akonadi);
+    ~PreprocessItemsHandler() override = default;
+
+    bool parseStream() override;
+};
+
+} // namespace Server
+} // namespace Akonadi
@@ -64,13 +64,21 @@ bool SearchHandler::parseStream()
     request.setMimeTypes(cmd.mimeTypes());
     request.setQuery(cmd.query());
     request.setRemoteSearch(cmd.remote());
-    QObject::connect(&request, &SearchRequest::resultsAvailable, &request, [this](const QSet<qint64> &results) {
+    request.setLimit(SearchRequest::limitFromQuery(cmd.query()));
+    // The items are sent to the client batch by batch while the search is running
+    QObject::connect(&request, &SearchRequest::resultsAvailable, &request, [this, &request](const QSet<qint64> &results) {
         processResults(results);
+        if (!connection()->isClientConnected()) {
+            request.cancel();
+        }
     });
     request.exec();
 
     // qCDebug(AKONADISERVER_SEARCH_LOG) << "\tResult:" << uids;
     qCDebug(AKONADISERVER_SEARCH_LOG) << "\tResult:" << mAllResults.count() << "matches";
+    if (request.isCancelled()) {
+        return failureResponse("Search cancelled, the client has disconnected");
+    }
 
     return successResponse<Protocol::SearchResponse>();
 }
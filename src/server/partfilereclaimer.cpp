@@ -0,0 +1,98 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "partfilereclaimer.h"
+#include "akonadiserver_debug.h"
+#include "entities.h"
+#include "storage/datastore.h"
+#include "storage/querybuilder.h"
+#include "storage/selectquerybuilder.h"
+
+#include "private/externalpartstorage_p.h"
+
+#include <QFile>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+PartFileReclaimer::PartFileReclaimer(StartMode startMode)
+    : AkThread(QStringLiteral("PartFileReclaimer"), startMode, QThread::IdlePriority)
+{
+}
+
+PartFileReclaimer::~PartFileReclaimer()
+{
+    quitThread();
+}
+
+void PartFileReclaimer::init()
+{
+    AkThread::init();
+
+    // Files left over when the server was stopped before they were deleted
+    reclaim();
+}
+
+void PartFileReclaimer::reclaim()
+{
+    // Removals which are committed while the thread is busy are picked up by the running pass
+    if (mScheduled.exchange(true)) {
+        return;
+    }
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            mScheduled = false;
+            reclaimPending();
+        },
+        Qt::QueuedConnection);
+}
+
+qint64 PartFileReclaimer::reclaimPending()
+{
+    qint64 count = 0;
+    while (true) {
+        SelectQueryBuilder<PartFileTombstone> qb;
+        qb.addSortColumn(PartFileTombstone::idColumn());
+        qb.setLimit(BatchSize);
+        if (!qb.exec()) {
+            qCWarning(AKONADISERVER_LOG) << "Failed to query part file tombstones";
+            return -1;
+        }
+        const auto tombstones = qb.result();
+        if (tombstones.isEmpty()) {
+            break;
+        }
+
+        QList<qint64> ids;
+        ids.reserve(tombstones.size());
+        for (const auto &tombstone : tombstones) {
+            bool exists = false;
+            const QString path = ExternalPartStorage::resolveAbsolutePath(tombstone.fileName(), &exists);
+            // The file may already be gone if the server stopped before the tombstone was removed
+            if (exists && !QFile::remove(path)) {
+                // Not retried, the StorageJanitor takes care of the file
+                qCWarning(AKONADISERVER_LOG) << "Failed to remove part file" << path;
+            }
+            ids.push_back(tombstone.id());
+        }
+
+        QueryBuilder removeQb(PartFileTombstone::tableName(), QueryBuilder::Delete);
+        removeQb.addValueCondition(PartFileTombstone::idColumn(), Query::In, ids);
+        if (!removeQb.exec()) {
+            qCWarning(AKONADISERVER_LOG) << "Failed to remove part file tombstones";
+            return -1;
+        }
+        count += ids.size();
+    }
+
+    if (count > 0) {
+        qCDebug(AKONADISERVER_LOG) << "Removed" << count << "part files of removed items";
+    }
+    return count;
+}
+
+#include "moc_partfilereclaimer.cpp"
@@ -0,0 +1,67 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akthread.h"
+
+#include <atomic>
+
+namespace Akonadi
+{
+namespace Server
+{
+/**
+ * Deletes the files of removed external parts in the background
+ *
+ * Removing items only records the file names of their external parts as
+ * PartFileTombstone in the transaction that removes the parts, see
+ * PartHelper::removeByItemIds(). Once the transaction is committed the files
+ * are deleted by this thread, so that removing many items does not keep the
+ * transaction open while thousands of files are unlinked.
+ *
+ * Since the tombstones are stored in the database together with the removal,
+ * files are never deleted for a removal that is rolled back, and files which
+ * were not deleted before the server stopped are deleted on the next start.
+ */
+class PartFileReclaimer : public AkThread
+{
+    Q_OBJECT
+
+protected:
+    /**
+     * Use AkThread::create() to create and start a new PartFileReclaimer thread.
+     */
+    explicit PartFileReclaimer(StartMode startMode = AutoStart);
+
+public:
+    /// Number of tombstones processed with a single query
+    static constexpr int BatchSize = 1000;
+
+    ~PartFileReclaimer() override;
+
+    /**
+     * Schedules the deletion of the files of all pending tombstones.
+     * Can be called from any thread.
+     */
+    void reclaim();
+
+    /**
+     * Deletes the files of all pending tombstones and the tombstones themselves
+     * using the DataStore of the current thread.
+     * Returns the number of processed tombstones, or -1 on error.
+     */
+    static qint64 reclaimPending();
+
+protected:
+    void init() override;
+
+private:
+    std::atomic_bool mScheduled = false;
+};
+
+} // namespace Server
+} // namespace Akonadi
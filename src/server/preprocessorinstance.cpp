@@ -66,6 +66,12 @@ void PreprocessorInstance::enqueueItem(qint64 itemId)
 
     mItemQueue.push_back(itemId);
 
+    // The preprocessor picks the item up with its next batch
+    if (mBatchMode) {
+        mManager.mItemsAvailable.wakeAll();
+        return;
+    }
+
     // If the preprocessor is already busy processing another item then do nothing.
     if (mBusy) {
         // The "head" item is the one being processed and we have just added another one.
@@ -84,6 +90,13 @@ void PreprocessorInstance::processHeadItem()
     // We shouldn't be here with no interface
     Q_ASSERT(mInterface);
 
+    // The preprocessor has switched to batches while the last item was processed
+    if (mBatchMode) {
+        mBusy = false;
+        mManager.mItemsAvailable.wakeAll();
+        return;
+    }
+
     qint64 itemId = mItemQueue.front();
 
     // Fetch the actual item data (as it may have changed since it was enqueued)
@@ -121,6 +134,71 @@ void PreprocessorInstance::processHeadItem()
     qCDebug(AKONADISERVER_LOG) << "PreprocessorInstance::processHeadItem(): processing started for item " << itemId;
 }
 
+void PreprocessorInstance::enterBatchMode()
+{
+    if (mBatchMode) {
+        return;
+    }
+
+    qCDebug(AKONADISERVER_LOG) << "PreprocessorInstance" << mId << "switched to batched mode";
+    mBatchMode = true;
+    // An item being processed via D-Bus is still finished by itemProcessed()
+}
+
+QList<qint64> PreprocessorInstance::takeBatch(qsizetype maxBatchSize)
+{
+    // Wait for the item handed out via D-Bus before switching
+    if (!mBatchMode || (mBusy && mBatch.isEmpty())) {
+        return {};
+    }
+
+    // The handed out items are at the head of the queue
+    QList<qint64> batch;
+    for (auto it = mItemQueue.cbegin() + mBatch.size(), end = mItemQueue.cend(); it != end && batch.size() < maxBatchSize; ++it) {
+        batch.push_back(*it);
+    }
+    if (batch.isEmpty()) {
+        return {};
+    }
+
+    qCDebug(AKONADISERVER_LOG) << "PreprocessorInstance::takeBatch(): handing out" << batch.size() << "items to" << mId;
+
+    mBatch += batch;
+    mBusy = true;
+    mItemProcessingStartDateTime = QDateTime::currentDateTime();
+    return batch;
+}
+
+bool PreprocessorInstance::finishBatchItem(qint64 itemId)
+{
+    if (!mBatch.removeOne(itemId)) {
+        mTracer.warning(QStringLiteral("PreprocessorInstance"),
+                        QStringLiteral("Pre-processor instance '%1' reported item %2 which it was not processing").arg(mId).arg(itemId));
+        return false;
+    }
+
+    std::erase(mItemQueue, itemId);
+    mBusy = !mBatch.isEmpty();
+    // Each finished item restarts the clock for the rest of the batch
+    mItemProcessingStartDateTime = QDateTime::currentDateTime();
+    return true;
+}
+
+void PreprocessorInstance::resetBatch()
+{
+    if (mBatch.isEmpty()) {
+        return;
+    }
+
+    mTracer.warning(QStringLiteral("PreprocessorInstance"),
+                    QStringLiteral("Pre-processor instance '%1' did not finish %2 items, handing them out again").arg(mId).arg(mBatch.size()));
+
+    // The handed out items are still at the head of the queue
+    mBatch.clear();
+    mBusy = false;
+    mManager.mItemsAvailable.wakeAll();
+}
+
 qint64 PreprocessorInstance::currentProcessingTime()
 {
     if (!mBusy) {
@@ -165,6 +243,9 @@ bool PreprocessorInstance::invokeRestart()
 
     iface.restartAgentInstance(mId);
 
+    // The new process does not know about the items handed out to the old one
+    resetBatch();
+
     return true;
 }
 
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <QDateTime>
+#include <QList>
 #include <QObject>
 
 #include <deque>
@@ -32,6 +33,12 @@ class Tracer;
  * Most of the interface of this class is protected and is exposed only
  * to PreprocessorManager (singleton).
  *
+ * Items are handed to the preprocessor one at a time via D-Bus until the
+ * preprocessor requests its first batch of items via the PreprocessItems
+ * command. From then on the instance is in batched mode: the items are
+ * handed out in batches over the preprocessor's connection and the
+ * preprocessor reports the result of each item of a batch.
+ *
  * This class is NOT thread safe. The caller is responsible of protecting
  * against concurrent access.
  */
@@ -78,9 +85,23 @@ private:
      * item in the queue. This is used to compute the processing time
      * and eventually spot a "dead" preprocessor (which takes longer
      * than N minutes to process an item).
+     *
+     * In batched mode this is the time at that the preprocessor has last
+     * made progress, that is received a batch or finished an item.
      */
     QDateTime mItemProcessingStartDateTime;
 
+    /**
+     * Are the items handed out in batches via PreprocessItems ?
+     */
+    bool mBatchMode = false;
+
+    /**
+     * The items handed out to the preprocessor in batched mode which
+     * are still being processed. They are kept in mItemQueue as well.
+     */
+    QList<qint64> mBatch;
+
     /**
      * The id of this preprocessor instance. This is actually
      * the AgentInstance identifier.
@@ -99,7 +120,7 @@ protected:
      * In case of failure this object should be destroyed as it can't
      * operate properly. The error message is printed via Tracer.
      */
-    bool init();
+    virtual bool init();
 
     /**
      * Returns true if this preprocessor instance is currently processing an item.
@@ -111,6 +132,47 @@ protected:
         return mBusy;
     }
 
+    /**
+     * Returns true if the items are handed out in batches.
+     */
+    bool isInBatchMode() const
+    {
+        return mBatchMode;
+    }
+
+    /**
+     * Returns true if items handed out in batched mode are still being processed.
+     */
+    bool hasBatch() const
+    {
+        return !mBatch.isEmpty();
+    }
+
+    /**
+     * Switches the instance to batched mode. An item that is currently
+     * being processed via D-Bus is finished via D-Bus first.
+     */
+    void enterBatchMode();
+
+    /**
+     * Hands out up to @p maxBatchSize waiting items to the preprocessor,
+     * in batched mode only. Returns an empty list if no items are waiting.
+     */
+    QList<qint64> takeBatch(qsizetype maxBatchSize);
+
+    /**
+     * Marks @p itemId of the current batch as processed. Returns false
+     * if the item wasn't handed out to the preprocessor.
+     */
+    bool finishBatchItem(qint64 itemId);
+
+    /**
+     * Forgets the items handed out in batched mode, so that they are handed
+     * out again. Called when the preprocessor process which received them
+     * has been replaced.
+     */
+    void resetBatch();
+
     /**
      * Returns the time in seconds elapsed since the current item was submitted
      * to the slave preprocessor instance. If no item is currently being
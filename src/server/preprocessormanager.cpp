@@ -19,6 +19,8 @@
 
 #include "preprocessormanageradaptor.h"
 
+#include <QDeadlineTimer>
+
 namespace Akonadi
 {
 namespace Server
@@ -106,7 +108,7 @@ void PreprocessorManager::registerInstance(const QString &id)
     // TODO: Maybe we need some kind of ordering here ?
     //       In that case we'll need to fiddle with the items that are currently enqueued for processing...
 
-    instance = new PreprocessorInstance(id, *this, mTracer);
+    instance = createInstance(id);
     if (!instance->init()) {
         mTracer.warning(QStringLiteral("PreprocessorManager"), QStringLiteral("Could not initialize preprocessor instance '%1'").arg(id));
         delete instance;
@@ -116,6 +118,14 @@ void PreprocessorManager::registerInstance(const QString &id)
     qCDebug(AKONADISERVER_LOG) << "Registering preprocessor instance " << id;
 
     mPreprocessorChain.append(instance);
+
+    // The preprocessor may already be waiting for its first batch
+    mItemsAvailable.wakeAll();
+}
+
+PreprocessorInstance *PreprocessorManager::createInstance(const QString &id)
+{
+    return new PreprocessorInstance(id, *this, mTracer);
 }
 
 void PreprocessorManager::unregisterInstance(const QString &id)
@@ -325,6 +335,11 @@ void PreprocessorManager::preProcessorFinishedHandlingItem(PreprocessorInstance
 {
     QMutexLocker locker(&mMutex);
 
+    lockedPreProcessorFinishedHandlingItem(preProcessor, itemId);
+}
+
+void PreprocessorManager::lockedPreProcessorFinishedHandlingItem(PreprocessorInstance *preProcessor, qint64 itemId)
+{
     int idx = mPreprocessorChain.indexOf(preProcessor);
     Q_ASSERT(idx >= 0); // must be there!
 
@@ -341,6 +356,76 @@ void PreprocessorManager::preProcessorFinishedHandlingItem(PreprocessorInstance
     }
 }
 
+void PreprocessorManager::batchItemsProcessed(const QString &id,
+                                              const QList<qint64> &completedItems,
+                                              const QList<qint64> &failedItems,
+                                              const QList<qint64> &refusedItems)
+{
+    QMutexLocker locker(&mMutex);
+
+    PreprocessorInstance *instance = lockedFindInstance(id);
+    if (!instance || !instance->isInBatchMode()) {
+        // The instance has been unregistered in the meantime and its items were handed on
+        return;
+    }
+
+    for (qint64 itemId : failedItems) {
+        mTracer.warning(QStringLiteral("PreprocessorManager"), QStringLiteral("Preprocessor '%1' failed to process item %2").arg(id).arg(itemId));
+    }
+    for (qint64 itemId : refusedItems) {
+        qCDebug(AKONADISERVER_LOG) << "Preprocessor" << id << "refused to process item" << itemId;
+    }
+
+    for (const auto *items : {&completedItems, &failedItems, &refusedItems}) {
+        for (qint64 itemId : *items) {
+            if (instance->finishBatchItem(itemId)) {
+                lockedPreProcessorFinishedHandlingItem(instance, itemId);
+            }
+        }
+    }
+}
+
+QList<qint64>
+PreprocessorManager::waitForItemBatch(const QString &id, qsizetype maxBatchSize, std::chrono::milliseconds timeout, bool firstRequest, bool reportedResults)
+{
+    QMutexLocker locker(&mMutex);
+
+    if (firstRequest) {
+        if (PreprocessorInstance *instance = lockedFindInstance(id)) {
+            instance->resetBatch();
+        }
+    }
+
+    const QDeadlineTimer deadline(timeout);
+    while (!mBatchRequestsCancelled) {
+        // Look the instance up again after waiting, it might have been unregistered
+        PreprocessorInstance *instance = lockedFindInstance(id);
+        if (instance) {
+            instance->enterBatchMode();
+            auto batch = instance->takeBatch(maxBatchSize);
+            // Don't hold back the results of a preprocessor that is still processing items. Without
+            // results, the preprocessor only asks when it has finished all of its items.
+            if (!batch.isEmpty() || (reportedResults && instance->hasBatch())) {
+                return batch;
+            }
+        }
+
+        if (!mItemsAvailable.wait(&mMutex, deadline)) {
+            break;
+        }
+    }
+
+    return {};
+}
+
+void PreprocessorManager::cancelBatchRequests()
+{
+    QMutexLocker locker(&mMutex);
+
+    mBatchRequestsCancelled = true;
+    mItemsAvailable.wakeAll();
+}
+
 void PreprocessorManager::lockedEndHandleItem(qint64 itemId)
 {
     // The exit point of the pre-processing chain.
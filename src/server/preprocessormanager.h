@@ -15,7 +15,9 @@
 #include <QList>
 #include <QMutex>
 #include <QObject>
+#include <QWaitCondition>
 
+#include <chrono>
 #include <deque>
 
 class QTimer;
@@ -90,6 +92,18 @@ protected:
      */
     QMutex mMutex;
 
+    /**
+     * Signalled when items are waiting for a preprocessor in batched mode,
+     * a preprocessor has been registered or the batch requests should be
+     * cancelled. Used together with mMutex.
+     */
+    QWaitCondition mItemsAvailable;
+
+    /**
+     * Set by cancelBatchRequests() when the server shuts down.
+     */
+    bool mBatchRequestsCancelled = false;
+
     /**
      * The heartbeat timer. Used mainly to expire preprocessor jobs.
      */
@@ -181,7 +195,48 @@ public:
      */
     void unregisterInstance(const QString &id);
 
+    /**
+     * This is called by the PreprocessItems handler to report the items
+     * that the preprocessor instance @p id has processed in batched mode.
+     * Failed and refused items are logged, all of them are passed on to
+     * the next preprocessor in the chain.
+     *
+     * This function is thread-safe.
+     */
+    void batchItemsProcessed(const QString &id, const QList<qint64> &completedItems, const QList<qint64> &failedItems, const QList<qint64> &refusedItems);
+
+    /**
+     * This is called by the PreprocessItems handler to fetch the next batch
+     * of at most @p maxBatchSize items for the preprocessor instance @p id,
+     * which is switched to batched mode.
+     *
+     * If @p firstRequest is set, the request is the first one of a new
+     * preprocessor process and the items handed out to a previous process are
+     * handed out again. If @p reportedResults is set and the instance still
+     * has items in progress, this returns immediately, so that the results of
+     * the remaining items are not held back. Otherwise this waits up to
+     * @p timeout for new items. Returns an empty list if there are no items.
+     *
+     * This function is thread-safe and blocks the calling thread.
+     */
+    QList<qint64>
+    waitForItemBatch(const QString &id, qsizetype maxBatchSize, std::chrono::milliseconds timeout, bool firstRequest = false, bool reportedResults = false);
+
+    /**
+     * Makes all waitForItemBatch() calls return, so that the connections
+     * can be closed on shutdown.
+     *
+     * This function is thread-safe.
+     */
+    void cancelBatchRequests();
+
 protected:
+    /**
+     * Creates the descriptor of the preprocessor instance @p id, which is
+     * initialized by registerInstance().
+     */
+    virtual PreprocessorInstance *createInstance(const QString &id);
+
     /**
      * This is called by PreprocessorInstance to signal that a certain preprocessor has finished
      * handling an item.
@@ -191,6 +246,11 @@ protected:
     void preProcessorFinishedHandlingItem(PreprocessorInstance *preProcessor, qint64 itemId);
 
 private:
+    /**
+     * This is the unprotected core of the preProcessorFinishedHandlingItem() function above.
+     */
+    void lockedPreProcessorFinishedHandlingItem(PreprocessorInstance *preProcessor, qint64 itemId);
+
     /**
      * Finds the preprocessor instance by its identifier.
      *
@@ -0,0 +1,139 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "protocolcapturewriter.h"
+#include "akonadiserver_debug.h"
+
+#include "private/datastream_p_p.h"
+#include "private/standarddirs_p.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QFile>
+#include <QSettings>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+ProtocolCaptureWriter::ProtocolCaptureWriter()
+{
+    const QSettings settings(StandardDirs::serverConfigFile(), QSettings::IniFormat);
+    const QString fileName = settings.value(QStringLiteral("Debug/ProtocolCaptureFile")).toString();
+    if (!fileName.isEmpty()) {
+        start(fileName, settings.value(QStringLiteral("Debug/ProtocolCaptureSessions")).toString());
+    }
+}
+
+ProtocolCaptureWriter::~ProtocolCaptureWriter()
+{
+    stop();
+}
+
+bool ProtocolCaptureWriter::start(const QString &fileName, const QString &sessionFilter)
+{
+    QRegularExpression filter(sessionFilter);
+    if (!filter.isValid()) {
+        qCWarning(AKONADISERVER_LOG) << "Invalid protocol capture session filter" << sessionFilter << ":" << filter.errorString();
+        return false;
+    }
+
+    QMutexLocker locker(&mLock);
+    stopLocked();
+
+    auto file = std::make_unique<QFile>(fileName);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to open protocol capture file" << fileName << ":" << file->errorString();
+        return false;
+    }
+    const ProtocolCapture::Header header{.startTime = QDateTime::currentMSecsSinceEpoch(), .protocolVersion = Protocol::version()};
+    if (!ProtocolCapture::writeHeader(file.get(), header)) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to write protocol capture file" << fileName << ":" << file->errorString();
+        return false;
+    }
+
+    mFile = std::move(file);
+    mSessionFilter = filter;
+    mTimer.start();
+    mActive = true;
+    qCInfo(AKONADISERVER_LOG) << "Capturing protocol of sessions matching" << sessionFilter << "to" << fileName;
+    return true;
+}
+
+void ProtocolCaptureWriter::stop()
+{
+    QMutexLocker locker(&mLock);
+    stopLocked();
+}
+
+void ProtocolCaptureWriter::stopLocked()
+{
+    if (!mFile) {
+        return;
+    }
+
+    mActive = false;
+    mSessions.clear();
+    mFile->close();
+    qCInfo(AKONADISERVER_LOG) << "Finished protocol capture" << mFile->fileName();
+    mFile.reset();
+}
+
+bool ProtocolCaptureWriter::isActive() const
+{
+    return mActive.load(std::memory_order_relaxed);
+}
+
+quint32 ProtocolCaptureWriter::beginSession(const QByteArray &sessionId)
+{
+    QMutexLocker locker(&mLock);
+    if (!mFile || !mSessionFilter.match(QString::fromUtf8(sessionId)).hasMatch()) {
+        return 0;
+    }
+
+    // Session ids are not reused by later captures, so that sessions which
+    // began before a capture was restarted are not captured by the new one
+    const quint32 session = ++mNextSession;
+    mSessions.insert(session);
+    writeRecord(ProtocolCapture::RecordType::SessionBegin, session, sessionId);
+    return session;
+}
+
+void ProtocolCaptureWriter::endSession(quint32 session)
+{
+    QMutexLocker locker(&mLock);
+    if (mSessions.remove(session)) {
+        writeRecord(ProtocolCapture::RecordType::SessionEnd, session, {});
+        mFile->flush();
+    }
+}
+
+void ProtocolCaptureWriter::captureCommand(quint32 session, qint64 tag, const Protocol::CommandPtr &command)
+{
+    // Serialize outside of the lock, the result is identical to what the client has sent
+    QByteArray data;
+    {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        Protocol::DataStream stream(&buffer);
+        stream << tag;
+        Protocol::serialize(stream, command);
+        stream.flush();
+    }
+
+    QMutexLocker locker(&mLock);
+    if (mSessions.contains(session)) {
+        writeRecord(ProtocolCapture::RecordType::Input, session, data);
+    }
+}
+
+void ProtocolCaptureWriter::writeRecord(ProtocolCapture::RecordType type, quint32 session, const QByteArray &data)
+{
+    const ProtocolCapture::Record record{.timestamp = mTimer.nsecsElapsed() / 1000, .session = session, .type = type, .data = data};
+    if (!ProtocolCapture::writeRecord(mFile.get(), record)) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to write protocol capture file" << mFile->fileName() << ":" << mFile->errorString();
+        stopLocked();
+    }
+}
@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "private/protocol_p.h"
+#include "private/protocolcapture_p.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSet>
+
+#include <atomic>
+#include <memory>
+
+class QFile;
+
+namespace Akonadi
+{
+namespace Server
+{
+/**
+ * Writes the commands of selected sessions to a protocol capture file.
+ *
+ * Unlike the Tracer, which turns every command into a debug string, the
+ * capture contains the commands in their wire format, so that the captured
+ * sessions can be replayed against another server with asapcat --replay.
+ * Only sessions which log in while the capture is running, and of which the
+ * session id matches the session filter, are captured.
+ *
+ * The capture is started on server startup if Debug/ProtocolCaptureFile is
+ * set in the server configuration, with Debug/ProtocolCaptureSessions as the
+ * session filter, or at runtime with the startProtocolCapture() D-Bus method
+ * of the DebugInterface.
+ */
+class ProtocolCaptureWriter
+{
+public:
+    explicit ProtocolCaptureWriter();
+    ~ProtocolCaptureWriter();
+
+    /**
+     * Starts writing a new capture to @p fileName, replacing the current one.
+     * @p sessionFilter is a regular expression matched against the session
+     * ids, an empty filter captures all sessions.
+     */
+    bool start(const QString &fileName, const QString &sessionFilter = QString());
+    void stop();
+
+    bool isActive() const;
+
+    /**
+     * Returns the id under which the commands of the session are captured,
+     * or 0 if the session is not captured.
+     */
+    quint32 beginSession(const QByteArray &sessionId);
+    void endSession(quint32 session);
+
+    void captureCommand(quint32 session, qint64 tag, const Protocol::CommandPtr &command);
+
+private:
+    void writeRecord(ProtocolCapture::RecordType type, quint32 session, const QByteArray &data);
+    void stopLocked();
+
+    std::atomic<bool> mActive = false;
+
+    QMutex mLock;
+    std::unique_ptr<QFile> mFile;
+    QRegularExpression mSessionFilter;
+    QSet<quint32> mSessions;
+    quint32 mNextSession = 0;
+    QElapsedTimer mTimer;
+};
+
+} // namespace Server
+} // namespace Akonadi
@@ -10,6 +10,9 @@
 #include <QSet>
 #include <QStringList>
 
+#include <algorithm>
+#include <functional>
+
 namespace Akonadi
 {
 /**
@@ -19,13 +22,33 @@ namespace Akonadi
  * provide access to their search capability.
  *
  * When the server performs a search, it will send the query to all available
- * search plugins and merge the results.
+ * search plugins and merge the results. The results are forwarded to the client
+ * as they are delivered by searchIncrementally().
  *
  * @since 1.12
  */
 class AbstractSearchPlugin
 {
 public:
+    /**
+     * A single search result.
+     *
+     * @since 6.9
+     */
+    struct SearchResult {
+        qint64 id = -1;
+        /// Relevance of the result, higher is more relevant. 0 if the plugin does not rank results.
+        double score = 0.0;
+    };
+
+    /**
+     * Receives a batch of search results. Returns @c false to cancel the search,
+     * e.g. because the client has disconnected.
+     *
+     * @since 6.9
+     */
+    using ResultCallback = std::function<bool(const QList<SearchResult> &results)>;
+
     /**
      * Destructor.
      */
@@ -42,6 +65,52 @@ public:
      */
     virtual QSet<qint64> search(const QString &query, const QList<qint64> &collections, const QStringList &mimeTypes) = 0;
 
+    /**
+     * Reimplement this method to deliver the results while the search is still
+     * running, rather than all at once when it is finished.
+     *
+     * The results are delivered in batches to @p callback. Plugins which rank
+     * their results should deliver the most relevant results first, so that a
+     * limited search returns the best matches. The search must stop as soon as
+     * @p callback returns @c false.
+     *
+     * The default implementation delivers the results of search() in batches.
+     *
+     * The implementation can block.
+     *
+     * @param query Search query to execute.
+     * @param limit Maximum number of results to deliver, -1 for no limit.
+     * @param callback Receives the batches of results.
+     * @return @c false if the search was cancelled by @p callback.
+     * @since 6.9
+     */
+    virtual bool searchIncrementally(const QString &query,
+                                     const QList<qint64> &collections,
+                                     const QStringList &mimeTypes,
+                                     int limit,
+                                     const ResultCallback &callback)
+    {
+        constexpr qsizetype batchSize = 1000;
+        const QSet<qint64> ids = search(query, collections, mimeTypes);
+        QList<SearchResult> batch;
+        batch.reserve(std::min(batchSize, ids.size()));
+        qsizetype delivered = 0;
+        for (const qint64 id : ids) {
+            if (limit >= 0 && delivered + batch.size() >= limit) {
+                break;
+            }
+            batch.push_back({id, 0.0});
+            if (batch.size() == batchSize) {
+                delivered += batch.size();
+                if (!callback(batch)) {
+                    return false;
+                }
+                batch.clear();
+            }
+        }
+        return batch.isEmpty() || callback(batch);
+    }
+
 protected:
     explicit AbstractSearchPlugin() = default;
 
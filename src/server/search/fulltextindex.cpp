@@ -0,0 +1,658 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "fulltextindex.h"
+#include "akonadiserver_search_debug.h"
+
+#include "private/standarddirs_p.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringDecoder>
+
+#include <algorithm>
+#include <atomic>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+namespace
+{
+std::atomic<int> sConnectionCounter = 0;
+
+// Limits the size of the index for huge text bodies, e.g. logs sent by mail
+constexpr qsizetype MaxBodyLength = 256 * 1024;
+// Nested multiparts deeper than this are not indexed
+constexpr int MaxMimeDepth = 8;
+// Results delivered to the callback of a search at once
+constexpr qsizetype ResultBatchSize = 500;
+
+// Values of SearchTerm::Relation and SearchTerm::Condition
+constexpr int RelOr = 1;
+constexpr int CondEqual = 0;
+constexpr int CondContains = 5;
+
+using Headers = QList<std::pair<QByteArray, QByteArray>>;
+
+Headers parseHeaders(const QByteArray &data, qsizetype &bodyStart)
+{
+    Headers headers;
+    qsizetype pos = 0;
+    while (pos < data.size()) {
+        qsizetype end = data.indexOf('\n', pos);
+        if (end < 0) {
+            end = data.size();
+        }
+        QByteArray line = data.mid(pos, end - pos);
+        pos = end + 1;
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        if (line.isEmpty()) {
+            break;
+        }
+        if ((line.startsWith(' ') || line.startsWith('\t')) && !headers.isEmpty()) {
+            // Unfold continuation lines
+            headers.last().second += ' ' + line.trimmed();
+            continue;
+        }
+        const qsizetype colon = line.indexOf(':');
+        if (colon <= 0) {
+            continue;
+        }
+        headers.push_back({line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed()});
+    }
+    bodyStart = std::min(pos, data.size());
+    return headers;
+}
+
+QByteArray headerValue(const Headers &headers, const char *name)
+{
+    for (const auto &[key, value] : headers) {
+        if (key == name) {
+            return value;
+        }
+    }
+    return {};
+}
+
+QByteArray headerParameter(const QByteArray &value, const char *name)
+{
+    const QList<QByteArray> params = value.split(';');
+    for (qsizetype i = 1; i < params.size(); ++i) {
+        const QByteArray param = params[i].trimmed();
+        const qsizetype eq = param.indexOf('=');
+        if (eq > 0 && param.left(eq).trimmed().toLower() == name) {
+            QByteArray paramValue = param.mid(eq + 1).trimmed();
+            if (paramValue.size() >= 2 && paramValue.startsWith('"') && paramValue.endsWith('"')) {
+                paramValue = paramValue.mid(1, paramValue.size() - 2);
+            }
+            return paramValue;
+        }
+    }
+    return {};
+}
+
+QString decodeCharset(const QByteArray &data, const QByteArray &charset)
+{
+    if (!charset.isEmpty()) {
+        QStringDecoder decoder(charset.constData());
+        if (decoder.isValid()) {
+            return decoder.decode(data);
+        }
+    }
+    // Unknown charsets are most likely a superset of ASCII
+    QStringDecoder utf8(QStringDecoder::Utf8);
+    const QString text = utf8.decode(data);
+    return utf8.hasError() ? QString::fromLatin1(data) : text;
+}
+
+QByteArray decodeQuotedPrintable(const QByteArray &data, bool underscoreIsSpace)
+{
+    QByteArray result;
+    result.reserve(data.size());
+    for (qsizetype i = 0; i < data.size(); ++i) {
+        const char c = data[i];
+        if (c == '=' && i + 1 < data.size()) {
+            if (data[i + 1] == '\n') {
+                ++i;
+                continue;
+            }
+            if (data[i + 1] == '\r' && i + 2 < data.size() && data[i + 2] == '\n') {
+                i += 2;
+                continue;
+            }
+            bool ok = false;
+            const int byte = data.mid(i + 1, 2).toInt(&ok, 16);
+            if (ok) {
+                result.append(static_cast<char>(byte));
+                i += 2;
+                continue;
+            }
+        }
+        result.append(underscoreIsSpace && c == '_' ? ' ' : c);
+    }
+    return result;
+}
+
+/// Decodes RFC 2047 encoded words in a header value
+QString decodeHeader(const QByteArray &value)
+{
+    static const QRegularExpression encodedWord(QStringLiteral(R"(=\?([^?]+)\?([bBqQ])\?([^?]*)\?=(\s+(?==\?))?)"));
+    const QString raw = QString::fromLatin1(value);
+    QString result;
+    qsizetype pos = 0;
+    auto it = encodedWord.globalMatch(raw);
+    while (it.hasNext()) {
+        const auto match = it.next();
+        result += raw.mid(pos, match.capturedStart() - pos);
+        const QByteArray charset = match.captured(1).toLatin1().split('*').first();
+        const QByteArray text = match.captured(3).toLatin1();
+        const QByteArray decoded =
+            match.captured(2).compare(QLatin1StringView("B"), Qt::CaseInsensitive) == 0 ? QByteArray::fromBase64(text) : decodeQuotedPrintable(text, true);
+        result += decodeCharset(decoded, charset);
+        pos = match.capturedEnd();
+    }
+    if (pos == 0) {
+        return decodeCharset(value, {});
+    }
+    result += raw.mid(pos);
+    return result;
+}
+
+QString stripHtml(const QString &html)
+{
+    static const QRegularExpression scripts(QStringLiteral("<(script|style)[^>]*>.*?</\\1>"),
+                                            QRegularExpression::CaseInsensitiveOption | QRegularExpression::DotMatchesEverythingOption);
+    static const QRegularExpression tags(QStringLiteral("<[^>]*>"));
+    QString text = html;
+    text.remove(scripts);
+    text.replace(tags, QStringLiteral(" "));
+    return text.replace(QLatin1StringView("&nbsp;"), QLatin1StringView(" "))
+        .replace(QLatin1StringView("&lt;"), QLatin1StringView("<"))
+        .replace(QLatin1StringView("&gt;"), QLatin1StringView(">"))
+        .replace(QLatin1StringView("&quot;"), QLatin1StringView("\""))
+        .replace(QLatin1StringView("&amp;"), QLatin1StringView("&"));
+}
+
+void extractText(const Headers &headers, const QByteArray &body, int depth, QString &text)
+{
+    const QByteArray contentType = headerValue(headers, "content-type");
+    const QByteArray mimeType = contentType.split(';').first().trimmed().toLower();
+
+    if (mimeType.startsWith("multipart/")) {
+        const QByteArray boundary = headerParameter(contentType, "boundary");
+        if (boundary.isEmpty() || depth >= MaxMimeDepth) {
+            return;
+        }
+        const QByteArray delimiter = "--" + boundary;
+        qsizetype pos = body.indexOf(delimiter);
+        while (pos >= 0 && text.size() < MaxBodyLength) {
+            pos += delimiter.size();
+            if (body.mid(pos, 2) == "--") {
+                break;
+            }
+            // The part starts on the line after the delimiter, a part without headers with an empty line
+            const qsizetype lineEnd = body.indexOf('\n', pos);
+            if (lineEnd < 0) {
+                break;
+            }
+            pos = lineEnd + 1;
+            const qsizetype next = body.indexOf(delimiter, pos);
+            const QByteArray part = body.mid(pos, next < 0 ? -1 : next - pos);
+            qsizetype partBodyStart = 0;
+            const Headers partHeaders = parseHeaders(part, partBodyStart);
+            extractText(partHeaders, part.mid(partBodyStart), depth + 1, text);
+            pos = next;
+        }
+        return;
+    }
+
+    if (!mimeType.isEmpty() && !mimeType.startsWith("text/")) {
+        return;
+    }
+    // Attachments which happen to be text are not part of the body
+    if (headerValue(headers, "content-disposition").trimmed().toLower().startsWith("attachment")) {
+        return;
+    }
+
+    const QByteArray encoding = headerValue(headers, "content-transfer-encoding").trimmed().toLower();
+    QByteArray decoded;
+    if (encoding == "base64") {
+        decoded = QByteArray::fromBase64(body);
+    } else if (encoding == "quoted-printable") {
+        decoded = decodeQuotedPrintable(body, false);
+    } else {
+        decoded = body;
+    }
+
+    QString partText = decodeCharset(decoded, headerParameter(contentType, "charset"));
+    if (mimeType == "text/html") {
+        partText = stripHtml(partText);
+    }
+    if (!text.isEmpty()) {
+        text += u'\n';
+    }
+    text += partText;
+}
+
+QStringList tokenize(const QString &value)
+{
+    static const QRegularExpression separators(QStringLiteral("[^\\w]+"), QRegularExpression::UseUnicodePropertiesOption);
+    return value.split(separators, Qt::SkipEmptyParts);
+}
+
+QString columnFilter(const QString &key)
+{
+    if (key == QLatin1StringView("subject")) {
+        return QStringLiteral("subject");
+    }
+    if (key == QLatin1StringView("from") || key == QLatin1StringView("replyto") || key == QLatin1StringView("resentfrom")
+        || key == QLatin1StringView("organization")) {
+        return QStringLiteral("sender");
+    }
+    if (key == QLatin1StringView("to") || key == QLatin1StringView("cc") || key == QLatin1StringView("bcc")) {
+        return QStringLiteral("recipients");
+    }
+    if (key == QLatin1StringView("headers")) {
+        return QStringLiteral("{subject sender recipients}");
+    }
+    // Contacts and incidences are indexed as a whole
+    if (key == QLatin1StringView("body") || key == QLatin1StringView("name") || key == QLatin1StringView("nickname") || key == QLatin1StringView("email")
+        || key == QLatin1StringView("uid") || key == QLatin1StringView("summary") || key == QLatin1StringView("location")
+        || key == QLatin1StringView("organizer") || key == QLatin1StringView("partstatus")) {
+        return QStringLiteral("body");
+    }
+    if (key == QLatin1StringView("message") || key == QLatin1StringView("all")) {
+        // No filter, all columns
+        return QStringLiteral("");
+    }
+    return {};
+}
+
+/**
+ * Translates a SearchQuery term into an SQL condition on the items table.
+ * Returns a null string when the term cannot be answered from the index.
+ *
+ * The MATCH expressions of the terms which are not negated are collected in
+ * @p rankExpressions, they determine the relevance of the results.
+ */
+QString translateTerm(const QJsonObject &term, QVariantList &bindValues, QStringList &rankExpressions)
+{
+    const bool negated = term.value(QLatin1StringView("negated")).toBool();
+
+    if (term.contains(QLatin1StringView("key"))) {
+        const QString columns = columnFilter(term.value(QLatin1StringView("key")).toString());
+        const int condition = term.value(QLatin1StringView("cond")).toInt();
+        const QStringList tokens = tokenize(term.value(QLatin1StringView("value")).toVariant().toString());
+        if (columns.isNull() || tokens.isEmpty() || (condition != CondEqual && condition != CondContains)) {
+            return {};
+        }
+
+        // Tokens consist of word characters only, quoting them is enough to escape them
+        QString expression;
+        if (condition == CondEqual) {
+            expression = u'"' + tokens.join(u' ') + u'"';
+        } else {
+            QStringList prefixes;
+            prefixes.reserve(tokens.size());
+            for (const QString &token : tokens) {
+                prefixes.push_back(u'"' + token + QStringLiteral("\"*"));
+            }
+            expression = prefixes.join(u' ');
+        }
+        if (!columns.isEmpty()) {
+            expression = columns + QStringLiteral(" : (") + expression + u')';
+        }
+        bindValues.push_back(expression);
+        if (!negated) {
+            rankExpressions.push_back(expression);
+        }
+        return QStringLiteral("items.id %1IN (SELECT rowid FROM content WHERE content MATCH ?)").arg(negated ? QStringLiteral("NOT ") : QString());
+    }
+
+    const bool isOr = term.value(QLatin1StringView("rel")).toInt() == RelOr;
+    const QJsonArray subTerms = term.value(QLatin1StringView("subTerms")).toArray();
+    QStringList conditions;
+    QStringList groupRankExpressions;
+    for (const auto &subTerm : subTerms) {
+        QVariantList subBindValues;
+        QStringList subRankExpressions;
+        const QString condition = translateTerm(subTerm.toObject(), subBindValues, subRankExpressions);
+        if (condition.isNull()) {
+            // Leaving out a term would add matches to an AND group and remove matches from an OR
+            // group, and nothing filters the results afterwards
+            return {};
+        }
+        conditions.push_back(condition);
+        bindValues.append(subBindValues);
+        groupRankExpressions.append(subRankExpressions);
+    }
+    if (conditions.isEmpty()) {
+        return {};
+    }
+    if (!negated) {
+        rankExpressions.append(groupRankExpressions);
+    }
+    const QString group = u'(' + conditions.join(isOr ? QStringLiteral(" OR ") : QStringLiteral(" AND ")) + u')';
+    return negated ? QStringLiteral("NOT ") + group : group;
+}
+
+} // namespace
+
+FullTextIndex::FullTextIndex(const QString &fileName)
+    : mFileName(fileName)
+    , mConnectionName(QStringLiteral("FullTextIndex-%1").arg(sConnectionCounter++))
+{
+}
+
+FullTextIndex::~FullTextIndex()
+{
+    if (mDatabase.isValid()) {
+        mDatabase.close();
+        mDatabase = QSqlDatabase();
+        QSqlDatabase::removeDatabase(mConnectionName);
+    }
+}
+
+QString FullTextIndex::defaultFileName()
+{
+    return StandardDirs::saveDir("data", QStringLiteral("search")) + QStringLiteral("/fulltext.db");
+}
+
+bool FullTextIndex::exec(const QString &statement)
+{
+    QSqlQuery query(mDatabase);
+    if (!query.exec(statement)) {
+        qCWarning(AKONADISERVER_SEARCH_LOG) << "Full-text index query" << statement << "failed:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool FullTextIndex::open(OpenMode mode)
+{
+    if (isOpen()) {
+        return true;
+    }
+
+    mDatabase = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), mConnectionName);
+    mDatabase.setDatabaseName(mFileName);
+    if (mode == OpenMode::ReadOnly) {
+        mDatabase.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+    }
+    if (!mDatabase.open()) {
+        qCWarning(AKONADISERVER_SEARCH_LOG) << "Failed to open the full-text index" << mFileName << ":" << mDatabase.lastError().text();
+        return false;
+    }
+
+    if (mode == OpenMode::ReadOnly) {
+        // The journal mode is persistent and the tables are created by the indexer,
+        // this only fails if the index is incomplete or SQLite lacks FTS5
+        if (!exec(QStringLiteral("SELECT 1 FROM items, content LIMIT 0"))) {
+            mDatabase.close();
+            return false;
+        }
+        return true;
+    }
+
+    if (!exec(QStringLiteral("PRAGMA journal_mode=WAL")) || !exec(QStringLiteral("PRAGMA synchronous=NORMAL"))
+        || !exec(QStringLiteral("CREATE TABLE IF NOT EXISTS items (id INTEGER PRIMARY KEY, collection INTEGER NOT NULL, mimetype TEXT NOT NULL)"))
+        || !exec(QStringLiteral("CREATE INDEX IF NOT EXISTS items_collection ON items (collection)"))
+        || !exec(QStringLiteral("CREATE TABLE IF NOT EXISTS meta (key TEXT PRIMARY KEY, value TEXT)"))) {
+        mDatabase.close();
+        return false;
+    }
+
+    if (!exec(QStringLiteral("CREATE VIRTUAL TABLE IF NOT EXISTS content USING fts5(subject, sender, recipients, body, "
+                             "tokenize = 'unicode61 remove_diacritics 2')"))) {
+        qCWarning(AKONADISERVER_SEARCH_LOG) << "The full-text index requires SQLite with the FTS5 extension";
+        mDatabase.close();
+        return false;
+    }
+    return true;
+}
+
+bool FullTextIndex::isOpen() const
+{
+    return mDatabase.isValid() && mDatabase.isOpen();
+}
+
+bool FullTextIndex::addDocuments(const QList<Document> &documents)
+{
+    if (!isOpen() || !mDatabase.transaction()) {
+        return false;
+    }
+
+    QSqlQuery removeContent(mDatabase);
+    removeContent.prepare(QStringLiteral("DELETE FROM content WHERE rowid = ?"));
+    QSqlQuery insertItem(mDatabase);
+    insertItem.prepare(QStringLiteral("INSERT OR REPLACE INTO items (id, collection, mimetype) VALUES (?, ?, ?)"));
+    QSqlQuery insertContent(mDatabase);
+    insertContent.prepare(QStringLiteral("INSERT INTO content (rowid, subject, sender, recipients, body) VALUES (?, ?, ?, ?, ?)"));
+
+    for (const Document &document : documents) {
+        removeContent.bindValue(0, document.id);
+        insertItem.bindValue(0, document.id);
+        insertItem.bindValue(1, document.collectionId);
+        insertItem.bindValue(2, document.mimeType);
+        insertContent.bindValue(0, document.id);
+        insertContent.bindValue(1, document.subject);
+        insertContent.bindValue(2, document.sender);
+        insertContent.bindValue(3, document.recipients);
+        insertContent.bindValue(4, document.body.left(MaxBodyLength));
+        if (!removeContent.exec() || !insertItem.exec() || !insertContent.exec()) {
+            qCWarning(AKONADISERVER_SEARCH_LOG) << "Failed to index item" << document.id << ":" << removeContent.lastError().text()
+                                                << insertItem.lastError().text() << insertContent.lastError().text();
+            mDatabase.rollback();
+            return false;
+        }
+    }
+    return mDatabase.commit();
+}
+
+bool FullTextIndex::removeDocuments(const QList<qint64> &ids)
+{
+    if (!isOpen() || !mDatabase.transaction()) {
+        return false;
+    }
+
+    QSqlQuery removeItem(mDatabase);
+    removeItem.prepare(QStringLiteral("DELETE FROM items WHERE id = ?"));
+    QSqlQuery removeContent(mDatabase);
+    removeContent.prepare(QStringLiteral("DELETE FROM content WHERE rowid = ?"));
+    for (const qint64 id : ids) {
+        removeItem.bindValue(0, id);
+        removeContent.bindValue(0, id);
+        if (!removeItem.exec() || !removeContent.exec()) {
+            qCWarning(AKONADISERVER_SEARCH_LOG) << "Failed to remove item" << id << "from the full-text index";
+            mDatabase.rollback();
+            return false;
+        }
+    }
+    return mDatabase.commit();
+}
+
+bool FullTextIndex::moveDocuments(const QList<qint64> &ids, qint64 collectionId)
+{
+    if (!isOpen() || !mDatabase.transaction()) {
+        return false;
+    }
+
+    QSqlQuery query(mDatabase);
+    query.prepare(QStringLiteral("UPDATE items SET collection = ? WHERE id = ?"));
+    for (const qint64 id : ids) {
+        query.bindValue(0, collectionId);
+        query.bindValue(1, id);
+        if (!query.exec()) {
+            qCWarning(AKONADISERVER_SEARCH_LOG) << "Failed to move item" << id << "in the full-text index:" << query.lastError().text();
+            mDatabase.rollback();
+            return false;
+        }
+    }
+    return mDatabase.commit();
+}
+
+QSet<qint64> FullTextIndex::search(const QString &query, const QList<qint64> &collections, const QStringList &mimeTypes)
+{
+    QSet<qint64> result;
+    search(query, collections, mimeTypes, -1, [&result](const QList<AbstractSearchPlugin::SearchResult> &results) {
+        for (const auto &searchResult : results) {
+            result.insert(searchResult.id);
+        }
+        return true;
+    });
+    return result;
+}
+
+bool FullTextIndex::search(const QString &query,
+                           const QList<qint64> &collections,
+                           const QStringList &mimeTypes,
+                           int limit,
+                           const AbstractSearchPlugin::ResultCallback &callback)
+{
+    if (!isOpen()) {
+        return true;
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(query.toUtf8()).object();
+    QVariantList bindValues;
+    QStringList rankExpressions;
+    const QString condition = translateTerm(root, bindValues, rankExpressions);
+    if (condition.isNull()) {
+        qCDebug(AKONADISERVER_SEARCH_LOG) << "Query cannot be answered by the full-text index:" << query;
+        return true;
+    }
+
+    // Results matching none of the positive terms, e.g. of NOT terms in an OR group, are not ranked and come last
+    QString statement;
+    if (rankExpressions.isEmpty()) {
+        statement = QStringLiteral("SELECT items.id, NULL FROM items WHERE ") + condition;
+    } else {
+        statement = QStringLiteral("SELECT items.id, ranking.rank FROM items "
+                                   "LEFT JOIN (SELECT rowid, rank FROM content WHERE content MATCH ?) AS ranking ON ranking.rowid = items.id WHERE ")
+            + condition;
+        bindValues.prepend(u'(' + rankExpressions.join(QStringLiteral(") OR (")) + u')');
+    }
+    if (!collections.isEmpty()) {
+        QStringList ids;
+        ids.reserve(collections.size());
+        for (const qint64 collection : collections) {
+            ids.push_back(QString::number(collection));
+        }
+        statement += QStringLiteral(" AND items.collection IN (%1)").arg(ids.join(u','));
+    }
+    if (!mimeTypes.isEmpty()) {
+        statement += QStringLiteral(" AND items.mimetype IN (%1)").arg(QStringList(mimeTypes.size(), QStringLiteral("?")).join(u','));
+        for (const QString &mimeType : mimeTypes) {
+            bindValues.push_back(mimeType);
+        }
+    }
+    if (!rankExpressions.isEmpty()) {
+        statement += QStringLiteral(" ORDER BY ranking.rank IS NULL, ranking.rank");
+    }
+    // The limit of the query and the limit of the caller, whichever is lower
+    const int queryLimit = root.value(QLatin1StringView("limit")).toInt(-1);
+    if (queryLimit > 0 && (limit < 0 || queryLimit < limit)) {
+        limit = queryLimit;
+    }
+    if (limit >= 0) {
+        statement += QStringLiteral(" LIMIT %1").arg(limit);
+    }
+
+    QSqlQuery sqlQuery(mDatabase);
+    sqlQuery.setForwardOnly(true);
+    sqlQuery.prepare(statement);
+    for (const QVariant &value : std::as_const(bindValues)) {
+        sqlQuery.addBindValue(value);
+    }
+    if (!sqlQuery.exec()) {
+        qCWarning(AKONADISERVER_SEARCH_LOG) << "Full-text search failed:" << sqlQuery.lastError().text() << statement;
+        return true;
+    }
+
+    QList<AbstractSearchPlugin::SearchResult> batch;
+    batch.reserve(ResultBatchSize);
+    while (sqlQuery.next()) {
+        // bm25() is negative, the more negative the more relevant
+        const QVariant rank = sqlQuery.value(1);
+        batch.push_back({sqlQuery.value(0).toLongLong(), rank.isNull() ? 0.0 : -rank.toDouble()});
+        if (batch.size() == ResultBatchSize) {
+            if (!callback(batch)) {
+                return false;
+            }
+            batch.clear();
+        }
+    }
+    return batch.isEmpty() || callback(batch);
+}
+
+qint64 FullTextIndex::documentCount()
+{
+    if (!isOpen()) {
+        return 0;
+    }
+    QSqlQuery query(mDatabase);
+    if (!query.exec(QStringLiteral("SELECT COUNT(*) FROM items")) || !query.next()) {
+        return 0;
+    }
+    return query.value(0).toLongLong();
+}
+
+QString FullTextIndex::metaData(const QString &key, const QString &defaultValue)
+{
+    if (!isOpen()) {
+        return defaultValue;
+    }
+    QSqlQuery query(mDatabase);
+    query.prepare(QStringLiteral("SELECT value FROM meta WHERE key = ?"));
+    query.addBindValue(key);
+    if (!query.exec() || !query.next()) {
+        return defaultValue;
+    }
+    return query.value(0).toString();
+}
+
+bool FullTextIndex::setMetaData(const QString &key, const QString &value)
+{
+    if (!isOpen()) {
+        return false;
+    }
+    QSqlQuery query(mDatabase);
+    query.prepare(QStringLiteral("INSERT OR REPLACE INTO meta (key, value) VALUES (?, ?)"));
+    query.addBindValue(key);
+    query.addBindValue(value);
+    return query.exec();
+}
+
+FullTextIndex::Document FullTextIndex::documentFromMessage(const QByteArray &message)
+{
+    qsizetype bodyStart = 0;
+    const Headers headers = parseHeaders(message, bodyStart);
+
+    Document document;
+    document.subject = decodeHeader(headerValue(headers, "subject"));
+
+    QStringList senders;
+    QStringList recipients;
+    for (const auto &[key, value] : headers) {
+        if (key == "from" || key == "sender" || key == "reply-to" || key == "resent-from" || key == "organization") {
+            senders.push_back(decodeHeader(value));
+        } else if (key == "to" || key == "cc" || key == "bcc") {
+            recipients.push_back(decodeHeader(value));
+        }
+    }
+    document.sender = senders.join(u'\n');
+    document.recipients = recipients.join(u'\n');
+
+    extractText(headers, message.mid(bodyStart), 0, document.body);
+    document.body.truncate(MaxBodyLength);
+    return document;
+}
@@ -0,0 +1,127 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "abstractsearchplugin.h"
+
+#include <QList>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+namespace Akonadi
+{
+namespace Server
+{
+/**
+ * A full-text index of items, stored in an SQLite database using the FTS5
+ * extension.
+ *
+ * The index holds the envelope (subject, senders, recipients) and the text
+ * body of every indexed item, together with its collection and MIME type, so
+ * that searches can be restricted to collections and MIME types without
+ * querying the Akonadi database.
+ *
+ * Each FullTextIndex owns its own database connection and must only be used
+ * from the thread in which it was created. Multiple connections to the same
+ * index file can be used in parallel, the database is in WAL mode.
+ */
+class FullTextIndex
+{
+public:
+    enum class OpenMode {
+        /// Creates the tables of the index if needed
+        ReadWrite,
+        /// Only for searching an index which has been created before
+        ReadOnly,
+    };
+
+    struct Document {
+        qint64 id = -1;
+        qint64 collectionId = -1;
+        QString mimeType;
+        QString subject;
+        QString sender;
+        QString recipients;
+        QString body;
+    };
+
+    /**
+     * Creates an index stored in @p fileName. Call open() before using it.
+     */
+    explicit FullTextIndex(const QString &fileName = defaultFileName());
+    ~FullTextIndex();
+
+    /**
+     * Opens the index and, in ReadWrite @p mode, creates its tables if needed.
+     * Returns false when the database cannot be opened, when SQLite was built
+     * without FTS5, or in ReadOnly mode when the index has not been created yet.
+     */
+    bool open(OpenMode mode = OpenMode::ReadWrite);
+    bool isOpen() const;
+
+    /**
+     * Adds the @p documents to the index, replacing already indexed documents
+     * with the same id.
+     */
+    bool addDocuments(const QList<Document> &documents);
+    bool removeDocuments(const QList<qint64> &ids);
+    bool moveDocuments(const QList<qint64> &ids, qint64 collectionId);
+
+    /**
+     * Returns the ids of the documents matching the SearchQuery JSON @p query,
+     * restricted to the @p collections and @p mimeTypes when they are not empty.
+     *
+     * A query containing any term which cannot be answered from the index
+     * (e.g. dates, sizes, flags or tags) matches nothing, regardless of how
+     * the term is combined with the others.
+     */
+    QSet<qint64> search(const QString &query, const QList<qint64> &collections, const QStringList &mimeTypes);
+
+    /**
+     * Delivers the ids of the documents matching @p query to @p callback in
+     * batches, the most relevant documents first. The relevance is determined
+     * by the terms which are not negated.
+     *
+     * At most @p limit results are delivered, or the limit of the query if it
+     * is lower. Returns @c false if the search was cancelled by @p callback.
+     */
+    bool search(const QString &query,
+                const QList<qint64> &collections,
+                const QStringList &mimeTypes,
+                int limit,
+                const AbstractSearchPlugin::ResultCallback &callback);
+
+    qint64 documentCount();
+
+    /**
+     * Returns the value stored under @p key in the index, used by the
+     * indexer to persist its progress.
+     */
+    QString metaData(const QString &key, const QString &defaultValue = {});
+    bool setMetaData(const QString &key, const QString &value);
+
+    /**
+     * Extracts the envelope and the text body from an RFC 822 message.
+     */
+    static Document documentFromMessage(const QByteArray &message);
+
+    static QString defaultFileName();
+
+private:
+    Q_DISABLE_COPY_MOVE(FullTextIndex)
+
+    bool exec(const QString &statement);
+
+    QString mFileName;
+    QString mConnectionName;
+    QSqlDatabase mDatabase;
+};
+
+} // namespace Server
+} // namespace Akonadi
@@ -0,0 +1,307 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "fulltextindexer.h"
+#include "akonadiserver_search_debug.h"
+#include "entities.h"
+#include "storage/datastore.h"
+#include "storage/parthelper.h"
+#include "storage/selectquerybuilder.h"
+
+#include "private/standarddirs_p.h"
+
+#include <QSettings>
+#include <QTimer>
+
+#include <algorithm>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Items indexed in a single transaction
+constexpr int BatchSize = 500;
+// Collects the notifications of a synchronization before indexing them
+constexpr auto ProcessDelay = 1s;
+// Gives the server some air between the batches of existing items
+constexpr auto BackfillInterval = 200ms;
+
+const auto BackfillPositionKey = QStringLiteral("backfillPosition");
+const auto BackfillDoneKey = QStringLiteral("backfillDone");
+
+} // namespace
+
+FullTextIndexer::FullTextIndexer(const QString &indexFileName, StartMode startMode)
+    : AkThread(QStringLiteral("FullTextIndexer"), startMode, QThread::LowPriority)
+    , mIndexFileName(indexFileName)
+{
+}
+
+FullTextIndexer::~FullTextIndexer()
+{
+    quitThread();
+}
+
+bool FullTextIndexer::isEnabled()
+{
+    const QSettings settings(StandardDirs::serverConfigFile(), QSettings::IniFormat);
+    return settings.value(QStringLiteral("Search/FullTextIndex"), false).toBool();
+}
+
+QString FullTextIndexer::indexFileName() const
+{
+    return mIndexFileName;
+}
+
+void FullTextIndexer::init()
+{
+    AkThread::init();
+
+    auto index = std::make_unique<FullTextIndex>(mIndexFileName);
+    if (!index->open()) {
+        qCWarning(AKONADISERVER_SEARCH_LOG) << "Failed to open the full-text index, items will not be indexed";
+        return;
+    }
+    mIndex = std::move(index);
+    mBackfillDone = mIndex->metaData(BackfillDoneKey) == QLatin1StringView("true");
+    qCInfo(AKONADISERVER_SEARCH_LOG) << "Full-text index" << mIndexFileName << "contains" << mIndex->documentCount() << "items";
+
+    mProcessTimer = new QTimer(this);
+    mProcessTimer->setSingleShot(true);
+    connect(mProcessTimer, &QTimer::timeout, this, &FullTextIndexer::processPendingChanges);
+    if (!mBackfillDone) {
+        mProcessTimer->start(BackfillInterval);
+    }
+}
+
+void FullTextIndexer::quit()
+{
+    delete mProcessTimer;
+    mProcessTimer = nullptr;
+    mIndex.reset();
+
+    AkThread::quit();
+}
+
+void FullTextIndexer::notify(const Protocol::ChangeNotificationList &msgs)
+{
+    bool changed = false;
+    {
+        QMutexLocker locker(&mLock);
+        for (const auto &msg : msgs) {
+            if (msg->type() != Protocol::Command::ItemChangeNotification) {
+                continue;
+            }
+            const auto &itemMsg = static_cast<const Protocol::ItemChangeNotification &>(*msg);
+            Change change;
+            switch (itemMsg.operation()) {
+            case Protocol::ItemChangeNotification::Add:
+                break;
+            case Protocol::ItemChangeNotification::Modify: {
+                // Changes of attributes only do not change the indexed content
+                const auto parts = itemMsg.itemParts();
+                if (!parts.isEmpty() && std::none_of(parts.cbegin(), parts.cend(), [](const QByteArray &part) {
+                        return part.startsWith("PLD:");
+                    })) {
+                    continue;
+                }
+                break;
+            }
+            case Protocol::ItemChangeNotification::Move:
+                change = {ChangeType::Move, itemMsg.parentDestCollection()};
+                break;
+            case Protocol::ItemChangeNotification::Remove:
+                change.type = ChangeType::Remove;
+                break;
+            default:
+                continue;
+            }
+
+            const auto items = itemMsg.items();
+            for (const auto &item : items) {
+                // A pending update reads the current collection anyway
+                const auto pending = mPendingChanges.constFind(item.id());
+                if (change.type == ChangeType::Move && pending != mPendingChanges.cend() && pending->type == ChangeType::Update) {
+                    continue;
+                }
+                mPendingChanges.insert(item.id(), change);
+            }
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        QMetaObject::invokeMethod(this, &FullTextIndexer::scheduleProcessing, Qt::QueuedConnection);
+    }
+}
+
+void FullTextIndexer::scheduleProcessing()
+{
+    if (!mProcessTimer) {
+        QMutexLocker locker(&mLock);
+        mPendingChanges.clear();
+        return;
+    }
+    if (!mProcessTimer->isActive()) {
+        mProcessTimer->start(ProcessDelay);
+    }
+}
+
+void FullTextIndexer::processPendingChanges()
+{
+    QHash<qint64, Change> changes;
+    bool hasMore = false;
+    {
+        QMutexLocker locker(&mLock);
+        if (mPendingChanges.size() <= BatchSize) {
+            changes = std::exchange(mPendingChanges, {});
+        } else {
+            for (auto it = mPendingChanges.begin(); it != mPendingChanges.end() && changes.size() < BatchSize;) {
+                changes.insert(it.key(), it.value());
+                it = mPendingChanges.erase(it);
+            }
+            hasMore = true;
+        }
+    }
+
+    if (changes.isEmpty()) {
+        if (!mBackfillDone && backfill()) {
+            mProcessTimer->start(BackfillInterval);
+        }
+        return;
+    }
+
+    QList<qint64> updated;
+    QList<qint64> removed;
+    QHash<qint64, QList<qint64>> moved;
+    for (auto it = changes.cbegin(), end = changes.cend(); it != end; ++it) {
+        switch (it->type) {
+        case ChangeType::Update:
+            updated.push_back(it.key());
+            break;
+        case ChangeType::Move:
+            moved[it->collectionId].push_back(it.key());
+            break;
+        case ChangeType::Remove:
+            removed.push_back(it.key());
+            break;
+        }
+    }
+
+    if (!removed.isEmpty()) {
+        mIndex->removeDocuments(removed);
+    }
+    for (auto it = moved.cbegin(), end = moved.cend(); it != end; ++it) {
+        mIndex->moveDocuments(*it, it.key());
+    }
+    if (!updated.isEmpty()) {
+        const auto documents = loadDocuments(updated);
+        mIndex->addDocuments(documents);
+        qCDebug(AKONADISERVER_SEARCH_LOG) << "Indexed" << documents.size() << "of" << updated.size() << "changed items";
+    }
+
+    if (hasMore) {
+        mProcessTimer->start(0ms);
+    } else if (!mBackfillDone) {
+        mProcessTimer->start(BackfillInterval);
+    }
+}
+
+bool FullTextIndexer::backfill()
+{
+    const qint64 position = mIndex->metaData(BackfillPositionKey, QStringLiteral("0")).toLongLong();
+
+    QueryBuilder qb(PimItem::tableName());
+    qb.addColumn(PimItem::idColumn());
+    qb.addValueCondition(PimItem::idColumn(), Query::Greater, position);
+    qb.addSortColumn(PimItem::idColumn());
+    qb.setLimit(BatchSize);
+    if (!qb.exec()) {
+        qCWarning(AKONADISERVER_SEARCH_LOG) << "Failed to query the items to index";
+        return false;
+    }
+    QList<qint64> ids;
+    ids.reserve(BatchSize);
+    while (qb.query().next()) {
+        ids.push_back(qb.query().value(0).toLongLong());
+    }
+    qb.query().finish();
+
+    if (ids.isEmpty()) {
+        mBackfillDone = true;
+        mIndex->setMetaData(BackfillDoneKey, QStringLiteral("true"));
+        qCInfo(AKONADISERVER_SEARCH_LOG) << "Finished indexing existing items, the full-text index contains" << mIndex->documentCount() << "items";
+        return false;
+    }
+
+    if (!mIndex->addDocuments(loadDocuments(ids))) {
+        return false;
+    }
+    mIndex->setMetaData(BackfillPositionKey, QString::number(ids.last()));
+    return true;
+}
+
+QList<FullTextIndex::Document> FullTextIndexer::loadDocuments(const QList<qint64> &ids)
+{
+    SelectQueryBuilder<Part> partQb;
+    partQb.addJoin(QueryBuilder::InnerJoin, PartType::tableName(), Part::partTypeIdFullColumnName(), PartType::idFullColumnName());
+    partQb.addValueCondition(Part::pimItemIdFullColumnName(), Query::In, QVariant::fromValue(ids));
+    partQb.addValueCondition(PartType::nsFullColumnName(), Query::Equals, QLatin1StringView("PLD"));
+    partQb.addValueCondition(PartType::nameFullColumnName(), Query::In, QStringList{QStringLiteral("RFC822"), QStringLiteral("HEAD")});
+    partQb.addValueCondition(Part::dataFullColumnName(), Query::IsNot, QVariant());
+    if (!partQb.exec()) {
+        qCWarning(AKONADISERVER_SEARCH_LOG) << "Failed to query the payloads of the items to index";
+        return {};
+    }
+    // The full message is preferred over the envelope
+    QHash<qint64, Part> payloads;
+    const Part::List parts = partQb.result();
+    for (const Part &part : parts) {
+        auto it = payloads.find(part.pimItemId());
+        if (it == payloads.end()) {
+            payloads.insert(part.pimItemId(), part);
+        } else if (part.partType().name() == QLatin1StringView("RFC822")) {
+            *it = part;
+        }
+    }
+    if (payloads.isEmpty()) {
+        return {};
+    }
+
+    SelectQueryBuilder<PimItem> itemQb;
+    itemQb.addValueCondition(PimItem::idFullColumnName(), Query::In, QVariant::fromValue(payloads.keys()));
+    if (!itemQb.exec()) {
+        qCWarning(AKONADISERVER_SEARCH_LOG) << "Failed to query the items to index";
+        return {};
+    }
+
+    QList<FullTextIndex::Document> documents;
+    const PimItem::List items = itemQb.result();
+    documents.reserve(items.size());
+    for (const PimItem &item : items) {
+        const QByteArray data = PartHelper::translateData(payloads.value(item.id()));
+        if (data.isEmpty()) {
+            continue;
+        }
+        const QString mimeType = item.mimeType().name();
+        FullTextIndex::Document document;
+        if (mimeType.startsWith(QLatin1StringView("message/"))) {
+            document = FullTextIndex::documentFromMessage(data);
+        } else {
+            // Contacts and incidences are stored as vCard and iCalendar
+            document.body = QString::fromUtf8(data);
+        }
+        document.id = item.id();
+        document.collectionId = item.collectionId();
+        document.mimeType = mimeType;
+        documents.push_back(std::move(document));
+    }
+    return documents;
+}
+
+#include "moc_fulltextindexer.cpp"
@@ -0,0 +1,97 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akthread.h"
+#include "fulltextindex.h"
+
+#include "private/protocol_p.h"
+
+#include <QHash>
+#include <QMutex>
+
+#include <memory>
+
+class QTimer;
+
+namespace Akonadi
+{
+namespace Server
+{
+/**
+ * Keeps the built-in full-text index up to date.
+ *
+ * The indexer is fed with the item change notifications emitted by the
+ * server. Changed items are collected and indexed in batches, so that a large
+ * synchronization results in a few large transactions on the index rather than
+ * in one transaction per item. Items which existed before the index was
+ * enabled are indexed in the background, in the order of their ids, whenever
+ * there are no pending changes. The progress is stored in the index, so that
+ * it continues after a restart of the server.
+ *
+ * Only payloads which are cached by the server are indexed.
+ *
+ * The indexer is enabled by the Search/FullTextIndex setting.
+ */
+class FullTextIndexer : public AkThread
+{
+    Q_OBJECT
+
+protected:
+    /**
+     * Use AkThread::create() to create and start a new FullTextIndexer thread.
+     */
+    explicit FullTextIndexer(const QString &indexFileName = FullTextIndex::defaultFileName(), StartMode startMode = AutoStart);
+
+public:
+    ~FullTextIndexer() override;
+
+    /**
+     * Schedules the items referenced by the notifications for indexing.
+     *
+     * Thread-safe.
+     */
+    void notify(const Protocol::ChangeNotificationList &msgs);
+
+    QString indexFileName() const;
+
+    /**
+     * Returns whether the Search/FullTextIndex setting is enabled.
+     */
+    static bool isEnabled();
+
+protected:
+    void init() override;
+    void quit() override;
+
+private:
+    enum class ChangeType {
+        Update,
+        Move,
+        Remove,
+    };
+    struct Change {
+        ChangeType type = ChangeType::Update;
+        qint64 collectionId = -1;
+    };
+
+    void scheduleProcessing();
+    void processPendingChanges();
+    bool backfill();
+    QList<FullTextIndex::Document> loadDocuments(const QList<qint64> &ids);
+
+    const QString mIndexFileName;
+    std::unique_ptr<FullTextIndex> mIndex;
+    QTimer *mProcessTimer = nullptr;
+    bool mBackfillDone = false;
+
+    QMutex mLock;
+    QHash<qint64, Change> mPendingChanges;
+};
+
+} // namespace Server
+} // namespace Akonadi
@@ -0,0 +1,85 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "fulltextsearchplugin.h"
+#include "akonadiserver_search_debug.h"
+#include "fulltextindex.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QThreadStorage>
+
+#include <memory>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+namespace
+{
+// Searches run in the threads of the connections, each of which keeps its connections
+// to the indexes open, as opening an index costs several statements
+QThreadStorage<QHash<QString, std::shared_ptr<FullTextIndex>>> sIndexes;
+
+FullTextIndex *threadIndex(const QString &fileName)
+{
+    auto &indexes = sIndexes.localData();
+    if (const auto index = indexes.value(fileName); index && index->isOpen()) {
+        return index.get();
+    }
+    auto index = std::make_shared<FullTextIndex>(fileName);
+    if (!index->open(FullTextIndex::OpenMode::ReadOnly)) {
+        indexes.remove(fileName);
+        return nullptr;
+    }
+    indexes.insert(fileName, index);
+    return index.get();
+}
+
+} // namespace
+
+FullTextSearchPlugin::FullTextSearchPlugin(const QString &indexFileName)
+    : mIndexFileName(indexFileName)
+{
+}
+
+QSet<qint64> FullTextSearchPlugin::search(const QString &query, const QList<qint64> &collections, const QStringList &mimeTypes)
+{
+    QSet<qint64> result;
+    searchIncrementally(query, collections, mimeTypes, -1, [&result](const QList<SearchResult> &results) {
+        for (const auto &searchResult : results) {
+            result.insert(searchResult.id);
+        }
+        return true;
+    });
+    return result;
+}
+
+bool FullTextSearchPlugin::searchIncrementally(const QString &query,
+                                               const QList<qint64> &collections,
+                                               const QStringList &mimeTypes,
+                                               int limit,
+                                               const ResultCallback &callback)
+{
+    // The index is created by the indexer
+    if (!QFile::exists(mIndexFileName)) {
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    FullTextIndex *index = threadIndex(mIndexFileName);
+    if (!index) {
+        return true;
+    }
+    qsizetype count = 0;
+    const bool completed = index->search(query, collections, mimeTypes, limit, [&count, &callback](const QList<SearchResult> &results) {
+        count += results.size();
+        return callback(results);
+    });
+    qCDebug(AKONADISERVER_SEARCH_LOG) << "Full-text search delivered" << count << "items in" << timer.elapsed() << "ms" << (completed ? "" : "(cancelled)");
+    return completed;
+}
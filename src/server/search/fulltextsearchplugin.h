@@ -0,0 +1,47 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "abstractsearchplugin.h"
+
+namespace Akonadi
+{
+namespace Server
+{
+/**
+ * Search plugin built into the server, which answers queries from the
+ * full-text index maintained by FullTextIndexer.
+ *
+ * The plugin is used when the Search/FullTextIndex setting is enabled, in
+ * addition to the search plugins installed on the system.
+ */
+class FullTextSearchPlugin : public AbstractSearchPlugin
+{
+public:
+    explicit FullTextSearchPlugin(const QString &indexFileName);
+
+    /**
+     * Searches the index using a read-only connection of the calling thread,
+     * which is kept open for later searches, so that it can be called from any thread.
+     */
+    QSet<qint64> search(const QString &query, const QList<qint64> &collections, const QStringList &mimeTypes) override;
+
+    /**
+     * Delivers the results ranked by their relevance.
+     */
+    bool searchIncrementally(const QString &query,
+                             const QList<qint64> &collections,
+                             const QStringList &mimeTypes,
+                             int limit,
+                             const ResultCallback &callback) override;
+
+private:
+    const QString mIndexFileName;
+};
+
+} // namespace Server
+} // namespace Akonadi
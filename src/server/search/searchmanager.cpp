@@ -11,6 +11,8 @@
 
 #include "agentsearchengine.h"
 #include "akonadi.h"
+#include "fulltextindexer.h"
+#include "fulltextsearchplugin.h"
 #include "handler/searchhelper.h"
 #include "notificationmanager.h"
 #include "searchrequest.h"
@@ -193,6 +195,11 @@ void SearchManager::initSearchPlugins()
         qCDebug(AKONADISERVER_SEARCH_LOG) << "SearchManager: loaded search plugin" << loader->fileName();
         mPlugins << plugin;
     }
+
+    if (FullTextIndexer::isEnabled()) {
+        qCDebug(AKONADISERVER_SEARCH_LOG) << "SearchManager: using the built-in full-text index";
+        mPlugins << new FullTextSearchPlugin(FullTextIndex::defaultFileName());
+    }
 }
 
 void SearchManager::scheduleSearchUpdate()
@@ -300,7 +307,6 @@ void SearchManager::updateSearchImpl(const Collection &collection)
     request.setMimeTypes(queryMimeTypes);
     request.setQuery(collection.queryString());
     request.setRemoteSearch(remoteSearch);
-    request.setStoreResults(true);
     request.setProperty("SearchCollection", QVariant::fromValue(collection));
     connect(&request, &SearchRequest::resultsAvailable, this, &SearchManager::searchUpdateResultsAvailable);
     request.exec(); // blocks until all searches are done
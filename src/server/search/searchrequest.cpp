@@ -9,10 +9,14 @@
 #include "abstractsearchplugin.h"
 #include "akonadi.h"
 #include "akonadiserver_search_debug.h"
+#include "commandscheduler.h"
 #include "connection.h"
 #include "searchmanager.h"
 #include "searchtaskmanager.h"
 
+#include <QJsonDocument>
+#include <QJsonObject>
+
 using namespace Akonadi::Server;
 
 SearchRequest::SearchRequest(const QByteArray &connectionId, SearchManager &searchManager, SearchTaskManager &agentSearchManager)
@@ -71,9 +75,24 @@ bool SearchRequest::remoteSearch() const
     return mRemoteSearch;
 }
 
-void SearchRequest::setStoreResults(bool storeResults)
+void SearchRequest::setLimit(int limit)
+{
+    mLimit = limit;
+}
+
+int SearchRequest::limit() const
+{
+    return mLimit;
+}
+
+void SearchRequest::cancel()
 {
-    mStoreResults = storeResults;
+    mCancelled = true;
+}
+
+bool SearchRequest::isCancelled() const
+{
+    return mCancelled;
 }
 
 QSet<qint64> SearchRequest::results() const
@@ -81,20 +100,57 @@ QSet<qint64> SearchRequest::results() const
     return mResults;
 }
 
+int SearchRequest::limitFromQuery(const QString &query)
+{
+    const int limit = QJsonDocument::fromJson(query.toUtf8()).object().value(QLatin1StringView("limit")).toInt(-1);
+    return limit >= 0 ? limit : -1;
+}
+
+bool SearchRequest::isFinished() const
+{
+    return mCancelled || (mLimit >= 0 && mResults.size() >= mLimit);
+}
+
+bool SearchRequest::emitResults(const QList<AbstractSearchPlugin::SearchResult> &results)
+{
+    QSet<qint64> newResults;
+    newResults.reserve(results.size());
+    for (const auto &result : results) {
+        if (isFinished()) {
+            break;
+        }
+        // The same item can be found by multiple plugins
+        if (!mResults.contains(result.id)) {
+            mResults.insert(result.id);
+            newResults.insert(result.id);
+        }
+    }
+    if (!newResults.isEmpty()) {
+        Q_EMIT resultsAvailable(newResults);
+    }
+    return !isFinished();
+}
+
 void SearchRequest::emitResults(const QSet<qint64> &results)
 {
-    Q_EMIT resultsAvailable(results);
-    if (mStoreResults) {
-        mResults.unite(results);
+    QList<AbstractSearchPlugin::SearchResult> list;
+    list.reserve(results.size());
+    for (const qint64 id : results) {
+        list.push_back({id, 0.0});
     }
+    emitResults(list);
 }
 
 void SearchRequest::searchPlugins()
 {
     const QList<AbstractSearchPlugin *> plugins = mSearchManager.searchPlugins();
     for (AbstractSearchPlugin *plugin : plugins) {
-        const QSet<qint64> result = plugin->search(mQuery, mCollections, mMimeTypes);
-        emitResults(result);
+        if (isFinished()) {
+            break;
+        }
+        plugin->searchIncrementally(mQuery, mCollections, mMimeTypes, mLimit, [this](const QList<AbstractSearchPlugin::SearchResult> &results) {
+            return emitResults(results);
+        });
     }
 }
 
@@ -107,8 +163,9 @@ void SearchRequest::exec()
     searchPlugins();
 
     // If remote search is disabled, just finish here after searching the plugins
-    if (!mRemoteSearch) {
-        qCInfo(AKONADISERVER_SEARCH_LOG) << "Search " << mConnectionId << "done (without remote search)";
+    if (!mRemoteSearch || isFinished()) {
+        qCInfo(AKONADISERVER_SEARCH_LOG) << "Search " << mConnectionId << "done (without remote search):" << mResults.size() << "results"
+                                         << (mCancelled ? "(cancelled)" : "");
         return;
     }
 
@@ -127,7 +184,14 @@ void SearchRequest::exec()
             break;
         }
 
-        task.notifier.wait(&task.sharedLock);
+        {
+            // The results are delivered by the resources through their own connections
+            CommandScheduler::Yield yield;
+            task.notifier.wait(&task.sharedLock);
+            // Don't wait for an execution slot while holding the lock needed to deliver results
+            task.sharedLock.unlock();
+        }
+        task.sharedLock.lock();
 
         qCDebug(AKONADISERVER_SEARCH_LOG) << task.pendingResults.count() << "search results available in search" << task.id;
         if (!task.pendingResults.isEmpty()) {
@@ -141,7 +205,8 @@ void SearchRequest::exec()
     }
     task.sharedLock.unlock();
 
-    qCInfo(AKONADISERVER_SEARCH_LOG) << "Search" << mConnectionId << "done (with remote search)";
+    qCInfo(AKONADISERVER_SEARCH_LOG) << "Search" << mConnectionId << "done (with remote search):" << mResults.size() << "results"
+                                     << (mCancelled ? "(cancelled)" : "");
 }
 
 #include "moc_searchrequest.cpp"
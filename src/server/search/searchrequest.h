@@ -6,11 +6,15 @@
 
 #pragma once
 
+#include "abstractsearchplugin.h"
+
 #include <QList>
 #include <QObject>
 #include <QSet>
 #include <QStringList>
 
+#include <atomic>
+
 namespace Akonadi
 {
 namespace Server
@@ -19,6 +23,14 @@ class Connection;
 class SearchManager;
 class SearchTaskManager;
 
+/**
+ * Executes a search in the search plugins and, for remote searches, in the
+ * resources.
+ *
+ * The results are emitted via resultsAvailable() in batches while the search
+ * is running, every result is emitted only once. The search stops early when
+ * the limit is reached or when it is cancelled.
+ */
 class SearchRequest : public QObject
 {
     Q_OBJECT
@@ -37,23 +49,41 @@ public:
     bool remoteSearch() const;
 
     /**
-     * Whether results should be stored after they are emitted via resultsAvailable(),
-     * so that they can be extracted via results() after the search is over. This
-     * is disabled by default.
+     * Limits the number of results, -1 (the default) for no limit. Plugins
+     * which rank their results deliver the most relevant ones first.
+     */
+    void setLimit(int limit);
+    int limit() const;
+
+    /**
+     * Stops the search once the current batch of results has been delivered.
+     *
+     * Thread-safe.
      */
-    void setStoreResults(bool storeResults);
+    void cancel();
+    bool isCancelled() const;
 
     QByteArray connectionId() const;
 
     void exec();
 
+    /**
+     * Returns all results emitted via resultsAvailable().
+     */
     QSet<qint64> results() const;
 
+    /**
+     * Returns the limit stored in a SearchQuery JSON @p query, -1 if there is none.
+     */
+    static int limitFromQuery(const QString &query);
+
 Q_SIGNALS:
     void resultsAvailable(const QSet<qint64> &results);
 
 private:
     void searchPlugins();
+    bool isFinished() const;
+    bool emitResults(const QList<AbstractSearchPlugin::SearchResult> &results);
     void emitResults(const QSet<qint64> &results);
 
     QByteArray mConnectionId;
@@ -61,7 +91,8 @@ private:
     QList<qint64> mCollections;
     QStringList mMimeTypes;
     bool mRemoteSearch = false;
-    bool mStoreResults = false;
+    int mLimit = -1;
+    std::atomic_bool mCancelled = false;
     QSet<qint64> mResults;
 
     SearchManager &mSearchManager;
@@ -20,55 +20,91 @@ using namespace Akonadi::Server;
 CollectionStatistics::CollectionStatistics(bool prefetch)
 {
     if (prefetch) {
-        QMutexLocker lock(&mCacheLock);
+        CollectionStatistics::prefetch();
+    }
+}
 
-        std::vector<QueryBuilder> builders;
-        // This single query will give us statistics for all non-empty non-virtual
-        // Collections at much better speed than individual queries.
-        auto qb = prepareGenericQuery();
-        qb.addColumn(PimItem::collectionIdFullColumnName());
-        qb.addGroupColumn(PimItem::collectionIdFullColumnName());
-        builders.emplace_back(std::move(qb));
-
-        // This single query will give us statistics for all non-empty virtual
-        // Collections
-        qb = prepareGenericQuery();
-        qb.addColumn(CollectionPimItemRelation::leftFullColumnName());
-        qb.addJoin(QueryBuilder::InnerJoin,
-                   CollectionPimItemRelation::tableName(),
-                   CollectionPimItemRelation::rightFullColumnName(),
-                   PimItem::idFullColumnName());
-        qb.addGroupColumn(CollectionPimItemRelation::leftFullColumnName());
-        builders.emplace_back(std::move(qb));
+void CollectionStatistics::prefetch()
+{
+    {
+        QMutexLocker lock(&mCacheLock);
+        mPrefetching = true;
+        mExpiredDuringPrefetch = false;
+        mChangedDuringPrefetch.clear();
+    }
 
-        for (auto &qb : builders) {
-            if (!qb.exec()) {
-                return;
-            }
+    // The queries run without the lock, so that statistics can be served in the meantime
+    QHash<qint64, Statistics> statistics;
+    const bool success = fetchAllStatistics(statistics);
 
-            auto &query = qb.query();
-            while (query.next()) {
-                mCache.insert(query.value(3).toLongLong(), {query.value(0).toLongLong(), query.value(1).toLongLong(), query.value(2).toLongLong()});
+    QMutexLocker lock(&mCacheLock);
+    if (success && !mExpiredDuringPrefetch) {
+        for (auto it = statistics.cbegin(), end = statistics.cend(); it != end; ++it) {
+            // Cached statistics are at least as recent as the prefetched ones
+            if (!mCache.contains(it.key()) && !mChangedDuringPrefetch.contains(it.key()) && !mMoving.contains(it.key())) {
+                mCache.insert(it.key(), it.value());
             }
         }
+    }
+    mPrefetching = false;
+    mChangedDuringPrefetch.clear();
+}
 
-        // Now quickly get all non-virtual enabled Collections and if they are
-        // not in mCache yet, insert them with empty statistics.
-        qb = QueryBuilder(Collection::tableName());
-        qb.addColumn(Collection::idColumn());
-        qb.addValueCondition(Collection::enabledColumn(), Query::Equals, true);
-        qb.addValueCondition(Collection::isVirtualColumn(), Query::Equals, false);
+bool CollectionStatistics::fetchAllStatistics(QHash<qint64, Statistics> &statistics)
+{
+    std::vector<QueryBuilder> builders;
+    // This single query will give us statistics for all non-empty non-virtual
+    // Collections at much better speed than individual queries.
+    auto qb = prepareGenericQuery();
+    qb.addColumn(PimItem::collectionIdFullColumnName());
+    qb.addGroupColumn(PimItem::collectionIdFullColumnName());
+    builders.emplace_back(std::move(qb));
+
+    // This single query will give us statistics for all non-empty virtual
+    // Collections
+    qb = prepareGenericQuery();
+    qb.addColumn(CollectionPimItemRelation::leftFullColumnName());
+    qb.addJoin(QueryBuilder::InnerJoin, CollectionPimItemRelation::tableName(), CollectionPimItemRelation::rightFullColumnName(), PimItem::idFullColumnName());
+    qb.addGroupColumn(CollectionPimItemRelation::leftFullColumnName());
+    builders.emplace_back(std::move(qb));
+
+    for (auto &qb : builders) {
         if (!qb.exec()) {
-            return;
+            return false;
         }
 
         auto &query = qb.query();
         while (query.next()) {
-            const auto colId = query.value(0).toLongLong();
-            if (!mCache.contains(colId)) {
-                mCache.insert(colId, {0, 0, 0});
-            }
+            statistics.insert(query.value(3).toLongLong(), {query.value(0).toLongLong(), query.value(1).toLongLong(), query.value(2).toLongLong()});
         }
+        query.finish();
+    }
+
+    // Now quickly get all non-virtual enabled Collections and if they are
+    // not in the statistics yet, insert them with empty statistics.
+    qb = QueryBuilder(Collection::tableName());
+    qb.addColumn(Collection::idColumn());
+    qb.addValueCondition(Collection::enabledColumn(), Query::Equals, true);
+    qb.addValueCondition(Collection::isVirtualColumn(), Query::Equals, false);
+    if (!qb.exec()) {
+        return false;
+    }
+
+    auto &query = qb.query();
+    while (query.next()) {
+        const auto colId = query.value(0).toLongLong();
+        if (!statistics.contains(colId)) {
+            statistics.insert(colId, {0, 0, 0});
+        }
+    }
+    query.finish();
+    return true;
+}
+
+void CollectionStatistics::collectionChanged(qint64 collectionId)
+{
+    if (mPrefetching) {
+        mChangedDuringPrefetch.insert(collectionId);
     }
 }
 
@@ -79,12 +115,13 @@ void CollectionStatistics::itemAdded(const Collection &col, qint64 size, bool se
     }
 
     QMutexLocker lock(&mCacheLock);
+    collectionChanged(col.id());
     auto stats = mCache.find(col.id());
     if (stats != mCache.end()) {
         ++(stats->count);
         stats->size += size;
         stats->read += (seen ? 1 : 0);
-    } else {
+    } else if (!mMoving.contains(col.id())) {
         mCache.insert(col.id(), calculateCollectionStatistics(col));
     }
 }
@@ -96,14 +133,80 @@ void CollectionStatistics::itemsSeenChanged(const Collection &col, qint64 seenCo
     }
 
     QMutexLocker lock(&mCacheLock);
+    collectionChanged(col.id());
     auto stats = mCache.find(col.id());
     if (stats != mCache.end()) {
         stats->read += seenCount;
-    } else {
+    } else if (!mMoving.contains(col.id())) {
         mCache.insert(col.id(), calculateCollectionStatistics(col));
     }
 }
 
+void CollectionStatistics::beginItemsMove(const Collection &source, const Collection &destination)
+{
+    QMutexLocker lock(&mCacheLock);
+    collectionChanged(source.id());
+    collectionChanged(destination.id());
+    ++mMoving[source.id()];
+    ++mMoving[destination.id()];
+}
+
+void CollectionStatistics::endItemsMove(qint64 collectionId)
+{
+    collectionChanged(collectionId);
+    if (auto moving = mMoving.find(collectionId); moving != mMoving.end() && --(*moving) <= 0) {
+        mMoving.erase(moving);
+    }
+}
+
+void CollectionStatistics::itemsMoveAborted(const Collection &source, const Collection &destination)
+{
+    QMutexLocker lock(&mCacheLock);
+    endItemsMove(source.id());
+    endItemsMove(destination.id());
+}
+
+void CollectionStatistics::itemsMoved(const Collection &source, const Collection &destination, const Statistics &delta)
+{
+    QMutexLocker lock(&mCacheLock);
+    endItemsMove(source.id());
+    endItemsMove(destination.id());
+    // Statistics which are not cached are calculated on demand
+    if (auto stats = mCache.find(source.id()); stats != mCache.end()) {
+        stats->count -= delta.count;
+        stats->size -= delta.size;
+        stats->read -= delta.read;
+    }
+    if (auto stats = mCache.find(destination.id()); stats != mCache.end()) {
+        stats->count += delta.count;
+        stats->size += delta.size;
+        stats->read += delta.read;
+    }
+}
+
+std::optional<QHash<qint64, CollectionStatistics::Statistics>> CollectionStatistics::itemStatistics(const QList<qint64> &itemIds)
+{
+    QHash<qint64, Statistics> result;
+    if (itemIds.isEmpty()) {
+        return result;
+    }
+
+    auto qb = prepareGenericQuery();
+    qb.addColumn(PimItem::collectionIdFullColumnName());
+    qb.addValueCondition(PimItem::idFullColumnName(), Query::In, itemIds);
+    qb.addGroupColumn(PimItem::collectionIdFullColumnName());
+    if (!qb.exec()) {
+        return std::nullopt;
+    }
+
+    auto &query = qb.query();
+    while (query.next()) {
+        result.insert(query.value(3).toLongLong(), {query.value(0).toLongLong(), query.value(1).toLongLong(), query.value(2).toLongLong()});
+    }
+    query.finish();
+    return result;
+}
+
 void CollectionStatistics::invalidateCollection(const Collection &col)
 {
     if (!col.isValid()) {
@@ -111,12 +214,14 @@ void CollectionStatistics::invalidateCollection(const Collection &col)
     }
 
     QMutexLocker lock(&mCacheLock);
+    collectionChanged(col.id());
     mCache.remove(col.id());
 }
 
 void CollectionStatistics::expireCache()
 {
     QMutexLocker lock(&mCacheLock);
+    mExpiredDuringPrefetch = mPrefetching;
     mCache.clear();
 }
 
@@ -125,6 +230,9 @@ CollectionStatistics::Statistics CollectionStatistics::statistics(const Collecti
     QMutexLocker lock(&mCacheLock);
     auto it = mCache.find(col.id());
     if (it == mCache.end()) {
+        if (mMoving.contains(col.id())) {
+            return calculateCollectionStatistics(col);
+        }
         it = mCache.insert(col.id(), calculateCollectionStatistics(col));
     }
     return it.value();
@@ -9,6 +9,9 @@
 
 #include <QHash>
 #include <QMutex>
+#include <QSet>
+
+#include <optional>
 
 namespace Akonadi
 {
@@ -40,10 +43,40 @@ public:
     explicit CollectionStatistics(bool prefetch = true);
     virtual ~CollectionStatistics() = default;
 
+    /**
+     * Fills the cache with the statistics of all collections.
+     *
+     * Can be called from any thread while the statistics are being used, the
+     * statistics of collections which change in the meantime are not cached.
+     */
+    void prefetch();
+
     Statistics statistics(const Collection &col);
 
     void itemAdded(const Collection &col, qint64 size, bool seen);
     void itemsSeenChanged(const Collection &col, qint64 seenCount);
+    /**
+     * Starts a move of items from @p source to @p destination by a transaction which
+     * is not committed yet. Until the move is finished by itemsMoved() or itemsMoveAborted(),
+     * the statistics of both collections are not cached, as other connections would
+     * calculate them without the moved items.
+     */
+    void beginItemsMove(const Collection &source, const Collection &destination);
+    /**
+     * Moves the statistics @p delta of items moved from @p source to @p destination
+     * between the cached statistics of both collections, once the move has been committed.
+     */
+    void itemsMoved(const Collection &source, const Collection &destination, const Statistics &delta);
+    /**
+     * Finishes a move which has been rolled back.
+     */
+    void itemsMoveAborted(const Collection &source, const Collection &destination);
+
+    /**
+     * Returns the statistics of the items @p itemIds, grouped by the collection they are in,
+     * or an empty optional if they could not be queried.
+     */
+    std::optional<QHash<qint64, Statistics>> itemStatistics(const QList<qint64> &itemIds);
 
     void invalidateCollection(const Collection &col);
 
@@ -56,6 +89,18 @@ protected:
 
     QMutex mCacheLock;
     QHash<qint64, Statistics> mCache;
+
+private:
+    bool fetchAllStatistics(QHash<qint64, Statistics> &statistics);
+    void collectionChanged(qint64 collectionId);
+    void endItemsMove(qint64 collectionId);
+
+    // Collections changed while prefetch() was running, guarded by mCacheLock
+    bool mPrefetching = false;
+    bool mExpiredDuringPrefetch = false;
+    QSet<qint64> mChangedDuringPrefetch;
+    // Number of uncommitted moves per collection, guarded by mCacheLock
+    QHash<qint64, int> mMoving;
 };
 
 } // namespace Server
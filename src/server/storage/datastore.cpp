@@ -16,10 +16,14 @@
 #include "dbinitializer.h"
 #include "dbupdater.h"
 #include "handler.h"
+#include "packedpartstorage.h"
+#include "partfilereclaimer.h"
 #include "parthelper.h"
 #include "parttypehelper.h"
 #include "querycache.h"
+#include "schemafingerprint.h"
 #include "selectquerybuilder.h"
+#include "sqltracebuffer.h"
 #include "storage/query.h"
 #include "storagedebugger.h"
 #include "tracer.h"
@@ -44,6 +48,7 @@
 
 #include <functional>
 #include <shared_mutex>
+#include <utility>
 
 using namespace Akonadi;
 using namespace Akonadi::Server;
@@ -155,7 +160,7 @@ void DataStore::open()
     }
 
     StorageDebugger::instance()->addConnection(reinterpret_cast<qint64>(this), QThread::currentThread()->objectName());
-    connect(QThread::currentThread(), &QThread::objectNameChanged, this, [this](const QString &name) {
+    m_threadNameConnection = connect(QThread::currentThread(), &QThread::objectNameChanged, this, [this](const QString &name) {
         if (!name.isEmpty()) {
             StorageDebugger::instance()->changeConnection(reinterpret_cast<qint64>(this), name);
         }
@@ -192,6 +197,8 @@ void DataStore::close()
         m_transactionLevel = 1;
         rollbackTransaction();
     }
+    // Records of a part write which failed outside of a transaction
+    PackedPartStorage::self()->releasePendingRecords(this);
 
     QueryCache::clear();
     m_database.close();
@@ -200,6 +207,7 @@ void DataStore::close()
     sStoreLookup.unregisterDataStore(m_connectionName);
 
     StorageDebugger::instance()->removeConnection(reinterpret_cast<qint64>(this));
+    disconnect(m_threadNameConnection);
 
     m_dbOpened = false;
 }
@@ -209,24 +217,34 @@ bool DataStore::init()
     // Q_ASSERT(QThread::currentThread() == QCoreApplication::instance()->thread());
 
     AkonadiSchema schema;
-    DbInitializer::Ptr initializer = DbInitializer::createInstance(m_database, &schema);
-    if (!initializer->run()) {
-        qCCritical(AKONADISERVER_LOG) << initializer->errorMsg();
-        return false;
-    }
+    if (const auto fingerprint = SchemaFingerprint::compute(schema, m_database); !fingerprint.isEmpty() && fingerprint == SchemaFingerprint::stored()) {
+        qCInfo(AKONADISERVER_LOG) << "Database schema unchanged since the last check, skipping DB initializer";
+    } else {
+        // An interrupted update must not be mistaken for a checked schema
+        SchemaFingerprint::clear();
 
-    if (QFile::exists(QStringLiteral(":dbupdate.xml"))) {
-        DbUpdater updater(m_database, QStringLiteral(":dbupdate.xml"));
-        if (!updater.run()) {
+        DbInitializer::Ptr initializer = DbInitializer::createInstance(m_database, &schema);
+        if (!initializer->run()) {
+            qCCritical(AKONADISERVER_LOG) << initializer->errorMsg();
             return false;
         }
-    } else {
-        qCWarning(AKONADISERVER_LOG) << "Warning: dbupdate.xml not found, skipping updates";
-    }
 
-    if (!initializer->updateIndexesAndConstraints()) {
-        qCCritical(AKONADISERVER_LOG) << initializer->errorMsg();
-        return false;
+        if (QFile::exists(QStringLiteral(":dbupdate.xml"))) {
+            DbUpdater updater(m_database, QStringLiteral(":dbupdate.xml"));
+            if (!updater.run()) {
+                return false;
+            }
+        } else {
+            qCWarning(AKONADISERVER_LOG) << "Warning: dbupdate.xml not found, skipping updates";
+        }
+
+        if (!initializer->updateIndexesAndConstraints()) {
+            qCCritical(AKONADISERVER_LOG) << initializer->errorMsg();
+            return false;
+        }
+
+        // The initializer and the updater may have changed the version and generation
+        SchemaFingerprint::store(SchemaFingerprint::compute(schema, m_database));
     }
 
     // enable caching for some tables
@@ -1156,16 +1174,24 @@ bool DataStore::unhidePimItem(PimItem &pimItem)
     return removeItemParts(pimItem, {AKONADI_ATTRIBUTE_HIDDEN});
 }
 
-bool DataStore::unhideAllPimItems()
+bool DataStore::unhideAllPimItems(PimItem::Id maxItemId)
 {
     if (!m_dbOpened) {
         return false;
     }
 
-    qCDebug(AKONADISERVER_LOG) << "DataStore::unhideAllPimItems()";
+    qCDebug(AKONADISERVER_LOG) << "DataStore::unhideAllPimItems()" << maxItemId;
 
     try {
-        return PartHelper::remove(Part::partTypeIdFullColumnName(), PartTypeHelper::fromFqName(QStringLiteral("ATR"), QStringLiteral("HIDDEN")).id());
+        const auto hiddenPartType = PartTypeHelper::fromFqName(QStringLiteral("ATR"), QStringLiteral("HIDDEN")).id();
+        if (maxItemId < 0) {
+            return PartHelper::remove(Part::partTypeIdFullColumnName(), hiddenPartType);
+        }
+        // The hidden attribute is a tiny part, which is never stored externally
+        QueryBuilder qb(Part::tableName(), QueryBuilder::Delete);
+        qb.addValueCondition(Part::partTypeIdColumn(), Query::Equals, hiddenPartType);
+        qb.addValueCondition(Part::pimItemIdColumn(), Query::LessOrEqual, maxItemId);
+        return qb.exec();
     } catch (...) {
     } // we can live with this failing
 
@@ -1180,27 +1206,40 @@ bool DataStore::cleanupPimItems(const PimItem::List &items, bool silent)
         notificationCollector()->itemsRemoved(items);
     }
 
-    // FIXME: Create a single query to do this
+    QList<PimItem::Id> ids;
+    ids.reserve(items.size());
     for (const auto &item : items) {
-        if (!item.clearFlags()) {
-            qCWarning(AKONADISERVER_LOG) << "Failed to clean up flags from PimItem" << item.id();
+        ids.push_back(item.id());
+    }
+
+    for (qsizetype i = 0; i < ids.size(); i += CleanupBatchSize) {
+        const auto batch = ids.mid(i, CleanupBatchSize);
+
+        QueryBuilder flagsQb(PimItemFlagRelation::tableName(), QueryBuilder::Delete);
+        flagsQb.addValueCondition(PimItemFlagRelation::leftColumn(), Query::In, batch);
+        if (!flagsQb.exec()) {
+            qCWarning(AKONADISERVER_LOG) << "Failed to clean up flags from" << batch.size() << "PimItems";
             return false;
         }
-        if (!PartHelper::remove(Part::pimItemIdColumn(), item.id())) {
-            qCWarning(AKONADISERVER_LOG) << "Failed to clean up parts from PimItem" << item.id();
+        if (!PartHelper::removeByItemIds(batch)) {
+            qCWarning(AKONADISERVER_LOG) << "Failed to clean up parts from" << batch.size() << "PimItems";
             return false;
         }
-        if (!PimItem::remove(PimItem::idColumn(), item.id())) {
-            qCWarning(AKONADISERVER_LOG) << "Failed to remove PimItem" << item.id();
+        QueryBuilder itemsQb(PimItem::tableName(), QueryBuilder::Delete);
+        itemsQb.addValueCondition(PimItem::idColumn(), Query::In, batch);
+        if (!itemsQb.exec()) {
+            qCWarning(AKONADISERVER_LOG) << "Failed to remove" << batch.size() << "PimItems";
             return false;
         }
-
-        if (!Entity::clearRelation<CollectionPimItemRelation>(item.id(), Entity::Right)) {
-            qCWarning(AKONADISERVER_LOG) << "Failed to remove PimItem" << item.id() << "from linked collections";
+        QueryBuilder linksQb(CollectionPimItemRelation::tableName(), QueryBuilder::Delete);
+        linksQb.addValueCondition(CollectionPimItemRelation::rightColumn(), Query::In, batch);
+        if (!linksQb.exec()) {
+            qCWarning(AKONADISERVER_LOG) << "Failed to remove" << batch.size() << "PimItems from linked collections";
             return false;
         }
     }
 
+    reclaimPartFiles();
     return true;
 }
 
@@ -1348,6 +1387,8 @@ bool DataStore::beginTransaction(const QString &name)
                 return false;
             }
         }
+        m_transactionTimer.start();
+        SqlTraceBuffer::self()->recordTransactionBegin(this, timer.nsecsElapsed() / 1000);
 
         if (DbType::type(m_database) == DbType::PostgreSQL) {
             // Make constraints check deferred in PostgreSQL. Allows for
@@ -1402,6 +1443,8 @@ bool DataStore::commitTransaction()
             qCWarning(AKONADISERVER_LOG) << "DataStore::commitTransaction(): Cannot commit, transaction was killed by mysql deadlock handling!";
             return false;
         }
+        // The committed parts must not refer to packed records which are lost on a crash
+        PackedPartStorage::self()->sync();
         QSqlDriver *driver = m_database.driver();
         QElapsedTimer timer;
         timer.start();
@@ -1413,7 +1456,12 @@ bool DataStore::commitTransaction()
             return false;
         } else {
             m_transactionLevel--;
+            PackedPartStorage::self()->releasePendingRecords(this);
+            SqlTraceBuffer::self()->recordTransactionEnd(this, true, m_transactionTimer.nsecsElapsed() / 1000);
             Q_EMIT transactionCommitted();
+            if (std::exchange(m_reclaimPartFiles, false)) {
+                reclaimPartFiles();
+            }
         }
     } else {
         m_transactionLevel--;
@@ -1436,6 +1484,10 @@ void DataStore::sendKeepAliveQuery()
 
 void DataStore::cleanupAfterRollback()
 {
+    // The tombstones have been rolled back as well, and the packed records will never be referenced
+    m_reclaimPartFiles = false;
+    PackedPartStorage::self()->releasePendingRecords(this);
+    SqlTraceBuffer::self()->recordTransactionEnd(this, false, m_transactionTimer.nsecsElapsed() / 1000);
     MimeType::invalidateCompleteCache();
     Flag::invalidateCompleteCache();
     Resource::invalidateCompleteCache();
@@ -1447,4 +1499,16 @@ void DataStore::cleanupAfterRollback()
     QueryCache::clear();
 }
 
+void DataStore::reclaimPartFiles()
+{
+    // Delete the files once the tombstones are committed
+    if (inTransaction()) {
+        m_reclaimPartFiles = true;
+        return;
+    }
+    if (m_akonadi && m_akonadi->partFileReclaimer()) {
+        m_akonadi->partFileReclaimer()->reclaim();
+    }
+}
+
 #include "moc_datastore.cpp"
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QList>
 #include <QMutex>
 #include <QObject>
@@ -96,6 +97,8 @@ class DataStore : public QObject
     Q_OBJECT
 public:
     const constexpr static bool Silent = true;
+    /// Number of items removed with a single statement by cleanupPimItems()
+    static constexpr qsizetype CleanupBatchSize = 500;
 
     static void setFactory(std::unique_ptr<DataStoreFactory> factory);
 
@@ -209,6 +212,10 @@ public:
                                PimItem &pimItem);
     /**
      * Removes the pim item and all referenced data ( e.g. flags )
+     *
+     * The items are removed in batches of CleanupBatchSize with a single statement
+     * per table. The files of external parts are deleted by the PartFileReclaimer
+     * after the transaction has been committed.
      */
     virtual bool cleanupPimItems(const PimItem::List &items, bool silent = false);
 
@@ -230,8 +237,11 @@ public:
      * being unhidden so it's meant to be called only in rare circumstances.
      * The most notable call to this function is at server startup
      * when we attempt to restore a clean state of the database.
+     *
+     * If @p maxItemId is not negative, only items up to that id are unhidden,
+     * so that items created in the meantime are left alone.
      */
-    virtual bool unhideAllPimItems();
+    virtual bool unhideAllPimItems(PimItem::Id maxItemId = -1);
 
     /* --- Collection attributes ------------------------------------------ */
     virtual bool addCollectionAttribute(const Collection &col, const QByteArray &key, const QByteArray &value, bool silent = false);
@@ -353,11 +363,14 @@ private:
     Q_DISABLE_COPY_MOVE(DataStore)
 
     void cleanupAfterRollback();
+    void reclaimPartFiles();
     QString m_connectionName;
     QSqlDatabase m_database;
     bool m_dbOpened;
     bool m_transactionKilledByDB = false;
+    bool m_reclaimPartFiles = false;
     uint m_transactionLevel;
+    QElapsedTimer m_transactionTimer;
     struct TransactionQuery {
         QString query;
         QList<QVariant> boundValues;
@@ -365,6 +378,8 @@ private:
     };
     QByteArray mSessionId;
     QTimer *m_keepAliveTimer = nullptr;
+    /// Renames the connection in the StorageDebugger while it is open
+    QMetaObject::Connection m_threadNameConnection;
 
     friend class DataStoreFactory;
 };
@@ -10,6 +10,7 @@
 #include "dbconfigmysql.h"
 #include "dbconfigpostgresql.h"
 #include "dbconfigsqlite.h"
+#include "packedpartstorage.h"
 
 #include <config-akonadi.h>
 
@@ -17,6 +18,8 @@
 #include "private/standarddirs_p.h"
 
 #include <QProcess>
+
+#include <algorithm>
 #include <memory>
 
 using namespace Akonadi;
@@ -44,6 +47,10 @@ DbConfig::DbConfig(const QString &configFile)
     } else {
         mSizeThreshold = 0;
     }
+
+    // Packed parts must fit into a single segment record
+    mPackedPartThreshold =
+        std::clamp<qint64>(settings.value(QStringLiteral("General/PackedPartThreshold"), 0).toLongLong(), 0, PackedPartStorage::MaxPartSize);
 }
 
 DbConfig::~DbConfig()
@@ -140,6 +147,11 @@ qint64 DbConfig::sizeThreshold() const
     return mSizeThreshold;
 }
 
+qint64 DbConfig::packedPartThreshold() const
+{
+    return mPackedPartThreshold;
+}
+
 QString DbConfig::defaultDatabaseName()
 {
     if (!Instance::hasIdentifier()) {
@@ -114,6 +114,15 @@ public:
      */
     virtual qint64 sizeThreshold() const;
 
+    /**
+     * Payload data bigger than sizeThreshold() but not bigger than this value will be appended
+     * to shared segment files instead of being stored in separate files, see PackedPartStorage.
+     *
+     * @return the packed part threshold in bytes, at most PackedPartStorage::MaxPartSize. Defaults
+     *         to 0, which disables packed parts.
+     */
+    virtual qint64 packedPartThreshold() const;
+
     /**
      * This method is called to setup initial database settings after a connection is established.
      */
@@ -156,6 +165,7 @@ private:
     Q_DISABLE_COPY(DbConfig)
 
     qint64 mSizeThreshold;
+    qint64 mPackedPartThreshold;
 };
 
 } // namespace Server
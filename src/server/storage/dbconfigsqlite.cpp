@@ -258,6 +258,13 @@ void DbConfigSqlite::setup()
             return;
         }
 
+        // Lets the DatabaseMaintenance free unused pages while the server is idle. Only
+        // takes effect for new databases, existing ones are converted by a full VACUUM.
+        if (!setPragma(db, query, QStringLiteral("auto_vacuum=INCREMENTAL"))) {
+            db.close();
+            return;
+        }
+
         if (!setSessionSettings(db)) {
             db.close();
             return;
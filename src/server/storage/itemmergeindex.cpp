@@ -0,0 +1,274 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "itemmergeindex.h"
+#include "akonadiserver_debug.h"
+#include "datastore.h"
+#include "dbconfig.h"
+#include "dbtype.h"
+#include "querybuilder.h"
+#include "utils.h"
+
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringView>
+#include <QThread>
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+using namespace Akonadi::Server;
+
+namespace
+{
+enum class ValueKind : size_t {
+    RemoteId = 0,
+    Gid = 1,
+};
+
+// Depending on the database and collation, comparing the values in SQL may ignore
+// the case and trailing spaces, so the filter has to ignore them as well
+QString normalized(const QString &value)
+{
+    QStringView view(value);
+    while (view.endsWith(u' ')) {
+        view.chop(1);
+    }
+    return view.toString().toCaseFolded();
+}
+
+} // namespace
+
+class ItemMergeIndex::Filter
+{
+public:
+    // With 10 bits per value and 4 hash functions the false positive rate is about 1%
+    static constexpr size_t BitsPerValue = 10;
+    static constexpr size_t HashCount = 4;
+    static constexpr qsizetype MinCapacity = 4096;
+
+    void reserve(qsizetype expectedValues)
+    {
+        // Leave room for the values added until the filter is rebuilt
+        mCapacity = std::max(expectedValues * 2, MinCapacity);
+        const size_t bitCount = std::bit_ceil(size_t(mCapacity) * BitsPerValue);
+        mBits.assign(bitCount / 64, 0);
+        mMask = bitCount - 1;
+    }
+
+    void add(ValueKind kind, const QString &value)
+    {
+        // Empty values are never looked up, see ItemMergeIndex::mayContain()
+        if (value.isEmpty()) {
+            return;
+        }
+        forEachBit(kind, value, [this](size_t bit) {
+            mBits[bit / 64] |= quint64(1) << (bit % 64);
+            return true;
+        });
+        ++mCount;
+    }
+
+    void add(const Entry &entry)
+    {
+        add(ValueKind::RemoteId, entry.remoteId);
+        add(ValueKind::Gid, entry.gid);
+    }
+
+    [[nodiscard]] bool contains(ValueKind kind, const QString &value) const
+    {
+        if (value.isEmpty()) {
+            return true;
+        }
+        return forEachBit(kind, value, [this](size_t bit) {
+            return (mBits[bit / 64] & (quint64(1) << (bit % 64))) != 0;
+        });
+    }
+
+    [[nodiscard]] bool isFull() const
+    {
+        return mCount > mCapacity;
+    }
+
+    bool ready = false;
+    quint64 lastUsed = 0;
+    // Entries added while the filter is being loaded
+    QList<Entry> pending;
+
+private:
+    template<typename Func>
+    bool forEachBit(ValueKind kind, const QString &value, Func &&func) const
+    {
+        const QString key = normalized(value);
+        const auto seed = size_t(kind) * 2;
+        const size_t h1 = qHash(key, seed + 1);
+        const size_t h2 = qHash(key, seed + 2) | 1;
+        for (size_t i = 0; i < HashCount; ++i) {
+            if (!func((h1 + i * h2) & mMask)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<quint64> mBits;
+    size_t mMask = 0;
+    qsizetype mCapacity = 0;
+    qsizetype mCount = 0;
+};
+
+ItemMergeIndex::~ItemMergeIndex() = default;
+
+bool ItemMergeIndex::mayContain(Collection::Id collectionId, bool ridMerge, const QString &remoteId, bool gidMerge, const QString &gid)
+{
+    std::shared_ptr<Filter> filter;
+    {
+        QMutexLocker locker(&mLock);
+        filter = mFilters.value(collectionId);
+        if (filter && filter->isFull()) {
+            mFilters.remove(collectionId);
+            filter.reset();
+        }
+        if (filter && !filter->ready) {
+            // Another connection is loading the filter
+            return true;
+        }
+        if (!filter) {
+            if (mFilters.size() >= MaxCollections) {
+                const auto lru = std::min_element(mFilters.cbegin(), mFilters.cend(), [](const auto &lhs, const auto &rhs) {
+                    return lhs->lastUsed < rhs->lastUsed;
+                });
+                mFilters.erase(lru);
+            }
+            filter = std::make_shared<Filter>();
+            // Register the filter before loading it, so that it also receives the items
+            // stored while the items of the collection are being loaded
+            mFilters.insert(collectionId, filter);
+
+            locker.unlock();
+            QList<Entry> entries;
+            const bool loaded = loadEntries(collectionId, entries);
+            locker.relock();
+
+            if (mFilters.value(collectionId) != filter) {
+                // Invalidated while loading
+                return true;
+            }
+            if (!loaded) {
+                mFilters.remove(collectionId);
+                return true;
+            }
+            filter->reserve((entries.size() + filter->pending.size()) * 2);
+            for (const Entry &entry : std::as_const(entries)) {
+                filter->add(entry);
+            }
+            for (const Entry &entry : std::as_const(filter->pending)) {
+                filter->add(entry);
+            }
+            filter->pending.clear();
+            filter->ready = true;
+            qCDebug(AKONADISERVER_LOG) << "Built item merge filter for collection" << collectionId << "with" << entries.size() << "items";
+        }
+
+        filter->lastUsed = ++mLookupCounter;
+
+        const bool ridMatches = filter->contains(ValueKind::RemoteId, remoteId);
+        // Matches the merge conditions of ItemCreateHandler::parseStream()
+        const bool mergeCandidate = (!gidMerge || filter->contains(ValueKind::Gid, gid)) && (!ridMerge || ridMatches);
+        const bool emptyGidCandidate = gidMerge && !remoteId.isEmpty() && ridMatches;
+        return mergeCandidate || emptyGidCandidate;
+    }
+}
+
+void ItemMergeIndex::addEntries(const QList<Entry> &entries)
+{
+    QMutexLocker locker(&mLock);
+    if (mFilters.isEmpty()) {
+        return;
+    }
+    for (const Entry &entry : entries) {
+        const auto filter = mFilters.value(entry.collectionId);
+        if (!filter) {
+            continue;
+        }
+        if (filter->ready) {
+            filter->add(entry);
+        } else {
+            filter->pending.push_back(entry);
+        }
+    }
+}
+
+void ItemMergeIndex::invalidateCollection(Collection::Id collectionId)
+{
+    QMutexLocker locker(&mLock);
+    mFilters.remove(collectionId);
+}
+
+void ItemMergeIndex::clear()
+{
+    QMutexLocker locker(&mLock);
+    mFilters.clear();
+}
+
+bool ItemMergeIndex::loadEntries(Collection::Id collectionId, QList<Entry> &entries)
+{
+    // A transaction does not see the items committed by other connections after its snapshot was taken, and
+    // those were not reported to the filter, which did not exist yet. They are loaded on a connection of
+    // their own, after the filter has been registered. Only the transaction sees the items it has written.
+    // SQLite has no concurrent writers, so its transactions cannot miss any commits.
+    DataStore *store = DataStore::self();
+    if (store->inTransaction() && DbType::type(store->database()) != DbType::Sqlite && !loadCommittedEntries(collectionId, entries)) {
+        return false;
+    }
+
+    QueryBuilder qb(PimItem::tableName());
+    qb.addColumn(PimItem::remoteIdColumn());
+    qb.addColumn(PimItem::gidColumn());
+    qb.addValueCondition(PimItem::collectionIdColumn(), Query::Equals, collectionId);
+    if (!qb.exec()) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to load the items of collection" << collectionId << "for the item merge filter";
+        return false;
+    }
+
+    auto &query = qb.query();
+    while (query.next()) {
+        entries.push_back({collectionId, Utils::variantToString(query.value(0)), Utils::variantToString(query.value(1))});
+    }
+    query.finish();
+    return true;
+}
+
+bool ItemMergeIndex::loadCommittedEntries(Collection::Id collectionId, QList<Entry> &entries)
+{
+    // Not a DataStore, which would share the prepared queries of the thread with the DataStore of the caller
+    const QString connectionName = QStringLiteral("ItemMergeIndex-%1").arg(reinterpret_cast<quintptr>(QThread::currentThread()));
+    bool loaded = false;
+    {
+        QSqlDatabase db = QSqlDatabase::cloneDatabase(DataStore::self()->database(), connectionName);
+        if (db.open()) {
+            DbConfig::configuredDatabase()->initSession(db);
+            QSqlQuery query(db);
+            query.prepare(QStringLiteral("SELECT %1, %2 FROM %3 WHERE %4 = ?")
+                              .arg(PimItem::remoteIdColumn(), PimItem::gidColumn(), PimItem::tableName(), PimItem::collectionIdColumn()));
+            query.addBindValue(collectionId);
+            if (query.exec()) {
+                while (query.next()) {
+                    entries.push_back({collectionId, Utils::variantToString(query.value(0)), Utils::variantToString(query.value(1))});
+                }
+                loaded = true;
+            } else {
+                qCWarning(AKONADISERVER_LOG) << "Failed to load the committed items of collection" << collectionId << ":" << query.lastError().text();
+            }
+        } else {
+            qCWarning(AKONADISERVER_LOG) << "Failed to open a database connection for the item merge filter:" << db.lastError().text();
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return loaded;
+}
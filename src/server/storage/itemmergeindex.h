@@ -0,0 +1,102 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "entities.h"
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include <memory>
+
+namespace Akonadi
+{
+namespace Server
+{
+/**
+ * Negative lookup filter for item merging
+ *
+ * Merging an item during ItemCreate requires looking up an existing item with the
+ * same remote ID or GID in the target collection. During a sync most of these
+ * lookups are for new items and don't find anything. This index keeps a bloom
+ * filter of the remote IDs and GIDs of every collection items have been merged
+ * into, so that the query can be skipped when the filter tells that no such item
+ * exists.
+ *
+ * The filter of a collection is built on the first lookup, from the items visible to
+ * the current transaction and the items committed by other connections. Afterwards it is kept
+ * up to date by the NotificationCollector, which reports the remote IDs and GIDs of
+ * items that are created, modified or moved into the collection, both when they are
+ * written and when the transaction is committed. Removed items are never removed from
+ * the filter: this only causes false positives, which are resolved by the query.
+ * A filter which has received too many values is rebuilt.
+ *
+ * Positive lookups always go to the database, since the existing item has to be
+ * retrieved and locked for the merge anyway.
+ */
+class ItemMergeIndex
+{
+public:
+    struct Entry {
+        Collection::Id collectionId;
+        QString remoteId;
+        QString gid;
+    };
+
+    static constexpr qsizetype MaxCollections = 64;
+
+    explicit ItemMergeIndex() = default;
+    virtual ~ItemMergeIndex();
+
+    /**
+     * Returns false if the collection @p collectionId certainly doesn't contain a merge
+     * candidate for an item with the given @p remoteId and @p gid, true if it might.
+     *
+     * The merge conditions are the ones of ItemCreateHandler: with @p ridMerge the remote ID
+     * has to match, with @p gidMerge the GID has to match, or the remote ID of an item without
+     * GID. Builds the filter of the collection if it doesn't exist yet.
+     */
+    bool mayContain(Collection::Id collectionId, bool ridMerge, const QString &remoteId, bool gidMerge, const QString &gid);
+
+    /**
+     * Records the remote IDs and GIDs of @p entries in the filters of their collections.
+     */
+    void addEntries(const QList<Entry> &entries);
+
+    /**
+     * Drops the filter of the collection @p collectionId.
+     */
+    void invalidateCollection(Collection::Id collectionId);
+
+    /**
+     * Drops all filters.
+     */
+    void clear();
+
+protected:
+    /**
+     * Loads the remote IDs and GIDs of all items in the collection @p collectionId,
+     * including the ones committed by other connections after the snapshot of the
+     * current transaction was taken.
+     */
+    virtual bool loadEntries(Collection::Id collectionId, QList<Entry> &entries);
+
+private:
+    class Filter;
+
+    /** Loads the items of @p collectionId committed so far on a database connection of its own. */
+    bool loadCommittedEntries(Collection::Id collectionId, QList<Entry> &entries);
+
+    QMutex mLock;
+    QHash<Collection::Id, std::shared_ptr<Filter>> mFilters;
+    quint64 mLookupCounter = 0;
+};
+
+} // namespace Server
+} // namespace Akonadi
@@ -7,6 +7,7 @@
 
 #include "itemretriever.h"
 
+#include "commandscheduler.h"
 #include "connection.h"
 #include "storage/itemqueryhelper.h"
 #include "storage/itemretrievalmanager.h"
@@ -186,10 +187,13 @@ bool ItemRetriever::runItemRetrievalRequests(std::list<ItemRetrievalRequest> req
 {
     QEventLoop eventLoop;
     std::vector<ItemRetrievalRequest::Id> pendingRequests;
+    // The items are delivered by the resources through their own connections, so do not
+    // block an execution slot while waiting for them
+    std::optional<CommandScheduler::Yield> yield;
     connect(&mItemRetrievalManager,
             &ItemRetrievalManager::requestFinished,
             &eventLoop,
-            [this, &eventLoop, &pendingRequests](const ItemRetrievalResult &result) { // clazy:exclude=lambda-in-connect
+            [this, &eventLoop, &pendingRequests, &yield](const ItemRetrievalResult &result) { // clazy:exclude=lambda-in-connect
                 const auto requestId = std::find(pendingRequests.begin(), pendingRequests.end(), result.request.id);
                 if (requestId != pendingRequests.end()) {
                     if (mCanceled) {
@@ -198,7 +202,9 @@ bool ItemRetriever::runItemRetrievalRequests(std::list<ItemRetrievalRequest> req
                         mLastError = result.errorMsg->toUtf8();
                         eventLoop.exit(1);
                     } else {
+                        yield.reset();
                         Q_EMIT itemsRetrieved(result.request.ids);
+                        yield.emplace();
                         pendingRequests.erase(requestId);
                         if (pendingRequests.empty()) {
                             eventLoop.quit();
@@ -234,7 +240,10 @@ bool ItemRetriever::runItemRetrievalRequests(std::list<ItemRetrievalRequest> req
     }
 
     if (!pendingRequests.empty()) {
-        if (eventLoop.exec()) {
+        yield.emplace();
+        const int result = eventLoop.exec();
+        yield.reset();
+        if (result) {
             return false;
         }
     }
@@ -15,12 +15,14 @@
 #include "intervalcheck.h"
 #include "notificationmanager.h"
 #include "protocol_p.h"
+#include "search/fulltextindexer.h"
 #include "search/searchmanager.h"
 #include "selectquerybuilder.h"
 #include "shared/akranges.h"
 #include "storage/collectionstatistics.h"
 #include "storage/datastore.h"
 #include "storage/entity.h"
+#include "storage/itemmergeindex.h"
 
 #include "akonadiserver_debug.h"
 
@@ -35,11 +37,24 @@ NotificationCollector::NotificationCollector(AkonadiServer &akonadi, DataStore *
     , mAkonadi(akonadi)
 {
     QObject::connect(db, &DataStore::transactionCommitted, db, [this]() {
+        for (const auto &move : std::as_const(mStatisticsMoves)) {
+            mAkonadi.collectionStatistics().itemsMoved(move.source, move.destination, move.delta);
+        }
+        mStatisticsMoves.clear();
+        if (!mItemMergeIndexEntries.isEmpty()) {
+            mAkonadi.itemMergeIndex().addEntries(mItemMergeIndexEntries);
+            mItemMergeIndexEntries.clear();
+        }
         if (!mIgnoreTransactions) {
             dispatchNotifications();
         }
     });
     QObject::connect(db, &DataStore::transactionRolledBack, db, [this]() {
+        for (const auto &move : std::as_const(mStatisticsMoves)) {
+            mAkonadi.collectionStatistics().itemsMoveAborted(move.source, move.destination);
+        }
+        mStatisticsMoves.clear();
+        mItemMergeIndexEntries.clear();
         if (!mIgnoreTransactions) {
             clear();
         }
@@ -50,12 +65,16 @@ void NotificationCollector::itemAdded(const PimItem &item, bool seen, const Coll
 {
     mAkonadi.searchManager().scheduleSearchUpdate();
     mAkonadi.collectionStatistics().itemAdded(collection, item.size(), seen);
+    updateItemMergeIndex({item}, collection.isValid() ? collection.id() : item.collectionId());
     itemNotification(Protocol::ItemChangeNotification::Add, item, collection, Collection(), resource);
 }
 
 void NotificationCollector::itemChanged(const PimItem &item, const QSet<QByteArray> &changedParts, const Collection &collection, const QByteArray &resource)
 {
     mAkonadi.searchManager().scheduleSearchUpdate();
+    if (changedParts.contains(AKONADI_PARAM_REMOTEID) || changedParts.contains(AKONADI_PARAM_GID)) {
+        updateItemMergeIndex({item}, item.collectionId());
+    }
     itemNotification(Protocol::ItemChangeNotification::Modify, item, collection, Collection(), resource, changedParts);
 }
 
@@ -96,6 +115,7 @@ void NotificationCollector::itemsMoved(const PimItem::List &items,
                                        const QByteArray &sourceResource)
 {
     mAkonadi.searchManager().scheduleSearchUpdate();
+    updateItemMergeIndex(items, collectionDest.id());
     itemNotification(Protocol::ItemChangeNotification::Move, items, collectionSrc, collectionDest, sourceResource);
 }
 
@@ -104,6 +124,22 @@ void NotificationCollector::itemsRemoved(const PimItem::List &items, const Colle
     itemNotification(Protocol::ItemChangeNotification::Remove, items, collection, Collection(), resource);
 }
 
+void NotificationCollector::itemIdentifiersChanged(const PimItem &item)
+{
+    updateItemMergeIndex({item}, item.collectionId());
+}
+
+void NotificationCollector::itemStatisticsMoved(const Collection &source, const Collection &destination, const CollectionStatistics::Statistics &delta)
+{
+    auto &statistics = mAkonadi.collectionStatistics();
+    statistics.beginItemsMove(source, destination);
+    if (mDb->inTransaction()) {
+        mStatisticsMoves.push_back({source, destination, delta});
+    } else {
+        statistics.itemsMoved(source, destination, delta);
+    }
+}
+
 void NotificationCollector::itemsLinked(const PimItem::List &items, const Collection &collection)
 {
     itemNotification(Protocol::ItemChangeNotification::Link, items, collection, Collection(), QByteArray());
@@ -157,6 +193,7 @@ void NotificationCollector::collectionRemoved(const Collection &collection, cons
     }
     mAkonadi.intervalChecker().collectionRemoved(collection.id());
     mAkonadi.collectionStatistics().invalidateCollection(collection);
+    mAkonadi.itemMergeIndex().invalidateCollection(collection.id());
     collectionNotification(Protocol::CollectionChangeNotification::Remove, collection, collection.parentId(), -1, resource);
 }
 
@@ -199,6 +236,22 @@ void NotificationCollector::clear()
     mNotifications.clear();
 }
 
+void NotificationCollector::updateItemMergeIndex(const PimItem::List &items, Collection::Id collectionId)
+{
+    QList<ItemMergeIndex::Entry> entries;
+    entries.reserve(items.size());
+    for (const PimItem &item : items) {
+        entries.push_back({collectionId, item.remoteId(), item.gid()});
+    }
+    // Items stored by this transaction might be looked up before it is committed, so they are
+    // added right away. A filter built by another connection in the meantime doesn't see them
+    // until the transaction is committed though, so they are added to it again on commit.
+    mAkonadi.itemMergeIndex().addEntries(entries);
+    if (mDb->inTransaction()) {
+        mItemMergeIndexEntries.append(entries);
+    }
+}
+
 void NotificationCollector::setConnection(Connection *connection)
 {
     mConnection = connection;
@@ -321,9 +374,10 @@ void NotificationCollector::itemNotification(Protocol::ItemChangeNotification::O
     }
     msg->setResource(res);
 
-    // Add and ModifyFlags are handled incrementally
-    // (see itemAdded() and itemsFlagsChanged())
-    if (msg->operation() != Protocol::ItemChangeNotification::Add && msg->operation() != Protocol::ItemChangeNotification::ModifyFlags) {
+    // Add, ModifyFlags and Move are handled incrementally
+    // (see itemAdded(), itemsFlagsChanged() and ItemMoveHandler)
+    if (msg->operation() != Protocol::ItemChangeNotification::Add && msg->operation() != Protocol::ItemChangeNotification::ModifyFlags
+        && msg->operation() != Protocol::ItemChangeNotification::Move) {
         mAkonadi.collectionStatistics().invalidateCollection(col);
     }
     dispatchNotification(msg);
@@ -605,6 +659,9 @@ bool NotificationCollector::dispatchNotifications()
 
 void NotificationCollector::notify(Protocol::ChangeNotificationList &&msgs)
 {
+    if (auto indexer = mAkonadi.fullTextIndexer()) {
+        indexer->notify(msgs);
+    }
     if (auto mgr = mAkonadi.notificationManager()) {
         QMetaObject::invokeMethod(mgr, "slotNotify", Qt::QueuedConnection, Q_ARG(Akonadi::Protocol::ChangeNotificationList, msgs));
     }
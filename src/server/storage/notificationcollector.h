@@ -7,6 +7,8 @@
 #pragma once
 
 #include "entities.h"
+#include "storage/collectionstatistics.h"
+#include "storage/itemmergeindex.h"
 
 #include "private/protocol_p.h"
 
@@ -100,6 +102,19 @@ public:
     */
     void itemsRemoved(const PimItem::List &items, const Collection &collection = Collection(), const QByteArray &resource = QByteArray());
 
+    /**
+      Records a change of the remote ID or GID of @p item which is not announced
+      by itemChanged(), so that the ItemMergeIndex stays up to date.
+    */
+    void itemIdentifiersChanged(const PimItem &item);
+
+    /**
+      Records that items with the statistics @p delta are moved from @p source
+      to @p destination. The cached statistics of both collections are updated
+      when the transaction is committed, and not cached until then.
+    */
+    void itemStatisticsMoved(const Collection &source, const Collection &destination, const CollectionStatistics::Statistics &delta);
+
     /**
      * Notify about linked items
      */
@@ -204,6 +219,8 @@ private:
     void dispatchNotification(const Protocol::ChangeNotificationPtr &msg);
     void clear();
 
+    void updateItemMergeIndex(const PimItem::List &items, Collection::Id collectionId);
+
     void completeNotification(const Protocol::ChangeNotificationPtr &msg);
 
 protected:
@@ -218,6 +235,15 @@ private:
     bool mIgnoreTransactions = false;
 
     Protocol::ChangeNotificationList mNotifications;
+    // Added to the ItemMergeIndex again on commit, see updateItemMergeIndex()
+    QList<ItemMergeIndex::Entry> mItemMergeIndexEntries;
+    struct StatisticsMove {
+        Collection source;
+        Collection destination;
+        CollectionStatistics::Statistics delta;
+    };
+    // Applied to the CollectionStatistics on commit, see itemStatisticsMoved()
+    QList<StatisticsMove> mStatisticsMoves;
 };
 
 } // namespace Server
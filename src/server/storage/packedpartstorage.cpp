@@ -0,0 +1,294 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "packedpartstorage.h"
+#include "akonadiserver_debug.h"
+
+#include "private/externalpartstorage_p.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QtEndian>
+
+#include <iterator>
+#include <limits>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+using namespace Akonadi::Server;
+
+namespace
+{
+// Every record starts with the magic and the size of the data, so that a segment can be inspected
+// without the database
+constexpr char RecordMagic[] = {'A', 'K', 'P', 'K'};
+constexpr qint64 RecordHeaderSize = sizeof(RecordMagic) + sizeof(quint32);
+static_assert(PackedPartStorage::MaxPartSize + RecordHeaderSize <= PackedPartStorage::MaxSegmentSize);
+static_assert(PackedPartStorage::MaxPartSize <= std::numeric_limits<quint32>::max());
+
+const QLatin1StringView SegmentSuffix(".pack");
+const QLatin1StringView RetiredSuffix(".retired");
+
+qint64 segmentFromFileName(const QString &fileName)
+{
+    if (!fileName.endsWith(SegmentSuffix)) {
+        return -1;
+    }
+    bool ok = false;
+    const qint64 segment = QStringView(fileName).chopped(SegmentSuffix.size()).toLongLong(&ok);
+    return ok ? segment : -1;
+}
+
+} // namespace
+
+bool PackedPartStorage::Location::isValid() const
+{
+    return segment >= 0 && offset >= 0 && size >= 0;
+}
+
+QByteArray PackedPartStorage::Location::toByteArray() const
+{
+    return QByteArray::number(segment) + ':' + QByteArray::number(offset) + ':' + QByteArray::number(size);
+}
+
+PackedPartStorage::Location PackedPartStorage::Location::fromByteArray(const QByteArray &data)
+{
+    const auto fields = data.split(':');
+    if (fields.size() != 3) {
+        return {};
+    }
+    Location location;
+    bool ok[3] = {false, false, false};
+    location.segment = fields[0].toLongLong(&ok[0]);
+    location.offset = fields[1].toLongLong(&ok[1]);
+    location.size = fields[2].toLongLong(&ok[2]);
+    if (!ok[0] || !ok[1] || !ok[2]) {
+        return {};
+    }
+    return location;
+}
+
+PackedPartStorage::PackedPartStorage() = default;
+
+PackedPartStorage::~PackedPartStorage() = default;
+
+PackedPartStorage *PackedPartStorage::self()
+{
+    static PackedPartStorage sInstance;
+    return &sInstance;
+}
+
+QString PackedPartStorage::storagePath()
+{
+    return ExternalPartStorage::akonadiStoragePath() + QDir::separator() + QLatin1StringView("packs");
+}
+
+QString PackedPartStorage::segmentPath(qint64 segment)
+{
+    return storagePath() + QDir::separator() + QString::number(segment) + SegmentSuffix;
+}
+
+bool PackedPartStorage::openActiveSegment(qint64 minSize)
+{
+    if (mActiveFile && (mActiveFile->size() == 0 || mActiveFile->size() + minSize <= MaxSegmentSize)) {
+        return true;
+    }
+
+    qint64 segment = mActiveSegment;
+    if (mActiveFile) {
+        syncActiveSegment();
+        mActiveFile.reset();
+        ++segment;
+    } else {
+        // Continue with the last segment after a restart
+        const auto sizes = segmentSizes();
+        if (sizes.isEmpty()) {
+            segment = 0;
+        } else {
+            const auto last = std::prev(sizes.cend());
+            segment = (last.value() + minSize <= MaxSegmentSize) ? last.key() : last.key() + 1;
+        }
+        while (QFile::exists(segmentPath(segment) + RetiredSuffix)) {
+            ++segment;
+        }
+    }
+
+    if (!QDir().mkpath(storagePath())) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to create packed part directory" << storagePath();
+        return false;
+    }
+    auto file = std::make_unique<QFile>(segmentPath(segment));
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to open packed part segment" << file->fileName() << ":" << file->errorString();
+        return false;
+    }
+    mActiveFile = std::move(file);
+    mActiveSegment = segment;
+    return true;
+}
+
+bool PackedPartStorage::appendPart(const QByteArray &data, QByteArray &location, const DataStore *owner)
+{
+    if (data.size() > MaxPartSize) {
+        qCWarning(AKONADISERVER_LOG) << "Part of" << data.size() << "bytes is too big to be packed";
+        return false;
+    }
+
+    QMutexLocker locker(&mLock);
+    if (!openActiveSegment(RecordHeaderSize + data.size())) {
+        return false;
+    }
+
+    QByteArray record;
+    record.reserve(RecordHeaderSize + data.size());
+    record.append(RecordMagic, sizeof(RecordMagic));
+    const quint32 size = qToBigEndian<quint32>(data.size());
+    record.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    record.append(data);
+
+    const qint64 offset = mActiveFile->size();
+    if (mActiveFile->write(record) != record.size() || !mActiveFile->flush()) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to append part to segment" << mActiveFile->fileName() << ":" << mActiveFile->errorString();
+        // Reopen the segment, new records are appended after the partial one
+        mActiveFile.reset();
+        return false;
+    }
+    mDirty = true;
+    if (owner) {
+        mPendingSegments[owner].insert(mActiveSegment);
+    }
+
+    location = Location{mActiveSegment, offset, data.size()}.toByteArray();
+    return true;
+}
+
+void PackedPartStorage::releasePendingRecords(const DataStore *owner)
+{
+    QMutexLocker locker(&mLock);
+    mPendingSegments.remove(owner);
+}
+
+QSet<qint64> PackedPartStorage::pendingSegments() const
+{
+    QMutexLocker locker(&mLock);
+    QSet<qint64> segments;
+    for (const auto &ownerSegments : mPendingSegments) {
+        segments.unite(ownerSegments);
+    }
+    return segments;
+}
+
+bool PackedPartStorage::readPart(const QByteArray &locationData, QByteArray &data) const
+{
+    const auto location = Location::fromByteArray(locationData);
+    if (!location.isValid()) {
+        qCWarning(AKONADISERVER_LOG) << "Invalid packed part location" << locationData;
+        return false;
+    }
+
+    QFile file(segmentPath(location.segment));
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to open packed part segment" << file.fileName() << ":" << file.errorString();
+        return false;
+    }
+    if (!file.seek(location.offset)) {
+        qCWarning(AKONADISERVER_LOG) << "Packed part location" << locationData << "is beyond the end of the segment";
+        return false;
+    }
+    const QByteArray header = file.read(RecordHeaderSize);
+    if (header.size() != RecordHeaderSize || !header.startsWith(QByteArrayView(RecordMagic, sizeof(RecordMagic)))
+        || qFromBigEndian<quint32>(header.constData() + sizeof(RecordMagic)) != location.size) {
+        qCWarning(AKONADISERVER_LOG) << "No valid packed part record at location" << locationData;
+        return false;
+    }
+    data = file.read(location.size);
+    if (data.size() != location.size) {
+        qCWarning(AKONADISERVER_LOG) << "Truncated packed part record at location" << locationData;
+        data.clear();
+        return false;
+    }
+    return true;
+}
+
+void PackedPartStorage::syncActiveSegment()
+{
+    if (!mDirty || !mActiveFile) {
+        return;
+    }
+    mActiveFile->flush();
+#ifdef Q_OS_UNIX
+    if (::fsync(mActiveFile->handle()) != 0) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to sync packed part segment" << mActiveFile->fileName();
+    }
+#endif
+    mDirty = false;
+}
+
+void PackedPartStorage::sync()
+{
+    QMutexLocker locker(&mLock);
+    syncActiveSegment();
+}
+
+qint64 PackedPartStorage::activeSegment() const
+{
+    QMutexLocker locker(&mLock);
+    return mActiveSegment;
+}
+
+QMap<qint64, qint64> PackedPartStorage::segmentSizes() const
+{
+    QMap<qint64, qint64> sizes;
+    const QDir dir(storagePath());
+    const auto entries = dir.entryInfoList({QStringLiteral("*") + SegmentSuffix}, QDir::Files);
+    for (const auto &entry : entries) {
+        const qint64 segment = segmentFromFileName(entry.fileName());
+        if (segment >= 0 && !QFile::exists(entry.filePath() + RetiredSuffix)) {
+            sizes.insert(segment, entry.size());
+        }
+    }
+    return sizes;
+}
+
+bool PackedPartStorage::retireSegment(qint64 segment)
+{
+    if (segment == activeSegment()) {
+        qCWarning(AKONADISERVER_LOG) << "Refusing to retire the active packed part segment" << segment;
+        return false;
+    }
+    QFile marker(segmentPath(segment) + RetiredSuffix);
+    if (!marker.open(QIODevice::WriteOnly)) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to retire packed part segment" << segment << ":" << marker.errorString();
+        return false;
+    }
+    return true;
+}
+
+int PackedPartStorage::removeRetiredSegments(std::chrono::seconds minAge)
+{
+    const QDir dir(storagePath());
+    const auto markers = dir.entryInfoList({QStringLiteral("*") + SegmentSuffix + RetiredSuffix}, QDir::Files);
+    const auto cutoff = QDateTime::currentDateTimeUtc().addSecs(-minAge.count());
+    int count = 0;
+    for (const auto &marker : markers) {
+        if (marker.lastModified().toUTC() > cutoff) {
+            continue;
+        }
+        const QString segment = marker.filePath().chopped(RetiredSuffix.size());
+        if (QFile::exists(segment) && !QFile::remove(segment)) {
+            qCWarning(AKONADISERVER_LOG) << "Failed to remove retired packed part segment" << segment;
+            continue;
+        }
+        QFile::remove(marker.filePath());
+        ++count;
+    }
+    return count;
+}
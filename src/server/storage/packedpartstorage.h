@@ -0,0 +1,136 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+#include <chrono>
+#include <memory>
+
+class QFile;
+
+namespace Akonadi
+{
+namespace Server
+{
+class DataStore;
+
+/**
+ * Append-only segment files for small payload parts
+ *
+ * Storing every part above the size threshold in a file of its own results in
+ * millions of small files for big mail folders, and anything that walks the
+ * external part storage is dominated by file system metadata operations. Parts
+ * not bigger than DbConfig::packedPartThreshold() are instead appended to a
+ * shared segment file. The data column of a Part with Packed storage holds the
+ * location of its record, see Location.
+ *
+ * Records are never modified. Updating a part appends a new record, and the
+ * records of removed or updated parts stay in the segment until it is compacted
+ * by the StorageJanitor, which moves the remaining parts of mostly unused
+ * segments into the active segment and retires the old segment. Retired segments
+ * are removed once no reader can still refer to them.
+ *
+ * Appended records are flushed to disk before the database transaction that
+ * refers to them is committed, see sync(). Records written by a transaction that
+ * is rolled back, or interrupted by a crash, are never referenced and are dropped
+ * by the compaction as well. Until then, the segments holding records of open
+ * transactions are reported by pendingSegments(), as the parts referring to them
+ * are not visible to the compaction yet.
+ */
+class PackedPartStorage
+{
+public:
+    /// Segments are not extended beyond this size
+    static constexpr qint64 MaxSegmentSize = 64 * 1024 * 1024;
+    /// Bigger parts do not fit into a segment together with the record header
+    static constexpr qint64 MaxPartSize = MaxSegmentSize - 8;
+
+    struct Location {
+        qint64 segment = -1;
+        qint64 offset = -1;
+        qint64 size = -1;
+
+        [[nodiscard]] bool isValid() const;
+        [[nodiscard]] QByteArray toByteArray() const;
+        static Location fromByteArray(const QByteArray &data);
+    };
+
+    static PackedPartStorage *self();
+
+    ~PackedPartStorage();
+
+    /** Returns the directory holding the segment files. */
+    static QString storagePath();
+    /** Returns the path of the segment file @p segment. */
+    static QString segmentPath(qint64 segment);
+
+    /**
+     * Appends @p data to the active segment and stores the location of the new
+     * record in @p location.
+     *
+     * If @p owner is set, the segment is reported as pending until
+     * releasePendingRecords() is called for @p owner, which must happen once
+     * the part referring to the record has been committed or rolled back.
+     */
+    bool appendPart(const QByteArray &data, QByteArray &location, const DataStore *owner = nullptr);
+
+    /** Marks the records appended by @p owner as no longer pending. */
+    void releasePendingRecords(const DataStore *owner);
+
+    /** Returns the segments holding records which are still pending. */
+    QSet<qint64> pendingSegments() const;
+
+    /**
+     * Reads the record at @p location into @p data.
+     */
+    bool readPart(const QByteArray &location, QByteArray &data) const;
+
+    /**
+     * Makes sure that all appended records are written to disk.
+     */
+    void sync();
+
+    /** Returns the segment new records are appended to, or -1 if none has been opened yet. */
+    qint64 activeSegment() const;
+
+    /** Returns the sizes of all segments which are not retired, by segment. */
+    QMap<qint64, qint64> segmentSizes() const;
+
+    /**
+     * Marks @p segment as no longer used. The segment is removed by
+     * removeRetiredSegments() once it has been retired for long enough that
+     * no reader can still be using a location in it.
+     */
+    bool retireSegment(qint64 segment);
+
+    /**
+     * Removes segments that have been retired at least @p minAge ago.
+     * Returns the number of removed segments.
+     */
+    int removeRetiredSegments(std::chrono::seconds minAge);
+
+private:
+    explicit PackedPartStorage();
+
+    bool openActiveSegment(qint64 minSize);
+    void syncActiveSegment();
+
+    mutable QMutex mLock;
+    std::unique_ptr<QFile> mActiveFile;
+    qint64 mActiveSegment = -1;
+    bool mDirty = false;
+    QHash<const DataStore *, QSet<qint64>> mPendingSegments;
+};
+
+} // namespace Server
+} // namespace Akonadi
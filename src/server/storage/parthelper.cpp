@@ -6,12 +6,16 @@
  ***************************************************************************/
 
 #include "parthelper.h"
+#include "datastore.h"
 #include "dbconfig.h"
+#include "packedpartstorage.h"
 #include "parttypehelper.h"
 #include "selectquerybuilder.h"
+#include "utils.h"
 
 #include "private/externalpartstorage_p.h"
 
+#include <QCryptographicHash>
 #include <QFile>
 
 #include "akonadiserver_debug.h"
@@ -19,22 +23,67 @@
 using namespace Akonadi;
 using namespace Akonadi::Server;
 
+namespace
+{
+// Tombstones inserted by a single statement, well below the bind value limit of all backends
+constexpr qsizetype TombstoneBatchSize = 500;
+
+QByteArray appendPackedPart(const QByteArray &data)
+{
+    QByteArray location;
+    // The record stays pending until the part referring to it has been committed, see releasePackedParts()
+    if (!PackedPartStorage::self()->appendPart(data, location, DataStore::self())) {
+        throw PartHelperException(QStringLiteral("Failed to append packed payload part"));
+    }
+    // Otherwise the record is synced before the transaction is committed
+    if (!DataStore::self()->inTransaction()) {
+        PackedPartStorage::self()->sync();
+    }
+    return location;
+}
+
+void releasePackedParts()
+{
+    // Otherwise the DataStore releases them when the transaction ends
+    if (!DataStore::self()->inTransaction()) {
+        PackedPartStorage::self()->releasePendingRecords(DataStore::self());
+    }
+}
+
+} // namespace
+
+Part::Storage PartHelper::storageForSize(qint64 dataSize)
+{
+    const auto *config = DbConfig::configuredDatabase();
+    if (dataSize <= config->sizeThreshold()) {
+        return Part::Internal;
+    }
+    return dataSize <= config->packedPartThreshold() ? Part::Packed : Part::External;
+}
+
 void PartHelper::update(Part *part, const QByteArray &data, qint64 dataSize)
 {
     if (!part) {
         throw PartHelperException("Invalid part");
     }
 
-    const bool storeExternal = dataSize > DbConfig::configuredDatabase()->sizeThreshold();
+    const Part::Storage newStorage = storageForSize(dataSize);
+    const bool storeExternal = newStorage == Part::External;
+    part->setContentHash(contentHash(data));
+    // Share the file of an existing part with the same content instead of writing another copy
+    const QByteArray sharedFile = storeExternal ? findExternalPartFile(part->contentHash(), dataSize, part->id()) : QByteArray();
 
     QByteArray newFile;
+    auto *storage = ExternalPartStorage::self();
     if (part->storage() == Part::External && storeExternal) {
-        if (!ExternalPartStorage::self()->updatePartFile(data, part->data(), newFile)) {
+        if ((sharedFile.isEmpty() || !storage->updatePartFileLink(sharedFile, part->data(), newFile))
+            && !storage->updatePartFile(data, part->data(), newFile)) {
             throw PartHelperException(QStringLiteral("Failed to update external payload part"));
         }
         part->setData(newFile);
     } else if (part->storage() != Part::External && storeExternal) {
-        if (!ExternalPartStorage::self()->createPartFile(data, part->id(), newFile)) {
+        if ((sharedFile.isEmpty() || !storage->createPartFileLink(sharedFile, part->id(), newFile))
+            && !storage->createPartFile(data, part->id(), newFile)) {
             throw PartHelperException(QStringLiteral("Failed to create external payload part"));
         }
         part->setData(newFile);
@@ -44,12 +93,20 @@ void PartHelper::update(Part *part, const QByteArray &data, qint64 dataSize)
             const QString file = ExternalPartStorage::resolveAbsolutePath(part->data());
             ExternalPartStorage::self()->removePartFile(file);
         }
-        part->setData(data);
-        part->setStorage(Part::Internal);
+        // The record of a previously packed payload is dropped by the next compaction
+        if (newStorage == Part::Packed) {
+            part->setData(appendPackedPart(data));
+        } else {
+            part->setData(data);
+        }
+        part->setStorage(newStorage);
     }
 
     part->setDatasize(dataSize);
     const bool result = part->update();
+    if (newStorage == Part::Packed) {
+        releasePackedParts();
+    }
     if (!result) {
         throw PartHelperException("Failed to update database record");
     }
@@ -61,23 +118,47 @@ bool PartHelper::insert(Part *part, qint64 *insertId)
         return false;
     }
 
-    const bool storeInFile = part->datasize() > DbConfig::configuredDatabase()->sizeThreshold();
+    // Copy by reference, the data is the file name of the part to share the payload with
+    const bool copyByReference = part->storage() == Part::External;
+    QByteArray sharedFile;
+    if (copyByReference) {
+        sharedFile = part->data();
+        if (sharedFile.isEmpty()) {
+            return false;
+        }
+    } else {
+        part->setContentHash(contentHash(part->data()));
+    }
+
+    const Part::Storage storage = copyByReference ? Part::External : storageForSize(part->datasize());
+    const bool storeInFile = storage == Part::External;
+    if (!copyByReference && storeInFile) {
+        sharedFile = findExternalPartFile(part->contentHash(), part->datasize());
+    }
     // it is needed to insert first the metadata so a new id is generated for the part,
     // and we need this id for the payload file name
     QByteArray data;
     if (storeInFile) {
         data = part->data();
         part->setData(QByteArray());
-        part->setStorage(Part::External);
-    } else {
-        part->setStorage(Part::Internal);
+    } else if (storage == Part::Packed) {
+        part->setData(appendPackedPart(part->data()));
     }
+    part->setStorage(storage);
 
     bool result = part->insert(insertId);
+    if (storage == Part::Packed) {
+        releasePackedParts();
+    }
 
     if (storeInFile && result) {
         QByteArray filename;
-        if (!ExternalPartStorage::self()->createPartFile(data, part->id(), filename)) {
+        auto *storage = ExternalPartStorage::self();
+        const bool linked = !sharedFile.isEmpty() && storage->createPartFileLink(sharedFile, part->id(), filename);
+        if (!linked && copyByReference) {
+            throw PartHelperException("Failed to share external payload part");
+        }
+        if (!linked && !storage->createPartFile(data, part->id(), filename)) {
             throw PartHelperException("Failed to create external payload part");
         }
         part->setData(filename);
@@ -119,9 +200,50 @@ bool PartHelper::remove(const QString &column, const QVariant &value)
     return Part::remove(column, value);
 }
 
+bool PartHelper::removeByItemIds(const QList<qint64> &itemIds)
+{
+    if (itemIds.isEmpty()) {
+        return true;
+    }
+
+    QueryBuilder qb(Part::tableName());
+    qb.addColumn(Part::dataColumn());
+    qb.addValueCondition(Part::pimItemIdColumn(), Query::In, itemIds);
+    qb.addValueCondition(Part::storageColumn(), Query::Equals, Part::External);
+    qb.addValueCondition(Part::dataColumn(), Query::IsNot, QVariant());
+    if (!qb.exec()) {
+        return false;
+    }
+    QVariantList fileNames;
+    auto &query = qb.query();
+    while (query.next()) {
+        fileNames.push_back(Utils::variantToByteArray(query.value(0)));
+    }
+    query.finish();
+
+    // An item may have any number of external parts, so the tombstones are inserted in chunks
+    for (qsizetype i = 0; i < fileNames.size(); i += TombstoneBatchSize) {
+        QueryBuilder tombstoneQb(PartFileTombstone::tableName(), QueryBuilder::Insert);
+        tombstoneQb.setColumnValues(PartFileTombstone::fileNameColumn(), fileNames.mid(i, TombstoneBatchSize));
+        if (!tombstoneQb.exec()) {
+            return false;
+        }
+    }
+
+    QueryBuilder removeQb(Part::tableName(), QueryBuilder::Delete);
+    removeQb.addValueCondition(Part::pimItemIdColumn(), Query::In, itemIds);
+    return removeQb.exec();
+}
+
 QByteArray PartHelper::translateData(const QByteArray &data, Part::Storage storage)
 {
-    if (storage == Part::External || storage == Part::Foreign) {
+    if (storage == Part::Packed) {
+        QByteArray payload;
+        if (!PackedPartStorage::self()->readPart(data, payload)) {
+            qCCritical(AKONADISERVER_LOG) << "Packed payload" << data << "could not be read!";
+        }
+        return payload;
+    } else if (storage == Part::External || storage == Part::Foreign) {
         QFile file;
         if (storage == Part::External) {
             file.setFileName(ExternalPartStorage::resolveAbsolutePath(data));
@@ -149,6 +271,50 @@ QByteArray PartHelper::translateData(const Part &part)
     return translateData(part.data(), part.storage());
 }
 
+QByteArray PartHelper::findExternalPartFile(const QString &hash, qint64 dataSize, qint64 excludePartId)
+{
+    if (hash.isEmpty()) {
+        return QByteArray();
+    }
+
+    QueryBuilder qb(Part::tableName());
+    qb.addColumn(Part::dataColumn());
+    qb.addValueCondition(Part::contentHashColumn(), Query::Equals, hash);
+    qb.addValueCondition(Part::datasizeColumn(), Query::Equals, dataSize);
+    qb.addValueCondition(Part::storageColumn(), Query::Equals, Part::External);
+    qb.addValueCondition(Part::idColumn(), Query::NotEquals, excludePartId);
+    qb.setLimit(1);
+    if (!qb.exec()) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to look up external parts with content hash" << hash;
+        return QByteArray();
+    }
+
+    QByteArray fileName;
+    if (qb.query().next()) {
+        fileName = qb.query().value(0).toByteArray();
+    }
+    qb.query().finish();
+    return fileName;
+}
+
+QString PartHelper::contentHash(const QByteArray &data)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Blake2b_256).toHex());
+}
+
+QString PartHelper::fileContentHash(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    QCryptographicHash hash(QCryptographicHash::Blake2b_256);
+    if (!hash.addData(&file)) {
+        return QString();
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
 bool PartHelper::truncate(Part &part)
 {
     if (part.storage() == Part::External) {
@@ -158,6 +324,7 @@ bool PartHelper::truncate(Part &part)
     part.setData(QByteArray());
     part.setDatasize(0);
     part.setStorage(Part::Internal);
+    part.setContentHash(QString());
     return part.update();
 }
 
@@ -168,19 +335,26 @@ bool PartHelper::verify(Part &part)
     }
 
     QString fileName;
-    if (part.storage() == Part::External) {
-        fileName = ExternalPartStorage::resolveAbsolutePath(part.data());
+    bool exists = false;
+    if (part.storage() == Part::Packed) {
+        QByteArray data;
+        fileName = QString::fromLatin1(part.data());
+        exists = PackedPartStorage::self()->readPart(part.data(), data);
+    } else if (part.storage() == Part::External) {
+        fileName = ExternalPartStorage::resolveAbsolutePath(part.data(), &exists);
     } else if (part.storage() == Part::Foreign) {
         fileName = QString::fromUtf8(part.data());
+        exists = QFile::exists(fileName);
     } else {
         Q_ASSERT(false);
     }
 
-    if (!QFile::exists(fileName)) {
+    if (!exists) {
         qCCritical(AKONADISERVER_LOG) << "Payload file" << fileName << "is missing, trying to recover.";
         part.setData(QByteArray());
         part.setDatasize(0);
         part.setStorage(Part::Internal);
+        part.setContentHash(QString());
         return part.update();
     }
 
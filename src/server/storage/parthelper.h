@@ -28,6 +28,11 @@ AKONADI_EXCEPTION_MAKE_INSTANCE(PartHelperException);
  */
 namespace PartHelper
 {
+/**
+ * Returns how a part with @p dataSize bytes of payload is stored: Internal, Packed or External.
+ */
+Part::Storage storageForSize(qint64 dataSize);
+
 /**
  * Update payload of an existing part @p part to @p data and size @p dataSize.
  * Automatically decides whether or not the data should be stored in the database
@@ -40,6 +45,11 @@ void update(Part *part, const QByteArray &data, qint64 dataSize);
  * Adds a new part to the database and if necessary to the filesystem.
  * @p part must not be in the database yet (ie. valid() == false) and must have
  * a data size set.
+ *
+ * If @p part has External storage, its data is the file name of another external
+ * part whose payload is shared with the new part without copying it, see
+ * ExternalPartStorage::createPartFileLink(). The data size and content hash are
+ * expected to be those of the other part.
  */
 bool insert(Part *part, qint64 *insertId = nullptr);
 
@@ -47,12 +57,31 @@ bool insert(Part *part, qint64 *insertId = nullptr);
 bool remove(Part *part);
 /** Deletes all parts which match the given constraint, including all corresponding filesystem data. */
 bool remove(const QString &column, const QVariant &value);
+/**
+ * Deletes all parts of the items @p itemIds with a single statement.
+ *
+ * The files of external parts are not removed right away, they are recorded as
+ * PartFileTombstone in the same transaction and deleted by the PartFileReclaimer
+ * once the transaction has been committed.
+ */
+bool removeByItemIds(const QList<qint64> &itemIds);
 
 /** Returns the payload data. */
 QByteArray translateData(const QByteArray &data, Part::Storage storageType);
 /** Convenience overload of the above. */
 QByteArray translateData(const Part &part);
 
+/**
+ * Returns the file name of an external part with the content hash @p hash and
+ * size @p dataSize other than @p excludePartId, or an empty array if there is none.
+ */
+QByteArray findExternalPartFile(const QString &hash, qint64 dataSize, qint64 excludePartId = -1);
+
+/** Returns the content hash of @p data, as stored in Part::contentHash(). */
+QString contentHash(const QByteArray &data);
+/** Returns the content hash of the file @p fileName, or an empty string if it can't be read. */
+QString fileContentHash(const QString &fileName);
+
 /** Truncate the payload of @p part and update filesystem/database accordingly.
  *  This is more efficient than using update since it does not require the data to be loaded.
  */
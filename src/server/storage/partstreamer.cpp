@@ -41,6 +41,21 @@ PartStreamer::~PartStreamer()
 {
 }
 
+void PartStreamer::setInlineParts(const QList<Protocol::StreamPayloadResponse> &parts)
+{
+    mInlineParts.clear();
+    mInlineParts.reserve(parts.size());
+    qint64 totalSize = 0;
+    for (const auto &part : parts) {
+        totalSize += part.data().size();
+        if (totalSize > MaxInlinePartSize) {
+            mInlineParts.clear();
+            throw PartStreamerException(QStringLiteral("Client sent more than %1 bytes of inline parts.").arg(MaxInlinePartSize));
+        }
+        mInlineParts.insert(part.payloadName(), part);
+    }
+}
+
 Protocol::PartMetaData PartStreamer::requestPartMetaData(const QByteArray &partName)
 {
     {
@@ -60,7 +75,9 @@ Protocol::PartMetaData PartStreamer::requestPartMetaData(const QByteArray &partN
 
 void PartStreamer::streamPayload(Part &part, const QByteArray &partName)
 {
-    Protocol::PartMetaData metaPart = requestPartMetaData(partName);
+    const auto inlinePart = mInlineParts.constFind(partName);
+    const bool isInline = inlinePart != mInlineParts.cend();
+    Protocol::PartMetaData metaPart = isInline ? inlinePart->metaData() : requestPartMetaData(partName);
     if (metaPart.name().isEmpty()) {
         throw PartStreamerException(QStringLiteral("Client sent empty metadata for part '%1'.").arg(QString::fromUtf8(partName)));
     }
@@ -77,9 +94,14 @@ void PartStreamer::streamPayload(Part &part, const QByteArray &partName)
         mDataChanged = mDataChanged || (metaPart.size() != part.datasize());
     }
 
-    if (metaPart.storageType() == Protocol::PartMetaData::Foreign) {
+    if (isInline) {
+        if (metaPart.storageType() != Protocol::PartMetaData::Internal) {
+            throw PartStreamerException(QStringLiteral("Client sent non-internal part '%1' inline.").arg(QString::fromUtf8(partName)));
+        }
+        storeInlinePayload(part, metaPart, inlinePart->data());
+    } else if (metaPart.storageType() == Protocol::PartMetaData::Foreign) {
         streamForeignPayload(part, metaPart);
-    } else if (part.datasize() > DbConfig::configuredDatabase()->sizeThreshold()) {
+    } else if (PartHelper::storageForSize(part.datasize()) == Part::External) {
         // actual case when streaming storage is used: external payload is enabled,
         // data is big enough in a literal
         streamPayloadToFile(part, metaPart);
@@ -117,14 +139,17 @@ void PartStreamer::streamPayloadData(Part &part, const Protocol::PartMetaData &m
     }
 
     if (part.isValid()) {
-        if (!mDataChanged) {
-            mDataChanged = mDataChanged || (newData != part.data());
+        const QString oldHash = part.contentHash();
+        if (!mDataChanged && oldHash.isEmpty()) {
+            // Parts stored before content hashes were introduced
+            mDataChanged = (newData != part.data());
         }
         PartHelper::update(&part, newData, newSize);
+        mDataChanged = mDataChanged || (!oldHash.isEmpty() && oldHash != part.contentHash());
     } else {
         part.setData(newData);
         part.setDatasize(newSize);
-        if (!part.insert()) {
+        if (!PartHelper::insert(&part)) {
             throw PartStreamerException("Failed to insert new part into database.");
         }
     }
@@ -132,8 +157,9 @@ void PartStreamer::streamPayloadData(Part &part, const Protocol::PartMetaData &m
 
 void PartStreamer::streamPayloadToFile(Part &part, const Protocol::PartMetaData &metaPart)
 {
+    const QString oldHash = part.contentHash();
     QByteArray origData;
-    if (!mDataChanged && mCheckChanged) {
+    if (!mDataChanged && mCheckChanged && oldHash.isEmpty()) {
         origData = PartHelper::translateData(part);
     }
 
@@ -204,10 +230,19 @@ void PartStreamer::streamPayloadToFile(Part &part, const Protocol::PartMetaData
             QStringLiteral("Payload size mismatch, client advertised %1 bytes, but the file is %2 bytes.").arg(metaPart.size(), file.size()));
     }
 
+    part.setContentHash(PartHelper::fileContentHash(file.fileName()));
+    if (!part.update()) {
+        throw PartStreamerException(QStringLiteral("Failed to update part %1 in database.").arg(part.id()));
+    }
+
     if (mCheckChanged && !mDataChanged) {
         // This is invoked only when part already exists, data sizes match and
         // caller wants to know whether parts really differ
-        mDataChanged = (origData != PartHelper::translateData(part));
+        if (oldHash.isEmpty()) {
+            mDataChanged = (origData != PartHelper::translateData(part));
+        } else {
+            mDataChanged = (oldHash != part.contentHash());
+        }
     }
 }
 
@@ -239,6 +274,8 @@ void PartStreamer::streamForeignPayload(Part &part, const Protocol::PartMetaData
 
     part.setStorage(Part::Foreign);
     part.setData(response.data());
+    // The file is owned by the client and can change at any time
+    part.setContentHash(QString());
 
     if (part.isValid()) {
         if (!part.update()) {
@@ -268,6 +305,36 @@ void PartStreamer::streamForeignPayload(Part &part, const Protocol::PartMetaData
     }
 }
 
+void PartStreamer::storeInlinePayload(Part &part, const Protocol::PartMetaData &metaPart, const QByteArray &data)
+{
+    if (data.size() > MaxInlinePartSize) {
+        throw PartStreamerException(QStringLiteral("Inline part '%1' exceeds %2 bytes.").arg(QString::fromUtf8(metaPart.name())).arg(MaxInlinePartSize));
+    }
+    if (data.size() != metaPart.size()) {
+        throw PartStreamerException(QStringLiteral("Payload size mismatch: client advertised %1 bytes but sent %2 bytes.").arg(metaPart.size()).arg(data.size()));
+    }
+
+    // PartHelper decides whether the data goes into the database or into an external file
+    try {
+        if (part.isValid()) {
+            const QString oldHash = part.contentHash();
+            if (mCheckChanged && !mDataChanged && oldHash.isEmpty()) {
+                mDataChanged = (data != PartHelper::translateData(part));
+            }
+            PartHelper::update(&part, data, data.size());
+            mDataChanged = mDataChanged || (!oldHash.isEmpty() && oldHash != part.contentHash());
+        } else {
+            part.setData(data);
+            part.setDatasize(data.size());
+            if (!PartHelper::insert(&part)) {
+                throw PartStreamerException(QStringLiteral("Failed to insert part of PimItem %1 into database.").arg(part.pimItemId()));
+            }
+        }
+    } catch (const PartHelperException &e) {
+        throw PartStreamerException(e.what());
+    }
+}
+
 void PartStreamer::preparePart(bool checkExists, const QByteArray &partName, Part &part)
 {
     mDataChanged = false;
@@ -333,12 +400,16 @@ void PartStreamer::streamAttribute(bool checkExists, const QByteArray &_partName
     preparePart(checkExists, partName, part);
 
     if (part.isValid()) {
-        if (mCheckChanged) {
+        const QString oldHash = part.contentHash();
+        if (mCheckChanged && oldHash.isEmpty()) {
             if (PartHelper::translateData(part) != value) {
                 mDataChanged = true;
             }
         }
         PartHelper::update(&part, value, value.size());
+        if (mCheckChanged && !oldHash.isEmpty() && oldHash != part.contentHash()) {
+            mDataChanged = true;
+        }
     } else {
         const bool storeInFile = value.size() > DbConfig::configuredDatabase()->sizeThreshold();
         part.setDatasize(value.size());
@@ -350,6 +421,7 @@ void PartStreamer::streamAttribute(bool checkExists, const QByteArray &_partName
             PartHelper::update(&part, value, value.size());
         } else {
             part.setData(value);
+            part.setContentHash(PartHelper::contentHash(value));
             if (!part.insert()) {
                 throw PartStreamerException(QStringLiteral("Failed to store attribute part for PimItem %1 in database.").arg(part.pimItemId()));
             }
@@ -7,20 +7,16 @@
 
 #pragma once
 
+#include <QHash>
 #include <QSharedPointer>
 
 #include "entities.h"
 #include "exception.h"
 
+#include "private/protocol_p.h"
+
 namespace Akonadi
 {
-namespace Protocol
-{
-class PartMetaData;
-class Command;
-using CommandPtr = QSharedPointer<Command>;
-}
-
 namespace Server
 {
 AKONADI_EXCEPTION_MAKE_INSTANCE(PartStreamerException);
@@ -32,9 +28,23 @@ class Connection;
 class PartStreamer
 {
 public:
+    /**
+     * Largest total size of the payload parts that clients may send inline with
+     * the command, advertised in the Login response.
+     */
+    static constexpr qint64 MaxInlinePartSize = 256 * 1024;
+
     explicit PartStreamer(Connection *connection, const PimItem &pimItem);
     ~PartStreamer();
 
+    /**
+     * Sets the parts the client sent along with the command. Those are stored
+     * without requesting their metadata and data from the client.
+     *
+     * @throws PartStreamerException if the parts exceed MaxInlinePartSize
+     */
+    void setInlineParts(const QList<Protocol::StreamPayloadResponse> &parts);
+
     /**
      * @throws PartStreamException
      */
@@ -50,12 +60,14 @@ private:
     void streamPayloadToFile(Part &part, const Protocol::PartMetaData &metaPart);
     void streamPayloadData(Part &part, const Protocol::PartMetaData &metaPart);
     void streamForeignPayload(Part &part, const Protocol::PartMetaData &metaPart);
+    void storeInlinePayload(Part &part, const Protocol::PartMetaData &metaPart, const QByteArray &data);
 
     Protocol::PartMetaData requestPartMetaData(const QByteArray &partName);
     void preparePart(bool checkExists, const QByteArray &partName, Part &part);
 
     Connection *mConnection;
     PimItem mItem;
+    QHash<QByteArray, Protocol::StreamPayloadResponse> mInlineParts;
     bool mCheckChanged;
     bool mDataChanged;
 };
@@ -15,6 +15,7 @@
 #ifndef QUERYBUILDER_UNITTEST
 #include "storage/datastore.h"
 #include "storage/querycache.h"
+#include "storage/sqltracebuffer.h"
 #include "storage/storagedebugger.h"
 #endif
 
@@ -540,7 +541,9 @@ bool QueryBuilder::exec()
 
     bool ret;
 
-    if (StorageDebugger::instance()->isSQLDebuggingEnabled()) {
+    auto *sqlTrace = SqlTraceBuffer::self();
+    const bool traceQuery = sqlTrace->isRecording();
+    if (StorageDebugger::instance()->isSQLDebuggingEnabled() || traceQuery) {
         QElapsedTimer t;
         t.start();
         if (isBatch) {
@@ -548,7 +551,14 @@ bool QueryBuilder::exec()
         } else {
             ret = mQuery.exec();
         }
-        StorageDebugger::instance()->queryExecuted(reinterpret_cast<qint64>(mDataStore), mQuery, t.elapsed());
+        if (traceQuery) {
+            sqlTrace->recordQuery(mDataStore, statement, t.nsecsElapsed() / 1000, mQuery.isSelect() ? mQuery.size() : mQuery.numRowsAffected(), !ret);
+        }
+        if (StorageDebugger::instance()->isSQLDebuggingEnabled()) {
+            StorageDebugger::instance()->queryExecuted(reinterpret_cast<qint64>(mDataStore), mQuery, t.elapsed());
+        } else {
+            StorageDebugger::instance()->incSequence();
+        }
     } else {
         StorageDebugger::instance()->incSequence();
         if (isBatch) {
@@ -0,0 +1,137 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "schemafingerprint.h"
+#include "akonadiserver_debug.h"
+#include "entities.h"
+#include "schema.h"
+
+#include "private/standarddirs_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QSqlQuery>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+namespace
+{
+// Bump when the check performed on startup changes without a change of the schema
+constexpr int FingerprintVersion = 1;
+
+void write(QDataStream &stream, const IndexDescription &index);
+void write(QDataStream &stream, const ColumnDescription &column);
+void write(QDataStream &stream, const DataDescription &data);
+void write(QDataStream &stream, const TableDescription &table);
+void write(QDataStream &stream, const RelationDescription &relation);
+
+template<typename T>
+void write(QDataStream &stream, const QList<T> &list)
+{
+    stream << list.size();
+    for (const auto &element : list) {
+        write(stream, element);
+    }
+}
+
+void write(QDataStream &stream, const IndexDescription &index)
+{
+    stream << index.name << index.columns << index.isUnique << index.sort;
+}
+
+void write(QDataStream &stream, const ColumnDescription &column)
+{
+    stream << column.name << column.type << column.size << column.allowNull << column.isAutoIncrement << column.isPrimaryKey << column.isUnique
+           << column.isEnum << column.refTable << column.refColumn << column.defaultValue << static_cast<int>(column.onUpdate)
+           << static_cast<int>(column.onDelete) << column.noUpdate << column.enumValueMap;
+}
+
+void write(QDataStream &stream, const DataDescription &data)
+{
+    stream << data.data;
+}
+
+void write(QDataStream &stream, const TableDescription &table)
+{
+    stream << table.name;
+    write(stream, table.columns);
+    write(stream, table.indexes);
+    write(stream, table.data);
+}
+
+void write(QDataStream &stream, const RelationDescription &relation)
+{
+    stream << relation.firstTable << relation.firstColumn << relation.secondTable << relation.secondColumn;
+    write(stream, relation.indexes);
+}
+
+} // namespace
+
+QByteArray SchemaFingerprint::compute(Schema &schema, const QSqlDatabase &db)
+{
+    // Identifies the database, a recreated database has a new generation
+    QSqlQuery query(db);
+    if (!query.exec(QStringLiteral("SELECT %1, %2 FROM %3")
+                        .arg(SchemaVersion::versionColumn(), SchemaVersion::generationColumn(), SchemaVersion::tableName()))
+        || !query.next()) {
+        return {};
+    }
+    const int version = query.value(0).toInt();
+    const qint64 generation = query.value(1).toLongLong();
+    query.finish();
+
+    QByteArray data;
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << FingerprintVersion << db.driverName() << db.databaseName() << db.hostName() << db.port() << version << generation;
+        write(stream, schema.tables());
+        write(stream, schema.relations());
+
+        QFile updates(QStringLiteral(":dbupdate.xml"));
+        if (updates.open(QIODevice::ReadOnly)) {
+            stream << updates.readAll();
+        }
+    }
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex();
+}
+
+QString SchemaFingerprint::fileName()
+{
+    return StandardDirs::saveDir("data") + QStringLiteral("/schema.fingerprint");
+}
+
+QByteArray SchemaFingerprint::stored()
+{
+    QFile file(fileName());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return file.readAll().trimmed();
+}
+
+bool SchemaFingerprint::store(const QByteArray &fingerprint)
+{
+    if (fingerprint.isEmpty()) {
+        clear();
+        return false;
+    }
+
+    QSaveFile file(fileName());
+    if (!file.open(QIODevice::WriteOnly) || file.write(fingerprint) != fingerprint.size() || !file.commit()) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to store the database schema fingerprint:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void SchemaFingerprint::clear()
+{
+    QFile::remove(fileName());
+}
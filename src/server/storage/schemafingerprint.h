@@ -0,0 +1,48 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QSqlDatabase>
+
+namespace Akonadi
+{
+namespace Server
+{
+class Schema;
+
+/**
+ * Detects whether the database schema needs to be checked on startup.
+ *
+ * Checking the schema introspects every table, column, index and foreign
+ * key of the database, which takes a considerable part of the startup time
+ * of the server on large databases. The fingerprint covers the desired
+ * schema, the schema updates, the database connection and the schema version
+ * and generation stored in the database. It is stored once the schema has
+ * been checked, and as long as the fingerprint of the database still matches
+ * the stored one, the check is skipped.
+ *
+ * Removing the fingerprint file forces a full check on the next start.
+ */
+namespace SchemaFingerprint
+{
+/**
+ * Returns the fingerprint of the schema of @p db, or an empty fingerprint if
+ * the schema version could not be read from the database.
+ */
+QByteArray compute(Schema &schema, const QSqlDatabase &db);
+
+/** The file in which the fingerprint of the last checked schema is stored. */
+QString fileName();
+
+QByteArray stored();
+bool store(const QByteArray &fingerprint);
+void clear();
+
+} // namespace SchemaFingerprint
+} // namespace Server
+} // namespace Akonadi
@@ -0,0 +1,281 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "sqltracebuffer.h"
+#include "akonadiserver_debug.h"
+
+#include "private/standarddirs_p.h"
+
+#include <QDateTime>
+#include <QSaveFile>
+#include <QSet>
+#include <QSettings>
+
+#include <algorithm>
+#include <limits>
+
+using namespace Akonadi;
+using namespace Akonadi::Server;
+
+namespace
+{
+constexpr int RecordWords = 6;
+
+struct ThreadState {
+    const SqlTraceBuffer *buffer = nullptr;
+    // Statements of which the text has been registered with the buffer
+    QSet<quint32> knownStatements;
+    quint32 statementsGeneration = 0;
+
+    quint32 commandCounter = 0;
+    quint32 command = 0;
+    quint16 commandType = 0;
+    bool commandSampled = false;
+
+    quint64 transactionCounter = 0;
+    quint64 transaction = 0;
+    bool transactionSampled = false;
+};
+
+thread_local ThreadState tState;
+
+} // namespace
+
+// A record is written by a single thread, which claims the slot by marking it with an odd sequence while
+// writing, so that snapshot() can skip records which are being written without locking the writers out.
+struct SqlTraceBuffer::Slot {
+    std::atomic<quint64> sequence = 0;
+    std::atomic<quint64> words[RecordWords] = {};
+};
+
+SqlTraceBuffer *SqlTraceBuffer::self()
+{
+    static SqlTraceBuffer *sInstance = []() {
+        const QSettings settings(StandardDirs::serverConfigFile(), QSettings::IniFormat);
+        return new SqlTraceBuffer(settings.value(QStringLiteral("Debug/SqlTraceSampleRate"), DefaultSampleRate).toUInt(),
+                                  settings.value(QStringLiteral("Debug/SqlTraceCapacity"), 32768).toLongLong());
+    }();
+    return sInstance;
+}
+
+SqlTraceBuffer::SqlTraceBuffer(quint32 sampleRate, qsizetype capacity)
+    : mSampleRate(sampleRate)
+    , mMask(sampleRate > 0 ? qNextPowerOfTwo(quint64(std::max<qsizetype>(capacity, 2) - 1)) - 1 : 0)
+    , mSlots(std::make_unique<Slot[]>(mMask + 1))
+    , mStartTime(QDateTime::currentMSecsSinceEpoch())
+    , mStatementsPruneSize(capacity())
+{
+    mTimer.start();
+}
+
+SqlTraceBuffer::~SqlTraceBuffer() = default;
+
+quint32 SqlTraceBuffer::sampleRate() const
+{
+    return mSampleRate;
+}
+
+qsizetype SqlTraceBuffer::capacity() const
+{
+    return mSampleRate > 0 ? mMask + 1 : 0;
+}
+
+void SqlTraceBuffer::beginCommand(quint16 commandType)
+{
+    tState.command = ++tState.commandCounter;
+    tState.commandType = commandType;
+    tState.commandSampled = mSampleRate > 0 && mSampleCounter.fetch_add(1, std::memory_order_relaxed) % mSampleRate == 0;
+}
+
+void SqlTraceBuffer::endCommand()
+{
+    tState.command = 0;
+    tState.commandType = 0;
+    tState.commandSampled = false;
+}
+
+bool SqlTraceBuffer::isRecording() const
+{
+    if (mSampleRate == 0) {
+        return false;
+    }
+    if (tState.command > 0) {
+        return tState.commandSampled;
+    }
+    if (tState.transaction > 0) {
+        return tState.transactionSampled;
+    }
+    // Statements executed outside of commands and transactions are sampled individually
+    return mSampleCounter.fetch_add(1, std::memory_order_relaxed) % mSampleRate == 0;
+}
+
+void SqlTraceBuffer::recordQuery(const DataStore *store, const QString &statement, qint64 durationUs, qint64 rows, bool error)
+{
+    const quint32 hash = SqlTrace::statementHash(statement);
+    if (record(store, hash, SqlTrace::EventType::Query, durationUs, rows, error ? SqlTrace::Error : SqlTrace::NoFlags)) {
+        registerStatement(hash, statement);
+    }
+}
+
+void SqlTraceBuffer::recordTransactionBegin(const DataStore *store, qint64 durationUs)
+{
+    // Transactions outside of commands are sampled as a whole
+    tState.transactionSampled = isRecording();
+    tState.transaction = ++tState.transactionCounter;
+    if (tState.transactionSampled) {
+        record(store, 0, SqlTrace::EventType::TransactionBegin, durationUs, -1, SqlTrace::NoFlags);
+    }
+}
+
+void SqlTraceBuffer::recordTransactionEnd(const DataStore *store, bool committed, qint64 durationUs)
+{
+    if (tState.transactionSampled) {
+        record(store,
+               0,
+               committed ? SqlTrace::EventType::TransactionCommit : SqlTrace::EventType::TransactionRollback,
+               durationUs,
+               -1,
+               SqlTrace::NoFlags);
+    }
+    tState.transaction = 0;
+    tState.transactionSampled = false;
+}
+
+void SqlTraceBuffer::registerStatement(quint32 hash, const QString &statement)
+{
+    const quint32 generation = mStatementsGeneration.load(std::memory_order_acquire);
+    if (tState.buffer != this || tState.statementsGeneration != generation || tState.knownStatements.size() >= capacity()) {
+        tState.buffer = this;
+        tState.statementsGeneration = generation;
+        tState.knownStatements.clear();
+    }
+    if (tState.knownStatements.contains(hash)) {
+        return;
+    }
+    tState.knownStatements.insert(hash);
+
+    QMutexLocker locker(&mStatementsLock);
+    mStatements.insert(hash, statement);
+    if (mStatements.size() > mStatementsPruneSize) {
+        pruneStatements();
+    }
+}
+
+void SqlTraceBuffer::pruneStatements()
+{
+    // Keep the statements referenced by the records in the buffer. A record being written concurrently is
+    // registered by its thread afterwards, as the new generation makes it forget its known statements.
+    QSet<quint32> referenced;
+    referenced.reserve(capacity());
+    for (quint64 i = 0; i <= mMask; ++i) {
+        referenced.insert(quint32(mSlots[i].words[2].load(std::memory_order_relaxed) >> 32));
+    }
+    mStatements.removeIf([&referenced](QHash<quint32, QString>::iterator it) {
+        return !referenced.contains(it.key());
+    });
+    // At most twice the capacity, while pruning only once every capacity() new statements
+    mStatementsPruneSize = mStatements.size() + capacity();
+    mStatementsGeneration.fetch_add(1, std::memory_order_release);
+}
+
+bool SqlTraceBuffer::record(const DataStore *store, quint32 statementHash, SqlTrace::EventType type, qint64 durationUs, qint64 rows, quint8 flags)
+{
+    if (mSampleRate == 0) {
+        return false;
+    }
+
+    const quint64 index = mHead.fetch_add(1, std::memory_order_relaxed);
+    auto &slot = mSlots[index & mMask];
+    quint64 sequence = slot.sequence.load(std::memory_order_relaxed);
+    do {
+        // Another thread is still writing an older record, or has already written a newer one, which
+        // only happens when the buffer wraps around while a thread is preempted. Drop the record
+        // rather than waiting for the other thread.
+        if ((sequence & 1) || sequence > 2 * index) {
+            return false;
+        }
+    } while (!slot.sequence.compare_exchange_weak(sequence, 2 * index + 1, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const quint64 duration = std::clamp<qint64>(durationUs, 0, std::numeric_limits<quint32>::max());
+    slot.words[0].store(mTimer.nsecsElapsed() / 1000, std::memory_order_relaxed);
+    slot.words[1].store(reinterpret_cast<quintptr>(store), std::memory_order_relaxed);
+    slot.words[2].store((quint64(statementHash) << 32) | duration, std::memory_order_relaxed);
+    slot.words[3].store(quint64(rows), std::memory_order_relaxed);
+    slot.words[4].store((quint64(tState.command) << 32) | (quint64(tState.commandType) << 16) | (quint64(type) << 8) | flags, std::memory_order_relaxed);
+    slot.words[5].store(tState.transaction, std::memory_order_relaxed);
+
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+    return true;
+}
+
+SqlTrace::Trace SqlTraceBuffer::snapshot() const
+{
+    SqlTrace::Trace trace;
+    trace.startTime = mStartTime;
+    trace.sampleRate = mSampleRate;
+    if (mSampleRate == 0) {
+        return trace;
+    }
+
+    const quint64 head = mHead.load(std::memory_order_acquire);
+    const quint64 first = head > mMask + 1 ? head - (mMask + 1) : 0;
+    trace.dropped = first;
+    trace.records.reserve(head - first);
+    for (quint64 index = first; index < head; ++index) {
+        const auto &slot = mSlots[index & mMask];
+        const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * index + 2) {
+            // Being written, or already overwritten by a newer record
+            continue;
+        }
+        quint64 words[RecordWords];
+        for (int i = 0; i < RecordWords; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        SqlTrace::Record record;
+        record.timestamp = qint64(words[0]);
+        record.connectionId = qint64(words[1]);
+        record.statementHash = quint32(words[2] >> 32);
+        record.duration = quint32(words[2]);
+        record.rows = qint64(words[3]);
+        record.command = quint32(words[4] >> 32);
+        record.commandType = quint16(words[4] >> 16);
+        record.type = static_cast<SqlTrace::EventType>(quint8(words[4] >> 8));
+        record.flags = quint8(words[4]);
+        record.transaction = words[5];
+        trace.records.push_back(record);
+    }
+    std::stable_sort(trace.records.begin(), trace.records.end(), [](const SqlTrace::Record &lhs, const SqlTrace::Record &rhs) {
+        return lhs.timestamp < rhs.timestamp;
+    });
+
+    QMutexLocker locker(&mStatementsLock);
+    trace.statements = mStatements;
+    return trace;
+}
+
+bool SqlTraceBuffer::dump(const QString &fileName) const
+{
+    const auto trace = snapshot();
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to open SQL trace file" << fileName << ":" << file.errorString();
+        return false;
+    }
+    if (!SqlTrace::write(&file, trace) || !file.commit()) {
+        qCWarning(AKONADISERVER_LOG) << "Failed to write SQL trace file" << fileName << ":" << file.errorString();
+        return false;
+    }
+    qCInfo(AKONADISERVER_LOG) << "Written" << trace.records.size() << "SQL trace records to" << fileName;
+    return true;
+}
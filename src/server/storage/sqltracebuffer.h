@@ -0,0 +1,111 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "private/sqltrace_p.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+
+#include <atomic>
+#include <memory>
+
+class QString;
+
+namespace Akonadi
+{
+namespace Server
+{
+class DataStore;
+
+/**
+ * Always-on, sampled in-memory trace of the executed SQL statements.
+ *
+ * Unlike the StorageDebugger, which sends every statement over D-Bus, the
+ * buffer only stores fixed-size records of the statements of every n-th
+ * command in a ring buffer, overwriting the oldest records. Recording does
+ * not take any locks, except once per thread for every new statement to
+ * remember its text. Texts of statements which are no longer referenced by
+ * any record in the buffer are dropped, so that their number stays bounded by
+ * the capacity. The content of the buffer can be written to a file with
+ * dump() and analyzed offline with the aksqltrace tool.
+ *
+ * The sampling rate and the capacity are read from Debug/SqlTraceSampleRate
+ * (0 disables the trace) and Debug/SqlTraceCapacity of the server
+ * configuration. By default every DefaultSampleRate-th command is traced.
+ */
+class SqlTraceBuffer
+{
+public:
+    static constexpr quint32 DefaultSampleRate = 100;
+
+    static SqlTraceBuffer *self();
+
+    explicit SqlTraceBuffer(quint32 sampleRate, qsizetype capacity);
+    ~SqlTraceBuffer();
+
+    quint32 sampleRate() const;
+    qsizetype capacity() const;
+
+    /**
+     * Marks the statements executed by the current thread until endCommand()
+     * as executed by the command, and decides whether the command is sampled.
+     */
+    void beginCommand(quint16 commandType);
+    void endCommand();
+
+    /**
+     * Returns true if the statements executed by the current thread are
+     * recorded, so that callers can avoid measuring them otherwise.
+     */
+    bool isRecording() const;
+
+    /// Records the execution of @p statement, only call this if isRecording() returned true
+    void recordQuery(const DataStore *store, const QString &statement, qint64 durationUs, qint64 rows, bool error);
+    /// Records the start of a transaction, @p durationUs is the time it took to start it
+    void recordTransactionBegin(const DataStore *store, qint64 durationUs);
+    /// Records the end of the current transaction, @p durationUs is the time it was held open
+    void recordTransactionEnd(const DataStore *store, bool committed, qint64 durationUs);
+
+    /**
+     * Returns the records currently in the buffer, records being written
+     * concurrently are skipped.
+     */
+    SqlTrace::Trace snapshot() const;
+
+    /**
+     * Writes the records currently in the buffer to @p fileName.
+     */
+    bool dump(const QString &fileName) const;
+
+private:
+    struct Slot;
+
+    bool record(const DataStore *store, quint32 statementHash, SqlTrace::EventType type, qint64 durationUs, qint64 rows, quint8 flags);
+    void registerStatement(quint32 hash, const QString &statement);
+    void pruneStatements();
+
+    const quint32 mSampleRate;
+    const quint64 mMask;
+    std::unique_ptr<Slot[]> mSlots;
+    std::atomic<quint64> mHead = 0;
+    mutable std::atomic<quint64> mSampleCounter = 0;
+
+    qint64 mStartTime = 0;
+    QElapsedTimer mTimer;
+
+    mutable QMutex mStatementsLock;
+    QHash<quint32, QString> mStatements;
+    // The statements are pruned when their number exceeds this
+    qsizetype mStatementsPruneSize = 0;
+    // Incremented by every pruning, so that the threads register their statements again
+    std::atomic<quint32> mStatementsGeneration = 0;
+};
+
+} // namespace Server
+} // namespace Akonadi
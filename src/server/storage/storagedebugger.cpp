@@ -6,6 +6,7 @@
  */
 
 #include "storagedebugger.h"
+#include "sqltracebuffer.h"
 #include "storagedebuggeradaptor.h"
 
 #include <QSqlError>
@@ -77,6 +78,11 @@ void StorageDebugger::enableSQLDebugging(bool enable)
     mEnabled = enable;
 }
 
+bool StorageDebugger::dumpSqlTrace(const QString &fileName)
+{
+    return SqlTraceBuffer::self()->dump(fileName);
+}
+
 bool StorageDebugger::writeToFile(const QString &file)
 {
     mFile = std::make_unique<QFile>(file);
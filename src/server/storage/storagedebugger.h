@@ -58,6 +58,11 @@ public:
 
     void queryExecuted(qint64 connectionId, const QSqlQuery &query, int duration);
 
+    /**
+     * Writes the content of the SqlTraceBuffer to @p fileName.
+     */
+    bool dumpSqlTrace(const QString &fileName);
+
     inline void incSequence()
     {
         ++mSequence;
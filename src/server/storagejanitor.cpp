@@ -8,7 +8,7 @@
 #include "agentmanagerinterface.h"
 #include "akonadi.h"
 #include "akonadiserver_debug.h"
-#include "akranges.h"
+#include "commandscheduler.h"
 #include "entities.h"
 #include "resourcemanager.h"
 #include "search/searchmanager.h"
@@ -16,29 +16,75 @@
 #include "storage/collectionstatistics.h"
 #include "storage/datastore.h"
 #include "storage/dbtype.h"
+#include "storage/packedpartstorage.h"
+#include "storage/parthelper.h"
 #include "storage/query.h"
 #include "storage/selectquerybuilder.h"
 #include "storage/transaction.h"
+#include "utils.h"
 
 #include "private/dbus_p.h"
 #include "private/externalpartstorage_p.h"
 #include "private/standarddirs_p.h"
 
 #include <QDateTime>
+#include <QDeadlineTimer>
 #include <QDir>
 #include <QDirIterator>
 #include <QRegularExpression>
+#include <QSet>
+#include <QSettings>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QStringBuilder>
+#include <QThread>
+#include <QTimer>
 
 #include <algorithm>
+#include <chrono>
 #include <functional>
+#include <numeric>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
 
 using namespace Akonadi;
 using namespace Akonadi::Server;
-using namespace AkRanges;
 using namespace Qt::StringLiterals;
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr qint64 PartChunkSize = 1000;
+constexpr qint64 CollectionChunkSize = 50;
+// Longest time a full chunk waits for clients to finish their commands, smaller chunks wait proportionally less
+constexpr auto MaxThrottleDelay = 2s;
+constexpr auto ThrottleInterval = 50ms;
+constexpr auto ProgressInterval = 5s;
+// An interrupted check is resumed once the server has settled after startup
+constexpr auto ResumeDelay = 5min;
+
+struct LaneState {
+    DataStore *dataStore = nullptr;
+    qsizetype task = -1;
+};
+
+thread_local LaneState tLane;
+
+#ifdef Q_OS_UNIX
+bool isSameFile(const QString &path1, const QString &path2)
+{
+    struct stat stat1;
+    struct stat stat2;
+    if (::stat(QFile::encodeName(path1).constData(), &stat1) != 0 || ::stat(QFile::encodeName(path2).constData(), &stat2) != 0) {
+        return false;
+    }
+    return stat1.st_dev == stat2.st_dev && stat1.st_ino == stat2.st_ino;
+}
+#endif
+
+} // namespace
 
 class StorageJanitorDataStore : public DataStore
 {
@@ -68,9 +114,16 @@ StorageJanitor::StorageJanitor(DbConfig *dbConfig)
 
 StorageJanitor::~StorageJanitor()
 {
+    // Interrupts a running check, it is resumed from its checkpoint after a restart
+    m_stopRequested = true;
     quitThread();
 }
 
+QString StorageJanitor::checkpointFileName()
+{
+    return StandardDirs::saveDir("data") + QStringLiteral("/storagejanitor.checkpoint");
+}
+
 void StorageJanitor::init()
 {
     AkThread::init();
@@ -85,6 +138,15 @@ void StorageJanitor::init()
     conn.registerObject(QStringLiteral(AKONADI_DBUS_STORAGEJANITOR_PATH),
                         this,
                         QDBusConnection::ExportScriptableSlots | QDBusConnection::ExportScriptableSignals);
+
+    if (m_akonadi && QFile::exists(checkpointFileName())) {
+        QTimer::singleShot(ResumeDelay, this, [this]() {
+            // Unless a check has been requested and completed in the meantime
+            if (QFile::exists(checkpointFileName())) {
+                check();
+            }
+        });
+    }
 }
 
 void StorageJanitor::quit()
@@ -103,28 +165,49 @@ void StorageJanitor::quit()
 
 void StorageJanitor::registerTasks()
 {
-    m_tasks = {{QStringLiteral("Looking for collections not belonging to a valid resource..."), &StorageJanitor::findOrphanedCollections},
-               {QStringLiteral("Checking collection tree consistency..."), &StorageJanitor::checkCollectionTreeConsistency},
-               {QStringLiteral("Looking for items not belonging to a valid collection..."), &StorageJanitor::findOrphanedItems},
-               {QStringLiteral("Looking for item parts not belonging to a valid item..."), &StorageJanitor::findOrphanedParts},
-               {QStringLiteral("Looking for item flags not belonging to a valid item..."), &StorageJanitor::findOrphanedPimItemFlags},
-               {QStringLiteral("Looking for duplicate item flags..."), &StorageJanitor::findDuplicateFlags},
-               {QStringLiteral("Looking for duplicate mime types..."), &StorageJanitor::findDuplicateMimeTypes},
-               {QStringLiteral("Looking for duplicate part types..."), &StorageJanitor::findDuplicatePartTypes},
-               {QStringLiteral("Looking for duplicate tag types..."), &StorageJanitor::findDuplicateTagTypes},
-               {QStringLiteral("Looking for overlapping external parts..."), &StorageJanitor::findOverlappingParts},
-               {QStringLiteral("Verifying external parts..."), &StorageJanitor::verifyExternalParts},
-               {QStringLiteral("Checking size threshold changes..."), &StorageJanitor::checkSizeTreshold},
-               {QStringLiteral("Looking for dirty objects..."), &StorageJanitor::findDirtyObjects},
-               {QStringLiteral("Looking for rid-duplicates not matching the content mime-type of the parent collection"), &StorageJanitor::findRIDDuplicates},
-               {QStringLiteral("Migrating parts to new cache hierarchy..."), &StorageJanitor::migrateToLevelledCacheHierarchy},
-               {QStringLiteral("Making sure virtual search resource and collections exist"), &StorageJanitor::ensureSearchCollection}};
+    m_tasks = {
+        {u"findOrphanedCollections"_s,
+         QStringLiteral("Looking for collections not belonging to a valid resource..."),
+         &StorageJanitor::findOrphanedCollections},
+        {u"checkCollectionTreeConsistency"_s, QStringLiteral("Checking collection tree consistency..."), &StorageJanitor::checkCollectionTreeConsistency},
+        {u"findOrphanedItems"_s, QStringLiteral("Looking for items not belonging to a valid collection..."), &StorageJanitor::findOrphanedItems},
+        {u"findOrphanedParts"_s,
+         QStringLiteral("Looking for item parts not belonging to a valid item..."),
+         &StorageJanitor::findOrphanedParts,
+         Task::PayloadLane},
+        {u"findOrphanedPimItemFlags"_s, QStringLiteral("Looking for item flags not belonging to a valid item..."), &StorageJanitor::findOrphanedPimItemFlags},
+        {u"findDuplicateFlags"_s, QStringLiteral("Looking for duplicate item flags..."), &StorageJanitor::findDuplicateFlags},
+        {u"findDuplicateMimeTypes"_s, QStringLiteral("Looking for duplicate mime types..."), &StorageJanitor::findDuplicateMimeTypes},
+        {u"findDuplicatePartTypes"_s, QStringLiteral("Looking for duplicate part types..."), &StorageJanitor::findDuplicatePartTypes},
+        {u"findDuplicateTagTypes"_s, QStringLiteral("Looking for duplicate tag types..."), &StorageJanitor::findDuplicateTagTypes},
+        {u"findOverlappingParts"_s, QStringLiteral("Looking for overlapping external parts..."), &StorageJanitor::findOverlappingParts, Task::PayloadLane},
+        {u"verifyExternalParts"_s, QStringLiteral("Verifying external parts..."), &StorageJanitor::verifyExternalParts, Task::PayloadLane},
+        {u"deduplicateExternalParts"_s,
+         QStringLiteral("Looking for duplicate external parts..."),
+         &StorageJanitor::deduplicateExternalParts,
+         Task::PayloadLane},
+        {u"checkSizeTreshold"_s, QStringLiteral("Checking size threshold changes..."), &StorageJanitor::checkSizeTreshold, Task::PayloadLane},
+        {u"checkPackedParts"_s, QStringLiteral("Checking packed part threshold changes..."), &StorageJanitor::checkPackedParts, Task::PayloadLane},
+        {u"compactPackedParts"_s, QStringLiteral("Compacting packed part segments..."), &StorageJanitor::compactPackedParts, Task::PayloadLane},
+        {u"findDirtyObjects"_s, QStringLiteral("Looking for dirty objects..."), &StorageJanitor::findDirtyObjects},
+        {u"findRIDDuplicates"_s,
+         QStringLiteral("Looking for rid-duplicates not matching the content mime-type of the parent collection"),
+         &StorageJanitor::findRIDDuplicates},
+        {u"migrateToLevelledCacheHierarchy"_s,
+         QStringLiteral("Migrating parts to new cache hierarchy..."),
+         &StorageJanitor::migrateToLevelledCacheHierarchy,
+         Task::PayloadLane},
+        {u"ensureSearchCollection"_s, QStringLiteral("Making sure virtual search resource and collections exist"), &StorageJanitor::ensureSearchCollection}};
 
     // Tasks that require a valid Akonadi instance
     if (m_akonadi) {
-        m_tasks += {{QStringLiteral("Looking for resources in the DB not matching a configured resource..."), &StorageJanitor::findOrphanedResources},
-                    {QStringLiteral("Checking search index consistency..."), &StorageJanitor::findOrphanSearchIndexEntries},
-                    {QStringLiteral("Flushing collection statistics memory cache..."), &StorageJanitor::expireCollectionStatisticsCache}};
+        m_tasks += {{u"findOrphanedResources"_s,
+                     QStringLiteral("Looking for resources in the DB not matching a configured resource..."),
+                     &StorageJanitor::findOrphanedResources},
+                    {u"findOrphanSearchIndexEntries"_s, QStringLiteral("Checking search index consistency..."), &StorageJanitor::findOrphanSearchIndexEntries},
+                    {u"expireCollectionStatisticsCache"_s,
+                     QStringLiteral("Flushing collection statistics memory cache..."),
+                     &StorageJanitor::expireCollectionStatisticsCache}};
     }
 
     /* TODO some ideas for further checks:
@@ -140,34 +223,267 @@ void StorageJanitor::registerTasks()
 void StorageJanitor::check() // implementation of `akonadictl fsck`
 {
     m_lostFoundCollectionId = -1; // start with a fresh one each time
+    loadCheckpoint();
 
-    for (const auto &[idx, task] : m_tasks | Views::enumerate(1)) {
-        inform(QStringLiteral("%1/%2 %3").arg(idx, 2).arg(m_tasks.size()).arg(task.name));
-        std::invoke(task.func, this);
-    }
+    // The payload tasks do not depend on the database tasks, so they run in parallel on their own connection
+    std::unique_ptr<QThread> payloadLane(QThread::create([this]() {
+        runLane(Task::PayloadLane, nullptr);
+    }));
+    payloadLane->setObjectName(QStringLiteral("StorageJanitor-Payloads"));
+    payloadLane->start(QThread::IdlePriority);
+    runLane(Task::DatabaseLane, m_dataStore.get());
+    payloadLane->wait();
 
-    inform("Consistency check done.");
+    {
+        QMutexLocker locker(&m_checkpointLock);
+        m_checkpoint.reset();
+    }
+    if (m_stopRequested) {
+        inform("Consistency check interrupted, it will be resumed after the server has been restarted.");
+    } else {
+        if (m_akonadi) {
+            QFile::remove(checkpointFileName());
+        }
+        inform("Consistency check done.");
+    }
 
     Q_EMIT done();
 }
 
+void StorageJanitor::runLane(Task::Lane lane, DataStore *dataStore)
+{
+    std::unique_ptr<DataStore> laneDataStore;
+    if (!dataStore) {
+        laneDataStore = std::make_unique<StorageJanitorDataStore>(m_akonadi, m_dbConfig);
+        laneDataStore->open();
+        dataStore = laneDataStore.get();
+    }
+    tLane.dataStore = dataStore;
+
+    for (qsizetype task = 0; task < m_tasks.size() && !m_stopRequested; ++task) {
+        if (m_tasks[task].lane != lane || isTaskFinished(task)) {
+            continue;
+        }
+        inform(QStringLiteral("%1/%2 %3").arg(task + 1, 2).arg(m_tasks.size()).arg(m_tasks[task].name));
+        tLane.task = task;
+        std::invoke(m_tasks[task].func, this);
+        tLane.task = -1;
+        // An interrupted task is resumed from its last checkpoint
+        if (!m_stopRequested) {
+            finishTask(task);
+        }
+    }
+
+    tLane = {};
+    if (laneDataStore) {
+        laneDataStore->close();
+        // Like AkThread::quit(), in case a helper used the thread's default store
+        if (DataStore::hasDataStore()) {
+            DataStore::self()->close();
+        }
+    }
+}
+
+DataStore *StorageJanitor::dataStore() const
+{
+    return tLane.dataStore ? tLane.dataStore : m_dataStore.get();
+}
+
+bool StorageJanitor::forEachChunk(const QString &table,
+                                  const QString &idColumn,
+                                  qint64 chunkSize,
+                                  const std::function<bool(qint64 from, qint64 to)> &processChunk)
+{
+    QueryBuilder qb(dataStore(), table, QueryBuilder::Select);
+    qb.addAggregation(idColumn, QStringLiteral("min"));
+    qb.addAggregation(idColumn, QStringLiteral("max"));
+    if (!qb.exec() || !qb.query().next()) {
+        inform(QStringLiteral("Failed to query the ids of %1, skipping test").arg(table));
+        return false;
+    }
+    if (qb.query().value(0).isNull()) {
+        // The table is empty
+        qb.query().finish();
+        return true;
+    }
+    const qint64 minId = qb.query().value(0).toLongLong();
+    const qint64 maxId = qb.query().value(1).toLongLong();
+    qb.query().finish();
+
+    const qsizetype task = tLane.task;
+    const auto progress = [minId, maxId](qint64 nextId) {
+        return std::min(1.0, double(nextId - minId) / double(maxId - minId + 1));
+    };
+    qint64 from = minId;
+    if (task >= 0) {
+        from = std::max(from, chunkCheckpoint(task));
+        if (from > minId) {
+            QMutexLocker locker(&m_progressLock);
+            m_taskProgress[task] = progress(from);
+            m_initialProgress += progress(from) / m_taskProgress.size();
+        }
+    }
+
+    while (from <= maxId) {
+        if (m_stopRequested) {
+            return false;
+        }
+        // Chunks span the ids of chunkSize rows, so that sparse id ranges don't cost a chunk each
+        QueryBuilder idQb(dataStore(), table, QueryBuilder::Select);
+        idQb.addColumn(idColumn);
+        idQb.addValueCondition(idColumn, Query::GreaterOrEqual, from);
+        idQb.addSortColumn(idColumn);
+        idQb.setLimit(int(chunkSize) + 1);
+        if (!idQb.exec()) {
+            inform(QStringLiteral("Failed to query the ids of %1, skipping test").arg(table));
+            return false;
+        }
+        qint64 rows = 0;
+        qint64 to = maxId + 1;
+        while (idQb.query().next()) {
+            if (rows == chunkSize) {
+                to = idQb.query().value(0).toLongLong();
+                break;
+            }
+            ++rows;
+        }
+        idQb.query().finish();
+        if (rows == 0) {
+            break;
+        }
+
+        throttle(std::chrono::milliseconds(MaxThrottleDelay) * rows / chunkSize);
+        if (!processChunk(from, to)) {
+            return false;
+        }
+        from = to;
+        if (task >= 0) {
+            setChunkCheckpoint(task, from);
+            setTaskProgress(task, progress(from));
+        }
+    }
+    return true;
+}
+
+void StorageJanitor::throttle(std::chrono::milliseconds maxDelay)
+{
+    auto *scheduler = m_akonadi ? m_akonadi->commandScheduler() : nullptr;
+    if (!scheduler) {
+        return;
+    }
+    const QDeadlineTimer deadline(maxDelay);
+    while (scheduler->runningCommands() > 0 && !deadline.hasExpired() && !m_stopRequested) {
+        QThread::sleep(ThrottleInterval);
+    }
+}
+
+void StorageJanitor::loadCheckpoint()
+{
+    QDateTime resumedCheck;
+    {
+        QMutexLocker locker(&m_checkpointLock);
+        // Checks of other databases than the one of the server, e.g. by the DbMigrator, are not resumable
+        if (m_akonadi) {
+            m_checkpoint = std::make_unique<QSettings>(checkpointFileName(), QSettings::IniFormat);
+            resumedCheck = m_checkpoint->value(QStringLiteral("Check/Started")).toDateTime();
+            if (!resumedCheck.isValid()) {
+                m_checkpoint->setValue(QStringLiteral("Check/Started"), QDateTime::currentDateTime());
+                m_checkpoint->sync();
+            }
+        }
+    }
+    if (resumedCheck.isValid()) {
+        inform(QStringLiteral("Resuming the consistency check started at %1").arg(resumedCheck.toString(Qt::ISODate)));
+    }
+
+    QList<double> taskProgress(m_tasks.size(), 0.0);
+    for (qsizetype task = 0; task < m_tasks.size(); ++task) {
+        if (isTaskFinished(task)) {
+            taskProgress[task] = 1.0;
+        }
+    }
+
+    QMutexLocker locker(&m_progressLock);
+    m_taskProgress = taskProgress;
+    m_initialProgress = m_tasks.isEmpty() ? 0.0 : std::accumulate(taskProgress.cbegin(), taskProgress.cend(), 0.0) / m_tasks.size();
+    m_checkTimer.start();
+    m_progressTimer.invalidate();
+}
+
+bool StorageJanitor::isTaskFinished(qsizetype task)
+{
+    QMutexLocker locker(&m_checkpointLock);
+    return m_checkpoint && m_checkpoint->value(QStringLiteral("Check/FinishedTasks")).toStringList().contains(m_tasks[task].id);
+}
+
+void StorageJanitor::finishTask(qsizetype task)
+{
+    setTaskProgress(task, 1.0);
+
+    QMutexLocker locker(&m_checkpointLock);
+    if (!m_checkpoint) {
+        return;
+    }
+    auto finishedTasks = m_checkpoint->value(QStringLiteral("Check/FinishedTasks")).toStringList();
+    finishedTasks.push_back(m_tasks[task].id);
+    m_checkpoint->setValue(QStringLiteral("Check/FinishedTasks"), finishedTasks);
+    m_checkpoint->remove(QStringLiteral("Chunks/") + m_tasks[task].id);
+    m_checkpoint->sync();
+}
+
+qint64 StorageJanitor::chunkCheckpoint(qsizetype task)
+{
+    QMutexLocker locker(&m_checkpointLock);
+    return m_checkpoint ? m_checkpoint->value(QStringLiteral("Chunks/") + m_tasks[task].id, -1).toLongLong() : -1;
+}
+
+void StorageJanitor::setChunkCheckpoint(qsizetype task, qint64 nextId)
+{
+    QMutexLocker locker(&m_checkpointLock);
+    if (m_checkpoint) {
+        m_checkpoint->setValue(QStringLiteral("Chunks/") + m_tasks[task].id, nextId);
+        m_checkpoint->sync();
+    }
+}
+
+void StorageJanitor::setTaskProgress(qsizetype task, double fraction)
+{
+    QMutexLocker locker(&m_progressLock);
+    if (task < 0 || task >= m_taskProgress.size()) {
+        return;
+    }
+    m_taskProgress[task] = fraction;
+    // Progress within a task is reported every few seconds, finished tasks are always reported
+    if (fraction < 1.0 && m_progressTimer.isValid() && m_progressTimer.durationElapsed() < ProgressInterval) {
+        return;
+    }
+    m_progressTimer.start();
+
+    const double total = std::accumulate(m_taskProgress.cbegin(), m_taskProgress.cend(), 0.0) / m_taskProgress.size();
+    const double gained = total - m_initialProgress;
+    const qint64 remainingSeconds = gained > 0.0 ? qint64(m_checkTimer.elapsed() / 1000.0 * (1.0 - total) / gained) : -1;
+    locker.unlock();
+
+    Q_EMIT progress(int(total * 100), remainingSeconds);
+}
+
 qint64 StorageJanitor::lostAndFoundCollection()
 {
     if (m_lostFoundCollectionId > 0) {
         return m_lostFoundCollectionId;
     }
 
-    Transaction transaction(m_dataStore.get(), QStringLiteral("JANITOR LOST+FOUND"));
-    Resource lfRes = Resource::retrieveByName(m_dataStore.get(), QStringLiteral("akonadi_lost+found_resource"));
+    Transaction transaction(dataStore(), QStringLiteral("JANITOR LOST+FOUND"));
+    Resource lfRes = Resource::retrieveByName(dataStore(), QStringLiteral("akonadi_lost+found_resource"));
     if (!lfRes.isValid()) {
         lfRes.setName(QStringLiteral("akonadi_lost+found_resource"));
-        if (!lfRes.insert(m_dataStore.get())) {
+        if (!lfRes.insert(dataStore())) {
             qCCritical(AKONADISERVER_LOG) << "Failed to create lost+found resource!";
         }
     }
 
     Collection lfRoot;
-    SelectQueryBuilder<Collection> qb(m_dataStore.get());
+    SelectQueryBuilder<Collection> qb(dataStore());
     qb.addValueCondition(Collection::resourceIdFullColumnName(), Query::Equals, lfRes.id());
     qb.addValueCondition(Collection::parentIdFullColumnName(), Query::Is, QVariant());
     if (!qb.exec()) {
@@ -185,11 +501,11 @@ qint64 StorageJanitor::lostAndFoundCollection()
         lfRoot.setCachePolicyLocalParts(QStringLiteral("ALL"));
         lfRoot.setCachePolicyCacheTimeout(-1);
         lfRoot.setCachePolicyInherit(false);
-        if (!lfRoot.insert(m_dataStore.get())) {
+        if (!lfRoot.insert(dataStore())) {
             qCCritical(AKONADISERVER_LOG) << "Failed to create lost+found root.";
         }
         if (m_akonadi) {
-            m_dataStore->notificationCollector()->collectionAdded(lfRoot, lfRes.name().toUtf8());
+            dataStore()->notificationCollector()->collectionAdded(lfRoot, lfRes.name().toUtf8());
         }
     }
 
@@ -197,17 +513,17 @@ qint64 StorageJanitor::lostAndFoundCollection()
     lfCol.setName(QDateTime::currentDateTime().toString(QStringLiteral("yyyy-MM-dd hh:mm:ss")));
     lfCol.setResourceId(lfRes.id());
     lfCol.setParentId(lfRoot.id());
-    if (!lfCol.insert(m_dataStore.get())) {
+    if (!lfCol.insert(dataStore())) {
         qCCritical(AKONADISERVER_LOG) << "Failed to create lost+found collection!";
     }
 
-    const auto retrieveAll = MimeType::retrieveAll(m_dataStore.get());
+    const auto retrieveAll = MimeType::retrieveAll(dataStore());
     for (const MimeType &mt : retrieveAll) {
-        lfCol.addMimeType(m_dataStore.get(), mt);
+        lfCol.addMimeType(dataStore(), mt);
     }
 
     if (m_akonadi) {
-        m_dataStore->notificationCollector()->collectionAdded(lfCol, lfRes.name().toUtf8());
+        dataStore()->notificationCollector()->collectionAdded(lfCol, lfRes.name().toUtf8());
     }
 
     transaction.commit();
@@ -217,7 +533,7 @@ qint64 StorageJanitor::lostAndFoundCollection()
 
 void StorageJanitor::findOrphanedResources()
 {
-    SelectQueryBuilder<Resource> qbres(m_dataStore.get());
+    SelectQueryBuilder<Resource> qbres(dataStore());
     OrgFreedesktopAkonadiAgentManagerInterface iface(DBus::serviceName(DBus::Control), QStringLiteral("/AgentManager"), QDBusConnection::sessionBus(), this);
     if (!iface.isValid()) {
         inform(QStringLiteral("ERROR: Couldn't talk to %1").arg(DBus::Control));
@@ -253,7 +569,7 @@ void StorageJanitor::findOrphanedResources()
 
 void StorageJanitor::findOrphanedCollections()
 {
-    SelectQueryBuilder<Collection> qb(m_dataStore.get());
+    SelectQueryBuilder<Collection> qb(dataStore());
     qb.addJoin(QueryBuilder::LeftJoin, Resource::tableName(), Collection::resourceIdFullColumnName(), Resource::idFullColumnName());
     qb.addValueCondition(Resource::idFullColumnName(), Query::Is, QVariant());
 
@@ -270,7 +586,7 @@ void StorageJanitor::findOrphanedCollections()
 
 void StorageJanitor::checkCollectionTreeConsistency()
 {
-    const Collection::List cols = Collection::retrieveAll(m_dataStore.get());
+    const Collection::List cols = Collection::retrieveAll(dataStore());
     std::for_each(cols.begin(), cols.end(), [this](const Collection &col) {
         checkPathToRoot(col);
     });
@@ -281,7 +597,7 @@ void StorageJanitor::checkPathToRoot(const Collection &col)
     if (col.parentId() == 0) {
         return;
     }
-    const Collection parent = col.parent(m_dataStore.get());
+    const Collection parent = col.parent(dataStore());
     if (!parent.isValid()) {
         inform(QLatin1StringView("Collection \"") + col.name() + QLatin1StringView("\" (id: ") + QString::number(col.id())
                + QLatin1StringView(") has no valid parent."));
@@ -306,7 +622,7 @@ void StorageJanitor::findOrphanedItems()
     }
 
     // Attach to lost+found collection
-    QSqlQuery query(m_dataStore->database());
+    QSqlQuery query(dataStore()->database());
     query.prepare(u"UPDATE %1 SET %2 = :col WHERE %3 NOT IN (SELECT DISTINCT %4 from %5)"_s.arg(PimItem::tableName(),
                                                                                                 PimItem::collectionIdColumn(),
                                                                                                 PimItem::collectionIdColumn(),
@@ -314,7 +630,7 @@ void StorageJanitor::findOrphanedItems()
                                                                                                 Collection::tableName()));
     query.bindValue(u":col"_s, QVariant::fromValue(col));
 
-    Transaction transaction(m_dataStore.get(), QStringLiteral("JANITOR ORPHANS"));
+    Transaction transaction(dataStore(), QStringLiteral("JANITOR ORPHANS"));
 
     if (query.exec() && transaction.commit()) {
         inform(QLatin1StringView("Moved orphan items to collection ") + QString::number(col));
@@ -325,23 +641,33 @@ void StorageJanitor::findOrphanedItems()
 
 void StorageJanitor::findOrphanedParts()
 {
-    SelectQueryBuilder<Part> qb(m_dataStore.get());
-    qb.addJoin(QueryBuilder::LeftJoin, PimItem::tableName(), Part::pimItemIdFullColumnName(), PimItem::idFullColumnName());
-    qb.addValueCondition(PimItem::idFullColumnName(), Query::Is, QVariant());
-    if (!qb.exec()) {
-        inform("Failed to query orphaned parts, skipping test");
-        return;
-    }
-    const Part::List orphans = qb.result();
-    if (!orphans.isEmpty()) {
-        inform(QLatin1StringView("Found ") + QString::number(orphans.size()) + QLatin1StringView(" orphan parts."));
+    qsizetype orphans = 0;
+    forEachChunk(Part::tableName(), Part::idColumn(), PartChunkSize, [this, &orphans](qint64 from, qint64 to) {
+        QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
+        qb.addColumn(Part::idFullColumnName());
+        qb.addJoin(QueryBuilder::LeftJoin, PimItem::tableName(), Part::pimItemIdFullColumnName(), PimItem::idFullColumnName());
+        qb.addValueCondition(PimItem::idFullColumnName(), Query::Is, QVariant());
+        qb.addValueCondition(Part::idFullColumnName(), Query::GreaterOrEqual, from);
+        qb.addValueCondition(Part::idFullColumnName(), Query::Less, to);
+        if (!qb.exec()) {
+            inform("Failed to query orphaned parts, skipping test");
+            return false;
+        }
+        while (qb.query().next()) {
+            ++orphans;
+        }
+        qb.query().finish();
+        return true;
+    });
+    if (orphans > 0) {
+        inform(QLatin1StringView("Found ") + QString::number(orphans) + QLatin1StringView(" orphan parts."));
         // TODO: create lost+found items for those? delete?
     }
 }
 
 void StorageJanitor::findOrphanedPimItemFlags()
 {
-    QueryBuilder sqb(m_dataStore.get(), PimItemFlagRelation::tableName(), QueryBuilder::Select);
+    QueryBuilder sqb(dataStore(), PimItemFlagRelation::tableName(), QueryBuilder::Select);
     sqb.addColumn(PimItemFlagRelation::leftFullColumnName());
     sqb.addJoin(QueryBuilder::LeftJoin, PimItem::tableName(), PimItemFlagRelation::leftFullColumnName(), PimItem::idFullColumnName());
     sqb.addValueCondition(PimItem::idFullColumnName(), Query::Is, QVariant());
@@ -356,7 +682,7 @@ void StorageJanitor::findOrphanedPimItemFlags()
     }
     sqb.query().finish();
     if (!ids.empty()) {
-        QueryBuilder qb(m_dataStore.get(), PimItemFlagRelation::tableName(), QueryBuilder::Delete);
+        QueryBuilder qb(dataStore(), PimItemFlagRelation::tableName(), QueryBuilder::Delete);
         qb.addValueCondition(PimItemFlagRelation::leftFullColumnName(), Query::In, ids);
         if (!qb.exec()) {
             qCCritical(AKONADISERVER_LOG) << "Error:" << qb.query().lastError().text();
@@ -432,7 +758,7 @@ std::optional<int> findDuplicatesImpl(DataStore *dataStore, const QString &nameC
 void StorageJanitor::findDuplicateFlags()
 {
     const auto removed =
-        findDuplicatesImpl<Flag>(m_dataStore.get(), Flag::nameFullColumnName(), {PimItemFlagRelation::tableName(), PimItemFlagRelation::rightFullColumnName()});
+        findDuplicatesImpl<Flag>(dataStore(), Flag::nameFullColumnName(), {PimItemFlagRelation::tableName(), PimItemFlagRelation::rightFullColumnName()});
     if (removed) {
         inform(u"Removed " % QString::number(*removed) % u" duplicate item flags");
     } else {
@@ -443,7 +769,7 @@ void StorageJanitor::findDuplicateFlags()
 void StorageJanitor::findDuplicateMimeTypes()
 {
     const auto removed =
-        findDuplicatesImpl<MimeType>(m_dataStore.get(), MimeType::nameFullColumnName(), {PimItem::tableName(), PimItem::mimeTypeIdFullColumnName()});
+        findDuplicatesImpl<MimeType>(dataStore(), MimeType::nameFullColumnName(), {PimItem::tableName(), PimItem::mimeTypeIdFullColumnName()});
     if (removed) {
         inform(u"Removed " % QString::number(*removed) % u" duplicate mime types");
     } else {
@@ -455,13 +781,13 @@ void StorageJanitor::findDuplicatePartTypes()
 {
     // Good thing that SQL is ANSI/ISO standardized...
     QString nameColumn;
-    if (DbType::type(m_dataStore->database()) == DbType::MySQL) {
+    if (DbType::type(dataStore()->database()) == DbType::MySQL) {
         nameColumn = QStringLiteral("CONCAT_WS(':', %1, %2) AS name");
     } else {
         nameColumn = QStringLiteral("(%1 || ':' || %2) AS name");
     }
 
-    const auto removed = findDuplicatesImpl<PartType>(m_dataStore.get(),
+    const auto removed = findDuplicatesImpl<PartType>(dataStore(),
                                                       nameColumn.arg(PartType::nsFullColumnName(), PartType::nameFullColumnName()),
                                                       {Part::tableName(), Part::partTypeIdFullColumnName()});
     if (removed) {
@@ -473,7 +799,7 @@ void StorageJanitor::findDuplicatePartTypes()
 
 void StorageJanitor::findDuplicateTagTypes()
 {
-    const auto removed = findDuplicatesImpl<TagType>(m_dataStore.get(), TagType::nameFullColumnName(), {Tag::tableName(), Tag::typeIdFullColumnName()});
+    const auto removed = findDuplicatesImpl<TagType>(dataStore(), TagType::nameFullColumnName(), {Tag::tableName(), Tag::typeIdFullColumnName()});
     if (removed) {
         inform(u"Removed " % QString::number(*removed) % u" duplicate tag types");
     } else {
@@ -483,7 +809,7 @@ void StorageJanitor::findDuplicateTagTypes()
 
 void StorageJanitor::findOverlappingParts()
 {
-    QueryBuilder qb(m_dataStore.get(), Part::tableName(), QueryBuilder::Select);
+    QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
     qb.addColumn(Part::dataColumn());
     qb.addColumn(QLatin1StringView("count(") + Part::idColumn() + QLatin1StringView(") as cnt"));
     qb.addValueCondition(Part::storageColumn(), Query::Equals, Part::External);
@@ -515,18 +841,104 @@ void StorageJanitor::verifyExternalParts()
 
     // list all files
     const QString dataDir = StandardDirs::saveDir("data", QStringLiteral("file_db_data"));
+    // Packed part segments are checked by checkPackedParts() and compactPackedParts()
+    const QString packsDir = PackedPartStorage::storagePath() + QDir::separator();
     QDirIterator it(dataDir, QDir::Files, QDirIterator::Subdirectories);
     while (it.hasNext()) {
-        existingFiles.insert(it.next());
+        const QString file = it.next();
+        if (!file.startsWith(packsDir)) {
+            existingFiles.insert(file);
+        }
     }
     existingFiles.remove(dataDir + QDir::separator() + u'.');
     existingFiles.remove(dataDir + QDir::separator() + QLatin1StringView(".."));
     inform(QLatin1StringView("Found ") + QString::number(existingFiles.size()) + QLatin1StringView(" external files."));
 
-    // list all parts from the db which claim to have an associated file
-    QueryBuilder qb(m_dataStore.get(), Part::tableName(), QueryBuilder::Select);
+    // verify all parts from the db which claim to have an associated file
+    qsizetype verifiedParts = 0;
+    qsizetype storedHashes = 0;
+    const bool finished = forEachChunk(Part::tableName(), Part::idColumn(), PartChunkSize, [&](qint64 from, qint64 to) {
+        QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
+        qb.addColumn(Part::dataColumn());
+        qb.addColumn(Part::pimItemIdColumn());
+        qb.addColumn(Part::idColumn());
+        qb.addColumn(Part::contentHashColumn());
+        qb.addValueCondition(Part::storageColumn(), Query::Equals, Part::External);
+        qb.addValueCondition(Part::dataColumn(), Query::IsNot, QVariant());
+        qb.addValueCondition(Part::idColumn(), Query::GreaterOrEqual, from);
+        qb.addValueCondition(Part::idColumn(), Query::Less, to);
+        if (!qb.exec()) {
+            inform("Failed to query existing parts, skipping test");
+            return false;
+        }
+        // Hashes of parts stored before content hashes were introduced, updated once the query is done
+        QHash<Entity::Id, QString> missingHashes;
+        while (qb.query().next()) {
+            const auto filename = qb.query().value(0).toByteArray();
+            const auto pimItemId = qb.query().value(1).value<Entity::Id>();
+            const auto partId = qb.query().value(2).value<Entity::Id>();
+            const auto contentHash = Utils::variantToString(qb.query().value(3));
+            QString partPath;
+            if (!filename.isEmpty()) {
+                partPath = ExternalPartStorage::resolveAbsolutePath(filename);
+            } else {
+                partPath = ExternalPartStorage::resolveAbsolutePath(ExternalPartStorage::nameForPartId(partId));
+            }
+            // The part may have been stored after the files were listed
+            bool valid = existingFiles.contains(partPath) || QFile::exists(partPath);
+            if (valid) {
+                const QString fileHash = PartHelper::fileContentHash(partPath);
+                if (contentHash.isEmpty()) {
+                    missingHashes.insert(partId, fileHash);
+                } else if (fileHash != contentHash) {
+                    // No longer referenced once the part is reset, so the file is moved to lost+found below
+                    inform(QLatin1StringView("Content of external file ") + partPath + QLatin1StringView(" does not match the hash of part: ")
+                           + QString::number(partId));
+                    valid = false;
+                }
+            } else {
+                inform(QLatin1StringView("Cleaning up missing external file: ") + partPath + QLatin1StringView(" for item: ") + QString::number(pimItemId)
+                       + QLatin1StringView(" on part: ") + QString::number(partId));
+            }
+
+            if (valid) {
+                ++verifiedParts;
+            } else {
+                // The payload will be retrieved from the resource again
+                Part part;
+                part.setId(partId);
+                part.setPimItemId(pimItemId);
+                part.setData(QByteArray());
+                part.setDatasize(0);
+                part.setStorage(Part::Internal);
+                part.update(dataStore());
+            }
+        }
+        qb.query().finish();
+
+        for (auto it = missingHashes.cbegin(), end = missingHashes.cend(); it != end; ++it) {
+            QueryBuilder hashQb(dataStore(), Part::tableName(), QueryBuilder::Update);
+            hashQb.setColumnValue(Part::contentHashColumn(), it.value());
+            hashQb.addValueCondition(Part::idColumn(), Query::Equals, it.key());
+            if (!hashQb.exec()) {
+                inform(QLatin1StringView("Failed to store the content hash of part: ") + QString::number(it.key()));
+            }
+        }
+        storedHashes += missingHashes.size();
+        return true;
+    });
+    if (storedHashes > 0) {
+        inform(QStringLiteral("Stored the content hashes of %1 external parts.").arg(storedHashes));
+    }
+    inform(QLatin1StringView("Verified ") + QString::number(verifiedParts) + QLatin1StringView(" external parts."));
+    if (!finished) {
+        // Without having seen all parts, unreferenced files cannot be told apart
+        return;
+    }
+
+    // The parts referencing files right now, including the ones added during the check
+    QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
     qb.addColumn(Part::dataColumn());
-    qb.addColumn(Part::pimItemIdColumn());
     qb.addColumn(Part::idColumn());
     qb.addValueCondition(Part::storageColumn(), Query::Equals, Part::External);
     qb.addValueCondition(Part::dataColumn(), Query::IsNot, QVariant());
@@ -536,31 +948,23 @@ void StorageJanitor::verifyExternalParts()
     }
     while (qb.query().next()) {
         const auto filename = qb.query().value(0).toByteArray();
-        const auto pimItemId = qb.query().value(1).value<Entity::Id>();
-        const auto partId = qb.query().value(2).value<Entity::Id>();
-        QString partPath;
         if (!filename.isEmpty()) {
-            partPath = ExternalPartStorage::resolveAbsolutePath(filename);
+            usedFiles.insert(ExternalPartStorage::resolveAbsolutePath(filename));
         } else {
-            partPath = ExternalPartStorage::resolveAbsolutePath(ExternalPartStorage::nameForPartId(partId));
-        }
-        if (existingFiles.contains(partPath)) {
-            usedFiles.insert(partPath);
-        } else {
-            inform(QLatin1StringView("Cleaning up missing external file: ") + partPath + QLatin1StringView(" for item: ") + QString::number(pimItemId)
-                   + QLatin1StringView(" on part: ") + QString::number(partId));
-
-            Part part;
-            part.setId(partId);
-            part.setPimItemId(pimItemId);
-            part.setData(QByteArray());
-            part.setDatasize(0);
-            part.setStorage(Part::Internal);
-            part.update(m_dataStore.get());
+            usedFiles.insert(ExternalPartStorage::resolveAbsolutePath(ExternalPartStorage::nameForPartId(qb.query().value(1).value<Entity::Id>())));
         }
     }
     qb.query().finish();
-    inform(QLatin1StringView("Found ") + QString::number(usedFiles.size()) + QLatin1StringView(" external parts."));
+
+    // Files of removed parts which the PartFileReclaimer has not deleted yet
+    QueryBuilder tombstoneQb(dataStore(), PartFileTombstone::tableName(), QueryBuilder::Select);
+    tombstoneQb.addColumn(PartFileTombstone::fileNameColumn());
+    if (tombstoneQb.exec()) {
+        while (tombstoneQb.query().next()) {
+            usedFiles.insert(ExternalPartStorage::resolveAbsolutePath(tombstoneQb.query().value(0).toByteArray()));
+        }
+        tombstoneQb.query().finish();
+    }
 
     // see what's left and move it to lost+found
     const QSet<QString> unreferencedFiles = existingFiles - usedFiles;
@@ -577,9 +981,92 @@ void StorageJanitor::verifyExternalParts()
     }
 }
 
+void StorageJanitor::deduplicateExternalParts()
+{
+#ifdef Q_OS_UNIX
+    QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
+    qb.addColumn(Part::idColumn());
+    qb.addColumn(Part::dataColumn());
+    qb.addColumn(Part::contentHashColumn());
+    qb.addColumn(Part::datasizeColumn());
+    qb.addValueCondition(Part::storageColumn(), Query::Equals, Part::External);
+    qb.addValueCondition(Part::dataColumn(), Query::IsNot, QVariant());
+    qb.addValueCondition(Part::contentHashColumn(), Query::IsNot, QVariant());
+    qb.addSortColumn(Part::contentHashColumn());
+    qb.addSortColumn(Part::datasizeColumn());
+    qb.addSortColumn(Part::idColumn());
+    if (!qb.exec()) {
+        inform("Failed to query external parts, skipping test");
+        return;
+    }
+
+    struct Duplicate {
+        qint64 partId;
+        QByteArray fileName;
+        QByteArray sharedFileName;
+    };
+    QList<Duplicate> duplicates;
+    QString sharedHash;
+    qint64 sharedSize = -1;
+    QByteArray sharedFileName;
+    while (qb.query().next()) {
+        const auto partId = qb.query().value(0).value<qint64>();
+        const auto fileName = qb.query().value(1).toByteArray();
+        const auto hash = Utils::variantToString(qb.query().value(2));
+        const auto size = qb.query().value(3).value<qint64>();
+        if (hash.isEmpty() || fileName.isEmpty()) {
+            continue;
+        }
+        // The first part of every group of parts with the same content keeps its file
+        if (hash != sharedHash || size != sharedSize) {
+            sharedHash = hash;
+            sharedSize = size;
+            sharedFileName = fileName;
+            continue;
+        }
+        if (!isSameFile(ExternalPartStorage::resolveAbsolutePath(fileName), ExternalPartStorage::resolveAbsolutePath(sharedFileName))) {
+            duplicates.push_back({partId, fileName, sharedFileName});
+        }
+    }
+    qb.query().finish();
+
+    int count = 0;
+    for (const auto &duplicate : std::as_const(duplicates)) {
+        // Only drop the old file once the part refers to the new one
+        ExternalPartStorageTransaction trx;
+        QByteArray newFileName;
+        if (!ExternalPartStorage::self()->updatePartFileLink(duplicate.sharedFileName, duplicate.fileName, newFileName)) {
+            inform(QLatin1StringView("Failed to share the external file of part: ") + QString::number(duplicate.partId));
+            trx.rollback();
+            continue;
+        }
+
+        QueryBuilder updateQb(dataStore(), Part::tableName(), QueryBuilder::Update);
+        updateQb.setColumnValue(Part::dataColumn(), newFileName);
+        updateQb.addValueCondition(Part::idColumn(), Query::Equals, duplicate.partId);
+        updateQb.addValueCondition(Part::dataColumn(), Query::Equals, duplicate.fileName);
+        if (!updateQb.exec() || updateQb.query().numRowsAffected() != 1) {
+            // The part has been modified in the meantime
+            trx.rollback();
+            continue;
+        }
+        trx.commit();
+        ++count;
+    }
+
+    if (count > 0) {
+        inform(QStringLiteral("Deduplicated %1 external parts.").arg(count));
+    } else {
+        inform("Found no duplicate external parts.");
+    }
+#else
+    inform("Sharing external part files is not supported on this platform, skipping test");
+#endif
+}
+
 void StorageJanitor::findDirtyObjects()
 {
-    SelectQueryBuilder<Collection> cqb(m_dataStore.get());
+    SelectQueryBuilder<Collection> cqb(dataStore());
     cqb.setSubQueryMode(Query::Or);
     cqb.addValueCondition(Collection::remoteIdColumn(), Query::Is, QVariant());
     cqb.addValueCondition(Collection::remoteIdColumn(), Query::Equals, QString());
@@ -594,7 +1081,7 @@ void StorageJanitor::findDirtyObjects()
     }
     inform(QLatin1StringView("Found ") + QString::number(ridLessCols.size()) + QLatin1StringView(" collections without RID."));
 
-    SelectQueryBuilder<PimItem> iqb1(m_dataStore.get());
+    SelectQueryBuilder<PimItem> iqb1(dataStore());
     iqb1.setSubQueryMode(Query::Or);
     iqb1.addValueCondition(PimItem::remoteIdColumn(), Query::Is, QVariant());
     iqb1.addValueCondition(PimItem::remoteIdColumn(), Query::Equals, QString());
@@ -609,7 +1096,7 @@ void StorageJanitor::findDirtyObjects()
     }
     inform(QLatin1StringView("Found ") + QString::number(ridLessItems.size()) + QLatin1StringView(" items without RID."));
 
-    SelectQueryBuilder<PimItem> iqb2(m_dataStore.get());
+    SelectQueryBuilder<PimItem> iqb2(dataStore());
     iqb2.addValueCondition(PimItem::dirtyColumn(), Query::Equals, true);
     iqb2.addValueCondition(PimItem::remoteIdColumn(), Query::IsNot, QVariant());
     iqb2.addSortColumn(PimItem::idFullColumnName());
@@ -626,88 +1113,96 @@ void StorageJanitor::findDirtyObjects()
 
 void StorageJanitor::findRIDDuplicates()
 {
-    QueryBuilder qb(m_dataStore.get(), Collection::tableName(), QueryBuilder::Select);
-    qb.addColumn(Collection::idColumn());
-    qb.addColumn(Collection::nameColumn());
-    qb.exec();
+    forEachChunk(Collection::tableName(), Collection::idColumn(), CollectionChunkSize, [this](qint64 from, qint64 to) {
+        QueryBuilder qb(dataStore(), Collection::tableName(), QueryBuilder::Select);
+        qb.addColumn(Collection::idColumn());
+        qb.addColumn(Collection::nameColumn());
+        qb.addValueCondition(Collection::idColumn(), Query::GreaterOrEqual, from);
+        qb.addValueCondition(Collection::idColumn(), Query::Less, to);
+        if (!qb.exec()) {
+            inform("Failed to query collections, skipping test");
+            return false;
+        }
 
-    while (qb.query().next()) {
-        const auto colId = qb.query().value(0).value<Collection::Id>();
-        const QString name = qb.query().value(1).toString();
-        inform(QStringLiteral("Checking ") + name);
-
-        QueryBuilder duplicates(m_dataStore.get(), PimItem::tableName(), QueryBuilder::Select);
-        duplicates.addColumn(PimItem::remoteIdColumn());
-        duplicates.addColumn(QStringLiteral("count(") + PimItem::idColumn() + QStringLiteral(") as cnt"));
-        duplicates.addValueCondition(PimItem::remoteIdColumn(), Query::IsNot, QVariant());
-        duplicates.addValueCondition(PimItem::collectionIdColumn(), Query::Equals, colId);
-        duplicates.addGroupColumn(PimItem::remoteIdColumn());
-        duplicates.addValueCondition(QStringLiteral("count(") + PimItem::idColumn() + u')', Query::Greater, 1, QueryBuilder::HavingCondition);
-        duplicates.exec();
-
-        Akonadi::Server::Collection col = Akonadi::Server::Collection::retrieveById(m_dataStore.get(), colId);
-        const QList<Akonadi::Server::MimeType> contentMimeTypes = col.mimeTypes(m_dataStore.get());
-        QVariantList contentMimeTypesVariantList;
-        contentMimeTypesVariantList.reserve(contentMimeTypes.count());
-        for (const Akonadi::Server::MimeType &mimeType : contentMimeTypes) {
-            contentMimeTypesVariantList << mimeType.id();
-        }
-        while (duplicates.query().next()) {
-            const QString rid = duplicates.query().value(0).toString();
-
-            Query::Condition condition(Query::And);
-            condition.addValueCondition(PimItem::remoteIdColumn(), Query::Equals, rid);
-            condition.addValueCondition(PimItem::mimeTypeIdColumn(), Query::NotIn, contentMimeTypesVariantList);
-            condition.addValueCondition(PimItem::collectionIdColumn(), Query::Equals, colId);
-
-            QueryBuilder items(m_dataStore.get(), PimItem::tableName(), QueryBuilder::Select);
-            items.addColumn(PimItem::idColumn());
-            items.addCondition(condition);
-            if (!items.exec()) {
-                inform(QStringLiteral("Error while deleting duplicates: ") + items.query().lastError().text());
-                continue;
-            }
-            QVariantList itemsIds;
-            while (items.query().next()) {
-                itemsIds.push_back(items.query().value(0));
-            }
-            items.query().finish();
-            if (itemsIds.isEmpty()) {
-                // the mimetype filter may have dropped some entries from the
-                // duplicates query
-                continue;
+        while (qb.query().next()) {
+            const auto colId = qb.query().value(0).value<Collection::Id>();
+            const QString name = qb.query().value(1).toString();
+            inform(QStringLiteral("Checking ") + name);
+
+            QueryBuilder duplicates(dataStore(), PimItem::tableName(), QueryBuilder::Select);
+            duplicates.addColumn(PimItem::remoteIdColumn());
+            duplicates.addColumn(QStringLiteral("count(") + PimItem::idColumn() + QStringLiteral(") as cnt"));
+            duplicates.addValueCondition(PimItem::remoteIdColumn(), Query::IsNot, QVariant());
+            duplicates.addValueCondition(PimItem::collectionIdColumn(), Query::Equals, colId);
+            duplicates.addGroupColumn(PimItem::remoteIdColumn());
+            duplicates.addValueCondition(QStringLiteral("count(") + PimItem::idColumn() + u')', Query::Greater, 1, QueryBuilder::HavingCondition);
+            duplicates.exec();
+
+            Akonadi::Server::Collection col = Akonadi::Server::Collection::retrieveById(dataStore(), colId);
+            const QList<Akonadi::Server::MimeType> contentMimeTypes = col.mimeTypes(dataStore());
+            QVariantList contentMimeTypesVariantList;
+            contentMimeTypesVariantList.reserve(contentMimeTypes.count());
+            for (const Akonadi::Server::MimeType &mimeType : contentMimeTypes) {
+                contentMimeTypesVariantList << mimeType.id();
             }
+            while (duplicates.query().next()) {
+                const QString rid = duplicates.query().value(0).toString();
+
+                Query::Condition condition(Query::And);
+                condition.addValueCondition(PimItem::remoteIdColumn(), Query::Equals, rid);
+                condition.addValueCondition(PimItem::mimeTypeIdColumn(), Query::NotIn, contentMimeTypesVariantList);
+                condition.addValueCondition(PimItem::collectionIdColumn(), Query::Equals, colId);
+
+                QueryBuilder items(dataStore(), PimItem::tableName(), QueryBuilder::Select);
+                items.addColumn(PimItem::idColumn());
+                items.addCondition(condition);
+                if (!items.exec()) {
+                    inform(QStringLiteral("Error while deleting duplicates: ") + items.query().lastError().text());
+                    continue;
+                }
+                QVariantList itemsIds;
+                while (items.query().next()) {
+                    itemsIds.push_back(items.query().value(0));
+                }
+                items.query().finish();
+                if (itemsIds.isEmpty()) {
+                    // the mimetype filter may have dropped some entries from the
+                    // duplicates query
+                    continue;
+                }
 
-            inform(QStringLiteral("Found duplicates ") + rid);
-
-            SelectQueryBuilder<Part> parts(m_dataStore.get());
-            parts.addValueCondition(Part::pimItemIdFullColumnName(), Query::In, QVariant::fromValue(itemsIds));
-            parts.addValueCondition(Part::storageFullColumnName(), Query::Equals, static_cast<int>(Part::External));
-            if (parts.exec()) {
-                const auto partsList = parts.result();
-                for (const auto &part : partsList) {
-                    bool exists = false;
-                    const auto filename = ExternalPartStorage::resolveAbsolutePath(part.data(), &exists);
-                    if (exists) {
-                        QFile::remove(filename);
+                inform(QStringLiteral("Found duplicates ") + rid);
+
+                SelectQueryBuilder<Part> parts(dataStore());
+                parts.addValueCondition(Part::pimItemIdFullColumnName(), Query::In, QVariant::fromValue(itemsIds));
+                parts.addValueCondition(Part::storageFullColumnName(), Query::Equals, static_cast<int>(Part::External));
+                if (parts.exec()) {
+                    const auto partsList = parts.result();
+                    for (const auto &part : partsList) {
+                        bool exists = false;
+                        const auto filename = ExternalPartStorage::resolveAbsolutePath(part.data(), &exists);
+                        if (exists) {
+                            QFile::remove(filename);
+                        }
                     }
                 }
-            }
 
-            items = QueryBuilder(m_dataStore.get(), PimItem::tableName(), QueryBuilder::Delete);
-            items.addCondition(condition);
-            if (!items.exec()) {
-                inform(QStringLiteral("Error while deleting duplicates ") + items.query().lastError().text());
+                items = QueryBuilder(dataStore(), PimItem::tableName(), QueryBuilder::Delete);
+                items.addCondition(condition);
+                if (!items.exec()) {
+                    inform(QStringLiteral("Error while deleting duplicates ") + items.query().lastError().text());
+                }
             }
+            duplicates.query().finish();
         }
-        duplicates.query().finish();
-    }
-    qb.query().finish();
+        qb.query().finish();
+        return true;
+    });
 }
 
 void StorageJanitor::vacuum()
 {
-    const DbType::Type dbType = DbType::type(m_dataStore->database());
+    const DbType::Type dbType = DbType::type(dataStore()->database());
     if (dbType == DbType::MySQL || dbType == DbType::PostgreSQL) {
         inform("vacuuming database, that'll take some time and require a lot of temporary disk space...");
         const auto tables = allDatabaseTables();
@@ -722,7 +1217,7 @@ void StorageJanitor::vacuum()
             } else {
                 continue;
             }
-            QSqlQuery q(m_dataStore->database());
+            QSqlQuery q(dataStore()->database());
             if (!q.exec(queryStr)) {
                 qCCritical(AKONADISERVER_LOG) << "failed to optimize table" << table << ":" << q.lastError().text();
             }
@@ -732,7 +1227,11 @@ void StorageJanitor::vacuum()
         inform(
             "vacuuming database, that'll take some time and require a lot of "
             "temporary disk space...");
-        QSqlQuery q(m_dataStore->database());
+        QSqlQuery q(dataStore()->database());
+        // Rebuilding the database enables incremental vacuuming by the DatabaseMaintenance
+        if (!q.exec(QLatin1StringView("PRAGMA auto_vacuum=INCREMENTAL"))) {
+            qCWarning(AKONADISERVER_LOG) << "Unable to enable incremental vacuum:" << q.lastError().text();
+        }
         if (!q.exec(QLatin1StringView("VACUUM"))) {
             qCCritical(AKONADISERVER_LOG) << "failed to optimize database:" << q.lastError().text();
         }
@@ -747,27 +1246,36 @@ void StorageJanitor::vacuum()
         inform("Vacuum not supported for this database backend.");
     }
 
+    compactPackedParts();
+
     Q_EMIT done();
 }
 
 void StorageJanitor::checkSizeTreshold()
 {
-    {
-        QueryBuilder qb(m_dataStore.get(), Part::tableName(), QueryBuilder::Select);
+    qsizetype movedToFiles = 0;
+    qsizetype movedToDatabase = 0;
+    forEachChunk(Part::tableName(), Part::idColumn(), PartChunkSize, [&](qint64 from, qint64 to) {
+        QList<qint64> partIds;
+        QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
         qb.addColumn(Part::idFullColumnName());
         qb.addValueCondition(Part::storageFullColumnName(), Query::Equals, Part::Internal);
-        qb.addValueCondition(Part::datasizeFullColumnName(), Query::Greater, m_dbConfig->sizeThreshold());
+        // Smaller parts are moved into packed segments by checkPackedParts()
+        qb.addValueCondition(Part::datasizeFullColumnName(), Query::Greater, std::max(m_dbConfig->sizeThreshold(), m_dbConfig->packedPartThreshold()));
+        qb.addValueCondition(Part::idFullColumnName(), Query::GreaterOrEqual, from);
+        qb.addValueCondition(Part::idFullColumnName(), Query::Less, to);
         if (!qb.exec()) {
             inform("Failed to query parts larger than threshold, skipping test");
-            return;
+            return false;
         }
+        while (qb.query().next()) {
+            partIds.push_back(qb.query().value(0).toLongLong());
+        }
+        qb.query().finish();
 
-        auto &query = qb.query();
-        inform(QStringLiteral("Found %1 parts to be moved to external files").arg(query.size()));
-
-        while (query.next()) {
-            Transaction transaction(m_dataStore.get(), QStringLiteral("JANITOR CHECK SIZE THRESHOLD"));
-            Part part = Part::retrieveById(m_dataStore.get(), query.value(0).toLongLong());
+        for (const qint64 partId : std::as_const(partIds)) {
+            Transaction transaction(dataStore(), QStringLiteral("JANITOR CHECK SIZE THRESHOLD"));
+            Part part = Part::retrieveById(dataStore(), partId);
             const QByteArray name = ExternalPartStorage::nameForPartId(part.id());
             const QString partPath = ExternalPartStorage::resolveAbsolutePath(name);
             QFile f(partPath);
@@ -788,32 +1296,35 @@ void StorageJanitor::checkSizeTreshold()
 
             part.setData(name);
             part.setStorage(Part::External);
-            if (!part.update(m_dataStore.get()) || !transaction.commit()) {
+            if (!part.update(dataStore()) || !transaction.commit()) {
                 qCCritical(AKONADISERVER_LOG) << "Failed to update database entry of part" << part.id();
                 f.remove();
                 continue;
             }
 
             inform(QStringLiteral("Moved part %1 from database into external file %2").arg(part.id()).arg(QString::fromLatin1(name)));
+            ++movedToFiles;
         }
-    }
 
-    {
-        QueryBuilder qb(m_dataStore.get(), Part::tableName(), QueryBuilder::Select);
+        partIds.clear();
+        qb = QueryBuilder(dataStore(), Part::tableName(), QueryBuilder::Select);
         qb.addColumn(Part::idFullColumnName());
         qb.addValueCondition(Part::storageFullColumnName(), Query::Equals, Part::External);
         qb.addValueCondition(Part::datasizeFullColumnName(), Query::Less, DbConfig::configuredDatabase()->sizeThreshold());
+        qb.addValueCondition(Part::idFullColumnName(), Query::GreaterOrEqual, from);
+        qb.addValueCondition(Part::idFullColumnName(), Query::Less, to);
         if (!qb.exec()) {
             inform("Failed to query parts smaller than threshold, skipping test");
-            return;
+            return false;
         }
+        while (qb.query().next()) {
+            partIds.push_back(qb.query().value(0).toLongLong());
+        }
+        qb.query().finish();
 
-        auto &query = qb.query();
-        inform(QStringLiteral("Found %1 parts to be moved to database").arg(query.size()));
-
-        while (query.next()) {
-            Transaction transaction(m_dataStore.get(), QStringLiteral("JANITOR CHECK SIZE THRESHOLD 2"));
-            Part part = Part::retrieveById(m_dataStore.get(), query.value(0).toLongLong());
+        for (const qint64 partId : std::as_const(partIds)) {
+            Transaction transaction(dataStore(), QStringLiteral("JANITOR CHECK SIZE THRESHOLD 2"));
+            Part part = Part::retrieveById(dataStore(), partId);
             const QString partPath = ExternalPartStorage::resolveAbsolutePath(part.data());
             QFile f(partPath);
             if (!f.exists()) {
@@ -831,7 +1342,7 @@ void StorageJanitor::checkSizeTreshold()
                 qCCritical(AKONADISERVER_LOG) << "Sizes of" << part.id() << "data don't match";
                 continue;
             }
-            if (!part.update(m_dataStore.get()) || !transaction.commit()) {
+            if (!part.update(dataStore()) || !transaction.commit()) {
                 qCCritical(AKONADISERVER_LOG) << "Failed to update database entry of part" << part.id();
                 continue;
             }
@@ -839,8 +1350,221 @@ void StorageJanitor::checkSizeTreshold()
             f.close();
             f.remove();
             inform(QStringLiteral("Moved part %1 from external file into database").arg(part.id()));
+            ++movedToDatabase;
+        }
+        return true;
+    });
+    inform(QStringLiteral("Moved %1 parts to external files and %2 parts to the database").arg(movedToFiles).arg(movedToDatabase));
+}
+
+void StorageJanitor::checkPackedParts()
+{
+    const qint64 sizeThreshold = m_dbConfig->sizeThreshold();
+    const qint64 packedThreshold = std::max(m_dbConfig->packedPartThreshold(), sizeThreshold);
+
+    {
+        QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
+        qb.addColumn(Part::idFullColumnName());
+        qb.addValueCondition(Part::storageFullColumnName(), Query::NotEquals, Part::Packed);
+        qb.addValueCondition(Part::storageFullColumnName(), Query::NotEquals, Part::Foreign);
+        qb.addValueCondition(Part::datasizeFullColumnName(), Query::Greater, sizeThreshold);
+        qb.addValueCondition(Part::datasizeFullColumnName(), Query::LessOrEqual, packedThreshold);
+        qb.addValueCondition(Part::dataFullColumnName(), Query::IsNot, QVariant());
+        if (!qb.exec()) {
+            inform("Failed to query parts to be packed, skipping test");
+            return;
+        }
+
+        QList<qint64> partIds;
+        while (qb.query().next()) {
+            partIds.push_back(qb.query().value(0).toLongLong());
+        }
+        qb.query().finish();
+        if (!partIds.isEmpty()) {
+            inform(QStringLiteral("Found %1 parts to be moved into packed segments").arg(partIds.size()));
+        }
+
+        for (const qint64 partId : std::as_const(partIds)) {
+            Transaction transaction(dataStore(), QStringLiteral("JANITOR PACK PARTS"));
+            Part part = Part::retrieveById(dataStore(), partId);
+            const QByteArray payload = PartHelper::translateData(part);
+            if (payload.size() != part.datasize()) {
+                qCCritical(AKONADISERVER_LOG) << "Sizes of" << part.id() << "data don't match";
+                continue;
+            }
+            QByteArray location;
+            if (!PackedPartStorage::self()->appendPart(payload, location, dataStore())) {
+                continue;
+            }
+
+            const QString oldFile = part.storage() == Part::External ? ExternalPartStorage::resolveAbsolutePath(part.data()) : QString();
+            part.setData(location);
+            part.setStorage(Part::Packed);
+            if (!part.update(dataStore()) || !transaction.commit()) {
+                qCCritical(AKONADISERVER_LOG) << "Failed to update database entry of part" << part.id();
+                continue;
+            }
+            if (!oldFile.isEmpty()) {
+                ExternalPartStorage::self()->removePartFile(oldFile);
+            }
+        }
+    }
+
+    {
+        QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
+        qb.addColumn(Part::idFullColumnName());
+        qb.addValueCondition(Part::storageFullColumnName(), Query::Equals, Part::Packed);
+        Query::Condition sizeCondition(Query::Or);
+        sizeCondition.addValueCondition(Part::datasizeFullColumnName(), Query::LessOrEqual, sizeThreshold);
+        sizeCondition.addValueCondition(Part::datasizeFullColumnName(), Query::Greater, packedThreshold);
+        qb.addCondition(sizeCondition);
+        if (!qb.exec()) {
+            inform("Failed to query packed parts to be unpacked, skipping test");
+            return;
+        }
+
+        QList<qint64> partIds;
+        while (qb.query().next()) {
+            partIds.push_back(qb.query().value(0).toLongLong());
+        }
+        qb.query().finish();
+        if (!partIds.isEmpty()) {
+            inform(QStringLiteral("Found %1 parts to be moved out of packed segments").arg(partIds.size()));
+        }
+
+        for (const qint64 partId : std::as_const(partIds)) {
+            Transaction transaction(dataStore(), QStringLiteral("JANITOR UNPACK PARTS"));
+            Part part = Part::retrieveById(dataStore(), partId);
+            const QByteArray payload = PartHelper::translateData(part);
+            if (payload.size() != part.datasize()) {
+                qCCritical(AKONADISERVER_LOG) << "Sizes of" << part.id() << "data don't match";
+                continue;
+            }
+
+            QString newFile;
+            if (part.datasize() > sizeThreshold) {
+                QByteArray fileName;
+                if (!ExternalPartStorage::self()->createPartFile(payload, part.id(), fileName)) {
+                    continue;
+                }
+                newFile = ExternalPartStorage::resolveAbsolutePath(fileName);
+                part.setData(fileName);
+                part.setStorage(Part::External);
+            } else {
+                part.setData(payload);
+                part.setStorage(Part::Internal);
+            }
+            if (!part.update(dataStore()) || !transaction.commit()) {
+                qCCritical(AKONADISERVER_LOG) << "Failed to update database entry of part" << part.id();
+                if (!newFile.isEmpty()) {
+                    QFile::remove(newFile);
+                }
+                continue;
+            }
+        }
+    }
+}
+
+void StorageJanitor::compactPackedParts()
+{
+    auto *storage = PackedPartStorage::self();
+
+    // Segments retired by a previous run are no longer referenced by any reader
+    const int removed = storage->removeRetiredSegments(std::chrono::hours(1));
+    if (removed > 0) {
+        inform(QStringLiteral("Removed %1 retired packed part segments.").arg(removed));
+    }
+
+    const auto segmentSizes = storage->segmentSizes();
+    if (segmentSizes.isEmpty()) {
+        return;
+    }
+
+    // Calls the callback with the ID, location and segment of every packed part
+    const auto queryPackedParts = [this](const std::function<void(qint64, const QByteArray &, qint64)> &callback) {
+        QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
+        qb.addColumn(Part::idColumn());
+        qb.addColumn(Part::dataColumn());
+        qb.addValueCondition(Part::storageColumn(), Query::Equals, Part::Packed);
+        if (!qb.exec()) {
+            return false;
+        }
+        while (qb.query().next()) {
+            const QByteArray data = qb.query().value(1).toByteArray();
+            callback(qb.query().value(0).toLongLong(), data, PackedPartStorage::Location::fromByteArray(data).segment);
+        }
+        qb.query().finish();
+        return true;
+    };
+
+    // Parts of open transactions are not visible to the query yet, the records they refer to would be taken as
+    // unused. Records are only appended to the active segment, so once it has been determined, the segments
+    // before it cannot become pending anymore.
+    const qint64 activeSegment = storage->activeSegment();
+    const QSet<qint64> pendingSegments = storage->pendingSegments();
+
+    QHash<qint64, qint64> liveSizes;
+    if (!queryPackedParts([&liveSizes](qint64, const QByteArray &data, qint64 segment) {
+            liveSizes[segment] += PackedPartStorage::Location::fromByteArray(data).size;
+        })) {
+        inform("Failed to query packed parts, skipping test");
+        return;
+    }
+
+    // Appends go to the active or the last segment, those are never compacted
+    const qint64 lastSegment = std::max(segmentSizes.lastKey(), activeSegment);
+    QSet<qint64> compactedSegments;
+    for (auto it = segmentSizes.cbegin(), end = segmentSizes.cend(); it != end; ++it) {
+        if (it.key() >= lastSegment || it.key() == activeSegment || pendingSegments.contains(it.key())) {
+            continue;
+        }
+        if (liveSizes.value(it.key()) * 2 < it.value()) {
+            compactedSegments.insert(it.key());
+        }
+    }
+    if (compactedSegments.isEmpty()) {
+        inform("Found no packed part segments to compact.");
+        return;
+    }
+
+    QList<std::pair<qint64, QByteArray>> movedParts;
+    if (!queryPackedParts([&](qint64 partId, const QByteArray &data, qint64 segment) {
+            if (compactedSegments.contains(segment)) {
+                movedParts.emplace_back(partId, data);
+            }
+        })) {
+        inform("Failed to query packed parts, skipping test");
+        return;
+    }
+
+    QSet<qint64> failedSegments;
+    for (const auto &[partId, oldLocation] : std::as_const(movedParts)) {
+        Transaction transaction(dataStore(), QStringLiteral("JANITOR COMPACT PACKED PARTS"));
+        QByteArray payload;
+        QByteArray newLocation;
+        if (!storage->readPart(oldLocation, payload) || !storage->appendPart(payload, newLocation, dataStore())) {
+            failedSegments.insert(PackedPartStorage::Location::fromByteArray(oldLocation).segment);
+            continue;
+        }
+
+        // Only move the part if it has not been modified in the meantime
+        QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Update);
+        qb.setColumnValue(Part::dataColumn(), newLocation);
+        qb.addValueCondition(Part::idColumn(), Query::Equals, partId);
+        qb.addValueCondition(Part::storageColumn(), Query::Equals, Part::Packed);
+        qb.addValueCondition(Part::dataColumn(), Query::Equals, oldLocation);
+        if (!qb.exec() || !transaction.commit()) {
+            failedSegments.insert(PackedPartStorage::Location::fromByteArray(oldLocation).segment);
+        }
+    }
+
+    int retired = 0;
+    for (const qint64 segment : std::as_const(compactedSegments)) {
+        if (!failedSegments.contains(segment) && storage->retireSegment(segment)) {
+            ++retired;
         }
     }
+    inform(QStringLiteral("Moved %1 packed parts and retired %2 packed part segments.").arg(movedParts.size()).arg(retired));
 }
 
 void StorageJanitor::migrateToLevelledCacheHierarchy()
@@ -853,7 +1577,7 @@ void StorageJanitor::migrateToLevelledCacheHierarchy()
         return;
     }
 
-    QueryBuilder qb(m_dataStore.get(), Part::tableName(), QueryBuilder::Select);
+    QueryBuilder qb(dataStore(), Part::tableName(), QueryBuilder::Select);
     qb.addColumn(Part::idColumn());
     qb.addColumn(Part::dataColumn());
     qb.addValueCondition(Part::storageColumn(), Query::Equals, Part::External);
@@ -896,7 +1620,7 @@ void StorageJanitor::migrateToLevelledCacheHierarchy()
 
 void StorageJanitor::findOrphanSearchIndexEntries()
 {
-    QueryBuilder qb(m_dataStore.get(), Collection::tableName(), QueryBuilder::Select);
+    QueryBuilder qb(dataStore(), Collection::tableName(), QueryBuilder::Select);
     qb.addSortColumn(Collection::idColumn(), Query::Ascending);
     qb.addColumn(Collection::idColumn());
     qb.addColumn(Collection::isVirtualColumn());
@@ -925,7 +1649,6 @@ void StorageJanitor::findOrphanSearchIndexEntries()
 
         inform(QStringLiteral("Checking Collection %1 search index...").arg(colId));
         SearchRequest req("StorageJanitor", m_akonadi->searchManager(), m_akonadi->agentSearchManager());
-        req.setStoreResults(true);
         req.setCollections({colId});
         req.setRemoteSearch(false);
         req.setQuery(QStringLiteral("{ }")); // empty query to match all
@@ -946,7 +1669,7 @@ void StorageJanitor::findOrphanSearchIndexEntries()
         req.exec();
         auto searchResults = req.results();
 
-        QueryBuilder iqb(m_dataStore.get(), PimItem::tableName(), QueryBuilder::Select);
+        QueryBuilder iqb(dataStore(), PimItem::tableName(), QueryBuilder::Select);
         iqb.addColumn(PimItem::idColumn());
         iqb.addValueCondition(PimItem::collectionIdColumn(), Query::Equals, colId);
         if (!iqb.exec()) {
@@ -970,17 +1693,17 @@ void StorageJanitor::ensureSearchCollection()
 {
     static const auto searchResourceName = QStringLiteral("akonadi_search_resource");
 
-    auto searchResource = Resource::retrieveByName(m_dataStore.get(), searchResourceName);
+    auto searchResource = Resource::retrieveByName(dataStore(), searchResourceName);
     if (!searchResource.isValid()) {
         searchResource.setName(searchResourceName);
         searchResource.setIsVirtual(true);
-        if (!searchResource.insert(m_dataStore.get())) {
+        if (!searchResource.insert(dataStore())) {
             inform(QStringLiteral("Failed to create Search resource."));
             return;
         }
     }
 
-    auto searchCols = Collection::retrieveFiltered(m_dataStore.get(), Collection::resourceIdColumn(), searchResource.id());
+    auto searchCols = Collection::retrieveFiltered(dataStore(), Collection::resourceIdColumn(), searchResource.id());
     if (searchCols.isEmpty()) {
         Collection searchCol;
         searchCol.setId(1);
@@ -988,7 +1711,7 @@ void StorageJanitor::ensureSearchCollection()
         searchCol.setResource(searchResource);
         searchCol.setIndexPref(Collection::False);
         searchCol.setIsVirtual(true);
-        if (!searchCol.insert(m_dataStore.get())) {
+        if (!searchCol.insert(dataStore())) {
             inform(QStringLiteral("Failed to create Search Collection"));
             return;
         }
@@ -10,6 +10,15 @@
 #include "storage/dbconfig.h"
 
 #include <QDBusConnection>
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+class QSettings;
 
 namespace Akonadi
 {
@@ -21,6 +30,16 @@ class DataStore;
 
 /**
  * Various database checking/maintenance features.
+ *
+ * The consistency check consists of tasks which are run in lanes: the tasks
+ * of a lane run one after another, while the lanes run in parallel, each on
+ * its own database connection. Tasks which scan whole tables process them in
+ * chunks of ids, giving way to clients between the chunks while commands are
+ * being executed.
+ *
+ * When running in the server, the progress of the check is checkpointed after
+ * every task and every chunk, so that a check which was interrupted by a
+ * shutdown of the server is resumed after the server has been restarted.
  */
 class StorageJanitor : public AkThread
 {
@@ -41,6 +60,9 @@ public:
     explicit StorageJanitor(DbConfig *config);
     ~StorageJanitor() override;
 
+    /** The file in which the progress of an interrupted consistency check is stored. */
+    static QString checkpointFileName();
+
 public Q_SLOTS:
     /** Triggers a consistency check of the internal storage. */
     Q_SCRIPTABLE Q_NOREPLY void check();
@@ -51,14 +73,58 @@ Q_SIGNALS:
     /** Sends informational messages to a possible UI for this. */
     Q_SCRIPTABLE void information(const QString &msg);
     Q_SCRIPTABLE void done();
+    /**
+     * Reports the progress of the consistency check, @p remainingSeconds is an
+     * estimate of the remaining time, or -1 if unknown.
+     */
+    Q_SCRIPTABLE void progress(int percent, qlonglong remainingSeconds);
 
 protected:
     void init() override;
     void quit() override;
 
 private:
+    struct Task {
+        enum Lane {
+            /// Runs on the janitor thread, tasks which need the running server go here
+            DatabaseLane,
+            /// Tasks moving, verifying and removing part payloads
+            PayloadLane,
+        };
+
+        /// Identifies the task in the checkpoint
+        QString id;
+        QString name;
+        void (StorageJanitor::*func)();
+        Lane lane = DatabaseLane;
+    };
+
     void registerTasks();
 
+    /** Runs the tasks of @p lane, on a new database connection if @p dataStore is nullptr. */
+    void runLane(Task::Lane lane, DataStore *dataStore);
+    /** The database connection of the lane running in the current thread. */
+    DataStore *dataStore() const;
+
+    /**
+     * Calls @p processChunk with consecutive half-open ranges [from, to) of
+     * ids of @p table, each containing up to @p chunkSize rows, resuming from
+     * the checkpoint of the current task. The ranges are found by keyset
+     * pagination over the ids, so gaps in the ids don't add chunks.
+     * Returns false if a chunk failed or the check has been interrupted.
+     */
+    bool forEachChunk(const QString &table, const QString &idColumn, qint64 chunkSize, const std::function<bool(qint64 from, qint64 to)> &processChunk);
+    /** Waits while clients are running commands, but not longer than @p maxDelay. */
+    void throttle(std::chrono::milliseconds maxDelay);
+
+    void loadCheckpoint();
+    bool isTaskFinished(qsizetype task);
+    void finishTask(qsizetype task);
+    qint64 chunkCheckpoint(qsizetype task);
+    void setChunkCheckpoint(qsizetype task, qint64 nextId);
+
+    void setTaskProgress(qsizetype task, double progress);
+
     void inform(const char *msg);
     void inform(const QString &msg);
     /** Create a lost+found collection if necessary. */
@@ -126,6 +192,12 @@ private:
      */
     void verifyExternalParts();
 
+    /**
+     * Look for external parts with the same content stored in separate files
+     * and make them share a single file.
+     */
+    void deduplicateExternalParts();
+
     /**
      * Look for dirty objects.
      */
@@ -146,6 +218,18 @@ private:
      */
     void checkSizeTreshold();
 
+    /**
+     * Moves parts into or out of packed segments when the packed part
+     * threshold has changed.
+     */
+    void checkPackedParts();
+
+    /**
+     * Moves the remaining parts of mostly unused packed segments into the
+     * active segment and removes segments retired by previous runs.
+     */
+    void compactPackedParts();
+
     /**
      * Check if all external payload files are migrated to the levelled folder
      * hierarchy and migrates them if necessary
@@ -177,11 +261,17 @@ private:
     DbConfig *m_dbConfig = nullptr;
     std::unique_ptr<DataStore> m_dataStore;
 
-    struct Task {
-        QString name;
-        void (StorageJanitor::*func)();
-    };
     QList<Task> m_tasks;
+    std::atomic<bool> m_stopRequested = false;
+
+    QMutex m_checkpointLock;
+    std::unique_ptr<QSettings> m_checkpoint;
+
+    QMutex m_progressLock;
+    QList<double> m_taskProgress;
+    double m_initialProgress = 0.0;
+    QElapsedTimer m_checkTimer;
+    QElapsedTimer m_progressTimer;
 };
 
 } // namespace Server
@@ -32,6 +32,12 @@ int main(int argc, char *argv[])
     KAboutData::setApplicationData(aboutData);
 
     aboutData.setupCommandLine(&parser);
+    parser.addOption(QCommandLineOption({QStringLiteral("c"), QStringLiteral("collection")},
+                                        i18nc("@info:shell", "Path of the collection to export"),
+                                        QStringLiteral("path")));
+    parser.addOption(QCommandLineOption({QStringLiteral("o"), QStringLiteral("output")},
+                                        i18nc("@info:shell", "File to write the XML data into"),
+                                        QStringLiteral("file")));
     parser.process(app);
     aboutData.processCommandLine(&parser);
 
@@ -50,7 +56,7 @@ int main(int argc, char *argv[])
 
     XmlWriteJob writer(root, parser.value(QStringLiteral("output")));
     if (!writer.exec()) {
-        qCritical() << writer.exec();
+        qCritical() << writer.errorString();
         return -1;
     }
 }
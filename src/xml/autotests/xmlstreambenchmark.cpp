@@ -0,0 +1,128 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "xmldocument.h"
+#include "xmlstreamreader.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
+
+using namespace Akonadi;
+
+/**
+  Compares loading a KNUT document into a DOM tree with reading it using
+  XmlStreamReader.
+
+  The size of the generated fixture defaults to a few megabytes so that the
+  benchmark can run as part of the test suite. Set AKONADI_XML_BENCHMARK_SIZE_MB
+  to run it on a multi-GB fixture, e.g. AKONADI_XML_BENCHMARK_SIZE_MB=4096.
+*/
+class XmlStreamBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryFile mFixture;
+    int mItemCount = 0;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        const qint64 sizeMB = qEnvironmentVariableIsSet("AKONADI_XML_BENCHMARK_SIZE_MB") ? qEnvironmentVariableIntValue("AKONADI_XML_BENCHMARK_SIZE_MB") : 8;
+        const qint64 targetSize = sizeMB * 1024 * 1024;
+        const QString payload = QStringLiteral("Subject: Benchmark\nFrom: knut@localhost\n\n") + QString(4000, u'x');
+        constexpr int itemsPerCollection = 1000;
+
+        QVERIFY(mFixture.open());
+        QXmlStreamWriter writer(&mFixture);
+        writer.setAutoFormatting(true);
+        writer.writeStartDocument();
+        writer.writeStartElement(QStringLiteral("knut"));
+        while (mFixture.pos() < targetSize) {
+            writer.writeStartElement(QStringLiteral("collection"));
+            writer.writeAttribute(QStringLiteral("rid"), QStringLiteral("c%1").arg(mItemCount / itemsPerCollection));
+            writer.writeAttribute(QStringLiteral("name"), QStringLiteral("Folder %1").arg(mItemCount / itemsPerCollection));
+            writer.writeAttribute(QStringLiteral("content"), QStringLiteral("message/rfc822"));
+            for (int i = 0; i < itemsPerCollection; ++i, ++mItemCount) {
+                writer.writeStartElement(QStringLiteral("item"));
+                writer.writeAttribute(QStringLiteral("rid"), QStringLiteral("i%1").arg(mItemCount));
+                writer.writeAttribute(QStringLiteral("mimetype"), QStringLiteral("message/rfc822"));
+                writer.writeTextElement(QStringLiteral("payload"), payload);
+                writer.writeTextElement(QStringLiteral("flag"), QStringLiteral("\\SEEN"));
+                writer.writeEndElement();
+            }
+            writer.writeEndElement();
+        }
+        writer.writeEndDocument();
+        mFixture.flush();
+        qDebug() << "Generated fixture with" << mItemCount << "items," << mFixture.size() / 1024 / 1024 << "MB";
+    }
+
+    void benchmarkStreamReader()
+    {
+        QElapsedTimer timer;
+        timer.start();
+        int items = 0;
+        QVERIFY(mFixture.seek(0));
+        XmlStreamReader reader(&mFixture, false);
+        for (auto token = reader.readNext(); token != XmlStreamReader::EndDocument; token = reader.readNext()) {
+            QVERIFY2(token != XmlStreamReader::Invalid, qPrintable(reader.errorString()));
+            if (token == XmlStreamReader::ItemElement) {
+                ++items;
+            }
+        }
+        QCOMPARE(items, mItemCount);
+        qDebug() << "XmlStreamReader:" << items << "items in" << timer.elapsed() << "ms";
+    }
+
+    void benchmarkDocument()
+    {
+        if (mFixture.size() > 512 * 1024 * 1024) {
+            QSKIP("Fixture too large to be loaded into a DOM tree");
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        XmlDocument doc;
+        // Schema validation is not what we are interested in here
+        QVERIFY(mFixture.seek(0));
+        QVERIFY(doc.document().setContent(&mFixture));
+        int items = 0;
+        const auto collections = doc.collections();
+        for (const auto &collection : collections) {
+            items += doc.items(collection, false).size();
+        }
+        QCOMPARE(items, mItemCount);
+        qDebug() << "XmlDocument:" << items << "items in" << timer.elapsed() << "ms";
+    }
+
+    void benchmarkRemoteIdLookup()
+    {
+        if (mFixture.size() > 512 * 1024 * 1024) {
+            QSKIP("Fixture too large to be loaded into a DOM tree");
+        }
+
+        XmlDocument doc;
+        QVERIFY(mFixture.seek(0));
+        QVERIFY(doc.document().setContent(&mFixture));
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < mItemCount; i += std::max(1, mItemCount / 1000)) {
+            QVERIFY(!doc.itemElementByRemoteId(QStringLiteral("i%1").arg(i)).isNull());
+        }
+        qDebug() << "XmlDocument: 1000 remote id lookups in" << timer.elapsed() << "ms";
+    }
+};
+
+QTEST_GUILESS_MAIN(XmlStreamBenchmark)
+
+#include "xmlstreambenchmark.moc"
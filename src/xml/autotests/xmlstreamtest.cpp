@@ -0,0 +1,150 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "xmldocument.h"
+#include "xmlstreamreader.h"
+#include "xmlstreamwriter.h"
+
+#include "attributefactory.h"
+#include "entitydisplayattribute.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QHash>
+#include <QObject>
+#include <QTest>
+
+using namespace Akonadi;
+
+class XmlStreamTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testReadMatchesDocument()
+    {
+        const XmlDocument doc(QFINDTESTDATA("knutdemo.xml"), QFINDTESTDATA("../akonadi-xml.xsd"));
+        QVERIFY(doc.isValid());
+
+        QFile file(QFINDTESTDATA("knutdemo.xml"));
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        XmlStreamReader reader(&file);
+
+        Collection::List collections;
+        QHash<QString, Item::List> items;
+        int depth = 0;
+        bool done = false;
+        while (!done) {
+            switch (reader.readNext()) {
+            case XmlStreamReader::StartCollection:
+                collections.push_back(reader.collection());
+                ++depth;
+                break;
+            case XmlStreamReader::EndCollection:
+                --depth;
+                break;
+            case XmlStreamReader::ItemElement:
+                items[reader.item().parentCollection().remoteId()].push_back(reader.item());
+                break;
+            case XmlStreamReader::TagElement:
+                break;
+            case XmlStreamReader::EndDocument:
+                done = true;
+                break;
+            case XmlStreamReader::Invalid:
+                QFAIL(qPrintable(reader.errorString()));
+            }
+        }
+        QCOMPARE(depth, 0);
+
+        const auto docCollections = doc.collections();
+        QCOMPARE(collections.size(), docCollections.size());
+        for (qsizetype i = 0; i < collections.size(); ++i) {
+            QCOMPARE(collections[i].remoteId(), docCollections[i].remoteId());
+            QCOMPARE(collections[i].name(), docCollections[i].name());
+            QCOMPARE(collections[i].parentCollection().remoteId(), docCollections[i].parentCollection().remoteId());
+            QCOMPARE(collections[i].attributes().size(), docCollections[i].attributes().size());
+        }
+
+        const Collection inbox = doc.collectionByRemoteId(QStringLiteral("c11"));
+        const auto docItems = doc.items(inbox);
+        const auto streamItems = items.value(QStringLiteral("c11"));
+        QCOMPARE(streamItems.size(), docItems.size());
+        QCOMPARE(streamItems.first().remoteId(), docItems.first().remoteId());
+        QCOMPARE(streamItems.first().flags(), docItems.first().flags());
+        QCOMPARE(streamItems.first().payloadData(), docItems.first().payloadData());
+    }
+
+    void testRoundTrip()
+    {
+        AttributeFactory::registerAttribute<EntityDisplayAttribute>();
+
+        Collection parent;
+        parent.setRemoteId(QStringLiteral("c1"));
+        parent.setName(QStringLiteral("Parent"));
+        parent.setContentMimeTypes({Collection::mimeType()});
+        auto attr = parent.attribute<EntityDisplayAttribute>(Collection::AddIfMissing);
+        attr->setDisplayName(QStringLiteral("Display Name"));
+
+        Collection child;
+        child.setRemoteId(QStringLiteral("c2"));
+        child.setName(QStringLiteral("Child"));
+        child.setContentMimeTypes({QStringLiteral("application/octet-stream")});
+
+        Item item(QStringLiteral("application/octet-stream"));
+        item.setRemoteId(QStringLiteral("i1"));
+        item.setPayloadFromData("Hello <World> & everyone");
+        item.setFlag("\\SEEN");
+
+        QBuffer buffer;
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        {
+            XmlStreamWriter writer(&buffer);
+            writer.writeStartDocument();
+            writer.writeStartCollection(parent);
+            writer.writeStartCollection(child);
+            writer.writeItem(item);
+            writer.writeEndCollection();
+            writer.writeEndCollection();
+            writer.writeEndDocument();
+            QVERIFY(!writer.hasError());
+        }
+        buffer.close();
+
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+        XmlStreamReader reader(&buffer);
+        QCOMPARE(reader.readNext(), XmlStreamReader::StartCollection);
+        QCOMPARE(reader.collection().remoteId(), parent.remoteId());
+        QCOMPARE(reader.collection().attribute<EntityDisplayAttribute>()->displayName(), QStringLiteral("Display Name"));
+        QCOMPARE(reader.readNext(), XmlStreamReader::StartCollection);
+        QCOMPARE(reader.collection().remoteId(), child.remoteId());
+        QCOMPARE(reader.collection().parentCollection().remoteId(), parent.remoteId());
+        QCOMPARE(reader.readNext(), XmlStreamReader::ItemElement);
+        QCOMPARE(reader.item().remoteId(), item.remoteId());
+        QCOMPARE(reader.item().parentCollection().remoteId(), child.remoteId());
+        QCOMPARE(reader.item().payloadData(), item.payloadData());
+        QVERIFY(reader.item().hasFlag("\\SEEN"));
+        QCOMPARE(reader.readNext(), XmlStreamReader::EndCollection);
+        QCOMPARE(reader.collection().remoteId(), child.remoteId());
+        QCOMPARE(reader.readNext(), XmlStreamReader::EndCollection);
+        QCOMPARE(reader.collection().remoteId(), parent.remoteId());
+        QCOMPARE(reader.readNext(), XmlStreamReader::EndDocument);
+    }
+
+    void testInvalidDocument()
+    {
+        QBuffer buffer;
+        buffer.setData("<knut><collection rid=\"c1\" name=\"c\" content=\"\"><item rid=\"i1\"");
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+        XmlStreamReader reader(&buffer);
+        QCOMPARE(reader.readNext(), XmlStreamReader::StartCollection);
+        QCOMPARE(reader.readNext(), XmlStreamReader::Invalid);
+        QVERIFY(!reader.errorString().isEmpty());
+    }
+};
+
+QTEST_MAIN(XmlStreamTest)
+
+#include "xmlstreamtest.moc"
@@ -12,6 +12,7 @@
 
 #include <QDomElement>
 #include <QFile>
+#include <QHash>
 
 #ifdef HAVE_LIBXML2
 #include <QStandardPaths>
@@ -87,12 +88,79 @@ public:
 
     QDomElement findElementByRid(const QString &rid, const QString &elemName) const
     {
-        return findElementByRidHelper(document.documentElement(), rid, elemName);
+        auto &index = elemName == Format::Tag::item() ? itemIndex : collectionIndex;
+        if (!indexValid) {
+            buildIndex();
+        }
+
+        // The DOM can be modified through XmlDocument::document(), so verify that
+        // the indexed element is still what we are looking for.
+        const auto it = index.constFind(rid);
+        if (it != index.cend() && isIndexedElement(*it, rid, elemName)) {
+            return *it;
+        }
+
+        const QDomElement elem = findElementByRidHelper(document.documentElement(), rid, elemName);
+        if (!elem.isNull()) {
+            index.insert(rid, elem);
+        }
+        return elem;
+    }
+
+    bool isIndexedElement(const QDomElement &elem, const QString &rid, const QString &elemName) const
+    {
+        if (elem.tagName() != elemName || elem.attribute(Format::Attr::remoteId()) != rid) {
+            return false;
+        }
+        // Make sure the element has not been removed from the tree
+        QDomNode node = elem;
+        while (!node.parentNode().isNull()) {
+            node = node.parentNode();
+        }
+        return node == document;
+    }
+
+    void buildIndex() const
+    {
+        itemIndex.clear();
+        collectionIndex.clear();
+        indexElement(document.documentElement());
+        indexValid = true;
+    }
+
+    void indexElement(const QDomElement &elem) const
+    {
+        for (QDomElement child = elem.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+            const QString tagName = child.tagName();
+            const QString rid = child.attribute(Format::Attr::remoteId());
+            // Same as findElementByRidHelper(), the first element in document order wins
+            if (tagName == Format::Tag::item()) {
+                if (!itemIndex.contains(rid)) {
+                    itemIndex.insert(rid, child);
+                }
+            } else if (tagName == Format::Tag::collection()) {
+                if (!collectionIndex.contains(rid)) {
+                    collectionIndex.insert(rid, child);
+                }
+                indexElement(child);
+            }
+        }
+    }
+
+    void invalidateIndex()
+    {
+        indexValid = false;
+        itemIndex.clear();
+        collectionIndex.clear();
     }
 
     QDomDocument document;
+    // remote id -> element lookup tables, built on first lookup
+    mutable QHash<QString, QDomElement> itemIndex;
+    mutable QHash<QString, QDomElement> collectionIndex;
     QString lastError;
     bool valid;
+    mutable bool indexValid = false;
 };
 
 } // namespace Akonadi
@@ -116,6 +184,7 @@ bool Akonadi::XmlDocument::loadFile(const QString &fileName, const QString &xsdF
 {
     d->valid = false;
     d->document = QDomDocument();
+    d->invalidateIndex();
 
     if (fileName.isEmpty()) {
         d->lastError = i18n("No filename specified");
@@ -227,13 +296,14 @@ QDomElement XmlDocument::collectionElement(const Collection &collection) const
     if (parent.isNull()) {
         return QDomElement();
     }
-    const QDomNodeList children = parent.childNodes();
-    for (int i = 0; i < children.count(); ++i) {
-        const QDomElement child = children.at(i).toElement();
-        if (child.isNull()) {
-            continue;
-        }
-        if (child.tagName() == Format::Tag::collection() && child.attribute(Format::Attr::remoteId()) == collection.remoteId()) {
+    const QDomElement elem = d->findElementByRid(collection.remoteId(), Format::Tag::collection());
+    if (!elem.isNull() && elem.parentNode() == parent) {
+        return elem;
+    }
+    // Remote ids are not necessarily unique across the whole document
+    for (QDomElement child = parent.firstChildElement(Format::Tag::collection()); !child.isNull();
+         child = child.nextSiblingElement(Format::Tag::collection())) {
+        if (child.attribute(Format::Attr::remoteId()) == collection.remoteId()) {
             return child;
         }
     }
@@ -0,0 +1,209 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "xmlstreamreader.h"
+#include "format_p.h"
+
+#include "attributefactory.h"
+
+#include <KLocalizedString>
+
+#include <QStack>
+#include <QXmlStreamReader>
+
+using namespace Akonadi;
+
+namespace Akonadi
+{
+class XmlStreamReaderPrivate
+{
+public:
+    XmlStreamReaderPrivate(QIODevice *device, bool includePayload)
+        : reader(device)
+        , includePayload(includePayload)
+    {
+    }
+
+    Attribute *readAttribute()
+    {
+        const auto type = reader.attributes().value(Format::Attr::attributeType()).toUtf8();
+        const auto data = reader.readElementText().toUtf8();
+        Attribute *attr = AttributeFactory::createAttribute(type);
+        Q_ASSERT(attr);
+        attr->deserialize(data);
+        return attr;
+    }
+
+    Collection readCollection()
+    {
+        const auto attrs = reader.attributes();
+        Collection c;
+        c.setRemoteId(attrs.value(Format::Attr::remoteId()).toString());
+        c.setName(attrs.value(Format::Attr::collectionName()).toString());
+        c.setContentMimeTypes(attrs.value(Format::Attr::collectionContentTypes()).toString().split(u','));
+        if (!collections.isEmpty()) {
+            c.parentCollection().setRemoteId(collections.top().remoteId());
+        }
+        return c;
+    }
+
+    Item readItem()
+    {
+        const auto attrs = reader.attributes();
+        const auto mimeType = attrs.value(Format::Attr::itemMimeType());
+        Item item(mimeType.isNull() ? QStringLiteral("application/octet-stream") : mimeType.toString());
+        item.setRemoteId(attrs.value(Format::Attr::remoteId()).toString());
+        if (!collections.isEmpty()) {
+            item.parentCollection().setRemoteId(collections.top().remoteId());
+        }
+
+        while (reader.readNextStartElement()) {
+            const auto name = reader.name();
+            if (name == Format::Tag::attribute()) {
+                item.addAttribute(readAttribute());
+            } else if (name == Format::Tag::flag()) {
+                item.setFlag(reader.readElementText().toUtf8());
+            } else if (name == Format::Tag::tag()) {
+                Tag tag;
+                tag.setRemoteId(reader.readElementText().toUtf8());
+                item.setTag(tag);
+            } else if (includePayload && name == Format::Tag::payload()) {
+                item.setPayloadFromData(reader.readElementText().toUtf8());
+            } else {
+                reader.skipCurrentElement();
+            }
+        }
+
+        return item;
+    }
+
+    Tag readTag()
+    {
+        const auto attrs = reader.attributes();
+        Tag t;
+        t.setRemoteId(attrs.value(Format::Attr::remoteId()).toUtf8());
+        t.setName(attrs.value(Format::Attr::name()).toString());
+        t.setGid(attrs.value(Format::Attr::gid()).toUtf8());
+        t.setType(attrs.value(Format::Attr::type()).toUtf8());
+        return t;
+    }
+
+    XmlStreamReader::TokenType reportPendingCollection()
+    {
+        collectionPending = false;
+        currentCollection = collections.top();
+        return XmlStreamReader::StartCollection;
+    }
+
+    QXmlStreamReader reader;
+    QStack<Collection> collections;
+    Collection currentCollection;
+    Item currentItem;
+    Tag currentTag;
+    QString errorString;
+    const bool includePayload;
+    // The collection on top of the stack has not been reported yet, we are
+    // still collecting its attributes
+    bool collectionPending = false;
+    // The current token of the reader has not been processed yet
+    bool replayToken = false;
+};
+
+} // namespace Akonadi
+
+XmlStreamReader::XmlStreamReader(QIODevice *device, bool includePayload)
+    : d(new XmlStreamReaderPrivate(device, includePayload))
+{
+}
+
+XmlStreamReader::~XmlStreamReader() = default;
+
+XmlStreamReader::TokenType XmlStreamReader::readNext()
+{
+    while (true) {
+        if (!d->replayToken) {
+            if (d->reader.atEnd() && !d->reader.hasError()) {
+                return EndDocument;
+            }
+            d->reader.readNext();
+        }
+        d->replayToken = false;
+
+        if (d->reader.hasError()) {
+            d->errorString = i18n("Unable to parse data file: %1", d->reader.errorString());
+            return Invalid;
+        }
+
+        switch (d->reader.tokenType()) {
+        case QXmlStreamReader::StartElement: {
+            const auto name = d->reader.name();
+            if (name == Format::Tag::root()) {
+                continue;
+            }
+            // Attributes of a collection precede its child collections and items
+            if (d->collectionPending && name != Format::Tag::attribute()) {
+                d->replayToken = true;
+                return d->reportPendingCollection();
+            }
+
+            if (name == Format::Tag::collection()) {
+                d->collections.push(d->readCollection());
+                d->collectionPending = true;
+            } else if (name == Format::Tag::attribute() && d->collectionPending) {
+                d->collections.top().addAttribute(d->readAttribute());
+            } else if (name == Format::Tag::item()) {
+                d->currentItem = d->readItem();
+                if (d->reader.hasError()) {
+                    d->errorString = i18n("Unable to parse data file: %1", d->reader.errorString());
+                    return Invalid;
+                }
+                return ItemElement;
+            } else if (name == Format::Tag::tag()) {
+                // Don't consume the element, nested tags are reported individually
+                d->currentTag = d->readTag();
+                return TagElement;
+            } else {
+                d->reader.skipCurrentElement();
+            }
+            continue;
+        }
+        case QXmlStreamReader::EndElement:
+            if (d->reader.name() == Format::Tag::collection()) {
+                if (d->collectionPending) {
+                    d->replayToken = true;
+                    return d->reportPendingCollection();
+                }
+                d->currentCollection = d->collections.pop();
+                return EndCollection;
+            }
+            continue;
+        case QXmlStreamReader::EndDocument:
+            return EndDocument;
+        default:
+            continue;
+        }
+    }
+}
+
+Collection XmlStreamReader::collection() const
+{
+    return d->currentCollection;
+}
+
+Item XmlStreamReader::item() const
+{
+    return d->currentItem;
+}
+
+Tag XmlStreamReader::tag() const
+{
+    return d->currentTag;
+}
+
+QString XmlStreamReader::errorString() const
+{
+    return d->errorString;
+}
@@ -0,0 +1,108 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akonadi-xml_export.h"
+
+// AkonadiCore
+#include "akonadi/collection.h"
+#include "akonadi/item.h"
+#include "akonadi/tag.h"
+
+#include <memory>
+
+class QIODevice;
+
+namespace Akonadi
+{
+class XmlStreamReaderPrivate;
+
+/**
+  Reads a document in the KNUT XML serialization format sequentially from a
+  QIODevice, without loading the whole document into memory.
+
+  Unlike XmlDocument, the reader does not support random access, the memory
+  it needs is bounded by the size of a single item and the depth of the
+  collection tree.
+
+  @code
+  XmlStreamReader reader(&file);
+  while (true) {
+      switch (reader.readNext()) {
+      case XmlStreamReader::StartCollection:
+          createCollection(reader.collection());
+          break;
+      case XmlStreamReader::ItemElement:
+          createItem(reader.item());
+          break;
+      case XmlStreamReader::EndDocument:
+          return true;
+      case XmlStreamReader::Invalid:
+          qWarning() << reader.errorString();
+          return false;
+      default:
+          break;
+      }
+  }
+  @endcode
+
+  @see Akonadi::XmlStreamWriter, Akonadi::XmlDocument
+*/
+class AKONADI_XML_EXPORT XmlStreamReader
+{
+public:
+    enum TokenType {
+        Invalid, ///< An error has occurred, see errorString()
+        StartCollection, ///< A collection has been read, see collection()
+        EndCollection, ///< All children of collection() have been read
+        ItemElement, ///< An item has been read, see item()
+        TagElement, ///< A tag has been read, see tag()
+        EndDocument, ///< The whole document has been read
+    };
+
+    /**
+      Creates a new reader reading from @p device. The device must be open
+      and must outlive the reader.
+
+      When @p includePayload is @c false, payload elements are skipped.
+    */
+    explicit XmlStreamReader(QIODevice *device, bool includePayload = true);
+    ~XmlStreamReader();
+
+    /**
+      Reads the next object from the document and returns its type.
+    */
+    TokenType readNext();
+
+    /**
+      Returns the collection read by the last StartCollection or EndCollection token.
+      The parent collection has its remote id set.
+    */
+    [[nodiscard]] Collection collection() const;
+
+    /**
+      Returns the item read by the last ItemElement token.
+      The parent collection has its remote id set.
+    */
+    [[nodiscard]] Item item() const;
+
+    /**
+      Returns the tag read by the last TagElement token.
+    */
+    [[nodiscard]] Tag tag() const;
+
+    /**
+      Returns a description of the last error, if readNext() returned Invalid.
+    */
+    [[nodiscard]] QString errorString() const;
+
+private:
+    Q_DISABLE_COPY(XmlStreamReader)
+    std::unique_ptr<XmlStreamReaderPrivate> const d;
+};
+
+}
@@ -0,0 +1,107 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "xmlstreamwriter.h"
+#include "format_p.h"
+
+#include "attribute.h"
+
+#include <QXmlStreamWriter>
+
+using namespace Akonadi;
+
+namespace Akonadi
+{
+class XmlStreamWriterPrivate
+{
+public:
+    explicit XmlStreamWriterPrivate(QIODevice *device)
+        : writer(device)
+    {
+        writer.setAutoFormatting(true);
+        writer.setAutoFormattingIndent(2);
+    }
+
+    template<typename T>
+    void writeAttributes(const T &entity)
+    {
+        const auto attributes = entity.attributes();
+        for (Attribute *attr : attributes) {
+            writer.writeStartElement(Format::Tag::attribute());
+            writer.writeAttribute(Format::Attr::attributeType(), QString::fromUtf8(attr->type()));
+            writer.writeCharacters(QString::fromUtf8(attr->serialized()));
+            writer.writeEndElement();
+        }
+    }
+
+    QXmlStreamWriter writer;
+    int openCollections = 0;
+};
+
+} // namespace Akonadi
+
+XmlStreamWriter::XmlStreamWriter(QIODevice *device)
+    : d(new XmlStreamWriterPrivate(device))
+{
+}
+
+XmlStreamWriter::~XmlStreamWriter() = default;
+
+void XmlStreamWriter::writeStartDocument()
+{
+    d->writer.writeStartDocument();
+    d->writer.writeStartElement(Format::Tag::root());
+}
+
+void XmlStreamWriter::writeEndDocument()
+{
+    d->openCollections = 0;
+    d->writer.writeEndDocument();
+}
+
+void XmlStreamWriter::writeStartCollection(const Collection &collection)
+{
+    ++d->openCollections;
+    d->writer.writeStartElement(Format::Tag::collection());
+    d->writer.writeAttribute(Format::Attr::remoteId(), collection.remoteId());
+    d->writer.writeAttribute(Format::Attr::collectionName(), collection.name());
+    d->writer.writeAttribute(Format::Attr::collectionContentTypes(), collection.contentMimeTypes().join(u','));
+    d->writeAttributes(collection);
+}
+
+void XmlStreamWriter::writeEndCollection()
+{
+    if (d->openCollections == 0) {
+        return;
+    }
+    --d->openCollections;
+    d->writer.writeEndElement();
+}
+
+void XmlStreamWriter::writeItem(const Item &item)
+{
+    d->writer.writeStartElement(Format::Tag::item());
+    d->writer.writeAttribute(Format::Attr::remoteId(), item.remoteId());
+    d->writer.writeAttribute(Format::Attr::itemMimeType(), item.mimeType());
+
+    if (item.hasPayload()) {
+        d->writer.writeTextElement(Format::Tag::payload(), QString::fromUtf8(item.payloadData()));
+    }
+
+    d->writeAttributes(item);
+
+    const auto flags = item.flags();
+    for (const Item::Flag &flag : flags) {
+        d->writer.writeTextElement(Format::Tag::flag(), QString::fromUtf8(flag));
+    }
+
+    d->writer.writeEndElement();
+}
+
+bool XmlStreamWriter::hasError() const
+{
+    return d->writer.hasError();
+}
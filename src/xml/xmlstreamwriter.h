@@ -0,0 +1,88 @@
+/*
+    SPDX-FileCopyrightText: 2026 Akonadi Developers
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "akonadi-xml_export.h"
+
+// AkonadiCore
+#include "akonadi/collection.h"
+#include "akonadi/item.h"
+
+#include <memory>
+
+class QIODevice;
+
+namespace Akonadi
+{
+class XmlStreamWriterPrivate;
+
+/**
+  Writes Akonadi objects in the KNUT XML serialization format directly into
+  a QIODevice, without building a DOM tree in memory.
+
+  Collections are written as they are opened and closed, so that items can be
+  serialized one by one while they are being retrieved:
+
+  @code
+  XmlStreamWriter writer(&file);
+  writer.writeStartDocument();
+  writer.writeStartCollection(collection);
+  writer.writeItem(item);
+  writer.writeEndCollection();
+  writer.writeEndDocument();
+  @endcode
+
+  @see Akonadi::XmlStreamReader, Akonadi::XmlWriter
+*/
+class AKONADI_XML_EXPORT XmlStreamWriter
+{
+public:
+    /**
+      Creates a new writer writing into @p device. The device must be open
+      and must outlive the writer.
+    */
+    explicit XmlStreamWriter(QIODevice *device);
+    ~XmlStreamWriter();
+
+    /**
+      Writes the XML declaration and opens the root element.
+    */
+    void writeStartDocument();
+
+    /**
+      Closes all open elements, including the root element.
+    */
+    void writeEndDocument();
+
+    /**
+      Opens a collection element for @p collection and writes its attributes.
+      All collections and items written until the matching writeEndCollection()
+      call become children of this collection.
+    */
+    void writeStartCollection(const Collection &collection);
+
+    /**
+      Closes the innermost open collection element.
+    */
+    void writeEndCollection();
+
+    /**
+      Serializes @p item into the innermost open collection.
+    */
+    void writeItem(const Item &item);
+
+    /**
+      Returns @c true if writing into the device has failed.
+    */
+    [[nodiscard]] bool hasError() const;
+
+private:
+    Q_DISABLE_COPY(XmlStreamWriter)
+    std::unique_ptr<XmlStreamWriterPrivate> const d;
+};
+
+}
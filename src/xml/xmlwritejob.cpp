@@ -5,17 +5,17 @@
 */
 
 #include "xmlwritejob.h"
-#include "xmldocument.h"
-#include "xmlwriter.h"
+#include "xmlstreamwriter.h"
 
 #include "collectionfetchjob.h"
 #include "item.h"
 #include "itemfetchjob.h"
 #include "itemfetchscope.h"
 
-#include <QDebug>
+#include <KLocalizedString>
 
-#include <QDomElement>
+#include <QDebug>
+#include <QSaveFile>
 #include <QStack>
 
 using namespace Akonadi;
@@ -33,9 +33,10 @@ public:
     XmlWriteJob *const q;
     Collection::List roots;
     QStack<Collection::List> pendingSiblings;
-    QStack<QDomElement> elementStack;
     QString fileName;
-    XmlDocument document;
+    // Collections and items are written into the file as soon as they are fetched
+    std::unique_ptr<QSaveFile> file;
+    std::unique_ptr<XmlStreamWriter> writer;
 
     void collectionFetchResult(KJob *job);
     void processCollection();
@@ -78,8 +79,8 @@ void XmlWriteJobPrivate::processCollection()
     }
 
     const Collection current = pendingSiblings.top().first();
-    qDebug() << "Writing " << current.name() << "into" << elementStack.top().attribute(QStringLiteral("name"));
-    elementStack.push(XmlWriter::writeCollection(current, elementStack.top()));
+    qDebug() << "Writing " << current.name();
+    writer->writeStartCollection(current);
     auto subfetch = new CollectionFetchJob(current, CollectionFetchJob::FirstLevel, q);
     q->connect(subfetch, &CollectionFetchJob::result, q, [this](KJob *job) {
         collectionFetchResult(job);
@@ -92,6 +93,13 @@ void XmlWriteJobPrivate::processItems()
     auto fetch = new ItemFetchJob(collection, q);
     fetch->fetchScope().fetchAllAttributes();
     fetch->fetchScope().fetchFullPayload();
+    // Don't accumulate the items in the job, write each batch as it arrives
+    fetch->setDeliveryOption(ItemFetchJob::EmitItemsInBatches);
+    q->connect(fetch, &ItemFetchJob::itemsReceived, q, [this](const Akonadi::Item::List &items) {
+        for (const Item &item : items) {
+            writer->writeItem(item);
+        }
+    });
     q->connect(fetch, &ItemFetchJob::result, q, [this](KJob *job) {
         itemFetchResult(job);
     });
@@ -102,14 +110,8 @@ void XmlWriteJobPrivate::itemFetchResult(KJob *job)
     if (job->error()) {
         return;
     }
-    auto fetch = qobject_cast<ItemFetchJob *>(job);
-    Q_ASSERT(fetch);
-    const Akonadi::Item::List lstItems = fetch->items();
-    for (const Item &item : lstItems) {
-        XmlWriter::writeItem(item, elementStack.top());
-    }
     pendingSiblings.top().removeFirst();
-    elementStack.pop();
+    writer->writeEndCollection();
     processCollection();
 }
 
@@ -133,7 +135,16 @@ XmlWriteJob::~XmlWriteJob() = default;
 
 void XmlWriteJob::doStart()
 {
-    d->elementStack.push(d->document.document().documentElement());
+    d->file = std::make_unique<QSaveFile>(d->fileName);
+    if (!d->file->open(QIODevice::WriteOnly)) {
+        setError(Unknown);
+        setErrorText(d->file->errorString());
+        emitResult();
+        return;
+    }
+    d->writer = std::make_unique<XmlStreamWriter>(d->file.get());
+    d->writer->writeStartDocument();
+
     auto job = new CollectionFetchJob(d->roots, this);
     connect(job, &CollectionFetchJob::result, this, [this](KJob *job) {
         d->collectionFetchResult(job);
@@ -142,9 +153,10 @@ void XmlWriteJob::doStart()
 
 void XmlWriteJob::done() // cannot be in the private class due to emitResult()
 {
-    if (!d->document.writeToFile(d->fileName)) {
+    d->writer->writeEndDocument();
+    if (d->writer->hasError() || !d->file->commit()) {
         setError(Unknown);
-        setErrorText(d->document.lastError());
+        setErrorText(i18n("Unable to write data file '%1': %2", d->fileName, d->file->errorString()));
     }
     emitResult();
 }